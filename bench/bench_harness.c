@@ -0,0 +1,284 @@
+#define _GNU_SOURCE
+#include "bench_harness.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/utsname.h>
+#include <time.h>
+#include <unistd.h>
+
+long long bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void bench_config_default(BenchConfig *config) {
+    config->warmup = BENCH_DEFAULT_WARMUP;
+    config->trials = BENCH_DEFAULT_TRIALS;
+    config->min_trial_ns = BENCH_DEFAULT_MIN_TRIAL_MS * 1000000LL;
+    config->root = NULL;
+}
+
+// Roda um lote e devolve a duração em ns, ou -1 se alguma operação falhou
+static long long run_batch(BenchFn fn, void *ctx, long long batch) {
+    long long start = bench_now_ns();
+    for (long long i = 0; i < batch; i++) {
+        if (fn(ctx) != 0) return -1;
+    }
+    return bench_now_ns() - start;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil pelo posto mais próximo sobre valores ordenados
+static double percentile(const double *sorted, int n, double q) {
+    int rank = (int)ceil(q * n);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted[rank - 1];
+}
+
+int bench_run(const BenchConfig *config, BenchFn fn, void *ctx, BenchResult *result) {
+
+    if (!config || !fn || !result || config->trials < 1) {
+        fprintf(stderr, "Erro: parametros invalidos em bench_run\n");
+        return -1;
+    }
+
+    // Calibração: dobra o lote até passar da duração mínima. Também serve
+    // de primeiro aquecimento (caches, páginas do buffer, dentries do /proc).
+    long long batch = 1;
+    for (;;) {
+        long long elapsed = run_batch(fn, ctx, batch);
+        if (elapsed < 0) return -1;
+        if (elapsed >= config->min_trial_ns || batch >= (1LL << 30)) break;
+        batch *= 2;
+    }
+
+    for (int i = 0; i < config->warmup; i++) {
+        if (run_batch(fn, ctx, batch) < 0) return -1;
+    }
+
+    double *per_op = malloc(sizeof(double) * (size_t)config->trials);
+    if (!per_op) {
+        fprintf(stderr, "Erro: falha ao alocar memoria para os lotes\n");
+        return -1;
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < config->trials; i++) {
+        long long elapsed = run_batch(fn, ctx, batch);
+        if (elapsed < 0) {
+            free(per_op);
+            return -1;
+        }
+        per_op[i] = (double)elapsed / (double)batch;
+        sum += per_op[i];
+    }
+
+    double mean = sum / config->trials;
+    double var = 0.0;
+    for (int i = 0; i < config->trials; i++) var += (per_op[i] - mean) * (per_op[i] - mean);
+
+    qsort(per_op, (size_t)config->trials, sizeof(double), cmp_double);
+
+    result->skipped = 0;
+    result->trials = config->trials;
+    result->batch = batch;
+    result->mean_ns = mean;
+    result->stddev_ns = config->trials > 1 ? sqrt(var / (config->trials - 1)) : 0.0;
+    result->min_ns = per_op[0];
+    result->p50_ns = percentile(per_op, config->trials, 0.50);
+    result->p90_ns = percentile(per_op, config->trials, 0.90);
+    result->p99_ns = percentile(per_op, config->trials, 0.99);
+    result->max_ns = per_op[config->trials - 1];
+
+    free(per_op);
+    return 0;
+}
+
+/* ------------------------------ JSON ------------------------------ */
+
+// Nomes e notas são escritos pelo próprio programa; só aspas e barras precisam de escape
+static void json_string(FILE *fp, const char *s) {
+    fputc('"', fp);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', fp);
+        if ((unsigned char)*s >= 0x20) fputc(*s, fp);
+    }
+    fputc('"', fp);
+}
+
+int bench_write_json(const char *path, const BenchConfig *config,
+                     const BenchResult *results, int count) {
+
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "Erro: nao foi possivel criar %s\n", path);
+        return -1;
+    }
+
+    time_t now = time(NULL);
+    struct tm tm_buf;
+    char when[32];
+    strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%S", localtime_r(&now, &tm_buf));
+
+    struct utsname uts;
+    if (uname(&uts) != 0) memset(&uts, 0, sizeof(uts));
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"timestamp\": \"%s\",\n", when);
+    fprintf(fp, "  \"host\": {\"kernel\": ");
+    json_string(fp, uts.release);
+    fprintf(fp, ", \"machine\": ");
+    json_string(fp, uts.machine);
+    fprintf(fp, ", \"cpus\": %ld},\n", sysconf(_SC_NPROCESSORS_ONLN));
+    fprintf(fp, "  \"config\": {\"warmup\": %d, \"trials\": %d, \"min_trial_ns\": %lld, \"root\": ",
+            config->warmup, config->trials, config->min_trial_ns);
+    if (config->root) json_string(fp, config->root);
+    else fprintf(fp, "null");
+    fprintf(fp, "},\n");
+    fprintf(fp, "  \"results\": [\n");
+
+    // Um resultado por linha: bench_compare lê o baseline linha a linha
+    for (int i = 0; i < count; i++) {
+        const BenchResult *r = &results[i];
+        fprintf(fp, "    {\"name\": ");
+        json_string(fp, r->name);
+        fprintf(fp, ", \"group\": ");
+        json_string(fp, r->group);
+        if (r->skipped) {
+            fprintf(fp, ", \"skipped\": true, \"note\": ");
+            json_string(fp, r->note);
+        } else {
+            fprintf(fp, ", \"trials\": %d, \"batch\": %lld, \"mean_ns\": %.1f, \"stddev_ns\": %.1f"
+                        ", \"min_ns\": %.1f, \"p50_ns\": %.1f, \"p90_ns\": %.1f, \"p99_ns\": %.1f, \"max_ns\": %.1f",
+                    r->trials, r->batch, r->mean_ns, r->stddev_ns,
+                    r->min_ns, r->p50_ns, r->p90_ns, r->p99_ns, r->max_ns);
+        }
+        fprintf(fp, "}%s\n", i + 1 < count ? "," : "");
+    }
+
+    fprintf(fp, "  ]\n}\n");
+
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel gravar %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/* --------------------------- comparação --------------------------- */
+
+typedef struct {
+    char name[BENCH_NAME_LEN];
+    double p50_ns;
+    double p90_ns;
+} BaselineEntry;
+
+// Extrai "name", "p50_ns" e "p90_ns" de uma linha de resultado. Retorna 1 se achou nome e p50.
+static int parse_baseline_line(const char *line, BaselineEntry *entry) {
+
+    const char *p = strstr(line, "\"name\": \"");
+    if (!p) return 0;
+    p += strlen("\"name\": \"");
+
+    size_t n = 0;
+    while (p[n] && p[n] != '"' && n + 1 < sizeof(entry->name)) {
+        entry->name[n] = p[n];
+        n++;
+    }
+    entry->name[n] = '\0';
+
+    const char *q = strstr(p, "\"p50_ns\": ");
+    if (!q) return 0;  // caso pulado no baseline
+    entry->p50_ns = strtod(q + strlen("\"p50_ns\": "), NULL);
+
+    q = strstr(p, "\"p90_ns\": ");
+    entry->p90_ns = q ? strtod(q + strlen("\"p90_ns\": "), NULL) : entry->p50_ns;
+    return entry->p50_ns > 0.0;
+}
+
+static void format_ns(double ns, char *buf, size_t size) {
+    if (ns < 1e3) snprintf(buf, size, "%.1f ns", ns);
+    else if (ns < 1e6) snprintf(buf, size, "%.2f us", ns / 1e3);
+    else snprintf(buf, size, "%.2f ms", ns / 1e6);
+}
+
+int bench_compare(const char *baseline_path, const BenchResult *results, int count,
+                  double threshold_pct, FILE *out) {
+
+    FILE *fp = fopen(baseline_path, "r");
+    if (!fp) {
+        fprintf(stderr, "Erro: nao foi possivel abrir o baseline %s\n", baseline_path);
+        return -1;
+    }
+
+    BaselineEntry *base = NULL;
+    int nbase = 0, cap = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), fp)) {
+        BaselineEntry entry;
+        if (!parse_baseline_line(line, &entry)) continue;
+        if (nbase == cap) {
+            cap = cap ? cap * 2 : 32;
+            BaselineEntry *grown = realloc(base, sizeof(*base) * (size_t)cap);
+            if (!grown) {
+                fprintf(stderr, "Erro: falha ao alocar memoria para o baseline\n");
+                free(base);
+                fclose(fp);
+                return -1;
+            }
+            base = grown;
+        }
+        base[nbase++] = entry;
+    }
+    fclose(fp);
+
+    fprintf(out, "\n===== COMPARACAO COM %s (limite +%.0f%% no p50) =====\n", baseline_path, threshold_pct);
+    fprintf(out, "%-32s %12s %12s %9s  %s\n", "CASO", "BASELINE", "ATUAL", "DELTA", "");
+
+    int regressions = 0;
+    for (int i = 0; i < count; i++) {
+        const BenchResult *r = &results[i];
+        if (r->skipped) continue;
+
+        const BaselineEntry *b = NULL;
+        for (int j = 0; j < nbase; j++) {
+            if (strcmp(base[j].name, r->name) == 0) {
+                b = &base[j];
+                break;
+            }
+        }
+
+        char now_s[24], base_s[24];
+        format_ns(r->p50_ns, now_s, sizeof(now_s));
+        if (!b) {
+            fprintf(out, "%-32s %12s %12s %9s  novo\n", r->name, "-", now_s, "-");
+            continue;
+        }
+
+        format_ns(b->p50_ns, base_s, sizeof(base_s));
+        double delta = 100.0 * (r->p50_ns - b->p50_ns) / b->p50_ns;
+        const char *verdict = "ok";
+        if (delta > threshold_pct && r->p50_ns > b->p90_ns) {
+            verdict = "REGRESSAO";
+            regressions++;
+        } else if (delta > threshold_pct) {
+            // Pior que o limite, mas dentro da variação que o próprio baseline teve
+            verdict = "ruido";
+        } else if (delta < -threshold_pct) {
+            verdict = "melhora";
+        }
+        fprintf(out, "%-32s %12s %12s %+8.1f%%  %s\n", r->name, base_s, now_s, delta, verdict);
+    }
+
+    fprintf(out, "Regressoes: %d\n", regressions);
+    free(base);
+    return regressions;
+}
@@ -0,0 +1,73 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <stdio.h>
+
+/*
+ * Harness dos microbenchmarks (make bench).
+ *
+ * Cada caso é uma função que executa UMA operação (uma coleta, um parse,
+ * uma linha de CSV). O harness aquece, calibra um lote que dure pelo menos
+ * min_trial_ns e mede trials lotes; cada lote vira um tempo por operação, e
+ * os percentis saem da distribuição dos lotes. Os resultados vão para JSON
+ * (um resultado por linha) e podem ser comparados com um baseline gravado
+ * pelo mesmo programa.
+ */
+
+#define BENCH_NAME_LEN 48
+#define BENCH_NOTE_LEN 96
+
+#define BENCH_DEFAULT_WARMUP 3          // lotes descartados antes de medir
+#define BENCH_DEFAULT_TRIALS 25         // lotes medidos
+#define BENCH_DEFAULT_MIN_TRIAL_MS 5    // duração mínima de cada lote
+#define BENCH_DEFAULT_THRESHOLD 10.0    // % de piora no p50 que conta como regressão
+
+// Executa uma operação. Retorna 0 ou -1 (o caso é abortado no primeiro erro).
+typedef int (*BenchFn)(void *ctx);
+
+typedef struct {
+    int warmup;
+    int trials;
+    long long min_trial_ns;
+    const char *root;          // árvore sintética medida (NULL: /proc e /sys do kernel)
+} BenchConfig;
+
+typedef struct {
+    char name[BENCH_NAME_LEN];
+    const char *group;         // "coletor", "parser", "saida"
+    int skipped;               // 1 se o caso não pôde rodar nesta máquina
+    char note[BENCH_NOTE_LEN]; // motivo do skip ou observação
+    int trials;
+    long long batch;           // operações por lote
+    double mean_ns, stddev_ns; // por operação
+    double min_ns, p50_ns, p90_ns, p99_ns, max_ns;
+} BenchResult;
+
+void bench_config_default(BenchConfig *config);
+
+long long bench_now_ns(void);
+
+/**
+ * Mede um caso
+ * @param config Aquecimento, lotes e duração mínima do lote
+ * @param fn Operação medida
+ * @param ctx Repassado a fn
+ * @param result Preenchido com os tempos por operação (name/group ficam com o chamador)
+ * @return 0 em sucesso, -1 se fn falhou
+ */
+int bench_run(const BenchConfig *config, BenchFn fn, void *ctx, BenchResult *result);
+
+// Grava os resultados em JSON. Retorna 0 ou -1.
+int bench_write_json(const char *path, const BenchConfig *config,
+                     const BenchResult *results, int count);
+
+/**
+ * Compara com um baseline gravado por bench_write_json (mediana contra mediana)
+ * @param threshold_pct Piora percentual no p50 a partir da qual o caso é regressão
+ * @param out Onde imprimir a tabela da comparação
+ * @return Número de regressões, ou -1 se o baseline não pôde ser lido
+ */
+int bench_compare(const char *baseline_path, const BenchResult *results, int count,
+                  double threshold_pct, FILE *out);
+
+#endif
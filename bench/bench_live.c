@@ -0,0 +1,185 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "live.h"
+
+/*
+ * Benchmark do segmento compartilhado (live.c): vazão dos leitores com o
+ * escritor parado e com o escritor atualizando os slots sem pausa (muito
+ * acima da cadência real de 1 coleta/s por alvo), com 1, 2 e 4 leitores.
+ *
+ * Cada leitor tem o próprio mapeamento (como um processo separado) e
+ * percorre todos os slots como o "top" faz. O escritor grava registros
+ * em que seq, cpu_percent e rss_bytes andam juntos; um leitor que visse
+ * uma escrita pela metade contaria uma cópia inconsistente (deve ser 0).
+ *
+ * Uso: ./bench_live [segundos por caso] [slots]
+ */
+
+#define DEFAULT_SECONDS 2
+#define DEFAULT_SLOTS 1024
+
+typedef struct {
+    char name[64];
+    unsigned slots;
+    atomic_int stop;
+    atomic_int writer_on;           // 0 = abrindo, 1 = parado, 2 = escrevendo, 3 = sair, -1 = falhou
+} Shared;
+
+typedef struct {
+    Shared *shared;
+    pthread_t thread;
+    unsigned long long reads;
+    unsigned long long retries;
+    unsigned long long torn;
+    atomic_ullong updates;
+} Worker;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void fill(SampleRecord *rec, pid_t pid, unsigned long long seq, long long sampled_ns) {
+    rec->pid = pid;
+    rec->seq = seq;
+    rec->sampled_ns = sampled_ns;
+    rec->flags = SAMPLE_HAS_CPU | SAMPLE_HAS_MEMORY;
+    rec->cpu.cpu_percent = (double)seq;
+    rec->memory.rss_bytes = seq * 4096;
+    rec->io.connections = seq ^ (unsigned long long)pid;
+}
+
+static int consistent(const SampleRecord *rec) {
+    return rec->cpu.cpu_percent == (double)rec->seq && rec->memory.rss_bytes == rec->seq * 4096 &&
+           rec->io.connections == (rec->seq ^ (unsigned long long)rec->pid);
+}
+
+static void *writer_main(void *arg) {
+    Worker *w = arg;
+    LiveWriter writer;
+    if (live_writer_open(&writer, w->shared->name, w->shared->slots) != 0) {
+        atomic_store(&w->shared->writer_on, -1);
+        return NULL;
+    }
+
+    SampleRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    unsigned long long seq = 0;
+    // Ocupa todos os slots antes de os leitores começarem
+    for (unsigned s = 0; s < w->shared->slots; s++) {
+        fill(&rec, (pid_t)(s + 1), ++seq, now_ns());
+        live_writer_update(&writer, &rec);
+    }
+    atomic_store(&w->shared->writer_on, 1);
+
+    int state;
+    while ((state = atomic_load_explicit(&w->shared->writer_on, memory_order_relaxed)) != 3) {
+        if (state != 2) {
+            usleep(1000);  // parado: só mantém o segmento
+            continue;
+        }
+        long long sampled = now_ns();
+        for (unsigned s = 0; s < w->shared->slots; s++) {
+            fill(&rec, (pid_t)(s + 1), ++seq, sampled);
+            live_writer_update(&writer, &rec);
+        }
+        atomic_store_explicit(&w->updates, atomic_load_explicit(&w->updates, memory_order_relaxed) + w->shared->slots,
+                              memory_order_relaxed);
+    }
+    live_writer_close(&writer);
+    return NULL;
+}
+
+static void *reader_main(void *arg) {
+    Worker *w = arg;
+    LiveReader reader;
+    if (live_reader_open(&reader, w->shared->name) != 0) return NULL;
+
+    SampleRecord rec;
+    while (!atomic_load_explicit(&w->shared->stop, memory_order_relaxed)) {
+        unsigned n = live_reader_slots(&reader);
+        for (unsigned s = 0; s < n; s++) {
+            if (live_read_slot(&reader, s, &rec) != 1) continue;
+            w->reads++;
+            if (!consistent(&rec)) w->torn++;
+        }
+    }
+    w->retries = reader.retries;
+    live_reader_close(&reader);
+    return NULL;
+}
+
+static void run_case(Shared *shared, Worker *writer, int readers, int writing, int seconds) {
+    Worker workers[4];
+    memset(workers, 0, sizeof(workers));
+    atomic_store(&shared->stop, 0);
+    atomic_store(&shared->writer_on, writing ? 2 : 1);
+    unsigned long long updates_before = atomic_load(&writer->updates);
+
+    long long start = now_ns();
+    for (int r = 0; r < readers; r++) {
+        workers[r].shared = shared;
+        pthread_create(&workers[r].thread, NULL, reader_main, &workers[r]);
+    }
+    sleep((unsigned)seconds);
+    atomic_store(&shared->stop, 1);
+    for (int r = 0; r < readers; r++) pthread_join(workers[r].thread, NULL);
+    double secs = (now_ns() - start) / 1e9;
+    unsigned long long updates = atomic_load(&writer->updates) - updates_before;
+    atomic_store(&shared->writer_on, 1);
+
+    unsigned long long reads = 0, retries = 0, torn = 0;
+    for (int r = 0; r < readers; r++) {
+        reads += workers[r].reads;
+        retries += workers[r].retries;
+        torn += workers[r].torn;
+    }
+    printf("%-9s %8d %14.2f %12.1f %12.4f %14llu %14.2f\n", writing ? "ativo" : "parado", readers,
+           reads / secs / 1e6, reads ? secs * 1e9 * readers / reads : 0.0,
+           reads ? (double)retries / reads : 0.0, torn, updates / secs / 1e6);
+}
+
+int main(int argc, char **argv) {
+    int seconds = argc > 1 ? atoi(argv[1]) : DEFAULT_SECONDS;
+    if (seconds <= 0) seconds = DEFAULT_SECONDS;
+    unsigned slots = argc > 2 ? (unsigned)atoi(argv[2]) : DEFAULT_SLOTS;
+    if (slots == 0) slots = DEFAULT_SLOTS;
+
+    Shared shared;
+    memset(&shared, 0, sizeof(shared));
+    snprintf(shared.name, sizeof(shared.name), "/rm-bench-live-%d", (int)getpid());
+    shared.slots = slots;
+
+    // O escritor vive o benchmark inteiro; os casos só o ligam e desligam
+    Worker writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.shared = &shared;
+    pthread_create(&writer.thread, NULL, writer_main, &writer);
+    while (atomic_load(&shared.writer_on) == 0) usleep(1000);
+    if (atomic_load(&shared.writer_on) < 0) {
+        pthread_join(writer.thread, NULL);
+        return 1;
+    }
+
+    printf("===== BENCHMARK SEGMENTO COMPARTILHADO =====\n");
+    printf("%u slots de %zu bytes | %d s por caso | %ld CPUs\n\n", slots, LIVE_SLOT_SIZE, seconds,
+           sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-9s %8s %14s %12s %12s %14s %14s\n", "ESCRITOR", "LEITORES", "LEITURAS(M/s)", "ns/LEITURA",
+           "RETRY/LEIT", "INCONSISTENTES", "ESCRITAS(M/s)");
+
+    static const int reader_counts[] = { 1, 2, 4 };
+    for (int writing = 0; writing <= 1; writing++)
+        for (size_t c = 0; c < sizeof(reader_counts) / sizeof(reader_counts[0]); c++)
+            run_case(&shared, &writer, reader_counts[c], writing, seconds);
+
+    atomic_store(&shared.writer_on, 3);
+    pthread_join(writer.thread, NULL);
+    return 0;
+}
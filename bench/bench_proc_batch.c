@@ -0,0 +1,269 @@
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#include "proc_batch.h"
+#include "proc_parse.h"
+
+/*
+ * Benchmark das leituras de um ciclo com muitos arquivos: proc_read_file
+ * (open/read/read/close por arquivo, como os coletores fazem hoje) contra
+ * o lote com pread e com io_uring (proc_batch.c).
+ *
+ * Mede syscalls por ciclo (contador de proc_parse.c, exato porque todas as
+ * leituras passam por ele) e latência do ciclo (mediana e máximo).
+ *
+ * Os arquivos são os de /proc/<pid> e /proc/<pid>/task/<tid> que existem
+ * na máquina; uma máquina de teste raramente tem processos suficientes
+ * para 10k ou 50k arquivos, então o restante é completado com arquivos
+ * em um diretório temporário (tmpfs quando /dev/shm existe) com o
+ * conteúdo de /proc/self/stat. A coluna PROC mostra quantos são reais.
+ *
+ * Uso: ./bench_proc_batch [ciclos]
+ */
+
+#define DEFAULT_TICKS 20
+#define READ_BUF 4096
+
+static const char *const per_task_files[] = {
+    "stat", "statm", "status", "io", "schedstat", "wchan", "oom_score", "cgroup", "limits", "comm",
+};
+
+typedef struct {
+    char **paths;
+    size_t count;
+    size_t real;           // quantos são de /proc
+    char tmpdir[256];
+} FileSet;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int cmp_ll(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+static int add_path(FileSet *set, size_t want, const char *path) {
+    if (set->count >= want) return 0;
+    if (access(path, R_OK) != 0) return 1;
+    set->paths[set->count] = strdup(path);
+    if (!set->paths[set->count]) return -1;
+    set->count++;
+    return 1;
+}
+
+// Arquivos reais de /proc: todos os processos e, depois, suas threads
+static void collect_proc(FileSet *set, size_t want) {
+
+    DIR *proc = opendir("/proc");
+    if (!proc) return;
+
+    struct dirent *de;
+    while (set->count < want && (de = readdir(proc)) != NULL) {
+        if (de->d_name[0] < '1' || de->d_name[0] > '9') continue;
+
+        char taskdir[300];
+        snprintf(taskdir, sizeof(taskdir), "/proc/%s/task", de->d_name);
+        DIR *tasks = opendir(taskdir);
+        if (!tasks) continue;
+
+        struct dirent *te;
+        while (set->count < want && (te = readdir(tasks)) != NULL) {
+            if (te->d_name[0] < '1' || te->d_name[0] > '9') continue;
+            for (size_t k = 0; k < sizeof(per_task_files) / sizeof(per_task_files[0]); k++) {
+                char path[600];
+                if (strcmp(te->d_name, de->d_name) == 0) {
+                    snprintf(path, sizeof(path), "/proc/%s/%s", de->d_name, per_task_files[k]);
+                } else {
+                    snprintf(path, sizeof(path), "/proc/%s/task/%s/%s", de->d_name, te->d_name, per_task_files[k]);
+                }
+                add_path(set, want, path);
+            }
+        }
+        closedir(tasks);
+    }
+    closedir(proc);
+}
+
+// Completa com arquivos temporários do tamanho de um /proc/<pid>/stat
+static int fill_tmp(FileSet *set, size_t want) {
+
+    if (set->count >= want) return 0;
+
+    char content[READ_BUF];
+    ssize_t len = proc_read_file("/proc/self/stat", content, sizeof(content));
+    if (len <= 0) return -1;
+
+    const char *base = access("/dev/shm", W_OK) == 0 ? "/dev/shm" : "/tmp";
+    snprintf(set->tmpdir, sizeof(set->tmpdir), "%s/bench_proc_batch.XXXXXX", base);
+    if (!mkdtemp(set->tmpdir)) {
+        fprintf(stderr, "Erro: nao foi possivel criar diretorio temporario\n");
+        set->tmpdir[0] = '\0';
+        return -1;
+    }
+
+    for (size_t i = 0; set->count < want; i++) {
+        char path[320];
+        snprintf(path, sizeof(path), "%s/f%zu", set->tmpdir, i);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd == -1 || write(fd, content, (size_t)len) != len) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", path);
+            if (fd != -1) close(fd);
+            return -1;
+        }
+        close(fd);
+        set->paths[set->count++] = strdup(path);
+    }
+    return 0;
+}
+
+static int fileset_build(FileSet *set, size_t want) {
+    memset(set, 0, sizeof(*set));
+    set->paths = calloc(want, sizeof(char *));
+    if (!set->paths) return -1;
+    collect_proc(set, want);
+    set->real = set->count;
+    return fill_tmp(set, want);
+}
+
+static void fileset_free(FileSet *set) {
+    for (size_t i = 0; i < set->count; i++) {
+        if (set->tmpdir[0] && i >= set->real) unlink(set->paths[i]);
+        free(set->paths[i]);
+    }
+    if (set->tmpdir[0]) rmdir(set->tmpdir);
+    free(set->paths);
+}
+
+typedef struct {
+    double syscalls_per_tick;
+    double median_ms;
+    double max_ms;
+    size_t ok;             // arquivos lidos com sucesso no último ciclo
+} TickStats;
+
+static void summarize(long long *lat, int ticks, unsigned long long syscalls, TickStats *out) {
+    qsort(lat, (size_t)ticks, sizeof(long long), cmp_ll);
+    out->syscalls_per_tick = (double)syscalls / ticks;
+    out->median_ms = lat[ticks / 2] / 1e6;
+    out->max_ms = lat[ticks - 1] / 1e6;
+}
+
+// Caminho atual dos coletores: proc_read_file por arquivo
+static void run_direct(const FileSet *set, int ticks, TickStats *out) {
+    long long *lat = calloc((size_t)ticks, sizeof(long long));
+    char buf[READ_BUF];
+    if (!lat) return;
+
+    unsigned long long before = proc_read_syscalls();
+    for (int t = 0; t < ticks; t++) {
+        long long t0 = now_ns();
+        size_t ok = 0;
+        for (size_t i = 0; i < set->count; i++) {
+            if (proc_read_file(set->paths[i], buf, sizeof(buf)) >= 0) ok++;
+        }
+        lat[t] = now_ns() - t0;
+        out->ok = ok;
+    }
+    summarize(lat, ticks, proc_read_syscalls() - before, out);
+    free(lat);
+}
+
+static int run_batch(const FileSet *set, ProcBatchBackend backend, int ticks, TickStats *out, const char **name) {
+    ProcBatch batch;
+    long long *lat = calloc((size_t)ticks, sizeof(long long));
+    if (!lat || proc_batch_init(&batch, backend) != 0) {
+        free(lat);
+        return -1;
+    }
+    batch.learning = 0;
+    *name = proc_batch_backend_name(&batch);
+
+    // Threads que terminaram desde a coleta ficam de fora (e fora de LIDOS)
+    for (size_t i = 0; i < set->count; i++) proc_batch_add(&batch, set->paths[i]);
+    proc_batch_read_all(&batch);  // aquecimento: registra arquivos e buffers
+
+    unsigned long long before = proc_read_syscalls();
+    for (int t = 0; t < ticks; t++) {
+        long long t0 = now_ns();
+        out->ok = (size_t)proc_batch_read_all(&batch);
+        lat[t] = now_ns() - t0;
+    }
+    summarize(lat, ticks, proc_read_syscalls() - before, out);
+    *name = proc_batch_backend_name(&batch);  // pode ter caído para pread
+
+    proc_batch_free(&batch);
+    free(lat);
+    return 0;
+}
+
+static void print_row(size_t files, size_t real, const char *mode, const TickStats *s) {
+    printf("%8zu %7zu  %-10s %14.1f %12.3f %10.3f %8zu\n",
+           files, real, mode, s->syscalls_per_tick, s->median_ms, s->max_ms, s->ok);
+}
+
+int main(int argc, char **argv) {
+    int ticks = argc > 1 ? atoi(argv[1]) : DEFAULT_TICKS;
+    if (ticks <= 0) ticks = DEFAULT_TICKS;
+
+    static const size_t sizes[] = { 1000, 10000, 50000 };
+    size_t largest = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+
+    // O lote mantém todos os arquivos abertos; root pode subir o limite rígido
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    if (rl.rlim_cur < largest + 64) {
+        struct rlimit want = { largest + 64, rl.rlim_max > largest + 64 ? rl.rlim_max : largest + 64 };
+        if (setrlimit(RLIMIT_NOFILE, &want) == 0) rl = want;
+        else if (rl.rlim_cur < rl.rlim_max) {
+            rl.rlim_cur = rl.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &rl);
+        }
+    }
+
+    printf("===== BENCHMARK LEITURAS EM LOTE =====\n");
+    printf("%d ciclos por caso | limite de arquivos abertos: %llu\n\n", ticks, (unsigned long long)rl.rlim_cur);
+    printf("%8s %7s  %-10s %14s %12s %10s %8s\n", "ARQUIVOS", "PROC", "MODO", "SYSCALLS/CICLO", "MEDIANA(ms)", "MAX(ms)", "LIDOS");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t n = sizes[s];
+        if (n + 32 > rl.rlim_cur) {
+            printf("%8zu  (pulado: o lote precisa de %zu arquivos abertos; suba o limite com ulimit -n)\n", n, n + 32);
+            continue;
+        }
+
+        FileSet set;
+        if (fileset_build(&set, n) != 0) {
+            fileset_free(&set);
+            return 1;
+        }
+
+        TickStats st;
+        const char *name;
+        memset(&st, 0, sizeof(st));
+        run_direct(&set, ticks, &st);
+        print_row(n, set.real, "open+read", &st);
+
+        memset(&st, 0, sizeof(st));
+        if (run_batch(&set, PROC_BATCH_PREAD, ticks, &st, &name) == 0) print_row(n, set.real, name, &st);
+
+        memset(&st, 0, sizeof(st));
+        if (run_batch(&set, PROC_BATCH_URING, ticks, &st, &name) == 0) {
+            if (strcmp(name, "io_uring") != 0) name = "(sem uring)";
+            print_row(n, set.real, name, &st);
+        }
+        printf("\n");
+        fileset_free(&set);
+    }
+
+    return 0;
+}
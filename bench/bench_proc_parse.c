@@ -0,0 +1,283 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "proc_parse.h"
+
+/*
+ * Microbenchmark do parser de /proc: compara o sscanf usado antes pelos
+ * coletores com proc_parse.c sobre amostras reais capturadas em bench/samples/.
+ *
+ * Só o parsing é medido (o arquivo já está em memória), para isolar o custo
+ * que o kernel não paga por nós.
+ *
+ * Uso: ./bench_proc_parse [diretorio_das_amostras]
+ */
+
+#define MIN_BENCH_NS 200000000LL  // roda cada caso por pelo menos 200 ms
+#define TCP_REPLICAS 5000         // linhas de net/tcp (servidor com muitas conexões)
+
+static volatile unsigned long long sink;  // impede o compilador de descartar o resultado
+
+typedef struct {
+    const char *buf;
+    size_t len;
+} Sample;
+
+typedef unsigned long long (*ParseFn)(const Sample *s);
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static char *load_sample(const char *dir, const char *name, size_t *len_out) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    char *buf = malloc((size_t)size + 1);
+    if (!buf || fread(buf, 1, (size_t)size, fp) != (size_t)size) {
+        fprintf(stderr, "Erro: nao foi possivel ler %s\n", path);
+        free(buf);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+
+    buf[size] = '\0';
+    *len_out = (size_t)size;
+    return buf;
+}
+
+/* ------------------------- versões com sscanf ------------------------- */
+
+// Itera pelas linhas como o fgets fazia, copiando cada uma para um buffer
+#define FOR_EACH_LINE(s, line)                                                   \
+    for (const char *_p = (s)->buf, *_nl; *_p && (_nl = strchr(_p, '\n'), 1);    \
+         _p = _nl ? _nl + 1 : _p + strlen(_p))                                   \
+        for (int _once = (snprintf(line, sizeof(line), "%.*s",                   \
+                                   (int)(_nl ? _nl - _p + 1 : (long)strlen(_p)), \
+                                   _p), 1); _once; _once = 0)
+
+static unsigned long long legacy_pid_stat(const Sample *s) {
+    unsigned long long utime = 0, stime = 0;
+    long threads = 0;
+    const char *p = strrchr(s->buf, ')') + 1;
+    sscanf(p,
+           " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u "
+           "%llu %llu "
+           "%*d %*d %*d %*d "
+           "%ld",
+           &utime, &stime, &threads);
+    return utime + stime + (unsigned long long)threads;
+}
+
+static unsigned long long legacy_pid_status(const Sample *s) {
+    char line[256];
+    unsigned long long voluntary = 0, nonvoluntary = 0;
+    FOR_EACH_LINE(s, line) {
+        if (sscanf(line, "voluntary_ctxt_switches: %llu", &voluntary) == 1) continue;
+        if (sscanf(line, "nonvoluntary_ctxt_switches: %llu", &nonvoluntary) == 1) continue;
+    }
+    return voluntary + nonvoluntary;
+}
+
+static unsigned long long legacy_pid_io(const Sample *s) {
+    char line[256];
+    unsigned long long rb = 0, wb = 0, r = 0, w = 0;
+    FOR_EACH_LINE(s, line) {
+        if (sscanf(line, "read_bytes: %llu", &rb) == 1) continue;
+        if (sscanf(line, "write_bytes: %llu", &wb) == 1) continue;
+        if (sscanf(line, "syscr: %llu", &r) == 1) continue;
+        if (sscanf(line, "syscw: %llu", &w) == 1) continue;
+    }
+    return rb + wb + r + w;
+}
+
+static unsigned long long legacy_pid_statm(const Sample *s) {
+    unsigned long long size = 0, resident = 0;
+    sscanf(s->buf, "%llu %llu %*u %*u %*u %*u %*u", &size, &resident);
+    return size + resident;
+}
+
+static unsigned long long legacy_proc_stat(const Sample *s) {
+    unsigned long long f[10] = {0};
+    sscanf(s->buf, "%*s %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+           &f[0], &f[1], &f[2], &f[3], &f[4], &f[5], &f[6], &f[7], &f[8], &f[9]);
+    return f[0] + f[3];
+}
+
+static unsigned long long legacy_net_tcp(const Sample *s) {
+    char line[512];
+    unsigned long long count = 0;
+    int header = 1;
+    FOR_EACH_LINE(s, line) {
+        unsigned int state;
+        if (header) { header = 0; continue; }
+        if (sscanf(line, "%*d: %*x:%*x %*x:%*x %x", &state) == 1 && state == 0x01) count++;
+    }
+    return count;
+}
+
+/* ----------------------- versões com proc_parse ----------------------- */
+
+static unsigned long long fast_pid_stat(const Sample *s) {
+    unsigned long long utime = 0, stime = 0, threads = 0;
+    const char *end = s->buf + s->len;
+    const char *p = strrchr(s->buf, ')') + 1;
+    p = proc_skip_fields(p, end, 11);
+    if (p) p = proc_parse_u64(p, end, &utime);
+    if (p) p = proc_parse_u64(p, end, &stime);
+    if (p) p = proc_skip_fields(p, end, 4);
+    if (p) p = proc_parse_u64(p, end, &threads);
+    return utime + stime + threads;
+}
+
+static unsigned long long fast_pid_status(const Sample *s) {
+    static const char *const keys[] = { "voluntary_ctxt_switches", "nonvoluntary_ctxt_switches" };
+    static ProcKeyTable table;
+    static int ready = 0;
+    if (!ready) { proc_key_table_init(&table, keys, 2); ready = 1; }
+    unsigned long long v[2] = {0, 0};
+    proc_parse_kv(s->buf, s->len, &table, v);
+    return v[0] + v[1];
+}
+
+static unsigned long long fast_pid_io(const Sample *s) {
+    static const char *const keys[] = { "read_bytes", "write_bytes", "syscr", "syscw" };
+    static ProcKeyTable table;
+    static int ready = 0;
+    if (!ready) { proc_key_table_init(&table, keys, 4); ready = 1; }
+    unsigned long long v[4] = {0, 0, 0, 0};
+    proc_parse_kv(s->buf, s->len, &table, v);
+    return v[0] + v[1] + v[2] + v[3];
+}
+
+static unsigned long long fast_pid_statm(const Sample *s) {
+    unsigned long long size = 0, resident = 0;
+    const char *p = proc_parse_u64(s->buf, s->buf + s->len, &size);
+    if (p) proc_parse_u64(p, s->buf + s->len, &resident);
+    return size + resident;
+}
+
+static unsigned long long fast_proc_stat(const Sample *s) {
+    unsigned long long f[10] = {0};
+    const char *end = proc_next_line(s->buf, s->buf + s->len);
+    const char *p = s->buf + 3;
+    for (int n = 0; n < 10 && (p = proc_parse_u64(p, end, &f[n])) != NULL; n++) {
+    }
+    return f[0] + f[3];
+}
+
+static unsigned long long fast_net_tcp(const Sample *s) {
+    const char *end = s->buf + s->len;
+    const char *line = proc_next_line(s->buf, end);  // pula o cabeçalho
+    unsigned long long count = 0;
+    while (line < end) {
+        const char *next = proc_next_line(line, end);
+        unsigned long long state = 0;
+        const char *p = proc_skip_fields(line, next, 3);
+        if (p && proc_parse_hex(p, next, &state) && state == 0x01) count++;
+        line = next;
+    }
+    return count;
+}
+
+/* ------------------------------ execução ------------------------------ */
+
+static double bench_ns_per_op(ParseFn fn, const Sample *s) {
+    unsigned long long acc = 0;
+    long long iterations = 0;
+    long long batch = 64;
+    long long start = now_ns();
+    long long elapsed = 0;
+
+    while (elapsed < MIN_BENCH_NS) {
+        for (long long i = 0; i < batch; i++) acc += fn(s);
+        iterations += batch;
+        elapsed = now_ns() - start;
+        if (batch < (1 << 20)) batch *= 2;
+    }
+
+    sink = acc;
+    return (double)elapsed / (double)iterations;
+}
+
+int main(int argc, char **argv) {
+    const char *dir = argc > 1 ? argv[1] : "bench/samples";
+
+    struct {
+        const char *file;
+        ParseFn legacy;
+        ParseFn fast;
+    } cases[] = {
+        { "pid_stat.txt",   legacy_pid_stat,   fast_pid_stat   },
+        { "pid_status.txt", legacy_pid_status, fast_pid_status },
+        { "pid_io.txt",     legacy_pid_io,     fast_pid_io     },
+        { "pid_statm.txt",  legacy_pid_statm,  fast_pid_statm  },
+        { "proc_stat.txt",  legacy_proc_stat,  fast_proc_stat  },
+        { "net_tcp.txt",    legacy_net_tcp,    fast_net_tcp    },
+    };
+    int ncases = (int)(sizeof(cases) / sizeof(cases[0]));
+
+    printf("===== BENCHMARK PROC PARSE =====\n");
+    printf("Amostras: %s\n\n", dir);
+    printf("%-16s %10s %14s %15s %9s\n", "ARQUIVO", "BYTES", "SSCANF (ns)", "PROC_PARSE (ns)", "SPEEDUP");
+
+    for (int i = 0; i < ncases; i++) {
+        size_t len = 0;
+        char *buf = load_sample(dir, cases[i].file, &len);
+        if (!buf) return 1;
+
+        // net/tcp capturado tem poucas conexões: replica as linhas de dados
+        // para representar um servidor ocupado (mantendo o formato real)
+        if (strcmp(cases[i].file, "net_tcp.txt") == 0) {
+            const char *rows = strchr(buf, '\n') + 1;
+            size_t header_len = (size_t)(rows - buf);
+            size_t rows_len = len - header_len;
+            char *big = malloc(header_len + rows_len * TCP_REPLICAS + 1);
+            if (!big) {
+                free(buf);
+                return 1;
+            }
+            memcpy(big, buf, header_len);
+            for (int r = 0; r < TCP_REPLICAS; r++) {
+                memcpy(big + header_len + rows_len * (size_t)r, rows, rows_len);
+            }
+            len = header_len + rows_len * TCP_REPLICAS;
+            big[len] = '\0';
+            free(buf);
+            buf = big;
+        }
+
+        Sample s = { buf, len };
+
+        // Os dois parsers precisam concordar antes de comparar velocidade
+        if (cases[i].legacy(&s) != cases[i].fast(&s)) {
+            fprintf(stderr, "Erro: resultados diferentes para %s\n", cases[i].file);
+            free(buf);
+            return 1;
+        }
+
+        double legacy_ns = bench_ns_per_op(cases[i].legacy, &s);
+        double fast_ns = bench_ns_per_op(cases[i].fast, &s);
+
+        printf("%-16s %10zu %14.1f %15.1f %8.1fx\n",
+               cases[i].file, len, legacy_ns, fast_ns, legacy_ns / fast_ns);
+        free(buf);
+    }
+
+    return 0;
+}
@@ -0,0 +1,549 @@
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench_harness.h"
+#include "cgroup.h"
+#include "monitor.h"
+#include "namespace.h"
+#include "pipeline.h"
+#include "proc_parse.h"
+#include "stats.h"
+
+/*
+ * Suíte de microbenchmarks do monitor (make bench).
+ *
+ * Coletores: uma chamada de *_sample sobre o próprio processo (o custo é
+ * dominado pelos arquivos lidos, não pelo alvo). Parsers: proc_parse.c sobre
+ * as amostras de bench/samples/, já em memória. Saída: uma linha de cada
+ * CSV e um registro do destino binário, gravados num diretório temporário,
+ * e um registro no resumo em fluxo (stats.h).
+ *
+ * Com --root DIR os coletores leem a árvore sintética de fixture_gen
+ * (DIR/proc e DIR/sys) e o alvo passa a ser o pid 1 dela, raiz de todos os
+ * processos: proc_tree_scan varre a árvore inteira, io_monitor_sample conta
+ * todas as linhas de net/tcp e generate_namespace_report lê os links de ns
+ * de todos os pids.
+ *
+ * Uso: ./bench_suite [--json arq] [--compare baseline.json] [--threshold pct]
+ *                    [--trials N] [--warmup N] [--min-time-ms N]
+ *                    [--filter texto] [--samples dir] [--root DIR [--pid N]]
+ * Sai com 2 se a comparação encontrar regressões.
+ */
+
+#define MAX_CASES 64
+
+static volatile unsigned long long sink;  // impede o compilador de descartar o resultado
+
+/* ----------------------------- coletores ----------------------------- */
+
+static CpuMonitorState cpu_state;
+static MemoryMonitorState memory_state;
+static IoMonitorState io_state;
+static ThreadMonitorState thread_state;
+static SystemCpuState system_state;
+static SchedMonitorState sched_state;
+static pid_t target_pid;
+
+static CpuSample cpu_sample;
+static MemorySample memory_sample;
+static IoSample io_sample;
+
+static char cgroup_group[256];        // cgroup v2 do próprio processo, relativo à raiz
+static char namespace_report_path[512];
+
+static int bench_cpu_sample(void *ctx) {
+    (void)ctx;
+    return cpu_monitor_sample(&cpu_state, &cpu_sample);
+}
+
+static int bench_memory_sample(void *ctx) {
+    (void)ctx;
+    return memory_monitor_sample(&memory_state, &memory_sample);
+}
+
+static int bench_io_sample(void *ctx) {
+    (void)ctx;
+    return io_monitor_sample(&io_state, &io_sample, 1.0);
+}
+
+static int bench_thread_sample(void *ctx) {
+    (void)ctx;
+    ThreadSample top[5];
+    return thread_monitor_sample(&thread_state, top, 5) < 0 ? -1 : 0;
+}
+
+static int bench_system_cpu_sample(void *ctx) {
+    (void)ctx;
+    SystemCpuSample sample;
+    return system_cpu_sample(&system_state, &sample);
+}
+
+static int bench_sched_sample(void *ctx) {
+    (void)ctx;
+    SchedSample sample;
+    return sched_monitor_sample(&sched_state, &sample);
+}
+
+static int bench_cgroup_io_stats(void *ctx) {
+    (void)ctx;
+    CgroupIOStats stats = cgroup_get_io_stats(cgroup_group);
+    return stats.rbytes < 0 ? -1 : 0;
+}
+
+// Varredura completa: todos os pids lidos e o fecho de descendentes do alvo
+static int bench_proc_tree_scan(void *ctx) {
+    (void)ctx;
+    ProcTreeState tree;
+    if (proc_tree_init(&tree, target_pid) != 0) return -1;
+    sink += (unsigned long long)tree.nmembers;
+    proc_tree_free(&tree);
+    return 0;
+}
+
+static int bench_namespace_report(void *ctx) {
+    (void)ctx;
+    generate_namespace_report(namespace_report_path);
+    return 0;
+}
+
+// Acha o cgroup v2 do alvo ("0::/caminho" em /proc/<pid>/cgroup)
+static int find_cgroup_v2(char *out, size_t size) {
+    char buf[4096], path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/cgroup", proc_root(), (int)target_pid);
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
+    if (len < 0) return -1;
+
+    for (char *line = buf; line && *line; ) {
+        char *nl = strchr(line, '\n');
+        if (nl) *nl = '\0';
+        if (strncmp(line, "0::/", 4) == 0) {
+            snprintf(out, size, "%s", line + 4);
+            return 0;
+        }
+        line = nl ? nl + 1 : NULL;
+    }
+    return -1;
+}
+
+/* ------------------------------ parsers ------------------------------ */
+
+typedef struct {
+    const char *file;
+    char *buf;
+    size_t len;
+} SampleFile;
+
+static char *load_sample(const char *dir, const char *name, size_t *len_out) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    char *buf = NULL;
+    size_t capacity = 0;
+    ssize_t len = proc_read_file_dyn(path, &buf, &capacity);
+    if (len < 0) {
+        fprintf(stderr, "Erro: nao foi possivel ler %s\n", path);
+        free(buf);
+        return NULL;
+    }
+    *len_out = (size_t)len;
+    return buf;
+}
+
+static int parse_pid_stat(void *ctx) {
+    const SampleFile *s = ctx;
+    unsigned long long utime = 0, stime = 0, threads = 0;
+    const char *end = s->buf + s->len;
+    const char *p = memrchr(s->buf, ')', s->len);
+    if (!p) return -1;
+    p = proc_skip_fields(p + 1, end, 11);
+    if (p) p = proc_parse_u64(p, end, &utime);
+    if (p) p = proc_parse_u64(p, end, &stime);
+    if (p) p = proc_skip_fields(p, end, 4);
+    if (p) p = proc_parse_u64(p, end, &threads);
+    sink += utime + stime + threads;
+    return p ? 0 : -1;
+}
+
+static int parse_pid_status(void *ctx) {
+    static const char *const keys[] = { "VmRSS", "VmSwap", "voluntary_ctxt_switches", "nonvoluntary_ctxt_switches" };
+    static ProcKeyTable table;
+    static int ready = 0;
+    const SampleFile *s = ctx;
+    if (!ready) {
+        if (proc_key_table_init(&table, keys, 4) != 0) return -1;
+        ready = 1;
+    }
+    unsigned long long v[4] = {0, 0, 0, 0};
+    sink += (unsigned long long)proc_parse_kv(s->buf, s->len, &table, v) + v[0] + v[2];
+    return 0;
+}
+
+static int parse_pid_io(void *ctx) {
+    static const char *const keys[] = { "read_bytes", "write_bytes", "syscr", "syscw" };
+    static ProcKeyTable table;
+    static int ready = 0;
+    const SampleFile *s = ctx;
+    if (!ready) {
+        if (proc_key_table_init(&table, keys, 4) != 0) return -1;
+        ready = 1;
+    }
+    unsigned long long v[4] = {0, 0, 0, 0};
+    sink += (unsigned long long)proc_parse_kv(s->buf, s->len, &table, v) + v[0] + v[1];
+    return 0;
+}
+
+static int parse_pid_statm(void *ctx) {
+    const SampleFile *s = ctx;
+    unsigned long long size = 0, resident = 0;
+    const char *p = proc_parse_u64(s->buf, s->buf + s->len, &size);
+    if (p) p = proc_parse_u64(p, s->buf + s->len, &resident);
+    sink += size + resident;
+    return p ? 0 : -1;
+}
+
+static int parse_proc_stat(void *ctx) {
+    const SampleFile *s = ctx;
+    const char *end = s->buf + s->len;
+    const char *line = s->buf;
+    unsigned long long total = 0;
+
+    // Todas as linhas cpu/cpuN, como system_cpu_sample
+    while (line < end && strncmp(line, "cpu", 3) == 0) {
+        const char *next = proc_next_line(line, end);
+        const char *p = proc_skip_fields(line, next, 1);
+        unsigned long long v;
+        for (int n = 0; n < CPU_STAT_FIELDS && p && (p = proc_parse_u64(p, next, &v)) != NULL; n++) total += v;
+        line = next;
+    }
+    sink += total;
+    return 0;
+}
+
+static int parse_net_tcp(void *ctx) {
+    const SampleFile *s = ctx;
+    const char *end = s->buf + s->len;
+    const char *line = proc_next_line(s->buf, end);  // pula o cabeçalho
+    unsigned long long count = 0;
+    while (line < end) {
+        const char *next = proc_next_line(line, end);
+        unsigned long long state = 0;
+        const char *p = proc_skip_fields(line, next, 3);
+        if (p && proc_parse_hex(p, next, &state) && state == 0x01) count++;
+        line = next;
+    }
+    sink += count;
+    return 0;
+}
+
+static char target_stat_path[PROC_PATH_MAX];
+
+static int read_self_stat(void *ctx) {
+    (void)ctx;
+    char buf[1024];
+    ssize_t len = proc_read_file(target_stat_path, buf, sizeof(buf));
+    sink += (unsigned long long)len;
+    return len < 0 ? -1 : 0;
+}
+
+/* ------------------------------- saída ------------------------------- */
+
+static SampleSink binary_sink;
+static SampleRecord binary_record;
+
+static int write_cpu_csv(void *ctx) {
+    (void)ctx;
+    return cpu_sample_csv_write(&cpu_sample);
+}
+
+static int write_memory_csv(void *ctx) {
+    (void)ctx;
+    return memory_sample_csv_write(&memory_sample);
+}
+
+static int write_io_csv(void *ctx) {
+    (void)ctx;
+    return io_sample_csv_write(&io_sample);
+}
+
+static int write_binary_record(void *ctx) {
+    (void)ctx;
+    return binary_sink.write(&binary_sink, &binary_record);
+}
+
+static StatsTable summary_table;
+
+// Resumo em fluxo: as 16 métricas do catálogo de um registro
+static int add_summary_record(void *ctx) {
+    (void)ctx;
+    binary_record.cpu.cpu_percent += 0.25;  // valores variados: percorre faixas diferentes
+    return stats_table_add(&summary_table, &binary_record);
+}
+
+// Apaga os arquivos gerados e o diretório temporário
+static void remove_scratch_dir(const char *dir) {
+    DIR *d = opendir(dir);
+    if (d) {
+        struct dirent *ent;
+        while ((ent = readdir(d)) != NULL) {
+            if (ent->d_name[0] == '.') continue;
+            unlinkat(dirfd(d), ent->d_name, 0);
+        }
+        closedir(d);
+    }
+    rmdir(dir);
+}
+
+/* ------------------------------ execução ------------------------------ */
+
+typedef struct {
+    const char *name;
+    const char *group;
+    BenchFn fn;
+    void *ctx;
+    const char *skip;  // não NULL: motivo para não rodar
+    int quiet;         // descarta o stdout do caso (mensagens de progresso)
+} BenchCase;
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+            "Uso: %s [--json arq] [--compare baseline.json] [--threshold pct]\n"
+            "          [--trials N] [--warmup N] [--min-time-ms N] [--filter texto] [--samples dir]\n"
+            "          [--root DIR [--pid N]]\n",
+            prog);
+}
+
+static void format_ns(double ns, char *buf, size_t size) {
+    if (ns < 1e3) snprintf(buf, size, "%.1f ns", ns);
+    else if (ns < 1e6) snprintf(buf, size, "%.2f us", ns / 1e3);
+    else snprintf(buf, size, "%.2f ms", ns / 1e6);
+}
+
+int main(int argc, char **argv) {
+
+    BenchConfig config;
+    bench_config_default(&config);
+
+    const char *json_path = NULL;
+    const char *baseline_path = NULL;
+    const char *filter = NULL;
+    const char *samples_dir = "bench/samples";
+    double threshold = BENCH_DEFAULT_THRESHOLD;
+    pid_t pid = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--json") == 0 && val) json_path = val;
+        else if (strcmp(arg, "--compare") == 0 && val) baseline_path = val;
+        else if (strcmp(arg, "--threshold") == 0 && val) threshold = atof(val);
+        else if (strcmp(arg, "--trials") == 0 && val) config.trials = atoi(val);
+        else if (strcmp(arg, "--warmup") == 0 && val) config.warmup = atoi(val);
+        else if (strcmp(arg, "--min-time-ms") == 0 && val) config.min_trial_ns = atoll(val) * 1000000LL;
+        else if (strcmp(arg, "--filter") == 0 && val) filter = val;
+        else if (strcmp(arg, "--samples") == 0 && val) samples_dir = val;
+        else if (strcmp(arg, "--root") == 0 && val) config.root = val;
+        else if (strcmp(arg, "--pid") == 0 && val) pid = (pid_t)atoi(val);
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    if (config.trials < 1 || config.warmup < 0 || config.min_trial_ns < 0 || threshold <= 0.0) {
+        fprintf(stderr, "Erro: parametros invalidos\n");
+        return 1;
+    }
+
+    /* Árvore sintética: as raízes mudam antes de qualquer coletor abrir arquivos */
+    if (config.root) {
+        char proc_dir[PROC_ROOT_MAX], sys_dir[PROC_ROOT_MAX];
+        if (snprintf(proc_dir, sizeof(proc_dir), "%s/proc", config.root) >= (int)sizeof(proc_dir) ||
+            snprintf(sys_dir, sizeof(sys_dir), "%s/sys", config.root) >= (int)sizeof(sys_dir) ||
+            proc_set_roots(proc_dir, sys_dir) != 0) {
+            fprintf(stderr, "Erro: raiz invalida: %s\n", config.root);
+            return 1;
+        }
+    }
+
+    /* Estado dos coletores: o próprio processo como alvo, ou a raiz da árvore sintética */
+    target_pid = pid > 0 ? pid : config.root ? 1 : getpid();
+    snprintf(target_stat_path, sizeof(target_stat_path), "%s/%d/stat", proc_root(), (int)target_pid);
+    if (cpu_monitor_init(&cpu_state, target_pid) != 0 ||
+        memory_monitor_init(&memory_state, target_pid, 0) != 0 ||
+        io_monitor_init(&io_state, target_pid) != 0 ||
+        thread_monitor_init(&thread_state, target_pid) != 0 ||
+        system_cpu_init(&system_state) != 0 ||
+        sched_monitor_init(&sched_state, target_pid) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel inicializar os coletores\n");
+        return 1;
+    }
+
+    // Primeira amostra de cada coletor: preenche os deltas e as amostras da saída
+    cpu_monitor_sample(&cpu_state, &cpu_sample);
+    memory_monitor_sample(&memory_state, &memory_sample);
+    io_monitor_sample(&io_state, &io_sample, 1.0);
+
+    const char *cgroup_skip = NULL;
+    char probe[8192], probe_path[512];
+    if (find_cgroup_v2(cgroup_group, sizeof(cgroup_group)) != 0) {
+        cgroup_skip = "processo fora de um cgroup v2";
+    } else {
+        snprintf(probe_path, sizeof(probe_path), "%s/fs/cgroup/%s/io.stat", sys_root(), cgroup_group);
+        if (proc_read_file(probe_path, probe, sizeof(probe)) < 0) cgroup_skip = "io.stat indisponivel (cgroup v1 ou controlador io desligado)";
+    }
+
+    /* Amostras dos parsers */
+    SampleFile files[] = {
+        { "pid_stat.txt", NULL, 0 }, { "pid_status.txt", NULL, 0 }, { "pid_io.txt", NULL, 0 },
+        { "pid_statm.txt", NULL, 0 }, { "proc_stat.txt", NULL, 0 }, { "net_tcp.txt", NULL, 0 },
+    };
+    int nfiles = (int)(sizeof(files) / sizeof(files[0]));
+    for (int i = 0; i < nfiles; i++) {
+        files[i].buf = load_sample(samples_dir, files[i].file, &files[i].len);
+        if (!files[i].buf) return 1;
+    }
+
+    /* Diretório temporário para os arquivos da saída e o relatório de namespaces */
+    char scratch[] = "/tmp/resource-monitor-bench-XXXXXX";
+    if (!mkdtemp(scratch)) {
+        perror("Erro ao criar diretorio temporario");
+        return 1;
+    }
+    snprintf(namespace_report_path, sizeof(namespace_report_path), "%s/namespace_report.csv", scratch);
+
+    int home = open(".", O_RDONLY | O_DIRECTORY);
+    if (home < 0 || chdir(scratch) != 0) {
+        perror("Erro ao entrar no diretorio temporario");
+        remove_scratch_dir(scratch);
+        return 1;
+    }
+
+    binary_record.pid = target_pid;
+    binary_record.flags = SAMPLE_HAS_CPU | SAMPLE_HAS_MEMORY | SAMPLE_HAS_IO;
+    binary_record.cpu = cpu_sample;
+    binary_record.memory = memory_sample;
+    binary_record.io = io_sample;
+    int binary_ok = sample_sink_binary(&binary_sink, "bench.bin") == 0;
+
+    BenchCase cases[] = {
+        { "cpu_monitor_sample",        "coletor", bench_cpu_sample,        NULL, NULL, 0 },
+        { "memory_monitor_sample",     "coletor", bench_memory_sample,     NULL, NULL, 0 },
+        { "io_monitor_sample",         "coletor", bench_io_sample,         NULL, NULL, 0 },
+        { "thread_monitor_sample",     "coletor", bench_thread_sample,     NULL, NULL, 0 },
+        { "system_cpu_sample",         "coletor", bench_system_cpu_sample, NULL, NULL, 0 },
+        { "sched_monitor_sample",      "coletor", bench_sched_sample,      NULL, NULL, 0 },
+        { "cgroup_get_io_stats",       "coletor", bench_cgroup_io_stats,   NULL, cgroup_skip, 0 },
+        { "proc_tree_scan",            "coletor", bench_proc_tree_scan,    NULL, NULL, 0 },
+        { "generate_namespace_report", "coletor", bench_namespace_report,  NULL, NULL, 1 },
+        { "proc_read_file/self_stat",  "parser",  read_self_stat,          NULL, NULL, 0 },
+        { "parse/pid_stat",            "parser",  parse_pid_stat,          &files[0], NULL, 0 },
+        { "parse/pid_status",          "parser",  parse_pid_status,        &files[1], NULL, 0 },
+        { "parse/pid_io",              "parser",  parse_pid_io,            &files[2], NULL, 0 },
+        { "parse/pid_statm",           "parser",  parse_pid_statm,         &files[3], NULL, 0 },
+        { "parse/proc_stat",           "parser",  parse_proc_stat,         &files[4], NULL, 0 },
+        { "parse/net_tcp",             "parser",  parse_net_tcp,           &files[5], NULL, 0 },
+        { "cpu_sample_csv_write",      "saida",   write_cpu_csv,           NULL, NULL, 0 },
+        { "memory_sample_csv_write",   "saida",   write_memory_csv,        NULL, NULL, 0 },
+        { "io_sample_csv_write",       "saida",   write_io_csv,            NULL, NULL, 0 },
+        { "sample_sink_binary",        "saida",   write_binary_record,     NULL, binary_ok ? NULL : "destino binario indisponivel", 0 },
+        { "stats_table_add",           "saida",   add_summary_record,      NULL, NULL, 0 },
+    };
+    int ncases = (int)(sizeof(cases) / sizeof(cases[0]));
+
+    static BenchResult results[MAX_CASES];
+    int nresults = 0;
+    int status = 0;
+
+    printf("===== MICROBENCHMARKS =====\n");
+    if (config.root) printf("Arvore sintetica: %s (alvo: pid %d)\n", config.root, (int)target_pid);
+    printf("Aquecimento: %d lotes | lotes medidos: %d | lote minimo: %lld ms\n\n",
+           config.warmup, config.trials, config.min_trial_ns / 1000000LL);
+    printf("%-32s %-8s %10s %10s %10s %10s %9s\n", "CASO", "GRUPO", "MIN", "P50", "P90", "P99", "LOTE");
+
+    for (int i = 0; i < ncases && nresults < MAX_CASES; i++) {
+        if (filter && !strstr(cases[i].name, filter)) continue;
+
+        BenchResult *r = &results[nresults++];
+        memset(r, 0, sizeof(*r));
+        snprintf(r->name, sizeof(r->name), "%s", cases[i].name);
+        r->group = cases[i].group;
+
+        if (cases[i].skip) {
+            r->skipped = 1;
+            snprintf(r->note, sizeof(r->note), "%s", cases[i].skip);
+            printf("%-32s %-8s pulado: %s\n", r->name, r->group, r->note);
+            continue;
+        }
+
+        // O stdout é trocado uma vez por caso, fora dos lotes medidos
+        int saved_stdout = -1;
+        if (cases[i].quiet) {
+            int devnull = open("/dev/null", O_WRONLY);
+            fflush(stdout);
+            if (devnull >= 0) {
+                saved_stdout = dup(STDOUT_FILENO);
+                dup2(devnull, STDOUT_FILENO);
+                close(devnull);
+            }
+        }
+
+        int rc = bench_run(&config, cases[i].fn, cases[i].ctx, r);
+
+        if (saved_stdout >= 0) {
+            fflush(stdout);
+            dup2(saved_stdout, STDOUT_FILENO);
+            close(saved_stdout);
+        }
+
+        if (rc != 0) {
+            r->skipped = 1;
+            snprintf(r->note, sizeof(r->note), "falhou durante a medicao");
+            printf("%-32s %-8s falhou\n", r->name, r->group);
+            status = 1;
+            continue;
+        }
+
+        char mn[24], p50[24], p90[24], p99[24];
+        format_ns(r->min_ns, mn, sizeof(mn));
+        format_ns(r->p50_ns, p50, sizeof(p50));
+        format_ns(r->p90_ns, p90, sizeof(p90));
+        format_ns(r->p99_ns, p99, sizeof(p99));
+        printf("%-32s %-8s %10s %10s %10s %10s %9lld\n", r->name, r->group, mn, p50, p90, p99, r->batch);
+    }
+
+    /* Limpeza dos arquivos de saída antes de voltar ao diretório original */
+    cpu_sample_csv_close();
+    memory_sample_csv_close();
+    io_sample_csv_close();
+    if (binary_ok) binary_sink.close(&binary_sink);
+    stats_table_free(&summary_table);
+    if (fchdir(home) != 0) perror("Erro ao voltar ao diretorio original");
+    close(home);
+    remove_scratch_dir(scratch);
+
+    memory_monitor_free(&memory_state);
+    thread_monitor_free(&thread_state);
+    system_cpu_free(&system_state);
+    sched_monitor_free(&sched_state);
+    for (int i = 0; i < nfiles; i++) free(files[i].buf);
+
+    if (json_path) {
+        if (bench_write_json(json_path, &config, results, nresults) != 0) return 1;
+        printf("\nResultados gravados em %s\n", json_path);
+    }
+
+    if (baseline_path) {
+        int regressions = bench_compare(baseline_path, results, nresults, threshold, stdout);
+        if (regressions < 0) return 1;
+        if (regressions > 0) return 2;
+    }
+
+    return status;
+}
@@ -0,0 +1,494 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Gera uma árvore /proc + /sys sintética nos formatos do kernel, para medir
+ * e testar os coletores com --proc-root/--sys-root (ou bench_suite --root).
+ *
+ * Layout em DIR:
+ *   proc/stat, proc/net/{tcp,dev}, proc/sys/kernel/task_delayacct
+ *   proc/<pid>/{stat,status,statm,io,schedstat,smaps_rollup,comm,cgroup}
+ *   proc/<pid>/ns/<tipo> -> ../../.ns/<tipo>-<n>   (stat() segue o link: um
+ *                           inode por namespace, como o nsfs)
+ *   proc/<pid>/task/<tid>/{stat,schedstat,comm,sched}
+ *   sys/fs/cgroup/g<n>/{cgroup.procs,memory.current,memory.max,cpu.stat,cpu.max,io.stat}
+ *   sys/devices/system/node/{online,node0/cpulist,node0/numastat}
+ *
+ * Os pids vão de 1 a N e formam uma única árvore com raiz no pid 1; tids
+ * extras vêm depois do último pid. Tudo sai de um gerador com semente fixa:
+ * a mesma linha de comando gera a mesma árvore.
+ *
+ * Uso: ./fixture_gen --out DIR [--procs N] [--threads T] [--sockets S]
+ *                    [--namespaces K] [--cgroups C] [--cpus P] [--seed X]
+ */
+
+#define NS_TYPES 7
+static const char *const ns_types[NS_TYPES] = { "pid", "net", "mnt", "uts", "ipc", "user", "cgroup" };
+
+typedef struct {
+    const char *out;
+    long procs;
+    int threads;        // threads por processo (inclui a principal)
+    long sockets;       // linhas de proc/net/tcp
+    int namespaces;     // namespaces distintos por tipo
+    int cgroups;
+    int cpus;
+    unsigned long long seed;
+} FixtureConfig;
+
+static unsigned long long rng_state;
+static unsigned long long files_written, bytes_written;
+
+// xorshift64*: rápido e determinístico para a semente dada
+static unsigned long long rng(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static unsigned long long rng_range(unsigned long long n) {
+    return n ? rng() % n : 0;
+}
+
+static int make_dir(const char *path) {
+    if (mkdir(path, 0755) == -1 && errno != EEXIST) {
+        fprintf(stderr, "Erro: nao foi possivel criar %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static int write_file(const char *path, const char *data, size_t len) {
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        fprintf(stderr, "Erro: nao foi possivel criar %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = write(fd, data + done, len - done);
+        if (n <= 0) {
+            fprintf(stderr, "Erro: falha ao escrever %s\n", path);
+            close(fd);
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    close(fd);
+
+    files_written++;
+    bytes_written += len;
+    return 0;
+}
+
+// Formata num buffer de pilha e grava; o conteúdo de cada arquivo cabe em 4 KB
+#define WRITE_FMT(path, ...)                                                  \
+    do {                                                                      \
+        char _buf[4096];                                                      \
+        int _n = snprintf(_buf, sizeof(_buf), __VA_ARGS__);                   \
+        if (_n < 0 || (size_t)_n >= sizeof(_buf)) return -1;                  \
+        if (write_file(path, _buf, (size_t)_n) != 0) return -1;               \
+    } while (0)
+
+/* ------------------------------ sistema ------------------------------ */
+
+static int gen_proc_stat(const FixtureConfig *cfg, const char *proc) {
+
+    size_t cap = 256 + (size_t)cfg->cpus * 128, len = 0;
+    char *buf = malloc(cap);
+    if (!buf) return -1;
+
+    unsigned long long total[10] = {0};
+    unsigned long long (*per)[10] = calloc((size_t)cfg->cpus, sizeof(*per));
+    if (!per) {
+        free(buf);
+        return -1;
+    }
+    for (int c = 0; c < cfg->cpus; c++) {
+        for (int f = 0; f < 10; f++) {
+            per[c][f] = f < 8 ? rng_range(f == 3 ? 5000000 : 500000) : 0;
+            total[f] += per[c][f];
+        }
+    }
+
+    len += (size_t)snprintf(buf + len, cap - len, "cpu  %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu\n",
+                            total[0], total[1], total[2], total[3], total[4],
+                            total[5], total[6], total[7], total[8], total[9]);
+    for (int c = 0; c < cfg->cpus; c++) {
+        len += (size_t)snprintf(buf + len, cap - len, "cpu%d %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu\n", c,
+                                per[c][0], per[c][1], per[c][2], per[c][3], per[c][4],
+                                per[c][5], per[c][6], per[c][7], per[c][8], per[c][9]);
+    }
+    len += (size_t)snprintf(buf + len, cap - len,
+                            "intr %llu 0 0 0\nctxt %llu\nbtime 1700000000\nprocesses %ld\n"
+                            "procs_running %d\nprocs_blocked 0\nsoftirq 0 0 0 0 0 0 0 0 0 0 0\n",
+                            rng_range(1ULL << 32), rng_range(1ULL << 32), cfg->procs, cfg->cpus);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/stat", proc);
+    int rc = write_file(path, buf, len);
+    free(per);
+    free(buf);
+    return rc;
+}
+
+static const char *const tcp_states[] = { "01", "01", "01", "01", "01", "01", "01", "0A", "0A", "06" };
+
+// proc/net/tcp com linhas de largura fixa (149 + '\n'), como o kernel
+static int gen_net_tcp(const FixtureConfig *cfg, const char *proc) {
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/net/tcp", proc);
+
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "Erro: nao foi possivel criar %s\n", path);
+        return -1;
+    }
+
+    fprintf(fp, "%-149s\n", "  sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode");
+    for (long i = 0; i < cfg->sockets; i++) {
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "%4ld: %08llX:%04llX %08llX:%04llX %s 00000000:00000000 00:00000000 00000000 %5llu        0 %llu 1 0000000000000000 100 0 0 10 0",
+                 i, rng_range(1ULL << 32), rng_range(65536), rng_range(1ULL << 32), rng_range(65536),
+                 tcp_states[rng_range(10)], rng_range(2000), 10000 + (unsigned long long)i);
+        fprintf(fp, "%-149s\n", line);
+    }
+
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "Erro: falha ao escrever %s\n", path);
+        return -1;
+    }
+    files_written++;
+    bytes_written += 150ULL * (unsigned long long)(cfg->sockets + 1);
+    return 0;
+}
+
+static int gen_net_dev(const char *proc) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/net/dev", proc);
+    WRITE_FMT(path,
+              "Inter-|   Receive                                                |  Transmit\n"
+              " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n"
+              "    lo: %llu %llu    0    0    0     0          0         0 %llu %llu    0    0    0     0       0          0\n"
+              "  eth0: %llu %llu    0    0    0     0          0         0 %llu %llu    0    0    0     0       0          0\n",
+              rng_range(1ULL << 30), rng_range(1ULL << 20), rng_range(1ULL << 30), rng_range(1ULL << 20),
+              rng_range(1ULL << 40), rng_range(1ULL << 30), rng_range(1ULL << 40), rng_range(1ULL << 30));
+    return 0;
+}
+
+static int gen_numa(const FixtureConfig *cfg, const char *sys) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/devices/system/node/online", sys);
+    WRITE_FMT(path, "0\n");
+    snprintf(path, sizeof(path), "%s/devices/system/node/node0/cpulist", sys);
+    WRITE_FMT(path, "0-%d\n", cfg->cpus - 1);
+    snprintf(path, sizeof(path), "%s/devices/system/node/node0/numastat", sys);
+    WRITE_FMT(path, "numa_hit %llu\nnuma_miss 0\nnuma_foreign 0\ninterleave_hit 0\nlocal_node %llu\nother_node 0\n",
+              rng_range(1ULL << 32), rng_range(1ULL << 32));
+    return 0;
+}
+
+/* ------------------------------ cgroups ------------------------------ */
+
+static int gen_cgroups(const FixtureConfig *cfg, const char *sys, const int *cgroup_of) {
+
+    for (int g = 0; g < cfg->cgroups; g++) {
+        char dir[1024], path[1100];
+        snprintf(dir, sizeof(dir), "%s/fs/cgroup/g%d", sys, g);
+        if (make_dir(dir) != 0) return -1;
+
+        snprintf(path, sizeof(path), "%s/cgroup.procs", dir);
+        FILE *fp = fopen(path, "w");
+        if (!fp) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", path);
+            return -1;
+        }
+        for (long pid = 1; pid <= cfg->procs; pid++) {
+            if (cgroup_of[pid] == g) fprintf(fp, "%ld\n", pid);
+        }
+        fclose(fp);
+        files_written++;
+
+        snprintf(path, sizeof(path), "%s/memory.current", dir);
+        WRITE_FMT(path, "%llu\n", rng_range(1ULL << 34));
+        snprintf(path, sizeof(path), "%s/memory.max", dir);
+        WRITE_FMT(path, "max\n");
+        snprintf(path, sizeof(path), "%s/cpu.max", dir);
+        WRITE_FMT(path, "max 100000\n");
+        snprintf(path, sizeof(path), "%s/cpu.stat", dir);
+        WRITE_FMT(path, "usage_usec %llu\nuser_usec %llu\nsystem_usec %llu\nnr_periods 0\nnr_throttled 0\nthrottled_usec 0\n",
+                  rng_range(1ULL << 36), rng_range(1ULL << 35), rng_range(1ULL << 35));
+        snprintf(path, sizeof(path), "%s/io.stat", dir);
+        WRITE_FMT(path,
+                  "8:0 rbytes=%llu wbytes=%llu rios=%llu wios=%llu dbytes=0 dios=0\n"
+                  "259:0 rbytes=%llu wbytes=%llu rios=%llu wios=%llu dbytes=0 dios=0\n",
+                  rng_range(1ULL << 36), rng_range(1ULL << 36), rng_range(1ULL << 20), rng_range(1ULL << 20),
+                  rng_range(1ULL << 36), rng_range(1ULL << 36), rng_range(1ULL << 20), rng_range(1ULL << 20));
+    }
+    return 0;
+}
+
+/* ----------------------------- processos ----------------------------- */
+
+// Nome do processo; alguns com espaço e parênteses, como no kernel real
+static void make_comm(long pid, char *comm, size_t size) {
+    if (pid == 1) snprintf(comm, size, "init");
+    else if (pid % 97 == 0) snprintf(comm, size, "tmux: server");
+    else if (pid % 89 == 0) snprintf(comm, size, "(sd-pam)");
+    else snprintf(comm, size, "worker-%ld", pid % 10000);
+}
+
+static int gen_task(const char *task_dir, long tid, long pid, long ppid, const char *comm, int cpus, int nthreads) {
+
+    char dir[1024], path[1100];
+    snprintf(dir, sizeof(dir), "%s/%ld", task_dir, tid);
+    if (make_dir(dir) != 0) return -1;
+
+    unsigned long long utime = rng_range(100000), stime = rng_range(20000);
+    unsigned long long vol = rng_range(100000), invol = rng_range(10000);
+
+    snprintf(path, sizeof(path), "%s/stat", dir);
+    WRITE_FMT(path,
+              "%ld (%s) %c %ld %ld %ld 0 -1 4194304 %llu 0 %llu 0 %llu %llu 0 0 20 0 %d 0 %llu %llu %llu "
+              "18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 %llu 0 0 %llu 0 0 0 0 0 0 0 0 0 0\n",
+              tid, comm, rng_range(8) == 0 ? 'R' : 'S', ppid, pid, pid,
+              rng_range(1ULL << 20), rng_range(100), utime, stime, nthreads,
+              rng_range(1ULL << 24), (rng_range(1ULL << 18) + 1) * 4096, rng_range(1ULL << 16),
+              rng_range((unsigned long long)cpus), rng_range(1000));
+
+    snprintf(path, sizeof(path), "%s/schedstat", dir);
+    WRITE_FMT(path, "%llu %llu %llu\n", (utime + stime) * 10000000ULL, rng_range(1ULL << 32), vol + invol);
+
+    snprintf(path, sizeof(path), "%s/comm", dir);
+    WRITE_FMT(path, "%s\n", comm);
+
+    snprintf(path, sizeof(path), "%s/sched", dir);
+    WRITE_FMT(path,
+              "%s (%ld, #threads: %d)\n"
+              "-------------------------------------------------------------------\n"
+              "se.exec_start                                :      %llu.%06llu\n"
+              "se.vruntime                                  :      %llu.%06llu\n"
+              "se.sum_exec_runtime                          :      %llu.%06llu\n"
+              "se.nr_migrations                             :      %llu\n"
+              "nr_switches                                  :      %llu\n"
+              "nr_voluntary_switches                        :      %llu\n"
+              "nr_involuntary_switches                      :      %llu\n"
+              "se.load.weight                               :      1048576\n"
+              "policy                                       :      0\n"
+              "prio                                         :      120\n",
+              comm, tid, nthreads, rng_range(1ULL << 30), rng_range(1000000), rng_range(1ULL << 30), rng_range(1000000),
+              (utime + stime) * 10, rng_range(1000000), rng_range(10000), vol + invol, vol, invol);
+    return 0;
+}
+
+static int gen_process(const FixtureConfig *cfg, const char *proc, long pid, long ppid,
+                       long *next_tid, int cgroup, const int *ns_of) {
+
+    char dir[1024], path[1100];
+    char comm[32];
+    make_comm(pid, comm, sizeof(comm));
+    snprintf(dir, sizeof(dir), "%s/%ld", proc, pid);
+    if (make_dir(dir) != 0) return -1;
+
+    unsigned long long rss_pages = rng_range(1ULL << 18) + 1;
+    unsigned long long vm_pages = rss_pages * (2 + rng_range(30));
+    unsigned long long swap_kb = rng_range(4) == 0 ? rng_range(1ULL << 20) : 0;
+    unsigned long long vol = rng_range(1ULL << 20), invol = rng_range(1ULL << 16);
+    unsigned long long utime = rng_range(1ULL << 20), stime = rng_range(1ULL << 18);
+
+    snprintf(path, sizeof(path), "%s/stat", dir);
+    WRITE_FMT(path,
+              "%ld (%s) S %ld %ld %ld 0 -1 4194560 %llu 0 %llu 0 %llu %llu 0 0 20 0 %d 0 %llu %llu %llu "
+              "18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 %llu 0 0 %llu 0 0 0 0 0 0 0 0 0 0\n",
+              pid, comm, ppid, pid, pid,
+              rng_range(1ULL << 24), rng_range(1ULL << 10), utime, stime, cfg->threads,
+              (unsigned long long)pid * 7, vm_pages * 4096, rss_pages, rng_range((unsigned long long)cfg->cpus),
+              rng_range(1000));
+
+    snprintf(path, sizeof(path), "%s/status", dir);
+    WRITE_FMT(path,
+              "Name:\t%s\nUmask:\t0022\nState:\tS (sleeping)\nTgid:\t%ld\nNgid:\t0\nPid:\t%ld\nPPid:\t%ld\n"
+              "TracerPid:\t0\nUid:\t1000\t1000\t1000\t1000\nGid:\t1000\t1000\t1000\t1000\nFDSize:\t64\n"
+              "VmPeak:\t%8llu kB\nVmSize:\t%8llu kB\nVmLck:\t       0 kB\nVmHWM:\t%8llu kB\nVmRSS:\t%8llu kB\n"
+              "RssAnon:\t%8llu kB\nRssFile:\t%8llu kB\nRssShmem:\t       0 kB\nVmData:\t%8llu kB\n"
+              "VmSwap:\t%8llu kB\nThreads:\t%d\nvoluntary_ctxt_switches:\t%llu\nnonvoluntary_ctxt_switches:\t%llu\n",
+              comm, pid, pid, ppid, vm_pages * 4, vm_pages * 4, rss_pages * 4, rss_pages * 4,
+              rss_pages * 3, rss_pages, vm_pages * 2, swap_kb, cfg->threads, vol, invol);
+
+    snprintf(path, sizeof(path), "%s/statm", dir);
+    WRITE_FMT(path, "%llu %llu %llu %llu 0 %llu 0\n", vm_pages, rss_pages, rss_pages / 4, rng_range(1000) + 1, vm_pages / 2);
+
+    snprintf(path, sizeof(path), "%s/io", dir);
+    WRITE_FMT(path, "rchar: %llu\nwchar: %llu\nsyscr: %llu\nsyscw: %llu\nread_bytes: %llu\nwrite_bytes: %llu\ncancelled_write_bytes: 0\n",
+              rng_range(1ULL << 36), rng_range(1ULL << 36), rng_range(1ULL << 24), rng_range(1ULL << 24),
+              rng_range(1ULL << 34), rng_range(1ULL << 34));
+
+    snprintf(path, sizeof(path), "%s/schedstat", dir);
+    WRITE_FMT(path, "%llu %llu %llu\n", (utime + stime) * 10000000ULL, rng_range(1ULL << 36), vol + invol);
+
+    snprintf(path, sizeof(path), "%s/smaps_rollup", dir);
+    WRITE_FMT(path,
+              "00400000-7ffff0000000 ---p 00000000 00:00 0                          [rollup]\n"
+              "Rss:            %8llu kB\nPss:            %8llu kB\nPss_Dirty:      %8llu kB\nPss_Anon:       %8llu kB\n"
+              "Pss_File:       %8llu kB\nPss_Shmem:             0 kB\nShared_Clean:   %8llu kB\nShared_Dirty:          0 kB\n"
+              "Private_Clean:  %8llu kB\nPrivate_Dirty:  %8llu kB\nReferenced:     %8llu kB\nAnonymous:      %8llu kB\n"
+              "LazyFree:              0 kB\nAnonHugePages:         0 kB\nShmemPmdMapped:        0 kB\nFilePmdMapped:         0 kB\n"
+              "Shared_Hugetlb:        0 kB\nPrivate_Hugetlb:       0 kB\nSwap:           %8llu kB\nSwapPss:        %8llu kB\nLocked:                0 kB\n",
+              rss_pages * 4, rss_pages * 3, rss_pages * 2, rss_pages * 2, rss_pages, rss_pages,
+              rss_pages, rss_pages * 2, rss_pages * 3, rss_pages * 3, swap_kb, swap_kb);
+
+    snprintf(path, sizeof(path), "%s/comm", dir);
+    WRITE_FMT(path, "%s\n", comm);
+
+    snprintf(path, sizeof(path), "%s/cgroup", dir);
+    WRITE_FMT(path, "0::/g%d\n", cgroup);
+
+    // Namespaces: links para os arquivos compartilhados em proc/.ns
+    snprintf(path, sizeof(path), "%s/ns", dir);
+    if (make_dir(path) != 0) return -1;
+    for (int t = 0; t < NS_TYPES; t++) {
+        char link[1100], target[64];
+        snprintf(link, sizeof(link), "%s/ns/%s", dir, ns_types[t]);
+        snprintf(target, sizeof(target), "../../.ns/%s-%d", ns_types[t], ns_of[t]);
+        if (symlink(target, link) == -1 && errno != EEXIST) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s: %s\n", link, strerror(errno));
+            return -1;
+        }
+    }
+
+    // Threads: a principal tem tid == pid; as demais vêm depois do último pid
+    char task_dir[1100];
+    snprintf(task_dir, sizeof(task_dir), "%s/task", dir);
+    if (make_dir(task_dir) != 0) return -1;
+    if (gen_task(task_dir, pid, pid, ppid, comm, cfg->cpus, cfg->threads) != 0) return -1;
+    for (int t = 1; t < cfg->threads; t++) {
+        if (gen_task(task_dir, (*next_tid)++, pid, ppid, comm, cfg->cpus, cfg->threads) != 0) return -1;
+    }
+    return 0;
+}
+
+/* ------------------------------ execução ------------------------------ */
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+            "Uso: %s --out DIR [--procs N] [--threads T] [--sockets S]\n"
+            "          [--namespaces K] [--cgroups C] [--cpus P] [--seed X]\n", prog);
+}
+
+int main(int argc, char **argv) {
+
+    FixtureConfig cfg = {
+        .out = NULL, .procs = 1000, .threads = 2, .sockets = 1000,
+        .namespaces = 4, .cgroups = 8, .cpus = 4, .seed = 1,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!val) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[i], "--out") == 0) cfg.out = val;
+        else if (strcmp(argv[i], "--procs") == 0) cfg.procs = atol(val);
+        else if (strcmp(argv[i], "--threads") == 0) cfg.threads = atoi(val);
+        else if (strcmp(argv[i], "--sockets") == 0) cfg.sockets = atol(val);
+        else if (strcmp(argv[i], "--namespaces") == 0) cfg.namespaces = atoi(val);
+        else if (strcmp(argv[i], "--cgroups") == 0) cfg.cgroups = atoi(val);
+        else if (strcmp(argv[i], "--cpus") == 0) cfg.cpus = atoi(val);
+        else if (strcmp(argv[i], "--seed") == 0) cfg.seed = strtoull(val, NULL, 10);
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    if (!cfg.out || cfg.procs < 1 || cfg.threads < 1 || cfg.sockets < 0 ||
+        cfg.namespaces < 1 || cfg.cgroups < 1 || cfg.cpus < 1 || strlen(cfg.out) > 200) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    rng_state = cfg.seed ? cfg.seed : 1;
+
+    char proc[512], sys[512], path[1024];
+    snprintf(proc, sizeof(proc), "%s/proc", cfg.out);
+    snprintf(sys, sizeof(sys), "%s/sys", cfg.out);
+
+    // Diretórios fixos da árvore
+    const char *const dirs[] = {
+        "", "/proc", "/proc/net", "/proc/sys", "/proc/sys/kernel", "/proc/.ns",
+        "/sys", "/sys/fs", "/sys/fs/cgroup", "/sys/devices", "/sys/devices/system",
+        "/sys/devices/system/node", "/sys/devices/system/node/node0",
+    };
+    for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+        snprintf(path, sizeof(path), "%s%s", cfg.out, dirs[i]);
+        if (make_dir(path) != 0) return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    if (gen_proc_stat(&cfg, proc) != 0 || gen_net_tcp(&cfg, proc) != 0 ||
+        gen_net_dev(proc) != 0 || gen_numa(&cfg, sys) != 0) return 1;
+
+    snprintf(path, sizeof(path), "%s/sys/kernel/task_delayacct", proc);
+    if (write_file(path, "0\n", 2) != 0) return 1;
+
+    // Um arquivo por namespace: o inode dele é a identidade do namespace
+    for (int t = 0; t < NS_TYPES; t++) {
+        for (int n = 0; n < cfg.namespaces; n++) {
+            snprintf(path, sizeof(path), "%s/.ns/%s-%d", proc, ns_types[t], n);
+            if (write_file(path, "", 0) != 0) return 1;
+        }
+    }
+
+    int *cgroup_of = malloc(sizeof(int) * (size_t)(cfg.procs + 1));
+    if (!cgroup_of) {
+        fprintf(stderr, "Erro: falha ao alocar memoria\n");
+        return 1;
+    }
+
+    long next_tid = cfg.procs + 1;
+    for (long pid = 1; pid <= cfg.procs; pid++) {
+        // Pai sorteado entre os anteriores: uma árvore só, com raiz no pid 1
+        long ppid = pid == 1 ? 0 : 1 + (long)rng_range((unsigned long long)(pid - 1));
+
+        // Metade dos processos no namespace 0 de cada tipo (o "host"), o resto espalhado
+        int ns_of[NS_TYPES];
+        for (int t = 0; t < NS_TYPES; t++) ns_of[t] = rng_range(2) ? 0 : (int)rng_range((unsigned long long)cfg.namespaces);
+
+        cgroup_of[pid] = (int)rng_range((unsigned long long)cfg.cgroups);
+        if (gen_process(&cfg, proc, pid, ppid, &next_tid, cgroup_of[pid], ns_of) != 0) {
+            free(cgroup_of);
+            return 1;
+        }
+    }
+
+    int rc = gen_cgroups(&cfg, sys, cgroup_of);
+    free(cgroup_of);
+    if (rc != 0) return 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    printf("Arvore gerada em %s (%.1f s)\n", cfg.out, secs);
+    printf("  processos: %ld | threads: %ld | conexoes TCP: %ld | namespaces por tipo: %d | cgroups: %d | CPUs: %d\n",
+           cfg.procs, cfg.procs * cfg.threads, cfg.sockets, cfg.namespaces, cfg.cgroups, cfg.cpus);
+    printf("  arquivos: %llu | %.1f MB\n", files_written, bytes_written / (1024.0 * 1024.0));
+    printf("Uso: ./resource-monitor --proc-root %s --sys-root %s\n", proc, sys);
+    printf("     ./bench_suite --root %s\n", cfg.out);
+    return 0;
+}
@@ -0,0 +1,119 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stddef.h>    // size_t
+#include <sys/types.h> // ssize_t
+#include <time.h>      // time_t, struct timespec
+
+/*
+ * Captura e reprodução das leituras do kernel.
+ *
+ * Gravação: um observador em proc_read_file (proc_set_read_tap) guarda os
+ * bytes exatos de cada arquivo de /proc, /sys e cgroup lido durante uma
+ * sessão num log binário só de acréscimo. Também vão para o log as leituras
+ * de relógio feitas pelos coletores (capture_clock/capture_time), para que
+ * taxas e timestamps saiam iguais na reprodução.
+ *
+ * Formato: CaptureHeader seguido de registros de um byte de tipo e campos
+ * nativos (o log é lido na mesma arquitetura que o gravou):
+ *   'P' id(u32) len(u16) caminho   primeira vez que um caminho aparece
+ *   'R' id(u32) len(i32) bytes     leitura (len -1: falhou)
+ *   'S' id(u32)                    leitura igual à anterior do mesmo caminho
+ *   'T' wall(i64) mono_ns(i64)     início de um ciclo
+ *   'C' mono_ns(i64)               leitura de CLOCK_MONOTONIC por um coletor
+ *   'W' wall(i64)                  leitura de time() por um coletor
+ * O segmento antes do primeiro 'T' guarda as leituras dos *_init.
+ *
+ * Reprodução: o log inteiro vai para a memória e uma fonte
+ * (proc_set_read_source) atende proc_read_file com os bytes do ciclo
+ * atual, sem tocar no kernel. Os coletores rodam sem mudança: o mesmo
+ * parsing, os mesmos deltas e a mesma saída da sessão gravada.
+ */
+
+#define CAPTURE_MAGIC "RMCAPTUR"
+#define CAPTURE_VERSION 1
+#define CAPTURE_GROUP_LEN 256
+
+#define CAPTURE_CGROUP_MEMORY 0x1u   // memory.current
+#define CAPTURE_CGROUP_CPU    0x2u   // cpu.stat
+#define CAPTURE_CGROUP_IO     0x4u   // io.stat
+
+typedef struct {
+    char magic[8];
+    unsigned version;
+    int pid;                          // alvo da sessão
+    int num_cpus;                     // da máquina que gravou
+    int page_size;
+    long clk_tck;
+    long long started;                // time() do início da gravação
+    char cgroup[CAPTURE_GROUP_LEN];   // cgroup v2 do alvo ("" = sem cgroup)
+    unsigned cgroup_files;            // CAPTURE_CGROUP_*: arquivos lidos a cada ciclo
+} CaptureHeader;
+
+// Um ciclo da reprodução
+typedef struct {
+    unsigned long long index;   // 0 = segmento dos *_init
+    time_t wall;                // time() no início do ciclo gravado
+    long long mono_ns;          // CLOCK_MONOTONIC no início do ciclo gravado
+    size_t reads;               // leituras gravadas no ciclo
+} CaptureTick;
+
+// Contadores da gravação
+typedef struct {
+    unsigned long long ticks;
+    unsigned long long reads;
+    unsigned long long repeats;     // leituras gravadas como 'S'
+    unsigned long long paths;
+    unsigned long long bytes_in;    // bytes lidos do kernel
+    unsigned long long bytes_out;   // bytes escritos no log
+} CaptureStats;
+
+/* ===================== GRAVAÇÃO ===================== */
+
+/**
+ * Cria o log e passa a gravar todas as leituras de proc_read_file
+ * @param path Arquivo do log (truncado se existir)
+ * @param header pid, cgroup e dados da máquina; magic, versão e início são preenchidos aqui
+ * @return 0 em sucesso, -1 em erro
+ */
+int capture_record_open(const char *path, const CaptureHeader *header);
+
+// Marca o início de um ciclo (as leituras seguintes pertencem a ele).
+void capture_record_tick(void);
+
+// Para de gravar e fecha o log. Retorna 0, ou -1 se alguma escrita falhou.
+int capture_record_close(CaptureStats *stats);
+
+/* ===================== REPRODUÇÃO ===================== */
+
+/**
+ * Carrega o log e instala a fonte de leituras no segmento dos *_init
+ * @param header Recebe o cabeçalho gravado
+ * @return 0 em sucesso, -1 em erro (arquivo ausente, formato inválido)
+ */
+int capture_replay_open(const char *path, CaptureHeader *header);
+
+/**
+ * Avança para o próximo ciclo gravado
+ * @return 1 com tick preenchido, 0 no fim do log
+ */
+int capture_replay_next(CaptureTick *tick);
+
+// Volta ao segmento dos *_init (para repetir o log).
+void capture_replay_rewind(void);
+
+// Remove a fonte e libera o log.
+void capture_replay_close(void);
+
+/* ===================== RELÓGIO ===================== */
+
+// 1 se há gravação ou reprodução em andamento.
+int capture_active(void);
+
+// CLOCK_MONOTONIC para os coletores: o real (gravado, se há gravação) ou o do log.
+void capture_clock(struct timespec *ts);
+
+// time(NULL) para os coletores, com a mesma regra.
+time_t capture_time(void);
+
+#endif
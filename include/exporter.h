@@ -0,0 +1,88 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>    // size_t
+#include <sys/types.h> // pid_t
+
+#include "pipeline.h"
+
+/*
+ * Exportador no formato texto do Prometheus (GET /metrics), numa porta
+ * local ou num socket unix.
+ *
+ * O destino do pipeline guarda a última coleta de cada alvo e, quando o
+ * escritor esvazia o anel, renderiza a resposta HTTP inteira (cabeçalho e
+ * corpo) num de dois buffers e a publica trocando o índice do buffer da
+ * frente. O thread servidor só copia essa resposta para o socket: cada
+ * raspagem custa um write, sem formatar nada e sem trava compartilhada com
+ * o escritor. Se o buffer de trás ainda está sendo enviado, a renderização
+ * é adiada (o escritor volta em PIPELINE_FLUSH_RETRY_MS); a coleta nunca
+ * espera nem o servidor nem o escritor.
+ */
+
+#define EXPORTER_DEFAULT_PORT 9464
+#define EXPORTER_MAX_TARGETS 8192
+#define EXPORTER_MAX_CLIENTS 64
+#define EXPORTER_STALE_SEC 60           // alvo sem coleta há mais que isso sai da resposta
+#define EXPORTER_MIN_RENDER_MS 100      // intervalo mínimo entre renderizações
+
+typedef struct {
+    char *data;
+    size_t len;                         // resposta pronta: data[start .. start + len)
+    size_t start;
+    size_t cap;
+} ExporterBuffer;
+
+typedef struct {
+    int listen_fd;
+    char address[128];                  // como foi pedido (para mensagens)
+    char unix_path[108];                // socket unix a remover no fechamento ("" se TCP)
+
+    // Alvos: última coleta de cada um, ordenados por pid (só o thread escritor)
+    SampleRecord *targets;
+    size_t count;
+    size_t capacity;
+    size_t hint;
+    int dirty;
+    long long last_render_ns;
+    unsigned long long renders;
+    unsigned long long deferred;        // renderizações adiadas (buffer de trás em uso)
+    unsigned long long ignored;         // coletas de alvos além de EXPORTER_MAX_TARGETS
+    long long render_ns;                // duração da última renderização
+
+    ExporterBuffer buffers[2];
+    atomic_int front;                   // buffer publicado
+    atomic_int sending;                 // buffer sendo enviado pelo servidor (-1 = nenhum)
+    atomic_ullong scrapes;
+    atomic_ullong bytes_sent;
+
+    pthread_t server;
+    atomic_int stop;
+    int running;
+} Exporter;
+
+/**
+ * Abre o socket e cria o thread servidor
+ * @param address "PORTA", "HOST:PORTA" ou "unix:CAMINHO" (NULL = 127.0.0.1:9464)
+ * @return 0 em sucesso, -1 em erro
+ */
+int exporter_open(Exporter *exporter, const char *address);
+
+// Guarda a coleta como a mais recente do alvo (thread escritor). Retorna 0 ou -1.
+int exporter_update(Exporter *exporter, const SampleRecord *record);
+
+/**
+ * Renderiza e publica a resposta se há coletas novas (thread escritor)
+ * @return 0 se nada ficou pendente, 1 se a publicação foi adiada
+ */
+int exporter_publish(Exporter *exporter);
+
+// Para o servidor, fecha o socket e libera os buffers.
+void exporter_close(Exporter *exporter);
+
+// Destino do pipeline que alimenta o exportador em address.
+int sample_sink_prometheus(SampleSink *sink, const char *address);
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef LIVE_H
+#define LIVE_H
+
+#include <stdatomic.h>
+#include <stddef.h>    // size_t
+#include <sys/types.h> // pid_t
+
+#include "pipeline.h"
+
+/*
+ * Tabela ao vivo em memória compartilhada (POSIX shm, /dev/shm/NOME).
+ *
+ * O monitor publica a última coleta de cada alvo num segmento de layout
+ * fixo: LiveHeader seguido de capacity slots de LIVE_SLOT_SIZE bytes, cada
+ * um com um seqlock e um SampleRecord. Qualquer processo local abre o
+ * segmento só para leitura e copia registros sem syscalls e sem falar com
+ * o escritor:
+ *
+ *   escritor: seq++ (ímpar) -> copia o registro -> seq++ (par)
+ *   leitor:   s1 = seq (par?) -> copia o registro -> s2 = seq; s1 == s2?
+ *
+ * Se o escritor mexeu no slot durante a cópia, o leitor simplesmente
+ * tenta de novo. Há um só escritor (o thread escritor do pipeline), então
+ * o seqlock não precisa de trava entre escritores. Um alvo fica sempre no
+ * mesmo slot; slots liberados (alvo sem coleta há LIVE_STALE_SEC) voltam
+ * com pid 0 e são reaproveitados.
+ *
+ * Ao fechar, o escritor zera writer_pid e remove o nome: quem já mapeou
+ * continua lendo os últimos valores, e quem chega depois não encontra um
+ * segmento abandonado. O nome só é tomado de um segmento cujo escritor já
+ * terminou, e só é removido se ainda aponta para o segmento do próprio
+ * escritor (mesmo dispositivo e inode).
+ */
+
+#define LIVE_MAGIC "RMLIVE01"
+#define LIVE_VERSION 1
+#define LIVE_DEFAULT_NAME "/resource-monitor"
+#define LIVE_DEFAULT_SLOTS 1024
+#define LIVE_STALE_SEC 60
+#define LIVE_READ_RETRIES 100000    // escritor morto no meio de uma escrita: o leitor desiste
+
+typedef struct {
+    char magic[8];
+    unsigned version;
+    unsigned header_size;               // sizeof(LiveHeader): os slots começam aqui
+    unsigned slot_size;                 // LIVE_SLOT_SIZE
+    unsigned record_size;               // sizeof(SampleRecord) de quem escreve
+    unsigned capacity;                  // slots no segmento
+    atomic_int writer_pid;              // 0 = escritor encerrado
+    atomic_uint used;                   // slots [0, used) já foram ocupados alguma vez
+    unsigned reserved;
+    atomic_llong updated_ns;            // CLOCK_MONOTONIC da última escrita
+    atomic_ullong updates;              // escritas desde a criação
+    char pad[64 - 8 - 4 * 8 - 2 * 8];   // cabeçalho ocupa uma linha de cache
+} LiveHeader;
+
+// Um slot: contador do seqlock e o registro, alinhado a linhas de cache
+typedef struct {
+    _Alignas(64) atomic_uint seq;       // ímpar = escrita em andamento
+    atomic_int pid;                     // 0 = livre; cópia de record.pid para buscas sem copiar o slot
+    SampleRecord record;
+} LiveSlot;
+
+#define LIVE_SLOT_SIZE sizeof(LiveSlot)
+
+/* ---------------------------- ESCRITOR ---------------------------- */
+
+typedef struct {
+    pid_t pid;
+    unsigned slot;
+} LiveIndex;
+
+typedef struct {
+    char name[64];
+    LiveHeader *header;
+    LiveSlot *slots;
+    size_t map_len;
+    dev_t dev;                          // identidade do segmento criado, para o fechamento
+    ino_t ino;
+    LiveIndex *index;                   // pid -> slot, ordenado por pid (memória privada)
+    size_t count;
+    unsigned *free_slots;               // pilha de slots liberados
+    size_t nfree;
+    long long last_sweep_ns;
+    unsigned long long ignored;         // coletas com o segmento cheio
+} LiveWriter;
+
+/**
+ * Cria o segmento name com capacity slots, substituindo um segmento
+ * anterior cujo escritor já terminou
+ * @param name Nome POSIX ("/resource-monitor"; a barra é acrescentada se faltar)
+ * @return 0 em sucesso, -1 em erro (inclusive se outro monitor vivo usa o nome)
+ */
+int live_writer_open(LiveWriter *writer, const char *name, unsigned capacity);
+
+// Publica a coleta no slot do alvo. Retorna 0 ou -1 (segmento cheio).
+int live_writer_update(LiveWriter *writer, const SampleRecord *record);
+
+// Marca o segmento como encerrado, remove o nome (se ainda é dele) e desfaz o mapeamento.
+void live_writer_close(LiveWriter *writer);
+
+// Destino do pipeline que publica as coletas no segmento name.
+int sample_sink_live(SampleSink *sink, const char *name);
+
+/* ----------------------------- LEITOR ----------------------------- */
+
+typedef struct {
+    const LiveHeader *header;
+    const LiveSlot *slots;
+    size_t map_len;
+    unsigned long long retries;         // cópias refeitas por escrita concorrente
+} LiveReader;
+
+/**
+ * Mapeia o segmento só para leitura
+ * @return 0 em sucesso, -1 se não existe ou tem outro formato
+ */
+int live_reader_open(LiveReader *reader, const char *name);
+
+/**
+ * Cópia consistente de um slot
+ * @param slot Índice, de 0 a live_reader_slots() - 1
+ * @return 1 com *out preenchido, 0 se o slot está livre, -1 se o escritor
+ *         não terminou a escrita em LIVE_READ_RETRIES tentativas
+ */
+int live_read_slot(LiveReader *reader, unsigned slot, SampleRecord *out);
+
+// Slots a percorrer (os que já foram ocupados alguma vez).
+unsigned live_reader_slots(const LiveReader *reader);
+
+/**
+ * Procura a coleta mais recente de um alvo
+ * @return 1 com *out preenchido, 0 se o alvo não está no segmento
+ */
+int live_find(LiveReader *reader, pid_t pid, SampleRecord *out);
+
+void live_reader_close(LiveReader *reader);
+
+#endif
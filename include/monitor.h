@@ -5,6 +5,33 @@
 #include <sys/types.h> // pid_t
 #include <time.h>      // time_t
 
+/* ===================== ALVO MONITORADO ===================== */
+
+// Processo alvo preso por um pidfd: a saída é detectada na hora e amostras
+// lidas depois que o PID foi reaproveitado são descartadas
+typedef struct {
+    pid_t pid;
+    int pidfd;                          // -1 se pidfd_open indisponível (kernel < 5.3)
+    unsigned long long start_time;      // stat campo 22: identidade junto com o pid
+    int exited;
+    int exit_code;                      // status no formato de wait(2); -1 se desconhecido
+    unsigned long long final_user_ticks;   // utime/stime lidos no instante da saída
+    unsigned long long final_system_ticks;
+    time_t exit_time;
+} MonitorTarget;
+
+int target_open(MonitorTarget *target, pid_t pid);
+int target_wait(MonitorTarget *target, int timeout_ms);
+int target_same_process(MonitorTarget *target);
+void target_describe_exit(const MonitorTarget *target, char *buf, size_t size);
+void target_close(MonitorTarget *target);
+
+/* ========================= CSV ========================= */
+
+// Escreve text entre aspas, dobrando as aspas internas (RFC 4180): nomes de
+// processos e threads podem ter vírgula e aspas. Retorna 0 ou -1.
+int csv_write_quoted(FILE *fp, const char *text);
+
 /* ====================== CPU SAMPLE ====================== */
 
 typedef struct {
@@ -16,6 +43,10 @@ typedef struct {
     unsigned long long system_time_ticks; // system time
     unsigned long long context_switches;  // trocas de contexto
     unsigned long long threads;           // número de threads
+    int num_cpus;                         // CPUs online na coleta
+    double cpu_percent_core;              // cpu_percent normalizado por core (100% = um core)
+    unsigned long long voluntary_switches;    // trocas voluntárias (bloqueios)
+    unsigned long long nonvoluntary_switches; // trocas involuntárias (preempção)
 } CpuSample;
 
 typedef struct {
@@ -23,6 +54,7 @@ typedef struct {
     unsigned long long last_user_time_ticks;
     unsigned long long last_system_time_ticks;
     unsigned long long last_total_ticks;
+    int num_cpus;
 } CpuMonitorState;
 
 int cpu_monitor_init(CpuMonitorState *state, pid_t pid);
@@ -38,15 +70,103 @@ typedef struct {
 
     unsigned long long rss_bytes;    // RSS (memória RAM que o processo está ocupando naquele momento)
     unsigned long long vsize_bytes;  // VSZ (tamanho total do espaço de memória virtual do processo)
-    unsigned long long page_faults;  // page faults
+    unsigned long long page_faults;  // page faults (minor + major)
     unsigned long long swap_bytes;   // swap
+
+    unsigned long long minor_faults;     // minflt acumulado (sem I/O de disco)
+    unsigned long long major_faults;     // majflt acumulado (com I/O de disco)
+    double minor_faults_per_sec;         // taxa de minor faults no intervalo
+    double major_faults_per_sec;         // taxa de major faults no intervalo
+    double rss_growth_bytes_per_sec;     // variação do RSS no intervalo (negativo = encolheu)
+    double swap_in_bytes_per_sec;        // queda do VmSwap no intervalo (páginas voltando do swap)
+    double swap_out_bytes_per_sec;       // aumento do VmSwap no intervalo (páginas indo para o swap)
+
+    double leak_slope_mb_per_hour;       // inclinação da regressão do RSS na janela
+    double leak_confidence;              // 0..1: R² da regressão ponderado pelo preenchimento da janela
+    int leak_suspected;                  // 1 se crescimento sustentado acima dos limiares
 } MemorySample;
 
-int memory_monitor_sample(pid_t pid, MemorySample *sample);
+/* Detecção de vazamento: regressão linear do RSS sobre uma janela deslizante */
+#define MEMORY_LEAK_WINDOW_DEFAULT 120   // amostras na janela quando init recebe 0
+#define MEMORY_LEAK_WINDOW_MAX 3600      // maior janela aceita
+#define MEMORY_LEAK_MIN_SAMPLES 10       // abaixo disso não há inclinação
+#define MEMORY_LEAK_MIN_MB_PER_HOUR 1.0  // crescimento mínimo para suspeitar
+#define MEMORY_LEAK_MIN_CONFIDENCE 0.8   // confiança mínima para suspeitar
+
+typedef struct {
+    double t_sec;   // instante relativo ao início do monitoramento
+    double rss_mb;  // RSS em MB
+} MemoryPoint;
+
+typedef struct {
+    pid_t pid;
+    int has_last;                          // 0 até a primeira amostra
+    unsigned long long last_minor_faults;
+    unsigned long long last_major_faults;
+    unsigned long long last_rss_bytes;
+    unsigned long long last_swap_bytes;
+    struct timespec start_ts;              // CLOCK_MONOTONIC do init
+    struct timespec last_ts;               // CLOCK_MONOTONIC da última amostra
+
+    /* Janela da regressão (anel). As somas são atualizadas em O(1) a cada
+       amostra e recalculadas do zero a cada volta completa do anel para não
+       acumular erro de arredondamento. */
+    int window;                            // capacidade usada do anel
+    int count;                             // pontos na janela
+    int head;                              // posição do ponto mais antigo
+    int since_rebase;                      // inserções desde o último recálculo
+    double origin_sec;                     // x é medido a partir daqui
+    double sum_x, sum_y, sum_xx, sum_xy, sum_yy;
+    MemoryPoint *points;                   // anel de window pontos, alocado no init
+} MemoryMonitorState;
+
+int memory_monitor_init(MemoryMonitorState *state, pid_t pid, int window_samples);
+int memory_monitor_sample(MemoryMonitorState *state, MemorySample *sample);
+void memory_monitor_free(MemoryMonitorState *state);
 int memory_sample_write_csv(const MemorySample *sample, FILE *fp);
 int memory_sample_csv_write(const MemorySample *sample);
 void memory_sample_csv_close(void);
 
+/* ============ MEMORY ROLLUP (smaps_rollup) ============ */
+
+// Detalhamento de /proc/<pid>/smaps_rollup. Todos os valores em bytes.
+typedef struct {
+    pid_t pid;
+    time_t timestamp;  // instante da coleta
+
+    unsigned long long rss_bytes;        // Rss (igual ao statm, conta páginas compartilhadas inteiras)
+    unsigned long long pss_bytes;        // Pss: páginas compartilhadas divididas entre os processos
+    unsigned long long uss_bytes;        // USS: Private_Clean + Private_Dirty (liberado se o processo sair)
+    unsigned long long shared_bytes;     // Shared_Clean + Shared_Dirty
+    unsigned long long pss_anon_bytes;   // Pss_Anon
+    unsigned long long pss_file_bytes;   // Pss_File
+    unsigned long long pss_shmem_bytes;  // Pss_Shmem
+    unsigned long long anon_bytes;       // Anonymous
+    unsigned long long anon_huge_bytes;  // AnonHugePages (THP)
+    unsigned long long swap_bytes;       // Swap
+    unsigned long long swap_pss_bytes;   // SwapPss: swap proporcional
+    unsigned long long cost_ns;          // tempo gasto lendo smaps_rollup nesta coleta
+} MemoryRollupSample;
+
+// smaps_rollup percorre as tabelas de páginas do processo e custa bem mais
+// que statm, por isso roda a cada every_n_ticks chamadas do loop principal.
+typedef struct {
+    pid_t pid;
+    int every_n_ticks;                  // cadência (1 = toda amostra)
+    int tick;                           // chamadas desde a última leitura
+    int has_sample;                     // last já foi preenchido
+    MemoryRollupSample last;            // última leitura (reaproveitada entre leituras)
+
+    unsigned long long reads;           // leituras feitas
+    unsigned long long total_cost_ns;   // soma do custo das leituras
+    unsigned long long max_cost_ns;     // leitura mais cara
+} MemoryRollupState;
+
+int memory_rollup_init(MemoryRollupState *state, pid_t pid, int every_n_ticks);
+int memory_rollup_tick(MemoryRollupState *state, MemoryRollupSample *sample);
+int memory_rollup_csv_write(const MemoryRollupSample *sample);
+void memory_rollup_csv_close(void);
+
 /* ====================== I/O SAMPLE ====================== */
 
 typedef struct {
@@ -82,4 +202,693 @@ int io_monitor_sample(IoMonitorState *state, IoSample *sample, double interval_s
 int io_sample_csv_write(const IoSample *sample);
 void io_sample_csv_close(void);
 
-#endif
\ No newline at end of file
+/* ==================== THREAD SAMPLE ==================== */
+
+#define THREAD_COMM_LEN 16  // tamanho máximo do nome da thread (TASK_COMM_LEN do kernel)
+
+typedef struct {
+    pid_t pid;          // processo dono da thread
+    pid_t tid;          // id da thread
+    time_t timestamp;   // instante da coleta
+
+    char comm[THREAD_COMM_LEN];      // nome da thread (/proc/<pid>/task/<tid>/comm)
+    char state;                      // estado (R, S, D, ...)
+    int last_cpu;                    // último CPU em que a thread executou
+    double cpu_percent;              // uso no intervalo (100% = um core inteiro)
+    unsigned long long user_time_ticks;   // user time acumulado
+    unsigned long long system_time_ticks; // system time acumulado
+    unsigned long long run_time_ns;       // tempo em CPU acumulado (schedstat)
+    unsigned long long run_delay_ns;      // tempo esperando na run queue (schedstat)
+} ThreadSample;
+
+typedef struct {
+    pid_t tid;
+    char comm[THREAD_COMM_LEN];
+    unsigned long long last_user_time_ticks;
+    unsigned long long last_system_time_ticks;
+    unsigned long long last_run_time_ns;
+} ThreadEntry;
+
+typedef struct {
+    pid_t pid;
+    ThreadEntry *threads;     // estado por thread, ordenado por tid
+    size_t count;             // threads vistas na última amostra
+    size_t capacity;
+    ThreadSample *scratch;    // buffer reaproveitado entre amostras
+    size_t scratch_capacity;
+    struct timespec last_ts;  // instante (CLOCK_MONOTONIC) da última amostra
+} ThreadMonitorState;
+
+int thread_monitor_init(ThreadMonitorState *state, pid_t pid);
+int thread_monitor_sample(ThreadMonitorState *state, ThreadSample *top, int top_n);
+void thread_monitor_free(ThreadMonitorState *state);
+int thread_sample_csv_write(const ThreadSample *sample);
+void thread_sample_csv_close(void);
+
+/* ================== SYSTEM CPU SAMPLE ================== */
+
+// Ordem dos campos de uma linha "cpuN" de /proc/stat
+enum {
+    CPU_STAT_USER, CPU_STAT_NICE, CPU_STAT_SYSTEM, CPU_STAT_IDLE,
+    CPU_STAT_IOWAIT, CPU_STAT_IRQ, CPU_STAT_SOFTIRQ, CPU_STAT_STEAL,
+    CPU_STAT_GUEST, CPU_STAT_GUEST_NICE,
+    CPU_STAT_FIELDS
+};
+
+typedef struct {
+    int online;             // 0 se o core não apareceu em /proc/stat (offline)
+    double user_percent;    // user + nice
+    double system_percent;
+    double idle_percent;
+    double iowait_percent;
+    double irq_percent;
+    double softirq_percent;
+    double steal_percent;   // tempo roubado pelo hypervisor (VMs)
+} CoreCpuUsage;
+
+typedef struct {
+    time_t timestamp;  // instante da coleta
+
+    int num_cores;              // tamanho do vetor cores
+    CoreCpuUsage total;         // linha agregada "cpu"
+    const CoreCpuUsage *cores;  // uso por core (vetor do estado, válido até a próxima amostra)
+
+    unsigned long long ctxt;          // trocas de contexto desde o boot
+    unsigned long long intr;          // interrupções desde o boot
+    double ctxt_per_sec;              // taxa de trocas de contexto
+    double intr_per_sec;              // taxa de interrupções
+    unsigned long long procs_running; // processos executáveis agora
+    unsigned long long procs_blocked; // processos bloqueados em I/O agora
+} SystemCpuSample;
+
+typedef struct {
+    int max_cores;                   // tamanho fixo dos vetores, definido na inicialização
+    unsigned long long last_total[CPU_STAT_FIELDS];
+    unsigned long long (*last_cores)[CPU_STAT_FIELDS];
+    CoreCpuUsage *cores;
+    unsigned long long last_ctxt;
+    unsigned long long last_intr;
+    struct timespec last_ts;
+    char *buf;                       // buffer de leitura de /proc/stat (cresce se preciso)
+    size_t buf_size;
+} SystemCpuState;
+
+int system_cpu_init(SystemCpuState *state);
+int system_cpu_sample(SystemCpuState *state, SystemCpuSample *sample);
+void system_cpu_free(SystemCpuState *state);
+int system_cpu_csv_write(const SystemCpuSample *sample);
+void system_cpu_csv_close(void);
+
+/* ================= WORKING SET SAMPLE ================= */
+
+// Como as páginas tocadas no intervalo são contadas
+typedef enum {
+    WS_METHOD_PAGE_IDLE,   // /sys/kernel/mm/page_idle/bitmap + /proc/<pid>/pagemap (precisa de root)
+    WS_METHOD_CLEAR_REFS   // /proc/<pid>/clear_refs + Referenced de smaps_rollup
+} WorkingSetMethod;
+
+typedef struct {
+    pid_t pid;
+    time_t timestamp;  // instante da coleta
+
+    WorkingSetMethod method;
+    double interval_sec;              // janela em que os acessos foram contados
+    unsigned long long rss_bytes;     // residente no fim do intervalo
+    unsigned long long ws_bytes;      // tocado durante o intervalo (working set)
+    double ws_percent;                // ws_bytes / rss_bytes
+    unsigned long long scanned_pages; // páginas presentes examinadas (page_idle)
+    unsigned long long cost_ns;       // custo da coleta, incluindo rearmar o próximo intervalo
+} WorkingSetSample;
+
+typedef struct {
+    pid_t pid;
+    WorkingSetMethod method;
+    long page_size;
+    struct timespec last_ts;              // início do intervalo atual
+    unsigned long long peak_ws_bytes;     // maior working set visto
+
+    /* page_idle */
+    int pagemap_fd;
+    int bitmap_fd;
+    unsigned long long *pfns;             // PFNs presentes do processo (ordenados)
+    size_t npfns;
+    size_t pfns_capacity;
+    unsigned long long *batch;            // buffer de leitura do pagemap / bitmap
+    char *maps_buf;                       // cópia de /proc/<pid>/maps
+    size_t maps_capacity;
+} WorkingSetState;
+
+int working_set_init(WorkingSetState *state, pid_t pid);
+int working_set_sample(WorkingSetState *state, WorkingSetSample *sample);
+void working_set_free(WorkingSetState *state);
+int working_set_csv_write(const WorkingSetSample *sample);
+void working_set_csv_close(void);
+
+/* ===================== NUMA SAMPLE ===================== */
+
+#define NUMA_MAX_NODES 64       // nós NUMA acompanhados
+#define NUMA_MAX_CPUS 1024      // CPUs mapeadas para nó
+#define NUMA_THREAD_TOP 64      // threads mais quentes usadas para a afinidade
+
+// Tipos de mapeamento em numa_maps
+enum {
+    NUMA_MAP_HEAP, NUMA_MAP_STACK, NUMA_MAP_ANON, NUMA_MAP_FILE,
+    NUMA_MAP_SHMEM, NUMA_MAP_HUGE,
+    NUMA_MAP_TYPES
+};
+
+typedef struct {
+    int node;                                   // id do nó (nodeN)
+
+    /* Memória do processo neste nó (numa_maps), em bytes */
+    unsigned long long bytes[NUMA_MAP_TYPES];   // por tipo de mapeamento
+    unsigned long long total_bytes;
+
+    /* Contadores do nó inteiro (numastat), por segundo */
+    double numa_hit_per_sec;      // alocação atendida no nó desejado
+    double numa_miss_per_sec;     // alocação que caiu aqui por falta de espaço no desejado
+    double numa_foreign_per_sec;  // alocação destinada aqui que foi para outro nó
+    double local_node_per_sec;    // alocação feita por processo rodando neste nó
+    double other_node_per_sec;    // alocação feita por processo rodando em outro nó
+
+    /* Onde as threads do processo estão executando */
+    int threads;                  // threads cujo último CPU pertence a este nó
+    double thread_cpu_percent;    // soma do CPU% dessas threads (100% = um core)
+} NumaNodeUsage;
+
+typedef struct {
+    pid_t pid;
+    time_t timestamp;  // instante da coleta
+
+    int num_nodes;                       // entradas válidas em nodes
+    NumaNodeUsage nodes[NUMA_MAX_NODES];
+    unsigned long long total_bytes;      // memória do processo em todos os nós
+
+    // Fração da memória que está no mesmo nó do CPU que a usa, ponderada
+    // pelo CPU% das threads (sem uso de CPU, todas as threads pesam igual)
+    double local_percent;
+    double remote_percent;
+} NumaSample;
+
+typedef struct {
+    pid_t pid;
+    int num_nodes;
+    int node_ids[NUMA_MAX_NODES];
+    short cpu_to_node[NUMA_MAX_CPUS];    // índice em node_ids, -1 = desconhecido
+    unsigned long long last_numastat[NUMA_MAX_NODES][5];
+    struct timespec last_ts;
+    ThreadMonitorState threads;          // colocação das threads por CPU
+    ThreadSample top[NUMA_THREAD_TOP];
+    char *buf;                           // buffer de numa_maps (cresce se preciso)
+    size_t buf_capacity;
+} NumaMonitorState;
+
+int numa_monitor_init(NumaMonitorState *state, pid_t pid);
+int numa_monitor_sample(NumaMonitorState *state, NumaSample *sample);
+void numa_monitor_free(NumaMonitorState *state);
+int numa_sample_csv_write(const NumaSample *sample);
+void numa_sample_csv_close(void);
+
+/* ================== MEMORY MAP (VMA) SAMPLE ================== */
+
+// Classificação das regiões de /proc/<pid>/maps
+enum {
+    VMA_HEAP,          // [heap] (brk)
+    VMA_STACK,         // [stack] da thread principal
+    VMA_THREAD_STACK,  // anônima logo acima de uma página de guarda (pilha de pthread)
+    VMA_ARENA,         // anônima alinhada em 64 MB (heap de arena do malloc)
+    VMA_ANON,          // demais mmaps anônimos
+    VMA_FILE,          // arquivos mapeados e bibliotecas
+    VMA_SHMEM,         // /dev/shm, SysV, memfd
+    VMA_SPECIAL,       // [vdso], [vvar], [vsyscall]...
+    VMA_GUARD,         // ---p sem acesso (guardas e reservas)
+    VMA_KINDS
+};
+
+typedef struct {
+    unsigned long long start;       // endereço inicial (inclusivo)
+    unsigned long long end;         // endereço final (exclusivo)
+    unsigned long long offset;      // offset no arquivo
+    unsigned long long inode;
+    unsigned long long rss_bytes;   // do último smaps (0 até a primeira leitura)
+    unsigned int line_off;          // linha no buffer do snapshot
+    unsigned int line_len;
+    unsigned short name_rel;        // nome = início da linha + name_rel
+    unsigned short name_len;
+    char perms[4];                  // rwxp
+    unsigned char kind;             // VMA_*
+} VmaRegion;
+
+// Um snapshot de maps: regiões ordenadas por endereço (índice de intervalos)
+typedef struct {
+    VmaRegion *regions;
+    size_t count;
+    size_t capacity;
+    char *buf;                      // texto de maps de onde vêm os nomes
+    size_t len;
+    size_t buf_capacity;
+} VmaSnapshot;
+
+enum { VMA_APPEARED, VMA_VANISHED, VMA_GREW, VMA_SHRANK };
+
+typedef struct {
+    int type;                       // VMA_APPEARED, ...
+    int kind;                       // VMA_HEAP, ...
+    unsigned long long start;
+    unsigned long long end;
+    long long delta_bytes;          // variação de tamanho virtual
+    const char *name;               // não terminado em '\0'; usar name_len
+    int name_len;
+} VmaChange;
+
+typedef struct {
+    pid_t pid;
+    time_t timestamp;  // instante da coleta
+
+    size_t num_regions;
+    unsigned long long virt_bytes[VMA_KINDS];  // tamanho virtual por tipo
+    unsigned long long rss_bytes[VMA_KINDS];   // residente por tipo (último smaps)
+    int smaps_fresh;                           // 1 se smaps foi lido nesta amostra
+
+    /* Diferença em relação ao snapshot anterior */
+    int appeared, vanished, grew, shrank;
+    long long grown_bytes;                     // soma das regiões que cresceram ou surgiram
+    long long shrunk_bytes;                    // soma das que encolheram ou sumiram
+    const VmaChange *changes;                  // válido até a próxima amostra
+    size_t num_changes;
+
+    /* Custo */
+    size_t lines_reused;                       // linhas idênticas ao snapshot anterior
+    size_t lines_parsed;
+    unsigned long long cost_ns;                // leitura + parse + diff de maps
+    unsigned long long smaps_cost_ns;          // leitura de smaps (0 se não leu)
+} VmaSample;
+
+typedef struct {
+    pid_t pid;
+    int smaps_every;                // lê smaps a cada N amostras (0 = nunca)
+    int tick;
+    VmaSnapshot snaps[2];
+    int cur;                        // snapshot atual em snaps
+    VmaChange *changes;
+    size_t num_changes;
+    size_t changes_capacity;
+    char *smaps_buf;
+    size_t smaps_capacity;
+} VmaMonitorState;
+
+int vma_monitor_init(VmaMonitorState *state, pid_t pid, int smaps_every);
+int vma_monitor_sample(VmaMonitorState *state, VmaSample *sample);
+const VmaRegion *vma_monitor_find(const VmaMonitorState *state, unsigned long long addr);
+const char *vma_kind_name(int kind);
+void vma_monitor_free(VmaMonitorState *state);
+int vma_sample_csv_write(const VmaSample *sample);
+void vma_sample_csv_close(void);
+
+/* ================== PERF COUNTER SAMPLE ================== */
+
+// Contadores lidos via perf_event_open (hardware primeiro, depois software)
+enum {
+    PERF_CNT_CYCLES, PERF_CNT_INSTRUCTIONS, PERF_CNT_CACHE_REFS,
+    PERF_CNT_CACHE_MISSES, PERF_CNT_BRANCH_MISSES,
+    PERF_CNT_TASK_CLOCK, PERF_CNT_PAGE_FAULTS, PERF_CNT_CPU_MIGRATIONS,
+    PERF_CNT_CONTEXT_SWITCHES,
+    PERF_COUNTERS
+};
+
+#define PERF_HW_COUNTERS 5  // os 5 primeiros são de hardware (PMU)
+
+typedef struct {
+    pid_t pid;
+    time_t timestamp;  // instante da coleta
+
+    int hw_available;                          // 0 se a PMU não está exposta (VMs)
+    int threads;                               // threads com contadores abertos
+    int skipped_threads;                       // threads sem contadores por falta de descritores
+    int failed_opens;                          // eventos que não abriram (contam 0 nesta amostra)
+    unsigned long long delta[PERF_COUNTERS];   // variação no intervalo (escalada se houve multiplexação)
+    double per_sec[PERF_COUNTERS];             // delta / intervalo
+
+    double ipc;                    // instructions / cycles
+    double cache_miss_percent;     // cache-misses / cache-references
+    double branch_misses_per_kinst;// branch-misses por mil instruções
+    double cpu_utilization;        // task-clock / intervalo (1.0 = um core)
+    double multiplex_percent;      // fração do tempo em que a PMU contou de fato (100 = sem multiplexação)
+} PerfSample;
+
+typedef struct {
+    pid_t tid;
+    int hw_fd;          // líder do grupo de hardware (-1 se indisponível)
+    int sw_fd;          // líder do grupo de software
+    int hw_fds[PERF_HW_COUNTERS];
+    int sw_fds[PERF_COUNTERS - PERF_HW_COUNTERS];
+} PerfThreadGroup;
+
+typedef struct {
+    pid_t pid;
+    int hw_available;
+    int exclude_kernel;                        // 1 se perf_event_paranoid exigiu só user space
+    PerfThreadGroup *groups;                   // um par de grupos por thread existente no init
+    int ngroups;
+    int skipped_threads;                       // threads deixadas de fora pelo limite de descritores
+    int failed_opens;                          // eventos de threads vivas que o kernel recusou
+    unsigned long long last[PERF_COUNTERS];
+    unsigned long long last_enabled;
+    unsigned long long last_running;
+    struct timespec last_ts;
+} PerfCounterState;
+
+int perf_counters_init(PerfCounterState *state, pid_t pid);
+int perf_counters_sample(PerfCounterState *state, PerfSample *sample);
+void perf_counters_free(PerfCounterState *state);
+int perf_sample_csv_write(const PerfSample *sample);
+void perf_sample_csv_close(void);
+
+/* ================== STACK PROFILER ================== */
+
+#define STACK_MAX_DEPTH 127          // frames por amostra (limite padrão do kernel)
+#define STACK_DEFAULT_FREQ 99        // Hz; fora de fase com timers de 100 Hz
+#define STACK_RING_PAGES 64          // páginas de dados por ring (potência de 2)
+#define STACK_FUNC_LEN 128
+
+typedef struct {
+    char *stack;                 // "comm;raiz;...;folha"
+    unsigned long long hash;
+    unsigned long long count;
+} FoldedEntry;
+
+typedef struct {
+    FoldedEntry *entries;        // endereçamento aberto; stack == NULL é vazio
+    size_t capacity;             // potência de 2
+    size_t count;
+} FoldedTable;
+
+typedef struct {
+    pid_t tid;
+    int fd;
+    void *ring;                  // perf_event_mmap_page + dados
+    size_t ring_size;
+    char comm[THREAD_COMM_LEN];
+    int seen;                    // marcado na última varredura de /proc/<pid>/task
+} StackThread;
+
+typedef struct {
+    pid_t pid;
+    time_t timestamp;            // instante da coleta
+
+    double cpu_percent;          // preenchido por quem chama, vindo do monitor de CPU
+    double sampled_cpu_percent;  // amostras / (freq * intervalo), para conferência
+    unsigned long long samples;  // amostras no intervalo
+    unsigned long long lost;     // registros perdidos por ring cheio
+    int threads;                 // threads com sampler aberto
+    char top_function[STACK_FUNC_LEN]; // função folha mais amostrada no intervalo
+    double top_percent;          // fração das amostras do intervalo nessa função
+} StackInterval;
+
+typedef struct {
+    pid_t pid;
+    int freq;
+    int exclude_kernel;          // 1 se perf_event_paranoid exigiu só user space
+    StackThread *threads;
+    int nthreads;
+    int threads_capacity;
+    void *symbolizer;            // Symbolizer (symbolizer.h), alocado no init
+    unsigned long long unknown_seen; // frames sem região conhecida desde o último reload de maps
+    FoldedTable stacks;          // perfil acumulado da sessão
+    FoldedTable leaves;          // funções folha do intervalo corrente
+    unsigned long long total_samples;
+    unsigned long long total_lost;
+    unsigned long long interval_samples;
+    unsigned long long interval_lost;
+    struct timespec last_ts;
+} StackProfilerState;
+
+int stack_profiler_init(StackProfilerState *state, pid_t pid, int freq_hz);
+int stack_profiler_poll(StackProfilerState *state);
+int stack_profiler_interval(StackProfilerState *state, StackInterval *interval);
+int stack_profiler_write_folded(const StackProfilerState *state, FILE *fp);
+void stack_profiler_free(StackProfilerState *state);
+int stack_interval_csv_write(const StackInterval *interval);
+void stack_interval_csv_close(void);
+
+/* ================== OFF-CPU SAMPLE ================== */
+
+#define OFFCPU_DEFAULT_HZ 100       // varreduras por segundo
+#define OFFCPU_MAX_BUCKETS 256      // motivos de espera distintos por resumo
+#define OFFCPU_TOP 16               // motivos reportados por resumo
+#define OFFCPU_LABEL_LEN 160
+#define OFFCPU_FD_CACHE 256         // fds com alvo (readlink) em cache por resumo
+
+typedef struct {
+    char state;                     // 'R', 'S', 'D', ...
+    char label[OFFCPU_LABEL_LEN];   // ex.: "futex [futex_wait_queue]", "read(fd 7 socket:[123])"
+    unsigned long long hash;
+    unsigned long long samples;     // amostras de thread nesse motivo
+} OffCpuBucket;
+
+typedef struct {
+    pid_t pid;
+    time_t timestamp;               // instante do resumo
+
+    unsigned long long ticks;       // varreduras no período
+    unsigned long long thread_samples; // soma de threads vistas em todas as varreduras
+    double achieved_hz;             // varreduras por segundo realmente feitas
+    int threads;                    // threads acompanhadas no fim do período
+    unsigned long long running;     // amostras em R (na CPU ou na fila)
+    unsigned long long sleeping;    // amostras em S
+    unsigned long long disk_wait;   // amostras em D
+    unsigned long long other;       // T, t, Z, ...
+    OffCpuBucket top[OFFCPU_TOP];   // motivos mais frequentes, em ordem
+    int ntop;
+    unsigned long long overflow;    // amostras de motivos que não couberam nos OFFCPU_MAX_BUCKETS
+    double scan_us;                 // custo médio de uma varredura
+} OffCpuSummary;
+
+typedef struct {
+    pid_t tid;
+    int stat_fd;                    // fds mantidos abertos e relidos com pread
+    int wchan_fd;
+    int syscall_fd;
+    int seen;
+} OffCpuThread;
+
+typedef struct {
+    int fd;                         // -1 = vazio
+    char target[64];
+} OffCpuFdCache;
+
+typedef struct {
+    pid_t pid;
+    OffCpuThread *threads;
+    int nthreads;
+    int threads_capacity;
+    OffCpuBucket buckets[OFFCPU_MAX_BUCKETS];
+    int nbuckets;
+    unsigned long long overflow;    // amostras que não couberam em buckets
+    OffCpuFdCache fd_cache[OFFCPU_FD_CACHE];
+    unsigned long long ticks;
+    unsigned long long thread_samples;
+    unsigned long long state_counts[4]; // running, sleeping, disk_wait, other
+    double scan_us_total;
+    struct timespec period_start;
+} OffCpuState;
+
+int offcpu_monitor_init(OffCpuState *state, pid_t pid);
+int offcpu_monitor_tick(OffCpuState *state);
+int offcpu_monitor_summary(OffCpuState *state, OffCpuSummary *summary);
+void offcpu_monitor_free(OffCpuState *state);
+int offcpu_summary_csv_write(const OffCpuSummary *summary);
+void offcpu_summary_csv_close(void);
+
+/* ================== SCHEDULER SAMPLE ================== */
+
+#define SCHED_THREAD_TOP 16   // threads com maior espera na fila reportadas por amostra
+
+typedef struct {
+    pid_t tid;
+    char comm[THREAD_COMM_LEN];
+    double run_ms_per_sec;          // tempo na CPU por segundo
+    double delay_ms_per_sec;        // tempo esperando na fila de execução por segundo
+    double delay_per_slice_us;      // espera média antes de cada timeslice
+    double timeslices_per_sec;
+    double voluntary_per_sec;
+    double nonvoluntary_per_sec;
+    double migrations_per_sec;
+} SchedThreadSample;
+
+typedef struct {
+    pid_t pid;
+    time_t timestamp;  // instante da coleta
+
+    int threads;                    // threads lidas nesta amostra
+    double run_ms_per_sec;          // soma das threads (1000 = um core ocupado)
+    double delay_ms_per_sec;        // soma das threads (1000 = uma thread sempre esperando)
+    double wait_percent;            // delay / (run + delay): quanto do tempo querendo CPU foi fila
+    double delay_per_slice_us;
+    double timeslices_per_sec;
+    double voluntary_per_sec;       // bloqueios (I/O, locks, sleeps)
+    double nonvoluntary_per_sec;    // preempções: fatia esgotada ou vizinho com prioridade
+    double migrations_per_sec;      // trocas de CPU (se.nr_migrations)
+    double blkio_delay_ms_per_sec;  // espera por I/O de bloco (delay accounting); -1 se desligado
+    SchedThreadSample top[SCHED_THREAD_TOP]; // ordenadas por delay_ms_per_sec
+    int ntop;
+} SchedSample;
+
+typedef struct {
+    pid_t tid;
+    char comm[THREAD_COMM_LEN];
+    unsigned long long run_ns;      // schedstat: tempo na CPU
+    unsigned long long delay_ns;    // schedstat: tempo na fila
+    unsigned long long timeslices;  // schedstat: vezes que ganhou a CPU
+    unsigned long long voluntary;   // sched: nr_voluntary_switches
+    unsigned long long nonvoluntary;// sched: nr_involuntary_switches
+    unsigned long long migrations;  // sched: se.nr_migrations
+    unsigned long long blkio_ticks; // stat campo 42: delayacct_blkio_ticks
+    int seen;
+} SchedThreadState;
+
+typedef struct {
+    pid_t pid;
+    int delayacct;                  // kernel.task_delayacct ligado
+    long ticks_per_sec;
+    SchedThreadState *threads;
+    int nthreads;
+    int threads_capacity;
+    struct timespec last_ts;
+} SchedMonitorState;
+
+int sched_monitor_init(SchedMonitorState *state, pid_t pid);
+int sched_monitor_sample(SchedMonitorState *state, SchedSample *sample);
+void sched_monitor_free(SchedMonitorState *state);
+int sched_sample_csv_write(const SchedSample *sample);
+void sched_sample_csv_close(void);
+
+/* ================== PROCESS TREE SAMPLE ================== */
+
+typedef struct {
+    pid_t pid;
+    pid_t ppid;
+    char comm[THREAD_COMM_LEN];
+    double cpu_percent;                 // próprio processo (100% = um core inteiro)
+    double exited_children_cpu_percent; // filhos que terminaram no intervalo (cutime/cstime)
+    unsigned long long rss_kb;
+    unsigned long long threads;
+} ProcTreeMemberSample;
+
+typedef struct {
+    pid_t root;
+    time_t timestamp;  // instante da coleta
+
+    int using_netlink;              // 1 = proc connector, 0 = varredura de /proc
+    int members;                    // processos vivos na árvore
+    int forks;                      // processos que entraram no intervalo
+    int exits;                      // processos que saíram no intervalo
+    double cpu_percent;             // soma: membros + filhos que terminaram
+    double exited_cpu_percent;      // parcela de filhos que terminaram
+    unsigned long long rss_kb;      // soma dos membros (páginas compartilhadas contam repetido)
+    unsigned long long threads;
+    ProcTreeMemberSample *rows;     // uma linha por membro (vetor do estado, vale até o próximo sample)
+    int nrows;
+} ProcTreeSample;
+
+typedef struct {
+    pid_t pid;
+    pid_t ppid;
+    char comm[THREAD_COMM_LEN];
+    unsigned long long own_ticks;       // utime + stime na última leitura
+    unsigned long long child_ticks;     // cutime + cstime na última leitura
+    unsigned long long reaped_seen;     // ticks já contados de filhos que este processo recolheu
+    unsigned long long starttime;       // stat campo 22: identidade junto com o pid (0 = ainda não lido)
+    int exited;                         // proc connector avisou a saída
+    int fresh;                          // entrou depois da última amostra (own_ticks base 0)
+} ProcTreeMember;
+
+typedef struct {
+    pid_t root;
+    int nl_fd;                          // socket do proc connector, -1 = fallback por varredura
+    ProcTreeMember *members;
+    int nmembers;
+    int capacity;
+    ProcTreeMemberSample *rows;
+    int forks;
+    int exits;
+    long ticks_per_sec;
+    long page_kb;
+    struct timespec last_ts;
+} ProcTreeState;
+
+int proc_tree_init(ProcTreeState *state, pid_t root);
+int proc_tree_sample(ProcTreeState *state, ProcTreeSample *sample);
+void proc_tree_free(ProcTreeState *state);
+int proc_tree_csv_write(const ProcTreeSample *sample);
+void proc_tree_csv_close(void);
+
+/* ================= AUTO-INSTRUMENTAÇÃO ================= */
+
+#define OVERHEAD_BUCKETS 40  // bucket i = [2^i, 2^(i+1)) ns
+
+// Etapas de um ciclo do próprio monitor
+typedef enum {
+    OVERHEAD_READ = 0,   // leituras do kernel (proc_read_file e lote)
+    OVERHEAD_PARSE,      // coletores menos as leituras: parsing e deltas
+    OVERHEAD_COMPUTE,    // depois dos coletores: registro, identidade do alvo, contabilidade
+    OVERHEAD_OUTPUT,     // destinos no thread escritor, por registro
+    OVERHEAD_TICK,       // ciclo inteiro no thread de coleta
+    OVERHEAD_JITTER,     // atraso do início do ciclo em relação ao horário marcado
+    OVERHEAD_STAGES
+} OverheadStage;
+
+typedef struct {
+    unsigned long long count;
+    unsigned long long sum_ns;
+    unsigned long long min_ns;
+    unsigned long long max_ns;
+    unsigned long long buckets[OVERHEAD_BUCKETS];
+} OverheadHistogram;
+
+// Custo de um ciclo, para a série do próprio monitor (overhead-monitor-*.csv)
+typedef struct {
+    time_t timestamp;
+    unsigned long long tick;
+    unsigned long long read_ns;
+    unsigned long long parse_ns;
+    unsigned long long compute_ns;
+    unsigned long long tick_ns;
+    unsigned long long jitter_ns;
+    unsigned long long syscalls;       // syscalls de leitura no ciclo
+    unsigned long long bytes_read;     // bytes lidos do kernel no ciclo
+    double cpu_percent;                // CPU do monitor (todos os threads) desde o ciclo anterior
+    long max_rss_kb;                   // pico de RSS do monitor (getrusage)
+} OverheadSample;
+
+// Cada histograma tem um único thread escritor: OUTPUT é do thread
+// escritor do pipeline, os demais do thread de coleta
+typedef struct {
+    OverheadHistogram stages[OVERHEAD_STAGES];
+    unsigned long long ticks;
+    long long start_ns;                 // CLOCK_MONOTONIC_RAW do init
+    long long tick_start_ns;
+    long long collect_end_ns;
+    unsigned long long jitter_ns;
+    unsigned long long mark_syscalls;   // contadores de leitura no início do ciclo
+    unsigned long long mark_bytes;
+    unsigned long long mark_read_ns;
+    unsigned long long start_syscalls;  // ... e no init
+    unsigned long long start_bytes;
+    long long start_cpu_us;             // getrusage no init
+    long long last_cpu_us;              // getrusage no fim do ciclo anterior
+    long long last_wall_ns;
+    OverheadSample last;                // último ciclo (parse/read do trecho dos coletores)
+} OverheadState;
+
+int overhead_init(OverheadState *state);
+long long overhead_now_ns(void);
+void overhead_record(OverheadHistogram *hist, unsigned long long ns);
+void overhead_tick_begin(OverheadState *state, long long lateness_ns);
+void overhead_collect_done(OverheadState *state);
+void overhead_tick_end(OverheadState *state, OverheadSample *sample);
+void overhead_print_summary(const OverheadState *state, FILE *fp);
+int overhead_csv_write(const OverheadSample *sample);
+void overhead_csv_close(void);
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stddef.h>    // size_t, offsetof
+#include <time.h>      // time_t
+
+#include "monitor.h"
+
+/*
+ * Pipeline de amostras: separa a coleta da saída.
+ *
+ * O thread de amostragem empurra registros de tamanho fixo num anel
+ * lock-free de um produtor e um consumidor; um thread escritor drena o anel
+ * para os destinos (CSV, binário, console). Disco ou terminal lentos só
+ * atrasam o escritor: a coleta nunca bloqueia. Com o anel cheio a amostra é
+ * descartada e contada em dropped, em vez de segurar o produtor.
+ */
+
+#define PIPELINE_DEFAULT_CAPACITY 1024  // registros no anel (potência de 2)
+#define PIPELINE_MAX_SINKS 8
+
+#define SAMPLE_HAS_CPU    0x1u
+#define SAMPLE_HAS_MEMORY 0x2u
+#define SAMPLE_HAS_IO     0x4u
+#define SAMPLE_HAS_OVERHEAD 0x8u  // custo do próprio monitor no ciclo
+#define SAMPLE_HAS_CGROUP 0x10u   // uso do cgroup v2 do alvo
+
+// Arquivos de uso do cgroup do alvo. Contadores acumulados, exceto a memória.
+typedef struct {
+    long long memory_bytes;   // memory.current
+    long long cpu_usage_usec; // usage_usec de cpu.stat
+    long long io_read_bytes;  // rbytes de io.stat (todos os dispositivos)
+    long long io_write_bytes;
+} CgroupUsageSample;
+
+// Uma coleta completa de um alvo. Tamanho fixo: copiado inteiro para o anel.
+typedef struct {
+    unsigned long long seq;  // número da coleta (contando as descartadas)
+    long long sampled_ns;    // CLOCK_MONOTONIC da coleta
+    pid_t pid;
+    unsigned flags;          // SAMPLE_HAS_*
+    CpuSample cpu;
+    MemorySample memory;
+    IoSample io;
+    CgroupUsageSample cgroup;
+    OverheadSample overhead;
+} SampleRecord;
+
+/*
+ * Catálogo das métricas numéricas de um SampleRecord, comum aos resumos e
+ * exportadores: cada uma é lida por deslocamento no registro, sem código
+ * por métrica. Contadores acumulados (ticks, bytes de rede) ficam de fora:
+ * os valores por intervalo já estão nas taxas.
+ */
+typedef enum {
+    METRIC_DOUBLE,
+    METRIC_U64,
+} SampleMetricType;
+
+typedef struct {
+    const char *name;
+    const char *unit;
+    unsigned flag;           // SAMPLE_HAS_* do bloco em que a métrica está
+    size_t offset;           // offsetof(SampleRecord, ...)
+    SampleMetricType type;
+} SampleMetric;
+
+#define SAMPLE_METRIC_COUNT 16
+
+extern const SampleMetric sample_metrics[SAMPLE_METRIC_COUNT];
+
+// Valor da métrica i do catálogo no registro (sem checar flags)
+double sample_metric_value(const SampleRecord *record, int i);
+
+// Instante da coleta: o timestamp do primeiro bloco presente (0 se nenhum)
+time_t sample_record_time(const SampleRecord *record);
+
+// Cabeçalho do arquivo binário: registros SampleRecord crus em seguida
+#define SAMPLE_FILE_MAGIC "RMSAMPLE"
+#define SAMPLE_FILE_VERSION 3
+
+typedef struct {
+    char magic[8];
+    unsigned version;
+    unsigned record_size;    // sizeof(SampleRecord) de quem gravou
+} SampleFileHeader;
+
+#define PIPELINE_FLUSH_RETRY_MS 100
+
+// Destino de saída. write roda no thread escritor; close depois do join.
+typedef struct SampleSink {
+    const char *name;
+    int (*write)(struct SampleSink *sink, const SampleRecord *record);
+    // Opcional: chamado pelo escritor quando o anel esvazia (fim de um lote).
+    // Retornar 1 pede uma nova chamada em PIPELINE_FLUSH_RETRY_MS mesmo sem
+    // registros novos (trabalho adiado); 0 = nada pendente.
+    int (*flush)(struct SampleSink *sink);
+    void (*close)(struct SampleSink *sink);
+    void *ctx;
+    unsigned wants;                 // SAMPLE_HAS_* de fora do catálogo que o destino usa (ex.: SAMPLE_HAS_CGROUP)
+    unsigned long long written;
+    unsigned long long errors;
+} SampleSink;
+
+typedef struct {
+    SampleRecord *slots;
+    size_t capacity;
+    _Alignas(64) atomic_size_t head;        // escrito só pelo produtor
+    _Alignas(64) atomic_size_t tail;        // escrito só pelo consumidor
+    _Alignas(64) atomic_ullong dropped;     // amostras descartadas com o anel cheio
+    unsigned long long pushed;              // aceitas no anel (produtor)
+    unsigned long long next_seq;
+    size_t max_depth;                       // maior ocupação vista pelo produtor
+    atomic_ullong drained;                  // entregues aos destinos (consumidor)
+    atomic_llong max_lag_ns;                // maior atraso coleta -> escrita
+    OverheadHistogram *output_hist;         // tempo dos destinos por registro (NULL = não mede)
+    sem_t items;                            // acorda o escritor
+    atomic_int stop;
+    pthread_t writer;
+    int running;
+    SampleSink sinks[PIPELINE_MAX_SINKS];
+    int nsinks;
+} SamplePipeline;
+
+/**
+ * Aloca o anel
+ * @param pipeline Estado a inicializar
+ * @param capacity Registros no anel (arredondado para potência de 2; 0 = padrão)
+ * @return 0 em sucesso, -1 em erro
+ */
+int pipeline_init(SamplePipeline *pipeline, size_t capacity);
+
+// Acrescenta um destino (antes de pipeline_start). Retorna 0 ou -1.
+int pipeline_add_sink(SamplePipeline *pipeline, const SampleSink *sink);
+
+// Cria o thread escritor. Retorna 0 ou -1.
+int pipeline_start(SamplePipeline *pipeline);
+
+/**
+ * Entrega uma coleta ao escritor sem bloquear. seq é preenchido aqui.
+ * @return 0 se entrou no anel, -1 se foi descartada (anel cheio)
+ */
+int pipeline_push(SamplePipeline *pipeline, SampleRecord *record);
+
+// Como pipeline_push, mas espera o escritor abrir espaço em vez de descartar,
+// e acorda o escritor por lote. Para a reprodução de capturas, em que o
+// produtor não tem prazo; o último lote sai no pipeline_stop.
+void pipeline_push_wait(SamplePipeline *pipeline, SampleRecord *record);
+
+// Drena o que restou no anel, encerra o escritor e fecha os destinos.
+void pipeline_stop(SamplePipeline *pipeline);
+
+void pipeline_free(SamplePipeline *pipeline);
+
+/* Destinos prontos */
+int sample_sink_csv(SampleSink *sink);                       // cpu/memory/io-monitor-*.csv
+int sample_sink_binary(SampleSink *sink, const char *path);  // path NULL = samples-*.bin
+int sample_sink_console(SampleSink *sink);                   // quadro por coleta no terminal
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef PROC_BATCH_H
+#define PROC_BATCH_H
+
+#include <stddef.h>    // size_t
+#include <sys/types.h> // ssize_t
+
+/*
+ * Lote de leituras de /proc, /sys e cgroup feitas uma vez por ciclo.
+ *
+ * Cada arquivo registrado fica aberto e é relido do offset 0 a cada ciclo
+ * (os arquivos do kernel são regenerados a cada leitura do início). Com
+ * io_uring, o ciclo inteiro vira um lote de leituras com arquivos e
+ * buffers fixos (IORING_OP_READ_FIXED), submetido e colhido numa única
+ * io_uring_enter por bloco de PROC_BATCH_RING_ENTRIES arquivos. Sem io_uring
+ * (kernel antigo, io_uring_disabled, seccomp) cada arquivo custa um pread,
+ * contra open/read/read/close de proc_read_file.
+ *
+ * Entre proc_batch_begin_tick e proc_batch_end_tick o lote atende as
+ * chamadas de proc_read_file dos coletores pelo caminho, sem mudar os
+ * coletores. Caminhos desconhecidos são lidos normalmente e, com learning
+ * ligado, entram no lote a partir do ciclo seguinte.
+ */
+
+#define PROC_BATCH_SLOT_SIZE 4096      // bytes por arquivo (uma página do seq_file)
+#define PROC_BATCH_RING_ENTRIES 4096   // leituras por io_uring_enter
+#define PROC_BATCH_MAX_FILES 65536
+
+typedef enum {
+    PROC_BATCH_PREAD = 0,  // um pread por arquivo
+    PROC_BATCH_URING = 1   // io_uring com arquivos e buffers fixos
+} ProcBatchBackend;
+
+typedef struct {
+    char *path;
+    int fd;
+    ssize_t len;           // bytes lidos no último ciclo, -1 em erro
+    int error;             // errno da última leitura (0 = ok)
+} ProcBatchFile;
+
+typedef struct ProcBatchUring ProcBatchUring;
+
+typedef struct {
+    ProcBatchFile *files;
+    size_t count;
+    size_t capacity;
+    unsigned *index;       // caminho -> posição + 1 (0 = vazio), endereçamento aberto
+    size_t index_slots;    // potência de 2
+    char *slots;           // capacity * PROC_BATCH_SLOT_SIZE, alinhado em página
+    size_t slots_bytes;
+    ProcBatchBackend backend;
+    ProcBatchUring *uring; // NULL no backend pread
+    int learning;          // registra caminhos pedidos durante o ciclo
+    int dirty;             // conjunto mudou: registrar arquivos/buffers de novo
+    int fresh;             // dados do ciclo atual valem para o gancho
+    unsigned long long ticks;
+    unsigned long long syscalls_last_tick;
+    unsigned long long served;   // leituras atendidas pelo lote
+    unsigned long long passed;   // leituras que foram direto ao kernel
+    double last_tick_ms;
+} ProcBatch;
+
+/**
+ * Inicializa o lote vazio
+ * @param batch Estado a inicializar
+ * @param backend PROC_BATCH_URING tenta io_uring e cai para pread se indisponível
+ * @return 0 em sucesso, -1 em erro
+ */
+int proc_batch_init(ProcBatch *batch, ProcBatchBackend backend);
+
+// Abre e registra um arquivo. Retorna o índice (o mesmo se já registrado) ou -1.
+int proc_batch_add(ProcBatch *batch, const char *path);
+
+// Relê todos os arquivos registrados. Retorna quantos foram lidos ou -1 em erro.
+// Arquivos que falharam (processo encerrado) saem do lote no ciclo seguinte.
+int proc_batch_read_all(ProcBatch *batch);
+
+// Conteúdo do arquivo idx no último ciclo (terminado em '\0'), ou NULL em erro.
+const char *proc_batch_data(const ProcBatch *batch, int idx, ssize_t *len);
+
+// proc_batch_read_all + instala o gancho de proc_read_file.
+int proc_batch_begin_tick(ProcBatch *batch);
+
+// Remove o gancho; leituras fora do ciclo voltam a ir direto ao kernel.
+void proc_batch_end_tick(ProcBatch *batch);
+
+const char *proc_batch_backend_name(const ProcBatch *batch);
+
+void proc_batch_free(ProcBatch *batch);
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef PROC_PARSE_H
+#define PROC_PARSE_H
+
+#include <stddef.h>    // size_t
+#include <sys/types.h> // ssize_t
+
+/*
+ * Parser compartilhado para os arquivos texto de /proc, /sys e cgroup.
+ *
+ * Substitui o sscanf no caminho quente: o formato dos arquivos do kernel é
+ * fixo, então não faz sentido reinterpretar uma string de formato a cada
+ * leitura. Dígitos são convertidos 8 por vez (SWAR) e a busca do N-ésimo
+ * campo usa SSE2 quando disponível, com fallback escalar.
+ *
+ * Todas as funções recebem o fim do buffer (end) e nunca leem além dele.
+ */
+
+/* ===================== RAÍZES ===================== */
+
+// Todos os caminhos dos coletores são montados a partir destas raízes, que
+// por padrão são /proc e /sys. Apontá-las para uma árvore sintética
+// (bench/fixture_gen.c) permite medir e testar com qualquer número de
+// processos, conexões, namespaces e cgroups, sem depender da máquina.
+#define PROC_ROOT_MAX 256
+#define PROC_PATH_MAX 512   // raiz + caminho mais longo montado pelos coletores
+
+// Troca as raízes (NULL mantém a atual). Retorna 0, ou -1 se o caminho for longo demais.
+int proc_set_roots(const char *proc_root, const char *sys_root);
+
+const char *proc_root(void);  // "/proc" ou a raiz configurada
+const char *sys_root(void);   // "/sys" ou a raiz configurada
+
+// 1 se /proc é o do kernel. Numa árvore sintética os pids não existem de
+// verdade: quem usa pidfd, perf_event ou ptrace deve checar antes.
+int proc_root_is_live(void);
+
+// Montam "<raiz>/<rel>" em buf e devolvem buf (para caminhos sem parâmetros).
+const char *proc_path(char *buf, size_t size, const char *rel);
+const char *sys_path(char *buf, size_t size, const char *rel);
+
+/* ===================== LEITURA ===================== */
+
+// Lê o arquivo inteiro (até size - 1 bytes) com open/read/close e termina com '\0'.
+// Retorna o número de bytes lidos ou -1 em erro. Arquivos maiores que o
+// buffer são truncados, o que basta para quem só precisa do início.
+ssize_t proc_read_file(const char *path, char *buf, size_t size);
+
+// Lê o arquivo inteiro para *buf, crescendo o buffer com realloc quando não
+// couber (maps, numa_maps, smaps). *buf e *capacity são reaproveitados entre
+// chamadas; o chamador libera *buf. Retorna o número de bytes ou -1 em erro.
+ssize_t proc_read_file_dyn(const char *path, char **buf, size_t *capacity);
+
+// Recebe um bloco de um arquivo lido em partes e devolve quantos bytes
+// consumiu (as linhas completas); o resto volta no início do próximo bloco.
+typedef size_t (*ProcChunkFn)(void *ctx, const char *data, size_t len);
+
+// Lê o arquivo em blocos de até size - 1 bytes de buf e entrega cada um a
+// chunk, para arquivos grandes demais para ler inteiros (net/tcp). Passa pela
+// fonte, pelo gancho e pelo observador como proc_read_file; com o observador
+// instalado o arquivo é lido inteiro uma vez, porque a gravação guarda o
+// conteúdo de uma só vez. Uma linha maior que buf encerra a leitura.
+// Retorna o número de bytes lidos ou -1 em erro.
+ssize_t proc_read_file_chunked(const char *path, char *buf, size_t size, ProcChunkFn chunk, void *ctx);
+
+// Retorno do gancho para "não é comigo": proc_read_file segue com a leitura normal.
+#define PROC_READ_PASS (-2)
+
+// Gancho consultado por proc_read_file antes de abrir o arquivo. Retorna os
+// bytes copiados para buf (terminado em '\0'), -1 para erro de leitura, ou
+// PROC_READ_PASS. Usado pelo lote de leituras (proc_batch.h).
+typedef ssize_t (*ProcReadHook)(void *ctx, const char *path, char *buf, size_t size);
+
+// Instala (ou remove, com NULL) o gancho de proc_read_file.
+void proc_set_read_hook(ProcReadHook hook, void *ctx);
+
+// Observador de leituras: recebe o conteúdo exato que proc_read_file e
+// proc_read_file_dyn devolveram (len -1 se a leitura falhou), venha do
+// kernel ou do gancho. Usado pela gravação de capturas (capture.h).
+typedef void (*ProcReadTap)(void *ctx, const char *path, const char *data, ssize_t len);
+
+// Instala (ou remove, com NULL) o observador de leituras.
+void proc_set_read_tap(ProcReadTap tap, void *ctx);
+
+// Fonte que substitui o kernel por completo (reprodução de uma captura).
+// Aponta *data para o conteúdo gravado de path e devolve o tamanho, ou -1
+// se a leitura falhou na captura ou não foi gravada. O conteúdo vale até a
+// próxima chamada.
+typedef ssize_t (*ProcReadSource)(void *ctx, const char *path, const char **data);
+
+// Instala (ou remove, com NULL) a fonte de leituras.
+void proc_set_read_source(ProcReadSource source, void *ctx);
+
+// Custo acumulado das leituras do kernel feitas por proc_read_file,
+// proc_read_file_dyn, proc_read_file_chunked e pelo lote (proc_batch.h)
+// desde o início.
+typedef struct {
+    unsigned long long syscalls;   // open/read/pread/close/io_uring_enter
+    unsigned long long bytes;      // bytes entregues pelo kernel
+    unsigned long long ns;         // tempo dentro das leituras (CLOCK_MONOTONIC_RAW)
+} ProcReadStats;
+
+void proc_read_stats(ProcReadStats *out);
+
+// Atalho para proc_read_stats(...).syscalls.
+unsigned long long proc_read_syscalls(void);
+
+// Soma uma leitura feita fora deste arquivo aos contadores acima.
+void proc_account_read(unsigned long long syscalls, unsigned long long bytes, unsigned long long ns);
+
+/* ===================== CAMPOS ===================== */
+
+// Avança até o início do campo de índice n (0 = primeiro campo a partir de p).
+// Campos são separados por um ou mais espaços. Retorna NULL se não houver.
+const char *proc_skip_fields(const char *p, const char *end, int n);
+
+// Converte um decimal sem sinal (pula espaços antes). Retorna o ponteiro
+// logo após o último dígito, ou NULL se não houver dígito.
+const char *proc_parse_u64(const char *p, const char *end, unsigned long long *out);
+
+// Igual a proc_parse_u64, aceitando um sinal '-' opcional.
+const char *proc_parse_i64(const char *p, const char *end, long long *out);
+
+// Converte um hexadecimal sem prefixo (pula espaços antes).
+const char *proc_parse_hex(const char *p, const char *end, unsigned long long *out);
+
+// Retorna o início da próxima linha, ou end se esta for a última.
+const char *proc_next_line(const char *p, const char *end);
+
+/* ================= ARQUIVOS "chave: valor" ================= */
+
+#define PROC_KEY_TABLE_SLOTS 64  // potência de 2, maior que o dobro de chaves
+
+typedef struct {
+    const char *key;    // NULL = slot vazio
+    unsigned char len;
+    int index;          // posição do valor no vetor de saída
+} ProcKeySlot;
+
+typedef struct {
+    ProcKeySlot slots[PROC_KEY_TABLE_SLOTS];
+    int nkeys;
+} ProcKeyTable;
+
+// Monta a tabela de busca para as chaves (sem o ':' final). keys[i] vai para values[i].
+int proc_key_table_init(ProcKeyTable *table, const char *const *keys, int nkeys);
+
+// Percorre um arquivo "chave: valor", "chave valor" ou "chave   :   valor"
+// (/proc/<pid>/sched) e preenche values[] para
+// as chaves da tabela (as demais ficam intactas). Para quando todas forem achadas.
+// Retorna quantas chaves foram encontradas.
+int proc_parse_kv(const char *buf, size_t len, const ProcKeyTable *table, unsigned long long *values);
+
+#endif
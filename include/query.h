@@ -0,0 +1,176 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <stdio.h>     // FILE
+#include <sys/types.h> // pid_t
+
+#include "pipeline.h"
+
+/*
+ * Consultas sobre capturas binárias (samples-*.bin).
+ *
+ * O arquivo é dividido em blocos de SAMPLE_INDEX_BLOCK registros, e o
+ * índice (ARQ.idx) guarda:
+ *   - por bloco: primeiro/último timestamp e posição (índice esparso de tempo);
+ *   - por alvo: a lista dos blocos em que ele aparece, cada um com
+ *     contagem, soma, min, max, primeiro e último valor por métrica do
+ *     catálogo (índice de blocos por PID).
+ * Uma consulta só lê registros dos blocos que cruzam as bordas do
+ * intervalo; média, min, max, contagem e taxa dos blocos inteiros saem do
+ * índice. Percentis precisam dos valores: leem os blocos do alvo no
+ * intervalo e passam por StreamStats (stats.h).
+ *
+ * O destino binário escreve o índice ao fechar; um índice ausente ou de
+ * outra versão do arquivo (tamanho ou mtime diferentes) é refeito numa
+ * leitura sequencial e gravado para as próximas consultas.
+ */
+
+#define SAMPLE_INDEX_MAGIC "RMSIDX01"
+#define SAMPLE_INDEX_VERSION 1
+#define SAMPLE_INDEX_BLOCK 8192   // registros por bloco (~3,5 MB)
+
+typedef struct {
+    char magic[8];
+    unsigned version;
+    unsigned record_size;
+    unsigned block_records;
+    unsigned metric_count;
+    unsigned long long capture_size;      // tamanho e mtime do .bin indexado
+    long long capture_mtime_ns;
+    unsigned long long records;
+    unsigned long long nblocks;
+    unsigned long long npids;
+    unsigned long long nentries;
+    int sorted;                           // blocos em ordem de tempo (busca binária)
+    int reserved;
+} SampleIndexHeader;
+
+typedef struct {
+    long long first_ts;
+    long long last_ts;
+    unsigned long long first_record;
+    unsigned long long count;
+} SampleIndexBlock;
+
+// Resumo de um alvo dentro de um bloco
+typedef struct {
+    unsigned long long block;
+    long long first_ts;
+    long long last_ts;
+    unsigned records;
+    unsigned present;                     // bit i: métrica i apareceu
+    unsigned n[SAMPLE_METRIC_COUNT];
+    double sum[SAMPLE_METRIC_COUNT];
+    double min[SAMPLE_METRIC_COUNT];
+    double max[SAMPLE_METRIC_COUNT];
+    double first[SAMPLE_METRIC_COUNT];    // valor no primeiro registro com a métrica
+    double last[SAMPLE_METRIC_COUNT];
+    long long first_at[SAMPLE_METRIC_COUNT];
+    long long last_at[SAMPLE_METRIC_COUNT];
+} SampleIndexEntry;
+
+typedef struct {
+    int pid;
+    unsigned reserved;
+    unsigned long long first_entry;       // entries[first_entry .. first_entry + nentries)
+    unsigned long long nentries;          // em ordem de bloco
+} SampleIndexPid;
+
+typedef struct {
+    SampleIndexHeader header;
+    SampleIndexBlock *blocks;
+    SampleIndexPid *pids;                 // ordenado por pid
+    SampleIndexEntry *entries;
+    void *map;                            // índice lido do disco: mmap do .idx (senão NULL)
+    size_t map_len;
+} SampleIndex;
+
+// Índice em construção, alimentado registro a registro
+typedef struct {
+    SampleIndexBlock *blocks;
+    size_t nblocks, blocks_cap;
+    struct IndexPidEntries *pids;         // ordenado por pid
+    size_t npids, pids_cap;
+    unsigned long long records;
+    int sorted;
+} SampleIndexBuilder;
+
+void sample_index_builder_init(SampleIndexBuilder *builder);
+
+// Acrescenta o próximo registro do arquivo. Retorna 0 ou -1 (sem memória).
+int sample_index_builder_add(SampleIndexBuilder *builder, const SampleRecord *record);
+
+/**
+ * Grava o índice de capture_path em capture_path.idx
+ * @return 0 em sucesso, -1 em erro
+ */
+int sample_index_builder_write(const SampleIndexBuilder *builder, const char *capture_path);
+
+void sample_index_builder_free(SampleIndexBuilder *builder);
+
+/**
+ * Carrega o índice de uma captura, refazendo-o se estiver ausente ou velho
+ * @return 0 em sucesso, -1 em erro
+ */
+int sample_index_load(SampleIndex *index, const char *capture_path);
+
+void sample_index_free(SampleIndex *index);
+
+/* ===================== CONSULTA ===================== */
+
+#define QUERY_MAX_METRICS SAMPLE_METRIC_COUNT
+#define QUERY_MAX_AGGS 8
+
+typedef enum {
+    QUERY_COUNT,
+    QUERY_AVG,
+    QUERY_MIN,
+    QUERY_MAX,
+    QUERY_RATE,          // (último - primeiro) / segundos entre eles; sem agrupar, soma das taxas por alvo
+    QUERY_PERCENTILE,
+} QueryAggKind;
+
+typedef struct {
+    QueryAggKind kind;
+    double q;            // fração, para QUERY_PERCENTILE
+    char name[8];        // "avg", "p99", ...
+} QueryAgg;
+
+typedef struct {
+    pid_t pid;                            // 0 = todos
+    long long from, to;                   // 0 = sem limite
+    int metrics[QUERY_MAX_METRICS];       // índices no catálogo
+    int nmetrics;
+    QueryAgg aggs[QUERY_MAX_AGGS];
+    int naggs;
+    int group_by_pid;                     // 0 = todos os alvos numa linha
+} Query;
+
+typedef struct {
+    unsigned long long targets;
+    unsigned long long entries_used;      // resumos de bloco usados direto do índice
+    unsigned long long blocks_read;       // blocos lidos do .bin
+    unsigned long long records_read;
+    unsigned long long bytes_read;
+} QueryStats;
+
+/**
+ * Lê uma lista de agregações ("avg,max,p99,rate")
+ * @return 0 em sucesso, -1 se algum nome é inválido
+ */
+int query_parse_aggs(Query *query, const char *list);
+
+/**
+ * Lê uma lista de métricas do catálogo ("cpu_percent,rss_bytes")
+ * @return 0 em sucesso, -1 se algum nome é inválido
+ */
+int query_parse_metrics(Query *query, const char *list);
+
+/**
+ * Executa a consulta e escreve o resultado em CSV
+ * (pid,metric,<agregações>)
+ * @return 0 em sucesso, -1 em erro
+ */
+int query_run(const SampleIndex *index, const char *capture_path, const Query *query, FILE *out, QueryStats *stats);
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <sys/types.h> // pid_t
+
+#include "pipeline.h"
+
+/*
+ * Histórico em camadas para monitoramento contínuo.
+ *
+ * Cada registro do pipeline entra na camada bruta (um valor por métrica do
+ * catálogo por coleta) e em baldes de 1 minuto, 10 minutos e 1 hora com
+ * min/max/média/último por métrica. Cada camada é um arquivo de tamanho
+ * fixo em DIR (raw.ring, 1m.ring, 10m.ring, 1h.ring) usado como anel:
+ * quando enche, o slot mais antigo é sobrescrito. A retenção de cada
+ * camada é escolhida na criação, então o disco usado é conhecido de
+ * antemão e a camada bruta some bem antes dos agregados.
+ *
+ * Formato de cada arquivo: RollupFileHeader seguido de capacity slots de
+ * slot_size bytes. Todo slot começa com RollupSlotHeader; seq (crescente,
+ * 0 = vazio) dá a ordem de escrita, então não há ponteiro de escrita para
+ * manter atualizado: na abertura, o maior seq diz onde continuar. Os
+ * valores são float: 7 dígitos bastam para métricas de monitoramento e
+ * dividem o tamanho por dois.
+ */
+
+typedef enum {
+    ROLLUP_RAW = 0,
+    ROLLUP_1M,
+    ROLLUP_10M,
+    ROLLUP_1H,
+    ROLLUP_TIERS,
+} RollupTierId;
+
+#define ROLLUP_MAGIC "RMROLLUP"
+#define ROLLUP_VERSION 1
+#define ROLLUP_DEFAULT_TARGETS 16
+
+typedef struct {
+    char magic[8];
+    unsigned version;
+    unsigned tier_seconds;      // largura do balde (1 na camada bruta: uma coleta por segundo)
+    unsigned slot_size;
+    unsigned metric_count;      // SAMPLE_METRIC_COUNT de quem criou
+    unsigned long long capacity;
+} RollupFileHeader;
+
+typedef struct {
+    unsigned long long seq;     // ordem de escrita; 0 = slot vazio
+    long long start;            // início do balde (time_t, alinhado à largura)
+    int pid;
+    unsigned count;             // coletas agregadas
+    unsigned present;           // bit i: métrica i do catálogo tem valor
+    unsigned reserved;
+} RollupSlotHeader;
+
+// Slot da camada bruta
+typedef struct {
+    RollupSlotHeader h;
+    float value[SAMPLE_METRIC_COUNT];
+} RollupRawSlot;
+
+// Slot das camadas agregadas; também é a linha devolvida na leitura de qualquer camada
+typedef struct {
+    RollupSlotHeader h;
+    float min[SAMPLE_METRIC_COUNT];
+    float max[SAMPLE_METRIC_COUNT];
+    float avg[SAMPLE_METRIC_COUNT];
+    float last[SAMPLE_METRIC_COUNT];
+} RollupRow;
+
+// Balde aberto de um alvo numa camada agregada
+typedef struct {
+    long long start;
+    unsigned count;
+    unsigned present;
+    unsigned n[SAMPLE_METRIC_COUNT];
+    double sum[SAMPLE_METRIC_COUNT];
+    float min[SAMPLE_METRIC_COUNT];
+    float max[SAMPLE_METRIC_COUNT];
+    float last[SAMPLE_METRIC_COUNT];
+} RollupBucket;
+
+typedef struct {
+    pid_t pid;
+    RollupBucket open[ROLLUP_TIERS];    // [ROLLUP_RAW] não é usado
+} RollupTarget;
+
+typedef struct {
+    int fd;
+    unsigned seconds;
+    size_t slot_size;
+    unsigned long long capacity;
+    unsigned long long next_seq;
+    unsigned long long head;            // próximo slot a escrever
+    unsigned long long write_errors;
+} RollupTier;
+
+typedef struct {
+    char dir[256];
+    RollupTier tiers[ROLLUP_TIERS];
+    RollupTarget **targets;             // ordenado por pid
+    size_t count;
+    size_t capacity;
+    size_t max_targets;
+    unsigned long long added;           // coletas recebidas desde a abertura
+    unsigned long long ignored;         // coletas de alvos além de max_targets
+} RollupStore;
+
+extern const char *const rollup_tier_names[ROLLUP_TIERS];   // "raw", "1m", "10m", "1h"
+
+/**
+ * Lê a retenção por camada, ex.: "raw=10m,1m=6h,10m=2d,1h=31d" (unidades
+ * s, m, h, d; camadas omitidas mantêm o valor recebido)
+ * @param retention_sec Segundos guardados por camada (entrada e saída)
+ * @return 0 em sucesso, -1 se a especificação é inválida
+ */
+int rollup_parse_retention(const char *spec, long retention_sec[ROLLUP_TIERS]);
+
+// Retenção padrão: raw 10 min, 1m 6 h, 10m 2 dias, 1h 31 dias
+void rollup_default_retention(long retention_sec[ROLLUP_TIERS]);
+
+/**
+ * Abre (ou cria) o histórico em dir. Os arquivos são dimensionados para
+ * max_targets alvos com a retenção pedida; um histórico existente precisa
+ * ter sido criado com os mesmos tamanhos.
+ * @return 0 em sucesso, -1 em erro
+ */
+int rollup_store_open(RollupStore *store, const char *dir, const long retention_sec[ROLLUP_TIERS], int max_targets);
+
+/**
+ * Acrescenta uma coleta: grava o slot bruto e fecha os baldes que ficaram
+ * para trás no tempo
+ * @return 0 em sucesso, -1 em erro de escrita ou alvo além do limite
+ */
+int rollup_store_add(RollupStore *store, const SampleRecord *record);
+
+// Bytes ocupados pelos arquivos das camadas (cabeçalhos + slots).
+unsigned long long rollup_store_bytes(const RollupStore *store);
+
+// Grava os baldes abertos (parciais) e fecha os arquivos.
+void rollup_store_close(RollupStore *store);
+
+/**
+ * Percorre uma camada em ordem de escrita (cronológica), sem abrir o
+ * histórico para escrita. Linhas da camada bruta vêm com min = max = avg = last.
+ * @param pid Só este alvo (0 = todos)
+ * @param from,to Intervalo de início dos baldes, inclusivo (0 = sem limite)
+ * @param fn Chamada por linha; um retorno diferente de 0 interrompe
+ * @return Linhas entregues, ou -1 em erro
+ */
+long rollup_store_scan(const char *dir, RollupTierId tier, pid_t pid, long long from, long long to,
+                       int (*fn)(const RollupRow *row, void *ctx), void *ctx);
+
+/**
+ * Início do balde mais antigo ainda guardado numa camada
+ * @return 0 em sucesso (*oldest = 0 se a camada está vazia), -1 em erro
+ */
+int rollup_store_oldest(const char *dir, RollupTierId tier, long long *oldest);
+
+// Destino do pipeline que alimenta o histórico em dir.
+int sample_sink_rollup(SampleSink *sink, const char *dir, const long retention_sec[ROLLUP_TIERS], int max_targets);
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>     // FILE
+#include <sys/types.h> // pid_t
+#include <time.h>      // time_t
+
+#include "pipeline.h"
+
+/*
+ * Resumos em fluxo: min, max, média, desvio padrão e percentis de cada
+ * métrica do catálogo (sample_metrics) de cada alvo, atualizados a cada
+ * amostra em O(1) e com memória limitada, sem guardar as linhas.
+ *
+ * Média e variância pelo método de Welford (estável numericamente). Os
+ * percentis saem de um histograma log-linear no estilo HDR: cada potência
+ * de 2 (oitava) é dividida em 32 faixas iguais, então o valor devolvido
+ * fica a no máximo 1/64 (~1,6%) do valor real em qualquer escala, de
+ * frações de ponto percentual a terabytes. As oitavas são alocadas na
+ * primeira amostra que cai nelas: uma métrica ocupa poucas centenas de
+ * bytes e no máximo 16 KB.
+ */
+
+#define STATS_SUB_BUCKETS 32        // faixas por oitava
+#define STATS_MIN_EXP (-16)         // |v| < 2^-16 conta como zero
+#define STATS_OCTAVES 64            // oitavas de 2^-16 a 2^48
+#define STATS_MAX_TARGETS 4096      // alvos distintos num resumo
+
+typedef struct {
+    unsigned long long count;
+    unsigned long long zeros;               // |v| abaixo da resolução
+    double min, max;
+    double mean, m2;                        // Welford: média e soma dos quadrados dos desvios
+    double last;
+    unsigned *pos[STATS_OCTAVES];           // contagens por faixa, v > 0
+    unsigned *neg[STATS_OCTAVES];           // v < 0 (ex.: RSS encolhendo)
+} StreamStats;
+
+void stream_stats_init(StreamStats *stats);
+
+/**
+ * Registra um valor
+ * @return 0 em sucesso, -1 se faltou memória para a oitava (min/max/média continuam certos)
+ */
+int stream_stats_add(StreamStats *stats, double value);
+
+/**
+ * Percentil aproximado (erro relativo de até 1/64)
+ * @param q Fração entre 0 e 1 (0.99 = p99)
+ * @return Valor, limitado a [min, max]; 0 sem amostras
+ */
+double stream_stats_percentile(const StreamStats *stats, double q);
+
+double stream_stats_stddev(const StreamStats *stats);
+
+void stream_stats_free(StreamStats *stats);
+
+// Resumo de um alvo: uma StreamStats por métrica do catálogo
+typedef struct {
+    pid_t pid;
+    time_t first;                           // instante da primeira e da última amostra
+    time_t last;
+    unsigned long long samples;
+    StreamStats metrics[SAMPLE_METRIC_COUNT];
+} TargetStats;
+
+typedef struct {
+    TargetStats **targets;
+    size_t count;
+    size_t capacity;
+    size_t hint;                            // último alvo encontrado
+    unsigned long long ignored;             // amostras de alvos além de STATS_MAX_TARGETS
+} StatsTable;
+
+void stats_table_init(StatsTable *table);
+
+/**
+ * Acrescenta um registro ao resumo do seu alvo (criado na primeira amostra)
+ * @return 0 em sucesso, -1 em erro (sem memória ou limite de alvos)
+ */
+int stats_table_add(StatsTable *table, const SampleRecord *record);
+
+// Quadro por alvo: métrica, n, min, média, desvio, p50, p90, p99, p99.9, max
+void stats_table_print(const StatsTable *table, FILE *fp);
+
+/**
+ * Grava o resumo em CSV (uma linha por alvo e métrica). O arquivo é escrito
+ * ao lado e renomeado, então quem o lê nunca vê um resumo pela metade.
+ * @return 0 em sucesso, -1 em erro
+ */
+int stats_table_write_csv(const StatsTable *table, const char *path);
+
+void stats_table_free(StatsTable *table);
+
+/**
+ * Destino do pipeline que mantém o resumo (summary-*.csv). Imprime e grava
+ * no fechamento e, com interval_sec > 0, a cada interval_sec segundos do
+ * relógio das amostras.
+ */
+int sample_sink_summary(SampleSink *sink, int interval_sec);
+
+#endif
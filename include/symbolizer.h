@@ -0,0 +1,82 @@
+#ifndef SYMBOLIZER_H
+#define SYMBOLIZER_H
+
+#include <stddef.h>    // size_t
+#include <sys/types.h> // pid_t
+
+/*
+ * Tradução de endereços de um processo em nomes de função.
+ *
+ * As regiões executáveis de /proc/<pid>/maps apontam para arquivos ELF;
+ * a tabela de símbolos (.symtab, ou .dynsym em binários sem símbolos) de
+ * cada arquivo é carregada uma vez, ordenada por endereço, e consultada
+ * com busca binária. Um cache endereço -> nome evita repetir a busca para
+ * os endereços quentes, que se repetem em quase toda amostra.
+ */
+
+typedef struct {
+    unsigned long long addr;   // endereço virtual no ELF
+    unsigned long long size;
+    const char *name;          // aponta para o strtab mapeado
+} SymbolEntry;
+
+typedef struct {
+    unsigned long long offset; // p_offset
+    unsigned long long vaddr;  // p_vaddr
+    unsigned long long filesz; // p_filesz
+} ElfSegment;
+
+typedef struct {
+    char *path;                // caminho como aparece em maps
+    const char *base_name;     // último componente de path
+    void *image;               // arquivo mapeado (MAP_PRIVATE)
+    size_t image_size;
+    SymbolEntry *syms;         // ordenados por addr
+    size_t nsyms;
+    ElfSegment segments[16];   // PT_LOAD, para converter offset em endereço
+    int nsegments;
+} ElfSymbols;
+
+typedef struct {
+    unsigned long long start;
+    unsigned long long end;
+    unsigned long long offset;
+    int file;                  // índice em files, ou -1 (anônima / sem ELF)
+} SymbolMap;
+
+#define SYMBOLIZER_CACHE_SLOTS 8192  // potência de 2
+
+typedef struct {
+    unsigned long long ip;     // 0 = vazio
+    const char *name;
+} SymbolCacheSlot;
+
+typedef struct {
+    pid_t pid;
+    SymbolMap *maps;           // regiões executáveis, ordenadas
+    size_t nmaps;
+    ElfSymbols *files;
+    size_t nfiles;
+    SymbolCacheSlot cache[SYMBOLIZER_CACHE_SLOTS];
+    char **owned;              // nomes montados ("lib.so+0x1a2b") a liberar
+    size_t nowned;
+    size_t owned_capacity;
+    unsigned long long lookups;
+    unsigned long long cache_hits;
+    unsigned long long unmapped;   // endereços fora de qualquer região executável
+} Symbolizer;
+
+int symbolizer_init(Symbolizer *sym, pid_t pid);
+
+// Relê maps (bibliotecas carregadas depois do início). As tabelas ELF já
+// carregadas são mantidas; o cache de endereços é descartado, pois uma
+// região pode ter sido reaproveitada por outra biblioteca.
+int symbolizer_reload_maps(Symbolizer *sym);
+
+// Nome da função que contém ip. Nunca retorna NULL: sem símbolo devolve
+// "arquivo+0xoffset" ou "[unknown]". O ponteiro vale até symbolizer_free.
+const char *symbolizer_lookup(Symbolizer *sym, unsigned long long ip);
+
+void symbolizer_free(Symbolizer *sym);
+
+#endif
@@ -0,0 +1,578 @@
+#define _GNU_SOURCE
+#include "capture.h"
+#include "proc_parse.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * Captura e reprodução das leituras do kernel (ver capture.h).
+ *
+ * Há no máximo uma captura por processo: o observador e a fonte de
+ * proc_parse.c são globais, e os coletores rodam todos no thread principal.
+ */
+
+enum { CAPTURE_OFF = 0, CAPTURE_RECORDING, CAPTURE_REPLAYING };
+
+static int capture_mode = CAPTURE_OFF;
+
+/* ----------------------------- GRAVAÇÃO ----------------------------- */
+
+typedef struct {
+    char *path;
+    char *last;          // conteúdo da leitura anterior (para 'S')
+    ssize_t last_len;    // -1: nenhuma leitura ainda ou a última falhou
+    size_t last_cap;
+} RecordPath;
+
+static FILE *record_file = NULL;
+static RecordPath *record_paths = NULL;
+static size_t record_npaths = 0, record_cap = 0;
+static unsigned *record_index = NULL;  // hash do caminho -> id + 1 (0 = vazio)
+static size_t record_slots = 0;        // potência de 2
+static CaptureStats record_stats;
+static int record_error = 0;
+
+static uint64_t hash_path(const char *s) {
+    uint64_t h = 1469598103934665603ULL;  // FNV-1a
+    for (; *s; s++) h = (h ^ (unsigned char)*s) * 1099511628211ULL;
+    return h;
+}
+
+static void record_put(const void *data, size_t len) {
+    if (len == 0 || record_error) return;
+    if (fwrite(data, 1, len, record_file) != len) record_error = 1;
+    record_stats.bytes_out += len;
+}
+
+static void record_put_type(char type) {
+    record_put(&type, 1);
+}
+
+static int record_grow_index(void) {
+
+    size_t slots = record_slots ? record_slots * 2 : 1024;
+    unsigned *index = calloc(slots, sizeof(*index));
+    if (!index) return -1;
+
+    for (size_t id = 0; id < record_npaths; id++) {
+        size_t s = (size_t)hash_path(record_paths[id].path) & (slots - 1);
+        while (index[s]) s = (s + 1) & (slots - 1);
+        index[s] = (unsigned)id + 1;
+    }
+    free(record_index);
+    record_index = index;
+    record_slots = slots;
+    return 0;
+}
+
+// Id do caminho; na primeira vez grava o registro 'P'. Retorna -1 sem memória.
+static long record_intern(const char *path) {
+
+    if (record_slots == 0 || (record_npaths + 1) * 2 > record_slots) {
+        if (record_grow_index() != 0) return -1;
+    }
+
+    size_t s = (size_t)hash_path(path) & (record_slots - 1);
+    while (record_index[s]) {
+        unsigned id = record_index[s] - 1;
+        if (strcmp(record_paths[id].path, path) == 0) return id;
+        s = (s + 1) & (record_slots - 1);
+    }
+
+    size_t len = strlen(path);
+    if (len > UINT16_MAX) return -1;
+
+    if (record_npaths == record_cap) {
+        size_t cap = record_cap ? record_cap * 2 : 64;
+        RecordPath *grown = realloc(record_paths, cap * sizeof(*grown));
+        if (!grown) return -1;
+        record_paths = grown;
+        record_cap = cap;
+    }
+
+    RecordPath *rp = &record_paths[record_npaths];
+    memset(rp, 0, sizeof(*rp));
+    rp->path = strdup(path);
+    if (!rp->path) return -1;
+    rp->last_len = -1;
+
+    uint32_t id = (uint32_t)record_npaths++;
+    record_index[s] = id + 1;
+    record_stats.paths++;
+
+    uint16_t len16 = (uint16_t)len;
+    record_put_type('P');
+    record_put(&id, sizeof(id));
+    record_put(&len16, sizeof(len16));
+    record_put(path, len);
+    return id;
+}
+
+static void record_tap(void *ctx, const char *path, const char *data, ssize_t len) {
+    (void)ctx;
+
+    long found = record_intern(path);
+    if (found < 0) {
+        record_error = 1;
+        return;
+    }
+    uint32_t id = (uint32_t)found;
+    RecordPath *rp = &record_paths[id];
+
+    record_stats.reads++;
+    if (len > 0) record_stats.bytes_in += (unsigned long long)len;
+
+    // Contadores parados (net/dev de um processo ocioso, limites de cgroup) viram 5 bytes
+    if (len >= 0 && rp->last_len == len && memcmp(rp->last, data, (size_t)len) == 0) {
+        record_put_type('S');
+        record_put(&id, sizeof(id));
+        record_stats.repeats++;
+        return;
+    }
+
+    int32_t len32 = len < 0 ? -1 : (int32_t)len;
+    record_put_type('R');
+    record_put(&id, sizeof(id));
+    record_put(&len32, sizeof(len32));
+    if (len > 0) record_put(data, (size_t)len);
+
+    rp->last_len = -1;
+    if (len >= 0) {
+        if (rp->last_cap < (size_t)len + 1) {
+            char *grown = realloc(rp->last, (size_t)len + 1);
+            if (!grown) return;  // sem cópia: a próxima leitura vai como 'R'
+            rp->last = grown;
+            rp->last_cap = (size_t)len + 1;
+        }
+        memcpy(rp->last, data, (size_t)len);
+        rp->last_len = len;
+    }
+}
+
+int capture_record_open(const char *path, const CaptureHeader *header) {
+
+    if (!path || !header) {
+        fprintf(stderr, "Erro: ponteiro nulo em capture_record_open\n");
+        return -1;
+    }
+    if (capture_mode != CAPTURE_OFF) {
+        fprintf(stderr, "Erro: ja existe uma captura em andamento\n");
+        return -1;
+    }
+
+    record_file = fopen(path, "wb");
+    if (!record_file) {
+        fprintf(stderr, "Erro: nao foi possivel criar %s\n", path);
+        return -1;
+    }
+    setvbuf(record_file, NULL, _IOFBF, 1 << 20);
+
+    memset(&record_stats, 0, sizeof(record_stats));
+    record_error = 0;
+
+    CaptureHeader h = *header;
+    memcpy(h.magic, CAPTURE_MAGIC, sizeof(h.magic));
+    h.version = CAPTURE_VERSION;
+    h.started = (long long)time(NULL);
+    h.cgroup[CAPTURE_GROUP_LEN - 1] = '\0';
+    record_put(&h, sizeof(h));
+
+    capture_mode = CAPTURE_RECORDING;
+    proc_set_read_tap(record_tap, NULL);
+    return record_error ? -1 : 0;
+}
+
+void capture_record_tick(void) {
+
+    if (capture_mode != CAPTURE_RECORDING) return;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    int64_t wall = (int64_t)time(NULL);
+    int64_t mono = (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+
+    record_put_type('T');
+    record_put(&wall, sizeof(wall));
+    record_put(&mono, sizeof(mono));
+    record_stats.ticks++;
+}
+
+int capture_record_close(CaptureStats *stats) {
+
+    if (capture_mode != CAPTURE_RECORDING) return -1;
+
+    proc_set_read_tap(NULL, NULL);
+    capture_mode = CAPTURE_OFF;
+
+    if (fclose(record_file) != 0) record_error = 1;
+    record_file = NULL;
+
+    for (size_t i = 0; i < record_npaths; i++) {
+        free(record_paths[i].path);
+        free(record_paths[i].last);
+    }
+    free(record_paths);
+    free(record_index);
+    record_paths = NULL;
+    record_index = NULL;
+    record_npaths = record_cap = record_slots = 0;
+
+    if (stats) *stats = record_stats;
+    if (record_error) {
+        fprintf(stderr, "Erro: falha ao gravar a captura\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* ---------------------------- REPRODUÇÃO ---------------------------- */
+
+typedef struct {
+    char type;             // 'R', 'T', 'C' ou 'W' ('S' vira 'R' na carga)
+    uint32_t id;
+    const char *data;      // aponta para o log carregado
+    ssize_t len;
+    long long value;       // 'T': wall; 'C': mono_ns; 'W': wall
+    long long value2;      // 'T': mono_ns
+} ReplayEvent;
+
+static char *replay_log = NULL;
+static ReplayEvent *replay_events = NULL;
+static size_t replay_nevents = 0;
+static char **replay_paths = NULL;
+static size_t replay_npaths = 0;
+static unsigned char *replay_used = NULL;
+static size_t replay_seg_begin = 0, replay_seg_end = 0;  // [begin, end) do segmento atual
+static size_t replay_clock_pos = 0, replay_time_pos = 0;
+static long long replay_started = 0;
+static CaptureTick replay_tick;
+
+static ssize_t replay_source(void *ctx, const char *path, const char **data) {
+    (void)ctx;
+
+    // Mesmo caminho lido duas vezes no ciclo: servido na ordem da gravação
+    for (size_t i = replay_seg_begin; i < replay_seg_end; i++) {
+        const ReplayEvent *ev = &replay_events[i];
+        if (ev->type != 'R' || replay_used[i]) continue;
+        if (strcmp(replay_paths[ev->id], path) != 0) continue;
+        replay_used[i] = 1;
+        *data = ev->data;
+        return ev->len;
+    }
+    return -1;  // não gravado: para o coletor é um arquivo que sumiu
+}
+
+// Acha o fim do segmento que começa em begin (próximo 'T' ou fim do log)
+static size_t segment_end(size_t begin) {
+    size_t i = begin;
+    if (i < replay_nevents && replay_events[i].type == 'T') i++;
+    while (i < replay_nevents && replay_events[i].type != 'T') i++;
+    return i;
+}
+
+static void enter_segment(size_t begin) {
+    replay_seg_begin = begin;
+    replay_seg_end = segment_end(begin);
+    replay_clock_pos = replay_time_pos = begin;
+    memset(replay_used + begin, 0, replay_seg_end - begin);
+
+    size_t reads = 0;
+    for (size_t i = begin; i < replay_seg_end; i++) reads += replay_events[i].type == 'R';
+    replay_tick.reads = reads;
+}
+
+static void replay_free(void) {
+    free(replay_log);
+    free(replay_events);
+    free(replay_used);
+    for (size_t i = 0; i < replay_npaths; i++) free(replay_paths[i]);
+    free(replay_paths);
+    replay_log = NULL;
+    replay_events = NULL;
+    replay_used = NULL;
+    replay_paths = NULL;
+    replay_nevents = replay_npaths = 0;
+}
+
+// Lê o arquivo inteiro para a memória. Retorna o tamanho ou -1.
+static long load_file(const char *path, char **out) {
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
+        return -1;
+    }
+
+    long size = -1;
+    if (fseek(fp, 0, SEEK_END) == 0) size = ftell(fp);
+    if (size < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        fprintf(stderr, "Erro: nao foi possivel ler %s\n", path);
+        return -1;
+    }
+
+    char *buf = malloc((size_t)size + 1);
+    if (!buf || fread(buf, 1, (size_t)size, fp) != (size_t)size) {
+        free(buf);
+        fclose(fp);
+        fprintf(stderr, "Erro: nao foi possivel ler %s\n", path);
+        return -1;
+    }
+    fclose(fp);
+    *out = buf;
+    return size;
+}
+
+// Decodifica os registros em eventos. Retorna 0, ou -1 se o log estiver corrompido.
+static int replay_decode(const char *p, const char *end) {
+
+    size_t cap = 0;
+    const char **last_data = NULL;   // por id: conteúdo da última 'R', para resolver 'S'
+    ssize_t *last_len = NULL;
+    size_t path_cap = 0;
+    int rc = 0;
+
+#define NEED(n) do { if ((size_t)(end - p) < (size_t)(n)) { rc = -1; goto out; } } while (0)
+
+    while (p < end) {
+        char type = *p++;
+
+        if (replay_nevents == cap) {
+            cap = cap ? cap * 2 : 4096;
+            ReplayEvent *grown = realloc(replay_events, cap * sizeof(*grown));
+            if (!grown) {
+                rc = -1;
+                goto out;
+            }
+            replay_events = grown;
+        }
+        ReplayEvent *ev = &replay_events[replay_nevents];
+        memset(ev, 0, sizeof(*ev));
+
+        if (type == 'P') {
+            uint32_t id;
+            uint16_t len;
+            NEED(sizeof(id) + sizeof(len));
+            memcpy(&id, p, sizeof(id));
+            memcpy(&len, p + sizeof(id), sizeof(len));
+            p += sizeof(id) + sizeof(len);
+            NEED(len);
+            if (id != replay_npaths) {
+                rc = -1;
+                goto out;
+            }
+            if (replay_npaths == path_cap) {
+                path_cap = path_cap ? path_cap * 2 : 64;
+                char **paths = realloc(replay_paths, path_cap * sizeof(*paths));
+                const char **datas = realloc(last_data, path_cap * sizeof(*datas));
+                if (datas) last_data = datas;
+                ssize_t *lens = realloc(last_len, path_cap * sizeof(*lens));
+                if (lens) last_len = lens;
+                if (!paths || !datas || !lens) {
+                    if (paths) replay_paths = paths;
+                    rc = -1;
+                    goto out;
+                }
+                replay_paths = paths;
+            }
+            replay_paths[replay_npaths] = strndup(p, len);
+            if (!replay_paths[replay_npaths]) {
+                rc = -1;
+                goto out;
+            }
+            last_data[replay_npaths] = NULL;
+            last_len[replay_npaths] = -1;
+            replay_npaths++;
+            p += len;
+            continue;  // 'P' não vira evento
+        }
+
+        if (type == 'R' || type == 'S') {
+            uint32_t id;
+            NEED(sizeof(id));
+            memcpy(&id, p, sizeof(id));
+            p += sizeof(id);
+            if (id >= replay_npaths) {
+                rc = -1;
+                goto out;
+            }
+            ev->type = 'R';
+            ev->id = id;
+            if (type == 'R') {
+                int32_t len;
+                NEED(sizeof(len));
+                memcpy(&len, p, sizeof(len));
+                p += sizeof(len);
+                if (len > 0) NEED(len);
+                ev->len = len;
+                ev->data = len > 0 ? p : "";
+                if (len > 0) p += len;
+                last_data[id] = ev->data;
+                last_len[id] = ev->len;
+            } else {
+                if (last_len[id] < 0) {
+                    rc = -1;
+                    goto out;
+                }
+                ev->data = last_data[id];
+                ev->len = last_len[id];
+            }
+        } else if (type == 'T') {
+            int64_t wall, mono;
+            NEED(sizeof(wall) + sizeof(mono));
+            memcpy(&wall, p, sizeof(wall));
+            memcpy(&mono, p + sizeof(wall), sizeof(mono));
+            p += sizeof(wall) + sizeof(mono);
+            ev->type = 'T';
+            ev->value = wall;
+            ev->value2 = mono;
+        } else if (type == 'C' || type == 'W') {
+            int64_t v;
+            NEED(sizeof(v));
+            memcpy(&v, p, sizeof(v));
+            p += sizeof(v);
+            ev->type = type;
+            ev->value = v;
+        } else {
+            rc = -1;
+            goto out;
+        }
+        replay_nevents++;
+    }
+
+#undef NEED
+
+out:
+    free(last_data);
+    free(last_len);
+    return rc;
+}
+
+int capture_replay_open(const char *path, CaptureHeader *header) {
+
+    if (!path || !header) {
+        fprintf(stderr, "Erro: ponteiro nulo em capture_replay_open\n");
+        return -1;
+    }
+    if (capture_mode != CAPTURE_OFF) {
+        fprintf(stderr, "Erro: ja existe uma captura em andamento\n");
+        return -1;
+    }
+
+    long size = load_file(path, &replay_log);
+    if (size < 0) return -1;
+
+    if ((size_t)size < sizeof(CaptureHeader)) {
+        fprintf(stderr, "Erro: %s nao e uma captura\n", path);
+        replay_free();
+        return -1;
+    }
+    memcpy(header, replay_log, sizeof(*header));
+    if (memcmp(header->magic, CAPTURE_MAGIC, sizeof(header->magic)) != 0 || header->version != CAPTURE_VERSION) {
+        fprintf(stderr, "Erro: %s nao e uma captura (ou versao incompativel)\n", path);
+        replay_free();
+        return -1;
+    }
+    header->cgroup[CAPTURE_GROUP_LEN - 1] = '\0';
+
+    if (replay_decode(replay_log + sizeof(*header), replay_log + size) != 0) {
+        fprintf(stderr, "Erro: captura corrompida: %s\n", path);
+        replay_free();
+        return -1;
+    }
+
+    replay_used = calloc(replay_nevents ? replay_nevents : 1, 1);
+    if (!replay_used) {
+        replay_free();
+        return -1;
+    }
+
+    replay_started = header->started;
+    capture_mode = CAPTURE_REPLAYING;
+    proc_set_read_source(replay_source, NULL);
+    capture_replay_rewind();
+    return 0;
+}
+
+void capture_replay_rewind(void) {
+    if (capture_mode != CAPTURE_REPLAYING) return;
+    memset(&replay_tick, 0, sizeof(replay_tick));
+    replay_tick.wall = (time_t)replay_started;
+    enter_segment(0);
+    // Um log que começa com 'T' tem o segmento dos *_init vazio
+    if (replay_nevents > 0 && replay_events[0].type == 'T') replay_seg_end = 0;
+}
+
+int capture_replay_next(CaptureTick *tick) {
+
+    if (capture_mode != CAPTURE_REPLAYING || replay_seg_end >= replay_nevents) return 0;
+
+    const ReplayEvent *t = &replay_events[replay_seg_end];
+    replay_tick.index++;
+    replay_tick.wall = (time_t)t->value;
+    replay_tick.mono_ns = t->value2;
+    enter_segment(replay_seg_end);
+
+    if (tick) *tick = replay_tick;
+    return 1;
+}
+
+void capture_replay_close(void) {
+    if (capture_mode != CAPTURE_REPLAYING) return;
+    proc_set_read_source(NULL, NULL);
+    capture_mode = CAPTURE_OFF;
+    replay_free();
+}
+
+/* ------------------------------ RELÓGIO ------------------------------ */
+
+int capture_active(void) {
+    return capture_mode != CAPTURE_OFF;
+}
+
+// Próximo evento do tipo pedido no segmento, a partir de *pos
+static const ReplayEvent *next_event(size_t *pos, char type) {
+    while (*pos < replay_seg_end) {
+        const ReplayEvent *ev = &replay_events[(*pos)++];
+        if (ev->type == type) return ev;
+    }
+    return NULL;
+}
+
+void capture_clock(struct timespec *ts) {
+
+    if (capture_mode == CAPTURE_REPLAYING) {
+        const ReplayEvent *ev = next_event(&replay_clock_pos, 'C');
+        long long ns = ev ? ev->value : replay_tick.mono_ns;
+        ts->tv_sec = (time_t)(ns / 1000000000LL);
+        ts->tv_nsec = (long)(ns % 1000000000LL);
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    if (capture_mode == CAPTURE_RECORDING) {
+        int64_t ns = (int64_t)ts->tv_sec * 1000000000LL + ts->tv_nsec;
+        record_put_type('C');
+        record_put(&ns, sizeof(ns));
+    }
+}
+
+time_t capture_time(void) {
+
+    if (capture_mode == CAPTURE_REPLAYING) {
+        const ReplayEvent *ev = next_event(&replay_time_pos, 'W');
+        return ev ? (time_t)ev->value : replay_tick.wall;
+    }
+
+    time_t now = time(NULL);
+    if (capture_mode == CAPTURE_RECORDING) {
+        int64_t wall = (int64_t)now;
+        record_put_type('W');
+        record_put(&wall, sizeof(wall));
+    }
+    return now;
+}
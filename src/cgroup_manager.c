@@ -1,4 +1,5 @@
 #include "cgroup.h"
+#include "proc_parse.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,7 +8,7 @@
 #include <fcntl.h>
 #include <errno.h>
 
-#define CGROUP_BASE_PATH "/sys/fs/cgroup"
+#define CGROUP_BASE_PATH "%s/fs/cgroup"  // prefixo: raiz de /sys (sys_root)
 #define BUFFER_SIZE 256
 
 // --- Funções Auxiliares (Helpers) ---
@@ -30,26 +31,17 @@ static int write_to_cgroup_file(const char *path, const char *value) {
     return 0;
 }
 
-// Helper para ler arquivos. 
+// Helper para ler arquivos. Passa por proc_read_file para ser atendido
+// pelo lote de leituras (proc_batch.h) quando houver um ciclo ativo.
 static long long read_from_cgroup_file(const char *path) {
     char buffer[BUFFER_SIZE];
-    int fd = open(path, O_RDONLY);
-    if (fd == -1) {
+    ssize_t bytes_read = proc_read_file(path, buffer, sizeof(buffer));
+    if (bytes_read == -1) {
         perror("Falha ao ler arquivo cgroup");
         fprintf(stderr, "Caminho: %s\n", path);
         return -1;
     }
 
-    ssize_t bytes_read = read(fd, buffer, sizeof(buffer) - 1);
-    if (bytes_read == -1) {
-        perror("Falha na leitura (read)");
-        close(fd);
-        return -1;
-    }
-
-    buffer[bytes_read] = '\0';
-    close(fd);
-    
     return atoll(buffer); 
 }
 
@@ -58,9 +50,9 @@ static long long read_from_cgroup_file(const char *path) {
 int cgroup_create(const char *controller, const char *group_name) {
     (void)controller; 
     
-    char path[BUFFER_SIZE];
+    char path[PROC_PATH_MAX];
     // Caminho v2: /sys/fs/cgroup/GROUP_NAME
-    snprintf(path, sizeof(path), "%s/%s", CGROUP_BASE_PATH, group_name);
+    snprintf(path, sizeof(path), CGROUP_BASE_PATH "/%s", sys_root(), group_name);
 
     if (mkdir(path, 0755) == -1) {
         if (errno == EEXIST) {
@@ -79,22 +71,22 @@ int cgroup_create(const char *controller, const char *group_name) {
  int cgroup_move_pid(const char *controller, const char *group_name, pid_t pid) {
     (void)controller; 
 
-    char path[BUFFER_SIZE];
+    char path[PROC_PATH_MAX];
     char pid_str[BUFFER_SIZE];
 
     // Caminho v2: /sys/fs/cgroup/GROUP_NAME/cgroup.procs
-    snprintf(path, sizeof(path), "%s/%s/cgroup.procs", CGROUP_BASE_PATH, group_name);
+    snprintf(path, sizeof(path), CGROUP_BASE_PATH "/%s/cgroup.procs", sys_root(), group_name);
     snprintf(pid_str, sizeof(pid_str), "%d", pid);
 
     return write_to_cgroup_file(path, pid_str);
 }
 
  int cgroup_set_memory_limit(const char *group_name, long long limit_bytes) {
-    char path[BUFFER_SIZE];
+    char path[PROC_PATH_MAX];
     char limit_str[BUFFER_SIZE];
 
     // Caminho v2: /sys/fs/cgroup/GROUP_NAME/memory.max
-    snprintf(path, sizeof(path), "%s/%s/memory.max", CGROUP_BASE_PATH, group_name);
+    snprintf(path, sizeof(path), CGROUP_BASE_PATH "/%s/memory.max", sys_root(), group_name);
     
     if (limit_bytes <= 0) {
         snprintf(limit_str, sizeof(limit_str), "max"); // "max" significa sem limite
@@ -106,14 +98,14 @@ int cgroup_create(const char *controller, const char *group_name) {
 }
 
 int cgroup_set_cpu_limit(const char *group_name, double cores, long period_us) {
-    char path[BUFFER_SIZE];
+    char path[PROC_PATH_MAX];
     char value_str[BUFFER_SIZE];
 
     long quota_us = (long)(cores * (double)period_us);
 
     // Caminho v2: /sys/fs/cgroup/GROUP_NAME/cpu.max
     
-    snprintf(path, sizeof(path), "%s/%s/cpu.max", CGROUP_BASE_PATH, group_name);
+    snprintf(path, sizeof(path), CGROUP_BASE_PATH "/%s/cpu.max", sys_root(), group_name);
     snprintf(value_str, sizeof(value_str), "%ld %ld", quota_us, period_us);
     
     printf("Limite de CPU (v2) definido: %ld us (quota) / %ld us (period)\n", quota_us, period_us);
@@ -121,9 +113,9 @@ int cgroup_set_cpu_limit(const char *group_name, double cores, long period_us) {
 }
 
 long long cgroup_get_memory_usage(const char *group_name) {
-    char path[BUFFER_SIZE];
+    char path[PROC_PATH_MAX];
     // Caminho v2: /sys/fs/cgroup/GROUP_NAME/memory.current
-    snprintf(path, sizeof(path), "%s/%s/memory.current", CGROUP_BASE_PATH, group_name);
+    snprintf(path, sizeof(path), CGROUP_BASE_PATH "/%s/memory.current", sys_root(), group_name);
     
     return read_from_cgroup_file(path);
 }
@@ -132,28 +124,32 @@ long long cgroup_get_memory_usage(const char *group_name) {
  * Lê o uso da CPU (v2)
  */
 long long cgroup_get_cpu_usage(const char *group_name) {
-    char path[BUFFER_SIZE];
-    snprintf(path, sizeof(path), "%s/%s/cpu.stat", CGROUP_BASE_PATH, group_name);
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), CGROUP_BASE_PATH "/%s/cpu.stat", sys_root(), group_name);
 
-    FILE *fp = fopen(path, "r");
-    if (fp == NULL) {
+    char buffer[1024];
+    ssize_t len = proc_read_file(path, buffer, sizeof(buffer));
+    if (len < 0) {
         perror("Falha ao ler cpu.stat");
         fprintf(stderr, "Caminho: %s\n", path);
         return -1;
     }
 
-    char line_buffer[BUFFER_SIZE];
-    long long usage_usec = -1;
+    // Tabela de chaves montada uma única vez ("usage_usec 1234")
+    static const char *const keys[] = { "usage_usec" };
+    static ProcKeyTable table;
+    static int table_ready = 0;
+    if (!table_ready) {
+        proc_key_table_init(&table, keys, 1);
+        table_ready = 1;
+    }
 
- 
-    while (fgets(line_buffer, sizeof(line_buffer), fp)) {
-        if (sscanf(line_buffer, "usage_usec %lld", &usage_usec) == 1) {
-            break; 
-        }
+    unsigned long long usage_usec = 0;
+    if (proc_parse_kv(buffer, (size_t)len, &table, &usage_usec) == 0) {
+        return -1;
     }
 
-    fclose(fp);
-    return usage_usec; // Retorna em microssegundos
+    return (long long)usage_usec; // Retorna em microssegundos
 }
 
 
@@ -163,13 +159,14 @@ long long cgroup_get_cpu_usage(const char *group_name) {
  * de todas as linhas de dispositivo (ex: "8:0 rbytes=123...").
  */
 CgroupIOStats cgroup_get_io_stats(const char *group_name) {
-    char path[BUFFER_SIZE];
-    snprintf(path, sizeof(path), "%s/%s/io.stat", CGROUP_BASE_PATH, group_name);
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), CGROUP_BASE_PATH "/%s/io.stat", sys_root(), group_name);
 
     CgroupIOStats stats = {0, 0}; // Inicializa com ZER0
 
-    FILE *fp = fopen(path, "r");
-    if (fp == NULL) {
+    char buffer[8192];
+    ssize_t len = proc_read_file(path, buffer, sizeof(buffer));
+    if (len < 0) {
         perror("Falha ao ler io.stat");
         fprintf(stderr, "Caminho: %s\n", path);
         stats.rbytes = -1; // Sinaliza erro
@@ -177,31 +174,23 @@ CgroupIOStats cgroup_get_io_stats(const char *group_name) {
         return stats; 
     }
 
-    char line_buffer[BUFFER_SIZE];
-    long long value;
+    const char *end = buffer + len;
+    const char *p = buffer;
 
-    // Loop por todas as linhas (ex: "8:0 rbytes=123 wbytes=456 ...")
-    while (fgets(line_buffer, sizeof(line_buffer), fp)) {
+    // Percorre todos os campos de todas as linhas (ex: "8:0 rbytes=123 wbytes=456 ...")
+    // e acumula os valores de rbytes= e wbytes= de cada dispositivo
+    while ((p = proc_skip_fields(p, end, 0)) != NULL) {
+        unsigned long long value;
         
-        // CORREÇÃO: Usamos strstr para encontrar os valores
-        // pois sscanf é muito frágil para este formato.
-        
-        char *ptr_rbytes = strstr(line_buffer, "rbytes=");
-        char *ptr_wbytes = strstr(line_buffer, "wbytes=");
-        
-        if (ptr_rbytes) {
-            if (sscanf(ptr_rbytes, "rbytes=%lld", &value) == 1) {
-                stats.rbytes += value; // Acumula o valor
-            }
+        if (end - p > 7 && memcmp(p, "rbytes=", 7) == 0 && proc_parse_u64(p + 7, end, &value)) {
+            stats.rbytes += (long long)value; // Acumula o valor
+        } else if (end - p > 7 && memcmp(p, "wbytes=", 7) == 0 && proc_parse_u64(p + 7, end, &value)) {
+            stats.wbytes += (long long)value; // Acumula o valor
         }
         
-        if (ptr_wbytes) {
-            if (sscanf(ptr_wbytes, "wbytes=%lld", &value) == 1) {
-                stats.wbytes += value; // Acumula o valor
-            }
-        }
+        // avança para o fim do campo atual
+        while (p < end && *p != ' ' && *p != '\n') p++;
     }
 
-    fclose(fp);
     return stats;
 }
\ No newline at end of file
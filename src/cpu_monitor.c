@@ -1,44 +1,36 @@
 #include "monitor.h"
+#include "proc_parse.h"
+#include "capture.h"
 
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 static int read_total_ticks(unsigned long long *total_out) {
     
-    FILE *fp = fopen("/proc/stat", "r");
+    // Só a primeira linha interessa; o buffer pequeno trunca o resto do arquivo
+    char buf[512], path[PROC_PATH_MAX];
+    ssize_t len = proc_read_file(proc_path(path, sizeof(path), "stat"), buf, sizeof(buf));
     
-    if (!fp) {
-        fprintf(stderr, "Erro: nao foi possivel abrir /proc/stat\n");
-        return -1;
-    }
-
-    char buf[512];
-    if (!fgets(buf, sizeof(buf), fp)) {
+    if (len <= 0) {
         fprintf(stderr, "Erro: nao foi possivel ler a primeira linha de /proc/stat\n");
-        fclose(fp);
         return -1;
     }
-    fclose(fp);
 
     unsigned long long fields[10] = {0};
     
-    // Lê de buf a string "cpu" e até 10 números inteiros sem sinal (unsigned long long)
-    // Formato esperado de buf:
+    // Formato esperado da primeira linha:
     // cpu  user nice system idle iowait irq softirq steal guest guest_nice
-    int n = sscanf(
-        buf,
-        "%*s %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",  // descarta primeira string "cpu"
-        &fields[0],     // user
-        &fields[1],     // nice
-        &fields[2],     // system
-        &fields[3],     // idle
-        &fields[4],     // iowait
-        &fields[5],     // irq
-        &fields[6],     // softirq
-        &fields[7],     // steal
-        &fields[8],     // guest
-        &fields[9]      // guest_nice
-    );
+    const char *end = proc_next_line(buf, buf + len);
+    const char *p = buf;
+    int n = 0;
+
+    if (strncmp(buf, "cpu ", 4) == 0) {
+        p += 3;  // descarta a string "cpu"
+        while (n < 10 && (p = proc_parse_u64(p, end, &fields[n])) != NULL) {
+            n++;
+        }
+    }
     
     if (n < 5) {
         fprintf(stderr, "Erro: formato inesperado em /proc/stat: %s\n", buf);
@@ -46,7 +38,9 @@ static int read_total_ticks(unsigned long long *total_out) {
     }
 
     unsigned long long total = 0;
-    // soma todos os n campos lidos
+    // soma os campos lidos, exceto guest e guest_nice: o kernel já os
+    // contabiliza dentro de user e nice
+    if (n > 8) n = 8;
     for (int i = 0; i < n; i++) {
         total += fields[i];
     }
@@ -61,32 +55,25 @@ static int read_process_times_and_threads(pid_t pid,
                                           unsigned long long *stime_out,
                                           unsigned long long *threads_out) {
     
-    char path[64];
+    char path[PROC_PATH_MAX];
 
     // Monta o caminho do arquivo /proc/<pid>/stat
-    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
-    
-    // Abre o arquivo /proc/<pid>/stat para leitura
-    FILE *fp = fopen(path, "r");
+    snprintf(path, sizeof(path), "%s/%d/stat", proc_root(), (int)pid);
     
-    if (!fp) {
-        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
-        return -1;
-    }
-
     char buf[4096];
 
     // Lê a linha do arquivo /proc/<pid>/stat
-    if (!fgets(buf, sizeof(buf), fp)) {
-        fprintf(stderr, "Erro: nao foi possivel ler %s\n", path);
-        fclose(fp);
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
+    
+    if (len <= 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
         return -1;
     }
-    fclose(fp);
 
     // /proc/<pid>/stat tem o nome do processo entre parênteses: pid (nome) ...
     // Procura o último ')' na linha para achar o fim do nome do processo
-    char *p = strrchr(buf, ')');
+    const char *end = buf + len;
+    const char *p = strrchr(buf, ')');
     if (!p) {
         fprintf(stderr, "Erro: formato inesperado em %s: %s\n", path, buf);
         return -1;
@@ -96,7 +83,7 @@ static int read_process_times_and_threads(pid_t pid,
 
     unsigned long long utime = 0;        // tempo em modo usuário em ticks
     unsigned long long stime = 0;        // tempo em modo sistema em ticks
-    long threads = 0;                    // número de threads     
+    unsigned long long threads = 0;      // número de threads     
 
     // Formato de /proc/[pid]/stat após o ')':
     // 1) state (char)
@@ -106,16 +93,14 @@ static int read_process_times_and_threads(pid_t pid,
     // 12) utime (ulong), 13) stime (ulong)  <-- queremos esses
     // 14) cutime (long), 15) cstime (long), 16) priority (long), 17) nice (long)
     // 18) num_threads (long)  <-- e esse
-    int scanned = sscanf(
-        p,
-        " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u "  // campos 1-11
-        "%llu %llu "                                      // campos 12-13: utime, stime
-        "%*d %*d %*d %*d "                               // campos 14-17
-        "%ld",                                            // campo 18: num_threads
-        &utime, &stime, &threads);
-
+    // (índices abaixo começam em 0 a partir do campo 1)
+    p = proc_skip_fields(p, end, 11);                // pula os campos 1-11
+    if (p) p = proc_parse_u64(p, end, &utime);        // campo 12: utime
+    if (p) p = proc_parse_u64(p, end, &stime);        // campo 13: stime
+    if (p) p = proc_skip_fields(p, end, 4);           // pula os campos 14-17
+    if (p) p = proc_parse_u64(p, end, &threads);      // campo 18: num_threads
 
-    if (scanned != 3) {
+    if (!p) {
         fprintf(stderr, "Erro: nao foi possivel extrair utime/stime/threads de %s\n", path);
         return -1;
     }
@@ -123,46 +108,45 @@ static int read_process_times_and_threads(pid_t pid,
     // escreve nas variáveis originais fornecidas
     *utime_out = utime;
     *stime_out = stime;
-    *threads_out = (unsigned long long)threads;
+    *threads_out = threads;
     return 0;
 }
 
-static int read_context_switches(pid_t pid, unsigned long long *ctx_out) {
+static int read_context_switches(pid_t pid, unsigned long long *voluntary_out,
+                                 unsigned long long *nonvoluntary_out) {
     
-    char path[64];
+    char path[PROC_PATH_MAX];
 
     // Monta o caminho do arquivo /proc/<pid>/status
-    snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+    snprintf(path, sizeof(path), "%s/%d/status", proc_root(), (int)pid);
 
-    // Abre o arquivo /proc/<pid>/status para leitura
-    FILE *fp = fopen(path, "r");
+    // Lê o arquivo /proc/<pid>/status inteiro
+    char buf[4096];
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
     
-    if (!fp) {
+    if (len <= 0) {
         fprintf(stderr, "Aviso: nao foi possivel abrir %s para ler context switches\n", path);
         return -1;
     }
 
-    // Buffer para armazenar cada linha lida do arquivo
-    char line[256];
-    unsigned long long voluntary = 0;
-    unsigned long long nonvoluntary = 0;
-
-    while (fgets(line, sizeof(line), fp)) {
-        // Se a linha tiver "voluntary_ctxt_switches: <valor>", guarda em voluntary
-        if (sscanf(line, "voluntary_ctxt_switches: %llu", &voluntary) == 1) {
-            continue; // vai para a próxima linha
-        }
-        // Se a linha tiver "nonvoluntary_ctxt_switches: <valor>", guarda em nonvoluntary
-        if (sscanf(line, "nonvoluntary_ctxt_switches: %llu", &nonvoluntary) == 1) {
-            continue; // vai para a próxima linha
-        }
+    // Tabela de chaves montada uma única vez
+    static const char *const keys[] = {
+        "voluntary_ctxt_switches",     // values[0]
+        "nonvoluntary_ctxt_switches",  // values[1]
+    };
+    static ProcKeyTable table;
+    static int table_ready = 0;
+    if (!table_ready) {
+        proc_key_table_init(&table, keys, 2);
+        table_ready = 1;
     }
 
-    // Fecha o arquivo depois de ler tudo
-    fclose(fp);
+    unsigned long long values[2] = {0, 0};
+    proc_parse_kv(buf, (size_t)len, &table, values);
 
-    // Soma trocas voluntárias + não voluntárias e escreve na variável original fornecida
-    *ctx_out = voluntary + nonvoluntary;
+    // Mantidas separadas: voluntárias = bloqueios (I/O, locks), não voluntárias = preempção
+    *voluntary_out = values[0];
+    *nonvoluntary_out = values[1];
 
     return 0;
 }
@@ -195,6 +179,10 @@ int cpu_monitor_init(CpuMonitorState *state, pid_t pid) {
     state->last_system_time_ticks = stime;
     state->last_total_ticks = total_ticks;
 
+    // Número de CPUs para normalizar o uso por core (100% = um core inteiro)
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    state->num_cpus = ncpu > 0 ? (int)ncpu : 1;
+
     return 0;
 }
 
@@ -208,7 +196,7 @@ int cpu_monitor_sample(CpuMonitorState *state, CpuSample *sample) {
 
     unsigned long long utime = 0, stime = 0, threads = 0;
     unsigned long long total_ticks = 0;
-    unsigned long long ctx_switches = 0;
+    unsigned long long voluntary = 0, nonvoluntary = 0;
 
     // Lê os tempos de CPU (utime/stime) e número de threads do processo
     if (read_process_times_and_threads(state->pid, &utime, &stime, &threads) < 0) {
@@ -224,8 +212,8 @@ int cpu_monitor_sample(CpuMonitorState *state, CpuSample *sample) {
     }
 
     // Lê o total de trocas de contexto do processo
-    if (read_context_switches(state->pid, &ctx_switches) < 0) {
-        ctx_switches = 0; // só avisa antes, já avisado no helper
+    if (read_context_switches(state->pid, &voluntary, &nonvoluntary) < 0) {
+        voluntary = nonvoluntary = 0; // só avisa antes, já avisado no helper
     }
 
     // Soma anterior de utime+stime do processo (guardada no estado)
@@ -254,12 +242,16 @@ int cpu_monitor_sample(CpuMonitorState *state, CpuSample *sample) {
 
     // Preenche a struct de amostra com os dados coletados
     sample->pid = state->pid;                // PID do processo monitorado
-    sample->timestamp = time(NULL);          // horário da coleta
+    sample->timestamp = capture_time();      // horário da coleta (o gravado, na reprodução)
     sample->cpu_percent = cpu_percent;       // uso de CPU em %
     sample->user_time_ticks = utime;         // utime acumulado em ticks
     sample->system_time_ticks = stime;       // stime acumulado em ticks
-    sample->context_switches = ctx_switches; // total de trocas de contexto
+    sample->context_switches = voluntary + nonvoluntary; // total de trocas de contexto
+    sample->voluntary_switches = voluntary;       // bloqueou por conta própria
+    sample->nonvoluntary_switches = nonvoluntary; // foi preemptado
     sample->threads = threads;               // número de threads atuais
+    sample->num_cpus = state->num_cpus;      // CPUs online
+    sample->cpu_percent_core = cpu_percent * state->num_cpus; // uso em "cores" (estilo top)
 
     // Atualiza o estado para servir de referência na próxima amostragem
     state->last_user_time_ticks = utime;
@@ -299,19 +291,23 @@ int cpu_sample_csv_write(const CpuSample *sample) {
         }
 
         // Escreve o cabeçalho do CSV
-        fprintf(cpu_csv_file, "timestamp,pid,cpu_percent,user_time_ticks,system_time_ticks,context_switches,threads\n");
+        fprintf(cpu_csv_file, "timestamp,pid,cpu_percent,user_time_ticks,system_time_ticks,context_switches,threads,num_cpus,cpu_percent_core,voluntary_switches,nonvoluntary_switches\n");
         fflush(cpu_csv_file);
     }
 
     if (fprintf(cpu_csv_file,
-                "%lld,%d,%.2f,%llu,%llu,%llu,%llu\n",
+                "%lld,%d,%.2f,%llu,%llu,%llu,%llu,%d,%.2f,%llu,%llu\n",
                 (long long)sample->timestamp,
                 (int)sample->pid,
                 sample->cpu_percent,
                 (unsigned long long)sample->user_time_ticks,
                 (unsigned long long)sample->system_time_ticks,
                 (unsigned long long)sample->context_switches,
-                (unsigned long long)sample->threads) < 0) {
+                (unsigned long long)sample->threads,
+                sample->num_cpus,
+                sample->cpu_percent_core,
+                sample->voluntary_switches,
+                sample->nonvoluntary_switches) < 0) {
         fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
         return -1;
     }
@@ -325,4 +321,13 @@ void cpu_sample_csv_close(void) {
         fclose(cpu_csv_file);
         cpu_csv_file = NULL;
     }
+}
+
+int csv_write_quoted(FILE *fp, const char *text) {
+    if (fputc('"', fp) == EOF) return -1;
+    for (const char *c = text; *c; c++) {
+        if (*c == '"' && fputc('"', fp) == EOF) return -1;
+        if (fputc(*c, fp) == EOF) return -1;
+    }
+    return fputc('"', fp) == EOF ? -1 : 0;
 }
\ No newline at end of file
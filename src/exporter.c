@@ -0,0 +1,587 @@
+#define _GNU_SOURCE
+#include "exporter.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define HEADER_ROOM 256          // espaço antes do corpo para o cabeçalho HTTP
+#define REQUEST_MAX 4096         // cabeçalhos de uma requisição
+#define SEND_TIMEOUT_SEC 2       // cliente que não lê perde a conexão
+
+static const char not_found[] =
+    "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 10\r\n\r\nnot found\n";
+
+static long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ------------------------------ SOCKET ------------------------------ */
+
+// "unix:CAMINHO", "HOST:PORTA" ou "PORTA"
+static int open_listener(Exporter *exporter, const char *address) {
+
+    int fd;
+    if (strncmp(address, "unix:", 5) == 0) {
+        struct sockaddr_un sun;
+        memset(&sun, 0, sizeof(sun));
+        sun.sun_family = AF_UNIX;
+        if (strlen(address + 5) == 0 || strlen(address + 5) >= sizeof(sun.sun_path)) {
+            fprintf(stderr, "Erro: caminho de socket invalido: %s\n", address);
+            return -1;
+        }
+        snprintf(sun.sun_path, sizeof(sun.sun_path), "%s", address + 5);
+
+        // Socket esquecido por uma execução anterior
+        struct stat st;
+        if (stat(sun.sun_path, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(sun.sun_path);
+
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0 || bind(fd, (struct sockaddr *)&sun, sizeof(sun)) != 0) {
+            fprintf(stderr, "Erro: nao foi possivel abrir %s: %s\n", address, strerror(errno));
+            if (fd >= 0) close(fd);
+            return -1;
+        }
+        snprintf(exporter->unix_path, sizeof(exporter->unix_path), "%s", sun.sun_path);
+    } else {
+        char host[64] = "127.0.0.1";
+        const char *port_text = address;
+        const char *colon = strrchr(address, ':');
+        if (colon) {
+            size_t n = (size_t)(colon - address);
+            if (n == 0 || n >= sizeof(host)) {
+                fprintf(stderr, "Erro: endereco invalido: %s\n", address);
+                return -1;
+            }
+            memcpy(host, address, n);
+            host[n] = '\0';
+            port_text = colon + 1;
+        }
+
+        char *end;
+        long port = strtol(port_text, &end, 10);
+        struct sockaddr_in sin;
+        memset(&sin, 0, sizeof(sin));
+        sin.sin_family = AF_INET;
+        sin.sin_port = htons((unsigned short)port);
+        if (end == port_text || *end != '\0' || port <= 0 || port > 65535 || inet_pton(AF_INET, host, &sin.sin_addr) != 1) {
+            fprintf(stderr, "Erro: endereco invalido: %s\n", address);
+            return -1;
+        }
+
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int one = 1;
+        if (fd >= 0) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (fd < 0 || bind(fd, (struct sockaddr *)&sin, sizeof(sin)) != 0) {
+            fprintf(stderr, "Erro: nao foi possivel abrir %s: %s\n", address, strerror(errno));
+            if (fd >= 0) close(fd);
+            return -1;
+        }
+    }
+
+    if (listen(fd, EXPORTER_MAX_CLIENTS) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel escutar em %s: %s\n", address, strerror(errno));
+        close(fd);
+        if (exporter->unix_path[0]) unlink(exporter->unix_path);
+        return -1;
+    }
+    return fd;
+}
+
+// Envia tudo ou desiste (erro ou cliente parado além de SEND_TIMEOUT_SEC)
+static int send_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Resposta publicada: marca o buffer da frente como em uso enquanto envia
+static int send_metrics(Exporter *exporter, int fd) {
+
+    int b;
+    for (;;) {
+        b = atomic_load(&exporter->front);
+        atomic_store(&exporter->sending, b);
+        if (atomic_load(&exporter->front) == b) break;  // trocado no meio: tenta de novo
+    }
+
+    const ExporterBuffer *buf = &exporter->buffers[b];
+    int rc = send_all(fd, buf->data + buf->start, buf->len);
+    atomic_store(&exporter->sending, -1);
+
+    if (rc == 0) {
+        atomic_fetch_add_explicit(&exporter->scrapes, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&exporter->bytes_sent, buf->len, memory_order_relaxed);
+    }
+    return rc;
+}
+
+typedef struct {
+    int fd;
+    size_t len;
+    char request[REQUEST_MAX];
+} Client;
+
+/**
+ * Atende as requisições completas no buffer do cliente
+ * @return 0 para manter a conexão, -1 para fechá-la
+ */
+static int serve_requests(Exporter *exporter, Client *client) {
+
+    for (;;) {
+        char *end = memmem(client->request, client->len, "\r\n\r\n", 4);
+        if (!end) return client->len < sizeof(client->request) ? 0 : -1;
+        *end = '\0';
+
+        // Linha de requisição: MÉTODO CAMINHO VERSÃO
+        char method[8] = "", path[256] = "", version[16] = "";
+        sscanf(client->request, "%7s %255s %15s", method, path, version);
+        char *query = strchr(path, '?');
+        if (query) *query = '\0';
+
+        int keep = strcmp(version, "HTTP/1.1") == 0;
+        for (char *line = strstr(client->request, "\r\n"); line; line = strstr(line + 2, "\r\n")) {
+            if (strncasecmp(line + 2, "Connection:", 11) == 0 && strcasestr(line + 13, "close")) keep = 0;
+        }
+
+        int rc;
+        if (strcmp(method, "GET") == 0 && strcmp(path, "/metrics") == 0) rc = send_metrics(exporter, client->fd);
+        else rc = send_all(client->fd, not_found, sizeof(not_found) - 1);
+        if (rc != 0 || !keep) return -1;
+
+        size_t used = (size_t)(end + 4 - client->request);
+        memmove(client->request, client->request + used, client->len - used);
+        client->len -= used;
+    }
+}
+
+static void *server_main(void *arg) {
+
+    Exporter *exporter = arg;
+    Client *clients = malloc(EXPORTER_MAX_CLIENTS * sizeof(*clients));
+    struct pollfd fds[EXPORTER_MAX_CLIENTS + 1];
+    int nclients = 0;
+    if (!clients) return NULL;
+
+    while (!atomic_load_explicit(&exporter->stop, memory_order_acquire)) {
+        fds[0].fd = exporter->listen_fd;
+        fds[0].events = POLLIN;
+        for (int i = 0; i < nclients; i++) {
+            fds[i + 1].fd = clients[i].fd;
+            fds[i + 1].events = POLLIN;
+        }
+
+        // Timeout curto: o fechamento só precisa esperar o stop ser visto
+        int n = poll(fds, (nfds_t)nclients + 1, 100);
+        if (n <= 0) continue;
+
+        for (int i = nclients - 1; i >= 0; i--) {
+            if (!fds[i + 1].revents) continue;
+            Client *c = &clients[i];
+            ssize_t got = read(c->fd, c->request + c->len, sizeof(c->request) - c->len);
+            if (got > 0) {
+                c->len += (size_t)got;
+                if (serve_requests(exporter, c) == 0) continue;
+            } else if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            close(c->fd);
+            clients[i] = clients[--nclients];
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept4(exporter->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+            if (fd < 0) continue;
+            if (nclients == EXPORTER_MAX_CLIENTS) {
+                close(fd);
+                continue;
+            }
+            struct timeval tv = { SEND_TIMEOUT_SEC, 0 };
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+            clients[nclients].fd = fd;
+            clients[nclients].len = 0;
+            nclients++;
+        }
+    }
+
+    for (int i = 0; i < nclients; i++) close(clients[i].fd);
+    free(clients);
+    return NULL;
+}
+
+/* ---------------------------- RENDERIZAÇÃO ---------------------------- */
+
+static int buffer_reserve(ExporterBuffer *buf, size_t extra) {
+    if (buf->len + extra <= buf->cap) return 0;
+    size_t cap = buf->cap ? buf->cap : 65536;
+    while (cap < buf->len + extra) cap *= 2;
+    char *grown = realloc(buf->data, cap);
+    if (!grown) return -1;
+    buf->data = grown;
+    buf->cap = cap;
+    return 0;
+}
+
+static int append_printf(ExporterBuffer *buf, const char *fmt, ...) {
+    if (buffer_reserve(buf, 256) != 0) return -1;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf->data + buf->len, buf->cap - buf->len, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n >= buf->cap - buf->len) return -1;  // linhas daqui cabem em 256
+    buf->len += (size_t)n;
+    return 0;
+}
+
+// Inteiros (a maioria dos valores: bytes, contagens) sem passar por printf
+static char *format_u64(char *end, unsigned long long v) {
+    do {
+        *--end = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    return end;
+}
+
+// Uma série: NOME{pid="N"} VALOR
+static int append_sample(ExporterBuffer *buf, const char *name, size_t name_len, pid_t pid, double value) {
+
+    if (buffer_reserve(buf, name_len + 64) != 0) return -1;
+    char *p = buf->data + buf->len;
+    memcpy(p, name, name_len);
+    p += name_len;
+    memcpy(p, "{pid=\"", 6);
+    p += 6;
+
+    char digits[24];
+    char *d = format_u64(digits + sizeof(digits), (unsigned long long)(pid > 0 ? pid : 0));
+    memcpy(p, d, (size_t)(digits + sizeof(digits) - d));
+    p += digits + sizeof(digits) - d;
+    memcpy(p, "\"} ", 3);
+    p += 3;
+
+    if (value >= 0.0 && value < 1e15 && value == (double)(unsigned long long)value) {
+        d = format_u64(digits + sizeof(digits), (unsigned long long)value);
+        memcpy(p, d, (size_t)(digits + sizeof(digits) - d));
+        p += digits + sizeof(digits) - d;
+    } else {
+        p += snprintf(p, 32, "%.9g", value);
+    }
+    *p++ = '\n';
+    buf->len = (size_t)(p - buf->data);
+    return 0;
+}
+
+static int append_family(ExporterBuffer *buf, const char *name, const char *type, const char *help) {
+    return append_printf(buf, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+// Métricas do cgroup: memória é medidor, o resto são contadores acumulados
+static const struct {
+    const char *name;
+    const char *type;
+    const char *help;
+    size_t offset;
+    double scale;
+} cgroup_series[] = {
+    { "resource_monitor_cgroup_memory_bytes", "gauge", "memory.current do cgroup v2 do alvo",
+      offsetof(CgroupUsageSample, memory_bytes), 1.0 },
+    { "resource_monitor_cgroup_cpu_usage_seconds_total", "counter", "usage_usec de cpu.stat do cgroup do alvo",
+      offsetof(CgroupUsageSample, cpu_usage_usec), 1e-6 },
+    { "resource_monitor_cgroup_io_read_bytes_total", "counter", "rbytes de io.stat do cgroup do alvo",
+      offsetof(CgroupUsageSample, io_read_bytes), 1.0 },
+    { "resource_monitor_cgroup_io_write_bytes_total", "counter", "wbytes de io.stat do cgroup do alvo",
+      offsetof(CgroupUsageSample, io_write_bytes), 1.0 },
+};
+
+// Corpo no formato texto do Prometheus, uma família de cada vez
+static int render_body(const Exporter *exporter, ExporterBuffer *buf) {
+
+    char name[96];
+    int rc = 0;
+
+    for (int i = 0; i < SAMPLE_METRIC_COUNT && rc == 0; i++) {
+        const SampleMetric *metric = &sample_metrics[i];
+        size_t len = (size_t)snprintf(name, sizeof(name), "resource_monitor_%s", metric->name);
+        int header = 0;
+        for (size_t t = 0; t < exporter->count && rc == 0; t++) {
+            const SampleRecord *record = &exporter->targets[t];
+            if (!(record->flags & metric->flag)) continue;
+            if (!header) {
+                char help[64];
+                if (metric->unit[0]) snprintf(help, sizeof(help), "%s (%s) da ultima coleta", metric->name, metric->unit);
+                else snprintf(help, sizeof(help), "%s da ultima coleta", metric->name);
+                rc = append_family(buf, name, "gauge", help);
+                header = 1;
+            }
+            if (rc == 0) rc = append_sample(buf, name, len, record->pid, sample_metric_value(record, i));
+        }
+    }
+
+    for (size_t s = 0; s < sizeof(cgroup_series) / sizeof(cgroup_series[0]) && rc == 0; s++) {
+        size_t len = strlen(cgroup_series[s].name);
+        int header = 0;
+        for (size_t t = 0; t < exporter->count && rc == 0; t++) {
+            const SampleRecord *record = &exporter->targets[t];
+            if (!(record->flags & SAMPLE_HAS_CGROUP)) continue;
+            long long raw = *(const long long *)((const char *)&record->cgroup + cgroup_series[s].offset);
+            if (raw < 0) continue;  // arquivo ausente ou ilegível
+            if (!header) {
+                rc = append_family(buf, cgroup_series[s].name, cgroup_series[s].type, cgroup_series[s].help);
+                header = 1;
+            }
+            if (rc == 0) rc = append_sample(buf, cgroup_series[s].name, len, record->pid, (double)raw * cgroup_series[s].scale);
+        }
+    }
+
+    static const char ts_name[] = "resource_monitor_sample_timestamp_seconds";
+    if (rc == 0 && exporter->count > 0) rc = append_family(buf, ts_name, "gauge", "Instante da ultima coleta do alvo");
+    for (size_t t = 0; t < exporter->count && rc == 0; t++) {
+        const SampleRecord *record = &exporter->targets[t];
+        rc = append_sample(buf, ts_name, sizeof(ts_name) - 1, record->pid, (double)sample_record_time(record));
+    }
+
+    if (rc == 0) {
+        rc = append_printf(buf,
+                           "# HELP resource_monitor_exporter_targets Alvos na resposta\n"
+                           "# TYPE resource_monitor_exporter_targets gauge\n"
+                           "resource_monitor_exporter_targets %zu\n"
+                           "# HELP resource_monitor_exporter_render_seconds Duracao da renderizacao anterior\n"
+                           "# TYPE resource_monitor_exporter_render_seconds gauge\n"
+                           "resource_monitor_exporter_render_seconds %.9f\n",
+                           exporter->count, exporter->render_ns / 1e9);
+    }
+    if (rc == 0) {
+        rc = append_printf(buf,
+                           "# HELP resource_monitor_exporter_scrapes_total Respostas enviadas\n"
+                           "# TYPE resource_monitor_exporter_scrapes_total counter\n"
+                           "resource_monitor_exporter_scrapes_total %llu\n"
+                           "# HELP resource_monitor_exporter_ignored_samples_total Coletas de alvos alem do limite\n"
+                           "# TYPE resource_monitor_exporter_ignored_samples_total counter\n"
+                           "resource_monitor_exporter_ignored_samples_total %llu\n",
+                           (unsigned long long)atomic_load_explicit(&exporter->scrapes, memory_order_relaxed),
+                           exporter->ignored);
+    }
+    return rc;
+}
+
+// Resposta HTTP completa: o cabeçalho é escrito logo antes do corpo
+static int render(const Exporter *exporter, ExporterBuffer *buf) {
+
+    buf->len = 0;
+    if (buffer_reserve(buf, HEADER_ROOM) != 0) return -1;
+    buf->len = HEADER_ROOM;
+    if (render_body(exporter, buf) != 0) return -1;
+
+    char header[HEADER_ROOM];
+    int n = snprintf(header, sizeof(header),
+                     "HTTP/1.1 200 OK\r\n"
+                     "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                     "Content-Length: %zu\r\n\r\n",
+                     buf->len - HEADER_ROOM);
+    buf->start = HEADER_ROOM - (size_t)n;
+    memcpy(buf->data + buf->start, header, (size_t)n);
+    buf->len -= buf->start;
+    return 0;
+}
+
+/* ------------------------------- ALVOS ------------------------------- */
+
+int exporter_update(Exporter *exporter, const SampleRecord *record) {
+
+    if (!exporter || !record) return -1;
+
+    size_t at = exporter->hint;
+    if (at >= exporter->count || exporter->targets[at].pid != record->pid) {
+        size_t lo = 0, hi = exporter->count;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (exporter->targets[mid].pid < record->pid) lo = mid + 1;
+            else hi = mid;
+        }
+        at = lo;
+        if (at == exporter->count || exporter->targets[at].pid != record->pid) {
+            if (exporter->count >= EXPORTER_MAX_TARGETS) {
+                exporter->ignored++;
+                return -1;
+            }
+            if (exporter->count == exporter->capacity) {
+                size_t cap = exporter->capacity ? exporter->capacity * 2 : 16;
+                SampleRecord *grown = realloc(exporter->targets, cap * sizeof(*grown));
+                if (!grown) return -1;
+                exporter->targets = grown;
+                exporter->capacity = cap;
+            }
+            memmove(&exporter->targets[at + 1], &exporter->targets[at],
+                    (exporter->count - at) * sizeof(*exporter->targets));
+            exporter->count++;
+        }
+    }
+
+    exporter->targets[at] = *record;
+    exporter->hint = at;
+    exporter->dirty = 1;
+    return 0;
+}
+
+// Tira da tabela os alvos sem coleta há mais de EXPORTER_STALE_SEC
+static void drop_stale(Exporter *exporter, long long now_ns) {
+    long long limit = now_ns - EXPORTER_STALE_SEC * 1000000000LL;
+    size_t kept = 0;
+    for (size_t t = 0; t < exporter->count; t++) {
+        if (exporter->targets[t].sampled_ns < limit) continue;
+        if (kept != t) exporter->targets[kept] = exporter->targets[t];
+        kept++;
+    }
+    exporter->count = kept;
+    exporter->hint = 0;
+}
+
+int exporter_publish(Exporter *exporter) {
+
+    if (!exporter || !exporter->dirty) return 0;
+
+    long long now = monotonic_ns();
+    if (now - exporter->last_render_ns < EXPORTER_MIN_RENDER_MS * 1000000LL) return 1;
+
+    // O buffer de trás só é reescrito se o servidor não está enviando dele
+    int back = 1 - atomic_load(&exporter->front);
+    if (atomic_load(&exporter->sending) == back) {
+        exporter->deferred++;
+        return 1;
+    }
+
+    drop_stale(exporter, now);
+    if (render(exporter, &exporter->buffers[back]) != 0) return 1;  // sem memória: mantém a anterior
+    atomic_store(&exporter->front, back);
+
+    exporter->dirty = 0;
+    exporter->renders++;
+    exporter->last_render_ns = now;
+    exporter->render_ns = monotonic_ns() - now;
+    return 0;
+}
+
+/* ------------------------------- CICLO ------------------------------- */
+
+int exporter_open(Exporter *exporter, const char *address) {
+
+    if (!exporter) return -1;
+    memset(exporter, 0, sizeof(*exporter));
+    exporter->listen_fd = -1;
+    char default_address[16];
+    snprintf(default_address, sizeof(default_address), "%d", EXPORTER_DEFAULT_PORT);
+    if (!address) address = default_address;
+    snprintf(exporter->address, sizeof(exporter->address), "%s", address);
+    atomic_init(&exporter->front, 0);
+    atomic_init(&exporter->sending, -1);
+    atomic_init(&exporter->scrapes, 0);
+    atomic_init(&exporter->bytes_sent, 0);
+    atomic_init(&exporter->stop, 0);
+
+    // Resposta inicial (sem alvos) para as raspagens antes da primeira coleta
+    if (render(exporter, &exporter->buffers[0]) != 0) {
+        exporter_close(exporter);
+        return -1;
+    }
+
+    exporter->listen_fd = open_listener(exporter, address);
+    if (exporter->listen_fd < 0) {
+        exporter_close(exporter);
+        return -1;
+    }
+
+    if (pthread_create(&exporter->server, NULL, server_main, exporter) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel criar o thread do exportador\n");
+        exporter_close(exporter);
+        return -1;
+    }
+    exporter->running = 1;
+    return 0;
+}
+
+void exporter_close(Exporter *exporter) {
+
+    if (!exporter) return;
+    if (exporter->running) {
+        atomic_store_explicit(&exporter->stop, 1, memory_order_release);
+        pthread_join(exporter->server, NULL);
+        exporter->running = 0;
+    }
+    if (exporter->listen_fd >= 0) close(exporter->listen_fd);
+    exporter->listen_fd = -1;
+    if (exporter->unix_path[0]) unlink(exporter->unix_path);
+    exporter->unix_path[0] = '\0';
+
+    for (int b = 0; b < 2; b++) free(exporter->buffers[b].data);
+    memset(exporter->buffers, 0, sizeof(exporter->buffers));
+    free(exporter->targets);
+    exporter->targets = NULL;
+    exporter->count = exporter->capacity = 0;
+}
+
+/* ------------------------------ DESTINO ------------------------------ */
+
+static int prometheus_write(SampleSink *sink, const SampleRecord *record) {
+    return exporter_update(sink->ctx, record);
+}
+
+static int prometheus_flush(SampleSink *sink) {
+    return exporter_publish(sink->ctx);
+}
+
+static void prometheus_close(SampleSink *sink) {
+
+    Exporter *exporter = sink->ctx;
+    if (!exporter) return;
+
+    printf("Exportador %s: %llu raspagens (%.1f KB enviados) | %llu renderizacoes, ultima %.2f ms, %llu adiadas",
+           exporter->address, (unsigned long long)atomic_load(&exporter->scrapes),
+           atomic_load(&exporter->bytes_sent) / 1024.0, exporter->renders, exporter->render_ns / 1e6,
+           exporter->deferred);
+    if (exporter->ignored) printf(" | %llu coletas de alvos alem do limite", exporter->ignored);
+    printf("\n");
+
+    exporter_close(exporter);
+    free(exporter);
+    sink->ctx = NULL;
+}
+
+int sample_sink_prometheus(SampleSink *sink, const char *address) {
+
+    if (!sink) return -1;
+    memset(sink, 0, sizeof(*sink));
+
+    Exporter *exporter = malloc(sizeof(*exporter));
+    if (!exporter) return -1;
+    if (exporter_open(exporter, address) != 0) {
+        free(exporter);
+        return -1;
+    }
+
+    sink->name = "prometheus";
+    sink->write = prometheus_write;
+    sink->flush = prometheus_flush;
+    sink->close = prometheus_close;
+    sink->ctx = exporter;
+    sink->wants = SAMPLE_HAS_CGROUP;
+    return 0;
+}
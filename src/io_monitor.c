@@ -1,4 +1,6 @@
 #include "monitor.h"
+#include "proc_parse.h"
+#include "capture.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -18,53 +20,41 @@ static int read_io_stats(pid_t pid,
                          unsigned long long *write_bytes_out,
                          unsigned long long *io_syscalls_out) {
     
-    char path[64];
+    char path[PROC_PATH_MAX];
     
     // Monta o caminho do arquivo /proc/<pid>/io
-    snprintf(path, sizeof(path), "/proc/%d/io", (int)pid);
+    snprintf(path, sizeof(path), "%s/%d/io", proc_root(), (int)pid);
     
-    // Abre o arquivo /proc/<pid>/io para leitura
-    FILE *fp = fopen(path, "r");
+    // Lê o arquivo /proc/<pid>/io inteiro (poucas linhas "chave: valor")
+    char buf[1024];
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
     
-    if (!fp) {
+    if (len < 0) {
         fprintf(stderr, "Erro: nao foi possivel abrir %s (pode requerer permissoes root)\n", path);
         return -1;
     }
     
-    // Buffer para ler linha por linha
-    char line[256];
-    unsigned long long read_bytes = 0;
-    unsigned long long write_bytes = 0;
-    unsigned long long syscr = 0;  // read syscalls
-    unsigned long long syscw = 0;  // write syscalls
-    
-    // Percorre todas as linhas do arquivo
-    while (fgets(line, sizeof(line), fp)) {
-        // read_bytes: bytes lidos de dispositivos de armazenamento
-        if (sscanf(line, "read_bytes: %llu", &read_bytes) == 1) {
-            continue;
-        }
-        // write_bytes: bytes escritos em dispositivos de armazenamento
-        if (sscanf(line, "write_bytes: %llu", &write_bytes) == 1) {
-            continue;
-        }
-        // syscr: número de syscalls de leitura (read, pread, etc)
-        if (sscanf(line, "syscr: %llu", &syscr) == 1) {
-            continue;
-        }
-        // syscw: número de syscalls de escrita (write, pwrite, etc)
-        if (sscanf(line, "syscw: %llu", &syscw) == 1) {
-            continue;
-        }
+    // Tabela de chaves montada uma única vez
+    static const char *const keys[] = {
+        "read_bytes",   // bytes lidos de dispositivos de armazenamento
+        "write_bytes",  // bytes escritos em dispositivos de armazenamento
+        "syscr",        // número de syscalls de leitura (read, pread, etc)
+        "syscw",        // número de syscalls de escrita (write, pwrite, etc)
+    };
+    static ProcKeyTable table;
+    static int table_ready = 0;
+    if (!table_ready) {
+        proc_key_table_init(&table, keys, 4);
+        table_ready = 1;
     }
-    
-    // Fecha o arquivo
-    fclose(fp);
+
+    unsigned long long values[4] = {0, 0, 0, 0};
+    proc_parse_kv(buf, (size_t)len, &table, values);
     
     // Escreve os valores coletados nas variáveis de saída
-    *read_bytes_out = read_bytes;
-    *write_bytes_out = write_bytes;
-    *io_syscalls_out = syscr + syscw;  // total de syscalls de I/O
+    *read_bytes_out = values[0];
+    *write_bytes_out = values[1];
+    *io_syscalls_out = values[2] + values[3];  // total de syscalls de I/O
     
     return 0;
 }
@@ -90,10 +80,11 @@ static int read_net_stats(pid_t pid,
     
     (void)pid;  // Marca o parâmetro como não utilizado
     
-    // Abre o arquivo /proc/net/dev para leitura
-    FILE *fp = fopen("/proc/net/dev", "r");
+    // Lê o arquivo /proc/net/dev inteiro (uma linha por interface)
+    char buf[16384], path[PROC_PATH_MAX];
+    ssize_t len = proc_read_file(proc_path(path, sizeof(path), "net/dev"), buf, sizeof(buf));
     
-    if (!fp) {
+    if (len < 0) {
         fprintf(stderr, "Aviso: nao foi possivel abrir /proc/net/dev\n");
         // Define valores como 0 se não conseguir ler
         *rx_bytes_out = 0;
@@ -103,40 +94,47 @@ static int read_net_stats(pid_t pid,
         return 0;  // Não é um erro crítico
     }
     
-    // Buffer para ler linha por linha
-    char line[512];
     unsigned long long total_rx_bytes = 0;
     unsigned long long total_tx_bytes = 0;
     unsigned long long total_rx_packets = 0;
     unsigned long long total_tx_packets = 0;
     
+    const char *end = buf + len;
+    
     // Pula as duas primeiras linhas (cabeçalho)
-    fgets(line, sizeof(line), fp);
-    fgets(line, sizeof(line), fp);
+    const char *line = proc_next_line(buf, end);
+    line = proc_next_line(line, end);
     
     // Lê cada interface de rede
-    while (fgets(line, sizeof(line), fp)) {
-        char iface[32];
-        unsigned long long rx_bytes, rx_packets, tx_bytes, tx_packets;
+    while (line < end) {
+        const char *next = proc_next_line(line, end);
+        const char *line_end = next[-1] == '\n' ? next - 1 : next;
+        const char *colon = memchr(line, ':', (size_t)(line_end - line));
         
-        // Formato: interface: rx_bytes rx_packets ... tx_bytes tx_packets ...
-        int n = sscanf(line, "%31[^:]:%llu %llu %*u %*u %*u %*u %*u %*u %llu %llu",
-                       iface, &rx_bytes, &rx_packets, &tx_bytes, &tx_packets);
+        const char *iface = line;
+        while (iface < colon && *iface == ' ') iface++;  // nome vem alinhado à direita
         
-        if (n == 5) {
-            // Ignora a interface loopback
-            if (strcmp(iface, "lo") != 0 && strncmp(iface, " lo", 3) != 0) {
+        // Formato: interface: rx_bytes rx_packets ... tx_bytes tx_packets ...
+        // Ignora a interface loopback
+        if (colon && !(colon - iface == 2 && memcmp(iface, "lo", 2) == 0)) {
+            unsigned long long rx_bytes = 0, rx_packets = 0, tx_bytes = 0, tx_packets = 0;
+            const char *p = proc_parse_u64(colon + 1, line_end, &rx_bytes);  // campo 0
+            if (p) p = proc_parse_u64(p, line_end, &rx_packets);              // campo 1
+            if (p) p = proc_skip_fields(p, line_end, 6);                      // pula os campos 2-7
+            if (p) p = proc_parse_u64(p, line_end, &tx_bytes);                // campo 8
+            if (p) p = proc_parse_u64(p, line_end, &tx_packets);              // campo 9
+            
+            if (p) {
                 total_rx_bytes += rx_bytes;
                 total_tx_bytes += tx_bytes;
                 total_rx_packets += rx_packets;
                 total_tx_packets += tx_packets;
             }
         }
+        
+        line = next;
     }
     
-    // Fecha o arquivo
-    fclose(fp);
-    
     // Escreve os valores totais nas variáveis de saída
     *rx_bytes_out = total_rx_bytes;
     *tx_bytes_out = total_tx_bytes;
@@ -146,47 +144,77 @@ static int read_net_stats(pid_t pid,
     return 0;
 }
 
+/**
+ * Conta as linhas completas em estado 01 (ESTABLISHED) de um trecho de /proc/net/tcp
+ * 
+ * @param line Início do trecho
+ * @param end Fim do trecho
+ * @param header 1 se a primeira linha do trecho é o cabeçalho (zerado ao pulá-lo)
+ * @param rest Recebe o início da linha incompleta no fim do trecho (ou end)
+ * @return Número de conexões estabelecidas no trecho
+ */
+static unsigned long long count_established(const char *line, const char *end, int *header, const char **rest) {
+    
+    unsigned long long count = 0;
+    const char *nl;
+    
+    // Lê cada conexão completa do trecho
+    while ((nl = memchr(line, '\n', (size_t)(end - line))) != NULL) {
+        if (*header) {
+            *header = 0;
+        } else {
+            // Formato: sl local_address rem_address st tx_queue rx_queue ...
+            // Estado 01 = ESTABLISHED
+            unsigned long long state = 0;
+            const char *p = proc_skip_fields(line, nl, 3);
+            if (p && proc_parse_hex(p, nl, &state) && state == 0x01) {  // TCP_ESTABLISHED
+                count++;
+            }
+        }
+        line = nl + 1;
+    }
+    
+    *rest = line;
+    return count;
+}
+
+// Contagem de count_tcp_connections entre os blocos de proc_read_file_chunked
+typedef struct {
+    int header;                 // 1 até pular a linha de cabeçalho
+    unsigned long long count;
+} TcpCount;
+
+static size_t count_established_chunk(void *ctx, const char *data, size_t len) {
+    TcpCount *tcp = ctx;
+    const char *rest;
+    tcp->count += count_established(data, data + len, &tcp->header, &rest);
+    return (size_t)(rest - data);
+}
+
 /**
  * Conta o número de conexões TCP ativas
  * 
  * @return Número de conexões TCP estabelecidas, ou 0 em caso de erro
  * 
  * Lê /proc/net/tcp e conta linhas com estado 01 (ESTABLISHED)
+ * 
+ * O arquivo pode ter centenas de milhares de linhas, então é lido em blocos
+ * grandes por proc_read_file_chunked, que também cuida da contabilidade e
+ * da captura; só as linhas completas de cada bloco são processadas.
  */
 static unsigned long long count_tcp_connections(void) {
     
-    // Abre o arquivo /proc/net/tcp para leitura
-    FILE *fp = fopen("/proc/net/tcp", "r");
+    char path[PROC_PATH_MAX];
+    proc_path(path, sizeof(path), "net/tcp");
     
-    if (!fp) {
-        fprintf(stderr, "Aviso: nao foi possivel abrir /proc/net/tcp\n");
+    char buf[65536];
+    TcpCount tcp = { .header = 1, .count = 0 };
+    if (proc_read_file_chunked(path, buf, sizeof(buf), count_established_chunk, &tcp) < 0) {
+        fprintf(stderr, "Aviso: nao foi possivel ler %s\n", path);
         return 0;
     }
     
-    // Buffer para ler linha por linha
-    char line[512];
-    unsigned long long count = 0;
-    
-    // Pula a primeira linha (cabeçalho)
-    fgets(line, sizeof(line), fp);
-    
-    // Lê cada conexão
-    while (fgets(line, sizeof(line), fp)) {
-        unsigned int state;
-        
-        // Formato: sl local_address rem_address st tx_queue rx_queue ...
-        // Estado 01 = ESTABLISHED
-        if (sscanf(line, "%*d: %*x:%*x %*x:%*x %x", &state) == 1) {
-            if (state == 0x01) {  // TCP_ESTABLISHED
-                count++;
-            }
-        }
-    }
-    
-    // Fecha o arquivo
-    fclose(fp);
-    
-    return count;
+    return tcp.count;
 }
 
 /**
@@ -297,7 +325,7 @@ int io_monitor_sample(IoMonitorState *state, IoSample *sample, double interval_s
     
     // Preenche a estrutura de amostra com os dados coletados
     sample->pid = state->pid;
-    sample->timestamp = time(NULL);
+    sample->timestamp = capture_time();
     
     // I/O de disco
     sample->read_bytes = read_bytes;
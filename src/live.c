@@ -0,0 +1,358 @@
+#define _GNU_SOURCE
+#include "live.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(LiveHeader) == 64, "LiveHeader deve ocupar uma linha de cache");
+
+#define SWEEP_INTERVAL_NS 1000000000LL   // varredura de alvos parados no máximo 1x/s
+#define SPIN_BEFORE_YIELD 64              // tentativas seguidas antes de ceder a CPU ao escritor
+
+static long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Nome POSIX com a barra inicial
+static void normalize_name(char *out, size_t len, const char *name) {
+    if (!name || !name[0]) name = LIVE_DEFAULT_NAME;
+    snprintf(out, len, "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+/**
+ * Escritor do segmento que hoje tem o nome, se ainda está rodando
+ * @return pid do escritor vivo, 0 se não há segmento ou o escritor terminou
+ */
+static pid_t live_owner(const char *name) {
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return 0;
+
+    pid_t owner = 0;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(LiveHeader)) {
+        LiveHeader *h = mmap(NULL, sizeof(LiveHeader), PROT_READ, MAP_SHARED, fd, 0);
+        if (h != MAP_FAILED) {
+            if (memcmp(h->magic, LIVE_MAGIC, sizeof(h->magic)) == 0) owner = atomic_load(&h->writer_pid);
+            munmap(h, sizeof(LiveHeader));
+        }
+    }
+    close(fd);
+
+    // EPERM: o processo existe, só é de outro usuário
+    if (owner > 0 && owner != getpid() && (kill(owner, 0) == 0 || errno == EPERM)) return owner;
+    return 0;
+}
+
+/* ------------------------------ SEQLOCK ------------------------------ */
+
+// Escrita de um slot: seq ímpar durante a cópia, par de novo ao terminar
+static void slot_store(LiveSlot *slot, pid_t pid, const SampleRecord *record) {
+
+    unsigned seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&slot->pid, pid, memory_order_relaxed);
+    if (record) memcpy(&slot->record, record, sizeof(*record));
+    else memset(&slot->record, 0, sizeof(slot->record));
+
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+}
+
+int live_read_slot(LiveReader *reader, unsigned slot, SampleRecord *out) {
+
+    if (!reader || !reader->header || !out || slot >= reader->header->capacity) return 0;
+    const LiveSlot *s = &reader->slots[slot];
+
+    for (unsigned attempt = 0; attempt < LIVE_READ_RETRIES; attempt++) {
+        // Escritor preempto no meio da escrita: girar não o faz terminar
+        if (attempt % SPIN_BEFORE_YIELD == SPIN_BEFORE_YIELD - 1) sched_yield();
+        unsigned before = atomic_load_explicit(&s->seq, memory_order_acquire);
+        if (before & 1) {
+            reader->retries++;
+            continue;
+        }
+        int pid = atomic_load_explicit(&s->pid, memory_order_relaxed);
+        memcpy(out, &s->record, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&s->seq, memory_order_relaxed) == before) return pid ? 1 : 0;
+        reader->retries++;
+    }
+    return -1;
+}
+
+/* ------------------------------ ESCRITOR ------------------------------ */
+
+int live_writer_open(LiveWriter *writer, const char *name, unsigned capacity) {
+
+    if (!writer) return -1;
+    memset(writer, 0, sizeof(*writer));
+    normalize_name(writer->name, sizeof(writer->name), name);
+    if (capacity == 0) capacity = LIVE_DEFAULT_SLOTS;
+
+    writer->index = malloc(capacity * sizeof(*writer->index));
+    writer->free_slots = malloc(capacity * sizeof(*writer->free_slots));
+    if (!writer->index || !writer->free_slots) {
+        live_writer_close(writer);
+        return -1;
+    }
+
+    pid_t owner = live_owner(writer->name);
+    if (owner) {
+        fprintf(stderr, "Erro: o segmento %s pertence ao monitor %d, que ainda esta rodando\n", writer->name, (int)owner);
+        live_writer_close(writer);
+        return -1;
+    }
+
+    /*
+     * Um segmento anterior (monitor que caiu ou terminou) é desligado do
+     * nome em vez de truncado: leitores que ainda o mapeiam não tomam SIGBUS
+     * e só deixam de receber atualizações.
+     */
+    shm_unlink(writer->name);
+    int fd = shm_open(writer->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Erro: nao foi possivel criar o segmento %s: %s\n", writer->name, strerror(errno));
+        live_writer_close(writer);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0) {
+        writer->dev = st.st_dev;
+        writer->ino = st.st_ino;
+    }
+
+    size_t len = sizeof(LiveHeader) + (size_t)capacity * LIVE_SLOT_SIZE;
+    void *map = MAP_FAILED;
+    if (ftruncate(fd, (off_t)len) == 0)
+        map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Erro: nao foi possivel mapear o segmento %s: %s\n", writer->name, strerror(errno));
+        shm_unlink(writer->name);
+        live_writer_close(writer);
+        return -1;
+    }
+
+    // ftruncate zera o segmento: todos os slots começam livres (seq 0, pid 0)
+    writer->header = map;
+    writer->slots = (LiveSlot *)((char *)map + sizeof(LiveHeader));
+    writer->map_len = len;
+    writer->last_sweep_ns = monotonic_ns();
+
+    LiveHeader *h = writer->header;
+    h->version = LIVE_VERSION;
+    h->header_size = sizeof(LiveHeader);
+    h->slot_size = LIVE_SLOT_SIZE;
+    h->record_size = sizeof(SampleRecord);
+    h->capacity = capacity;
+    atomic_init(&h->writer_pid, getpid());
+    atomic_init(&h->used, 0);
+    atomic_init(&h->updated_ns, 0);
+    atomic_init(&h->updates, 0);
+    // A assinatura vai por último: quem a vê, vê o cabeçalho completo
+    atomic_thread_fence(memory_order_release);
+    memcpy(h->magic, LIVE_MAGIC, sizeof(h->magic));
+    return 0;
+}
+
+// Posição de pid no índice (ou onde entraria)
+static size_t index_find(const LiveWriter *writer, pid_t pid) {
+    size_t lo = 0, hi = writer->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (writer->index[mid].pid < pid) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Libera os slots de alvos sem coleta há mais de LIVE_STALE_SEC
+static void sweep_stale(LiveWriter *writer, long long now_ns) {
+    long long limit = now_ns - LIVE_STALE_SEC * 1000000000LL;
+    size_t kept = 0;
+    for (size_t i = 0; i < writer->count; i++) {
+        LiveSlot *slot = &writer->slots[writer->index[i].slot];
+        if (slot->record.sampled_ns < limit) {
+            slot_store(slot, 0, NULL);
+            writer->free_slots[writer->nfree++] = writer->index[i].slot;
+            continue;
+        }
+        writer->index[kept++] = writer->index[i];
+    }
+    writer->count = kept;
+    writer->last_sweep_ns = now_ns;
+}
+
+int live_writer_update(LiveWriter *writer, const SampleRecord *record) {
+
+    if (!writer || !writer->header || !record || record->pid <= 0) return -1;
+    LiveHeader *h = writer->header;
+
+    long long now = monotonic_ns();
+    if (now - writer->last_sweep_ns >= SWEEP_INTERVAL_NS) sweep_stale(writer, now);
+
+    size_t at = index_find(writer, record->pid);
+    if (at < writer->count && writer->index[at].pid == record->pid) {
+        slot_store(&writer->slots[writer->index[at].slot], record->pid, record);
+    } else {
+        unsigned slot;
+        unsigned used = atomic_load_explicit(&h->used, memory_order_relaxed);
+        if (writer->nfree > 0) slot = writer->free_slots[--writer->nfree];
+        else if (used < h->capacity) slot = used;
+        else {
+            writer->ignored++;
+            return -1;
+        }
+        slot_store(&writer->slots[slot], record->pid, record);
+        // O slot já está escrito quando o leitor passa a percorrê-lo
+        if (slot == used) atomic_store_explicit(&h->used, used + 1, memory_order_release);
+
+        memmove(&writer->index[at + 1], &writer->index[at], (writer->count - at) * sizeof(*writer->index));
+        writer->index[at].pid = record->pid;
+        writer->index[at].slot = slot;
+        writer->count++;
+    }
+
+    // Um só escritor: load + store em vez de uma instrução atômica travada
+    atomic_store_explicit(&h->updates, atomic_load_explicit(&h->updates, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_store_explicit(&h->updated_ns, record->sampled_ns, memory_order_relaxed);
+    return 0;
+}
+
+void live_writer_close(LiveWriter *writer) {
+
+    if (!writer) return;
+    if (writer->header) {
+        atomic_store(&writer->header->writer_pid, 0);
+        // Outro monitor pode ter assumido o nome depois que este o criou
+        int fd = shm_open(writer->name, O_RDONLY, 0);
+        if (fd >= 0) {
+            struct stat st;
+            int ours = fstat(fd, &st) == 0 && st.st_dev == writer->dev && st.st_ino == writer->ino;
+            close(fd);
+            if (ours) shm_unlink(writer->name);
+        }
+        munmap(writer->header, writer->map_len);
+    }
+    free(writer->index);
+    free(writer->free_slots);
+    writer->header = NULL;
+    writer->slots = NULL;
+    writer->index = NULL;
+    writer->free_slots = NULL;
+    writer->count = writer->nfree = 0;
+}
+
+/* ------------------------------ DESTINO ------------------------------ */
+
+static int live_write(SampleSink *sink, const SampleRecord *record) {
+    return live_writer_update(sink->ctx, record);
+}
+
+static void live_close(SampleSink *sink) {
+
+    LiveWriter *writer = sink->ctx;
+    if (!writer) return;
+
+    printf("Segmento %s: %llu atualizacoes | %zu alvos em %u slots",
+           writer->name, (unsigned long long)atomic_load(&writer->header->updates),
+           writer->count, writer->header->capacity);
+    if (writer->ignored) printf(" | %llu coletas sem slot livre", writer->ignored);
+    printf("\n");
+
+    live_writer_close(writer);
+    free(writer);
+    sink->ctx = NULL;
+}
+
+int sample_sink_live(SampleSink *sink, const char *name) {
+
+    if (!sink) return -1;
+    memset(sink, 0, sizeof(*sink));
+
+    LiveWriter *writer = malloc(sizeof(*writer));
+    if (!writer) return -1;
+    if (live_writer_open(writer, name, LIVE_DEFAULT_SLOTS) != 0) {
+        free(writer);
+        return -1;
+    }
+
+    sink->name = "live";
+    sink->write = live_write;
+    sink->close = live_close;
+    sink->ctx = writer;
+    sink->wants = SAMPLE_HAS_CGROUP;
+    return 0;
+}
+
+/* ------------------------------- LEITOR ------------------------------- */
+
+int live_reader_open(LiveReader *reader, const char *name) {
+
+    if (!reader) return -1;
+    memset(reader, 0, sizeof(*reader));
+
+    char path[64];
+    normalize_name(path, sizeof(path), name);
+    int fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(LiveHeader))
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const LiveHeader *h = map;
+    int ok = memcmp(h->magic, LIVE_MAGIC, sizeof(h->magic)) == 0;
+    atomic_thread_fence(memory_order_acquire);
+    ok = ok && h->version == LIVE_VERSION && h->header_size == sizeof(LiveHeader) &&
+         h->slot_size == LIVE_SLOT_SIZE && h->record_size == sizeof(SampleRecord) &&
+         sizeof(LiveHeader) + (size_t)h->capacity * LIVE_SLOT_SIZE <= (size_t)st.st_size;
+    if (!ok) {
+        munmap(map, (size_t)st.st_size);
+        return -1;
+    }
+
+    reader->header = h;
+    reader->slots = (const LiveSlot *)((const char *)map + sizeof(LiveHeader));
+    reader->map_len = (size_t)st.st_size;
+    return 0;
+}
+
+unsigned live_reader_slots(const LiveReader *reader) {
+    if (!reader || !reader->header) return 0;
+    return atomic_load_explicit(&reader->header->used, memory_order_acquire);
+}
+
+int live_find(LiveReader *reader, pid_t pid, SampleRecord *out) {
+
+    unsigned n = live_reader_slots(reader);
+    for (unsigned i = 0; i < n; i++) {
+        if (atomic_load_explicit(&reader->slots[i].pid, memory_order_relaxed) != pid) continue;
+        // O slot pode ter mudado de dono entre a olhada e a cópia
+        if (live_read_slot(reader, i, out) == 1 && out->pid == pid) return 1;
+    }
+    return 0;
+}
+
+void live_reader_close(LiveReader *reader) {
+    if (!reader) return;
+    if (reader->header) munmap((void *)reader->header, reader->map_len);
+    memset(reader, 0, sizeof(*reader));
+}
@@ -1,11 +1,24 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "monitor.h"
 #include "namespace.h"
 #include "cgroup.h"
+#include "capture.h"
+#include "exporter.h"
+#include "live.h"
+#include "proc_batch.h"
+#include "proc_parse.h"
+#include "pipeline.h"
+#include "query.h"
+#include "rollup.h"
+#include "stats.h"
 
 void clear_input_buffer(void) {
     int c;
@@ -31,6 +44,15 @@ void print_profiler_menu(void) {
     printf("  2. Monitorar Memoria de um processo\n");
     printf("  3. Monitorar I/O de um processo\n");
     printf("  4. Monitorar TUDO (CPU + Memoria + I/O)\n");
+    printf("  5. Monitorar threads (top-N por CPU)\n");
+    printf("  6. Monitorar CPU do sistema (por core)\n");
+    printf("  7. Estimar working set de um processo\n");
+    printf("  8. Monitorar colocacao NUMA de um processo\n");
+    printf("  9. Analisar mapa de memoria (regioes)\n");
+    printf(" 10. Contadores de desempenho (perf_event)\n");
+    printf(" 11. Perfil off-CPU (onde as threads esperam)\n");
+    printf(" 12. Latencia de escalonamento (fila de execucao)\n");
+    printf(" 13. Monitorar arvore de processos (raiz + descendentes)\n");
     printf("  0. Voltar\n");
     printf("\nEscolha uma opcao: ");
 }
@@ -84,10 +106,205 @@ int run_stress_test(const char *group_name) {
     return 0;
 }
 
+/**
+ * Espera o próximo ciclo de amostragem pelo pidfd do alvo
+ * @return 1 (e imprime o motivo) se o processo terminou, 0 caso contrário
+ */
+static int wait_target(MonitorTarget *tg, int timeout_ms) {
+    if (target_wait(tg, timeout_ms) == 0) return 0;
+    char msg[256];
+    target_describe_exit(tg, msg, sizeof(msg));
+    printf("\nFim do monitoramento: %s\n", msg);
+    return 1;
+}
+
+/*
+ * Leituras em lote (--io-backend): nos modos que leem muitos arquivos por
+ * ciclo, os coletores passam a ser atendidos por um ProcBatch. Desligado,
+ * cada coletor abre e lê seus arquivos como antes.
+ */
+static int batch_enabled = 0;
+static ProcBatchBackend batch_backend = PROC_BATCH_PREAD;
+static ProcBatch tick_batch;
+
+static void batch_start(void) {
+    if (!batch_enabled || proc_batch_init(&tick_batch, batch_backend) != 0) return;
+    printf("Leituras em lote: %s\n", proc_batch_backend_name(&tick_batch));
+}
+
+static void batch_begin_tick(void) {
+    if (batch_enabled) proc_batch_begin_tick(&tick_batch);
+}
+
+static void batch_end_tick(void) {
+    if (batch_enabled) proc_batch_end_tick(&tick_batch);
+}
+
+static void batch_finish(void) {
+    if (!batch_enabled) return;
+    printf("Lote (%s): %zu arquivos | ultimo ciclo: %llu syscalls, %.3f ms | %llu leituras atendidas, %llu diretas\n",
+           proc_batch_backend_name(&tick_batch), tick_batch.count, tick_batch.syscalls_last_tick,
+           tick_batch.last_tick_ms, tick_batch.served, tick_batch.passed);
+    proc_batch_free(&tick_batch);
+}
+
+/*
+ * Destinos do pipeline de amostras (--sinks): o modo "Tudo" coleta no
+ * thread principal e um thread escritor grava CSV, binário, console e o
+ * resumo das métricas.
+ */
+#define SINK_CONSOLE 0x1u
+#define SINK_CSV     0x2u
+#define SINK_BINARY  0x4u
+#define SINK_SUMMARY 0x8u
+
+static unsigned sink_mask = SINK_CONSOLE | SINK_CSV | SINK_SUMMARY;
+static int summary_interval = 0;  // --summary-interval: resumo também a cada N s (0 = só no fim)
+static int self_metrics = 0;  // --self-metrics: série overhead-monitor-*.csv junto das amostras
+static const char *record_path = NULL;  // --record: captura das leituras do modo "Tudo" (capture.h)
+static const char *store_dir = NULL;    // --store: histórico em camadas (rollup.h)
+static long store_retention[ROLLUP_TIERS];
+static int store_targets = ROLLUP_DEFAULT_TARGETS;
+static const char *metrics_listen = NULL;  // --metrics-listen: exportador Prometheus (exporter.h)
+static const char *live_name = NULL;       // --live: segmento compartilhado para "top" (live.h)
+
+static long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int pipeline_open(SamplePipeline *pl, OverheadHistogram *output_hist) {
+
+    if (pipeline_init(pl, 0) != 0) return -1;
+    pl->output_hist = output_hist;
+
+    SampleSink sink;
+    if ((sink_mask & SINK_CSV) && sample_sink_csv(&sink) == 0) pipeline_add_sink(pl, &sink);
+    if ((sink_mask & SINK_BINARY) && sample_sink_binary(&sink, NULL) == 0) pipeline_add_sink(pl, &sink);
+    if ((sink_mask & SINK_CONSOLE) && sample_sink_console(&sink) == 0) pipeline_add_sink(pl, &sink);
+    if ((sink_mask & SINK_SUMMARY) && sample_sink_summary(&sink, summary_interval) == 0) pipeline_add_sink(pl, &sink);
+    if (store_dir && sample_sink_rollup(&sink, store_dir, store_retention, store_targets) == 0) pipeline_add_sink(pl, &sink);
+    if (metrics_listen && sample_sink_prometheus(&sink, metrics_listen) == 0) pipeline_add_sink(pl, &sink);
+    if (live_name && sample_sink_live(&sink, live_name) == 0) pipeline_add_sink(pl, &sink);
+
+    if (pipeline_start(pl) != 0) {
+        pipeline_free(pl);
+        return -1;
+    }
+    return 0;
+}
+
+// Destino aberto de fato (um --live ou --metrics-listen recusado não entra no pipeline)
+static int pipeline_has_sink(const SamplePipeline *pl, const char *name) {
+    for (int i = 0; i < pl->nsinks; i++)
+        if (strcmp(pl->sinks[i].name, name) == 0) return 1;
+    return 0;
+}
+
+/*
+ * Captura (--record): o modo "Tudo" grava cada leitura do kernel num log que
+ * "resource-monitor replay" reproduz offline. Com o alvo num cgroup v2, os
+ * arquivos de uso do cgroup também são lidos a cada ciclo (e vão para os
+ * registros do pipeline quando algum destino os usa, com ou sem captura).
+ */
+static CaptureHeader record_header;
+
+static void record_start(pid_t pid) {
+
+    memset(&record_header, 0, sizeof(record_header));
+    record_header.pid = pid;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    record_header.num_cpus = ncpu > 0 ? (int)ncpu : 1;
+    record_header.page_size = (int)sysconf(_SC_PAGESIZE);
+    record_header.clk_tck = sysconf(_SC_CLK_TCK);
+
+    // cgroup v2 do alvo: linha "0::/grupo" de /proc/<pid>/cgroup
+    char path[PROC_PATH_MAX], buf[4096];
+    snprintf(path, sizeof(path), "%s/%d/cgroup", proc_root(), (int)pid);
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
+    for (char *line = len > 0 ? buf : NULL; line && *line; ) {
+        char *nl = strchr(line, '\n');
+        if (nl) *nl = '\0';
+        if (strncmp(line, "0::/", 4) == 0 && line[4]) {
+            snprintf(record_header.cgroup, sizeof(record_header.cgroup), "%s", line + 4);
+        }
+        line = nl ? nl + 1 : NULL;
+    }
+
+    static const struct { const char *file; unsigned bit; } cgroup_files[] = {
+        { "memory.current", CAPTURE_CGROUP_MEMORY }, { "cpu.stat", CAPTURE_CGROUP_CPU }, { "io.stat", CAPTURE_CGROUP_IO },
+    };
+    for (size_t i = 0; record_header.cgroup[0] && i < sizeof(cgroup_files) / sizeof(cgroup_files[0]); i++) {
+        snprintf(path, sizeof(path), "%s/fs/cgroup/%s/%s", sys_root(), record_header.cgroup, cgroup_files[i].file);
+        if (access(path, R_OK) == 0) record_header.cgroup_files |= cgroup_files[i].bit;
+    }
+
+    if (!record_path) return;
+    if (capture_record_open(record_path, &record_header) != 0) return;
+    printf("Gravando leituras em %s", record_path);
+    if (record_header.cgroup_files) printf(" (com o cgroup %s)", record_header.cgroup);
+    printf("\n");
+}
+
+// Arquivos de uso do cgroup, pelas funções de cgroup_manager.c
+static void read_cgroup_usage(const CaptureHeader *header, long long *memory, long long *cpu_usec, CgroupIOStats *io) {
+    if (header->cgroup_files & CAPTURE_CGROUP_MEMORY) *memory = cgroup_get_memory_usage(header->cgroup);
+    if (header->cgroup_files & CAPTURE_CGROUP_CPU) *cpu_usec = cgroup_get_cpu_usage(header->cgroup);
+    if (header->cgroup_files & CAPTURE_CGROUP_IO) *io = cgroup_get_io_stats(header->cgroup);
+}
+
+/*
+ * O bloco do cgroup fica fora do catálogo de métricas: só a captura e os
+ * destinos que pedem SAMPLE_HAS_CGROUP em wants o usam. Sem nenhum deles,
+ * os três arquivos não são lidos a cada ciclo.
+ */
+static int cgroup_sample_wanted(const SamplePipeline *pl) {
+    if (record_path && capture_active()) return 1;
+    for (int i = 0; i < pl->nsinks; i++) {
+        if (pl->sinks[i].wants & SAMPLE_HAS_CGROUP) return 1;
+    }
+    return 0;
+}
+
+// Uso do cgroup no registro: lido depois de capture_record_tick, entra no log do ciclo
+static void read_cgroup_sample(const CaptureHeader *header, SampleRecord *rec) {
+    if (!header->cgroup_files) return;
+    CgroupIOStats io = {0, 0};
+    read_cgroup_usage(header, &rec->cgroup.memory_bytes, &rec->cgroup.cpu_usage_usec, &io);
+    rec->cgroup.io_read_bytes = io.rbytes;
+    rec->cgroup.io_write_bytes = io.wbytes;
+    rec->flags |= SAMPLE_HAS_CGROUP;
+}
+
+static void record_tick(void) {
+    if (!record_path || !capture_active()) return;
+    capture_record_tick();
+}
+
+static void record_finish(void) {
+    if (!record_path || !capture_active()) return;
+    CaptureStats st;
+    if (capture_record_close(&st) != 0) return;
+    printf("Captura: %llu ciclos, %llu leituras (%llu repetidas) de %llu arquivos | %.1f KB lidos -> %.1f KB em %s\n",
+           st.ticks, st.reads, st.repeats, st.paths, st.bytes_in / 1024.0, st.bytes_out / 1024.0, record_path);
+}
+
+static void pipeline_close(SamplePipeline *pl) {
+    pipeline_stop(pl);
+    printf("Pipeline: %llu coletas gravadas, %llu descartadas (anel cheio) | ocupacao maxima %zu/%zu | atraso maximo %.1f ms\n",
+           (unsigned long long)atomic_load(&pl->drained), (unsigned long long)atomic_load(&pl->dropped),
+           pl->max_depth, pl->capacity, atomic_load(&pl->max_lag_ns) / 1e6);
+    pipeline_free(pl);
+}
+
 void handle_profiler_menu(void) {
     int opt, pid, dur;
+    MonitorTarget tg;  // alvo do modo atual, preso por pidfd
+    tg.pidfd = -1;
     
     while (1) {
+        target_close(&tg);
         print_profiler_menu();
         if (scanf("%d", &opt) != 1) { clear_input_buffer(); continue; }
         clear_input_buffer();
@@ -100,17 +317,17 @@ void handle_profiler_menu(void) {
                 clear_input_buffer();
                 
                 CpuMonitorState cs;
-                if (cpu_monitor_init(&cs, pid) == 0) {
+                if (target_open(&tg, pid) == 0 && cpu_monitor_init(&cs, pid) == 0) {
                     printf("\nMonitorando CPU...\n");
                     for (int i = 0; i < dur; i++) {
                         CpuSample smp;
-                        sleep(1);
-                        if (cpu_monitor_sample(&cs, &smp) == 0) {
+                        if (wait_target(&tg, 1000)) break;
+                        if (cpu_monitor_sample(&cs, &smp) == 0 && target_same_process(&tg)) {
                             struct tm *tm_info = localtime(&smp.timestamp);
                             char time_str[32];
                             strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
-                            printf("[%s] CPU: %.2f%% | User: %llu ticks | System: %llu ticks | Ctx Sw: %llu | Threads: %llu\n", 
-                                   time_str, smp.cpu_percent, smp.user_time_ticks, 
+                            printf("[%s] CPU: %.2f%% (%.2f%% de %d cores) | User: %llu ticks | System: %llu ticks | Ctx Sw: %llu | Threads: %llu\n", 
+                                   time_str, smp.cpu_percent_core, smp.cpu_percent, smp.num_cpus, smp.user_time_ticks, 
                                    smp.system_time_ticks, smp.context_switches, smp.threads);
                             cpu_sample_csv_write(&smp); // salva em CSV
                         }
@@ -119,30 +336,73 @@ void handle_profiler_menu(void) {
                 }
                 break;
                 
-            case 2: // Memoria
+            case 2: { // Memoria
+                int rollup_every = 0;
                 printf("\nPID: "); scanf("%d", &pid);
                 printf("Duracao (s): "); scanf("%d", &dur);
+                printf("PSS/USS a cada N amostras (0 = desligado): "); scanf("%d", &rollup_every);
                 clear_input_buffer();
+
+                if (target_open(&tg, pid) != 0) break;
+
+                MemoryRollupState rs;
+                int use_rollup = rollup_every > 0 && memory_rollup_init(&rs, pid, rollup_every) == 0;
+
+                MemoryMonitorState mst;
+                if (memory_monitor_init(&mst, pid, 0) != 0) break;
                 
                 printf("\nMonitorando Memoria...\n");
                 for (int i = 0; i < dur; i++) {
                     MemorySample ms;
-                    sleep(1);
-                    if (memory_monitor_sample(pid, &ms) == 0) {
+                    if (wait_target(&tg, 1000)) break;
+                    if (memory_monitor_sample(&mst, &ms) == 0 && target_same_process(&tg)) {
                         struct tm *tm_info = localtime(&ms.timestamp);
                         char time_str[32];
                         strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
-                        printf("[%s] RSS: %.2f MB | VSZ: %.2f MB | Page Faults: %llu | Swap: %.2f MB\n",
+                        printf("[%s] RSS: %.2f MB (%+.1f KB/s) | VSZ: %.2f MB | Faults/s: %.0f min, %.0f maj | "
+                               "Swap: %.2f MB (in %.1f KB/s, out %.1f KB/s) | Vazamento: %+.2f MB/h (conf %.2f)%s\n",
                                time_str, 
                                ms.rss_bytes/(1024.0*1024.0),
+                               ms.rss_growth_bytes_per_sec/1024.0,
                                ms.vsize_bytes/(1024.0*1024.0),
-                               ms.page_faults,
-                               ms.swap_bytes/(1024.0*1024.0));
+                               ms.minor_faults_per_sec,
+                               ms.major_faults_per_sec,
+                               ms.swap_bytes/(1024.0*1024.0),
+                               ms.swap_in_bytes_per_sec/1024.0,
+                               ms.swap_out_bytes_per_sec/1024.0,
+                               ms.leak_slope_mb_per_hour,
+                               ms.leak_confidence,
+                               ms.leak_suspected ? " SUSPEITO" : "");
                         memory_sample_csv_write(&ms); // salva em CSV
                     }
+
+                    // smaps_rollup só é lido quando a cadência vence
+                    MemoryRollupSample rb;
+                    if (use_rollup && memory_rollup_tick(&rs, &rb) == 1) {
+                        printf("    PSS: %.2f MB (anon %.2f, file %.2f, shmem %.2f) | USS: %.2f MB | "
+                               "Shared: %.2f MB | THP: %.2f MB | SwapPss: %.2f MB | custo: %.1f us\n",
+                               rb.pss_bytes/(1024.0*1024.0),
+                               rb.pss_anon_bytes/(1024.0*1024.0),
+                               rb.pss_file_bytes/(1024.0*1024.0),
+                               rb.pss_shmem_bytes/(1024.0*1024.0),
+                               rb.uss_bytes/(1024.0*1024.0),
+                               rb.shared_bytes/(1024.0*1024.0),
+                               rb.anon_huge_bytes/(1024.0*1024.0),
+                               rb.swap_pss_bytes/(1024.0*1024.0),
+                               rb.cost_ns/1000.0);
+                        memory_rollup_csv_write(&rb);
+                    }
                 }
+                memory_monitor_free(&mst);
                 memory_sample_csv_close(); // fecha o arquivo CSV
+
+                if (use_rollup && rs.reads > 0) {
+                    printf("\nsmaps_rollup: %llu leituras | custo medio %.1f us | maximo %.1f us\n",
+                           rs.reads, rs.total_cost_ns / 1000.0 / rs.reads, rs.max_cost_ns / 1000.0);
+                    memory_rollup_csv_close();
+                }
                 break;
+            }
                 
             case 3: // I/O
                 if (geteuid() != 0) printf("\nAVISO: Requer sudo\n");
@@ -151,12 +411,12 @@ void handle_profiler_menu(void) {
                 clear_input_buffer();
                 
                 IoMonitorState is;
-                if (io_monitor_init(&is, pid) == 0) {
+                if (target_open(&tg, pid) == 0 && io_monitor_init(&is, pid) == 0) {
                     printf("\nMonitorando I/O...\n");
                     for (int i = 0; i < dur; i++) {
                         IoSample ios;
-                        sleep(1);
-                        if (io_monitor_sample(&is, &ios, 1.0) == 0) {
+                        if (wait_target(&tg, 1000)) break;
+                        if (io_monitor_sample(&is, &ios, 1.0) == 0 && target_same_process(&tg)) {
                             struct tm *tm_info = localtime(&ios.timestamp);
                             char time_str[32];
                             strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
@@ -173,75 +433,497 @@ void handle_profiler_menu(void) {
                 }
                 break;
                 
-            case 4: // Tudo
+            case 4: { // Tudo
                 if (geteuid() != 0) printf("\nAVISO: I/O requer sudo\n");
                 printf("\nPID: "); scanf("%d", &pid);
                 printf("Duracao (s): "); scanf("%d", &dur);
                 clear_input_buffer();
                 
                 CpuMonitorState csa;
+                MemoryMonitorState msa;
                 IoMonitorState isa;
-                cpu_monitor_init(&csa, pid);
+                SamplePipeline pl;
+                OverheadState ov;
+                if (target_open(&tg, pid) != 0) break;
+                record_start(pid);  // antes dos *_init: as leituras de referência também vão para o log
+                if (cpu_monitor_init(&csa, pid) != 0 || memory_monitor_init(&msa, pid, 0) != 0) {
+                    fprintf(stderr, "Erro: nao foi possivel iniciar os monitores de CPU e memoria do PID %d\n", pid);
+                    record_finish();
+                    break;
+                }
                 int io_ok = (io_monitor_init(&isa, pid) == 0);
+                overhead_init(&ov);
+                if (pipeline_open(&pl, &ov.stages[OVERHEAD_OUTPUT]) != 0) {
+                    memory_monitor_free(&msa);
+                    record_finish();
+                    break;
+                }
                 
                 printf("\n========================================\n");
                 printf("     MONITORAMENTO COMPLETO (PID: %d)    \n", pid);
                 printf("========================================\n");
-                printf("Dados serao salvos em 3 arquivos CSV\n\n");
+                if (sink_mask & SINK_CSV) printf("Dados serao salvos em 3 arquivos CSV\n");
+                if (sink_mask & SINK_BINARY) printf("Dados serao salvos em samples-*.bin\n");
+                if (sink_mask & SINK_SUMMARY) printf("Resumo das metricas em summary-*.csv\n");
+                if (store_dir) printf("Historico em camadas em %s\n", store_dir);
+                if (pipeline_has_sink(&pl, "prometheus")) printf("Metricas Prometheus em %s (GET /metrics)\n", metrics_listen);
+                if (pipeline_has_sink(&pl, "live")) printf("Metricas ao vivo no segmento %s (resource-monitor top --name %s)\n", live_name, live_name);
+                printf("\n");
+                int cgroup_wanted = cgroup_sample_wanted(&pl);
+                batch_start();
                 
+                // Cadência absoluta: a saída roda no thread escritor e não atrasa a próxima coleta
+                long long next_ns = monotonic_ns();
                 for (int i = 0; i < dur; i++) {
-                    CpuSample c; MemorySample m; IoSample io;
-                    sleep(1);
-                    cpu_monitor_sample(&csa, &c);
-                    memory_monitor_sample(pid, &m);
-                    if (io_ok) io_monitor_sample(&isa, &io, 1.0);
-                    
-                    struct tm *tm_info = localtime(&c.timestamp);
+                    next_ns += 1000000000LL;
+                    long long wait_ms = (next_ns - monotonic_ns()) / 1000000;
+                    if (wait_target(&tg, wait_ms > 0 ? (int)wait_ms : 0)) break;
+
+                    SampleRecord rec;
+                    memset(&rec, 0, sizeof(rec));
+                    overhead_tick_begin(&ov, monotonic_ns() - next_ns);
+                    batch_begin_tick();
+                    record_tick();
+                    if (cgroup_wanted) read_cgroup_sample(&record_header, &rec);
+                    // Como na reprodução: só o que foi lido vai marcado (registro zerado não é amostra)
+                    if (cpu_monitor_sample(&csa, &rec.cpu) == 0) rec.flags |= SAMPLE_HAS_CPU;
+                    if (memory_monitor_sample(&msa, &rec.memory) == 0) rec.flags |= SAMPLE_HAS_MEMORY;
+                    if (io_ok && io_monitor_sample(&isa, &rec.io, 1.0) == 0) rec.flags |= SAMPLE_HAS_IO;
+                    batch_end_tick();
+                    overhead_collect_done(&ov);
+                    if (!target_same_process(&tg)) {  // leituras podem ser de outro processo
+                        overhead_tick_end(&ov, NULL);
+                        continue;
+                    }
+
+                    rec.pid = pid;
+                    rec.sampled_ns = monotonic_ns();
+                    overhead_tick_end(&ov, &rec.overhead);
+                    if (self_metrics) rec.flags |= SAMPLE_HAS_OVERHEAD;
+                    pipeline_push(&pl, &rec);  // descartada (e contada) se o escritor ficou para trás
+                }
+                
+                // Drena o anel e fecha os arquivos antes do resumo
+                pipeline_close(&pl);
+                memory_monitor_free(&msa);
+                batch_finish();
+                record_finish();
+                overhead_print_summary(&ov, stdout);
+                break;
+            }
+
+            case 5: // Threads
+                printf("\nPID: "); scanf("%d", &pid);
+                printf("Duracao (s): "); scanf("%d", &dur);
+                int top_n;
+                printf("Top N threads: "); scanf("%d", &top_n);
+                clear_input_buffer();
+                if (top_n <= 0) top_n = 10;
+
+                ThreadMonitorState ts;
+                if (target_open(&tg, pid) == 0 && thread_monitor_init(&ts, pid) == 0) {
+                    ThreadSample *top = malloc((size_t)top_n * sizeof(ThreadSample));
+                    if (!top) {
+                        thread_monitor_free(&ts);
+                        break;
+                    }
+                    printf("\nMonitorando threads...\n");
+                    for (int i = 0; i < dur; i++) {
+                        if (wait_target(&tg, 1000)) break;
+                        int n = thread_monitor_sample(&ts, top, top_n);
+                        // n == 0: todas as threads sumiram entre a listagem e a leitura
+                        if (n <= 0 || !target_same_process(&tg)) continue;
+
+                        struct tm *tm_info = localtime(&top[0].timestamp);
+                        char time_str[32];
+                        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
+                        printf("\n[%s] Threads: %zu | Top %d\n", time_str, ts.count, n);
+                        printf("  %-8s %-16s %-3s %-4s %8s %14s\n",
+                               "TID", "NOME", "ST", "CPU", "CPU%", "RUNQ (ms)");
+                        for (int k = 0; k < n; k++) {
+                            printf("  %-8d %-16s %-3c %-4d %7.2f%% %14.2f\n",
+                                   (int)top[k].tid, top[k].comm, top[k].state,
+                                   top[k].last_cpu, top[k].cpu_percent,
+                                   top[k].run_delay_ns / 1e6);
+                            thread_sample_csv_write(&top[k]); // salva em CSV
+                        }
+                    }
+                    free(top);
+                    thread_monitor_free(&ts);
+                    thread_sample_csv_close(); // fecha o arquivo CSV
+                }
+                break;
+
+            case 6: // CPU do sistema
+                printf("\nDuracao (s): "); scanf("%d", &dur);
+                clear_input_buffer();
+
+                SystemCpuState sys;
+                if (system_cpu_init(&sys) == 0) {
+                    printf("\nMonitorando CPU do sistema (%d cores)...\n", sys.max_cores);
+                    for (int i = 0; i < dur; i++) {
+                        SystemCpuSample ss;
+                        sleep(1);
+                        if (system_cpu_sample(&sys, &ss) != 0) continue;
+
+                        struct tm *tm_info = localtime(&ss.timestamp);
+                        char time_str[32];
+                        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
+                        printf("\n[%s] Ctx/s: %.0f | Intr/s: %.0f | Running: %llu | Blocked: %llu\n",
+                               time_str, ss.ctxt_per_sec, ss.intr_per_sec,
+                               ss.procs_running, ss.procs_blocked);
+                        printf("  %-5s %7s %7s %7s %7s %7s %7s %7s\n",
+                               "CORE", "USR%", "SYS%", "IOW%", "IRQ%", "SIRQ%", "STEAL%", "IDLE%");
+                        printf("  %-5s %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f\n", "all",
+                               ss.total.user_percent, ss.total.system_percent, ss.total.iowait_percent,
+                               ss.total.irq_percent, ss.total.softirq_percent, ss.total.steal_percent,
+                               ss.total.idle_percent);
+                        for (int c = 0; c < ss.num_cores; c++) {
+                            const CoreCpuUsage *u = &ss.cores[c];
+                            if (!u->online) continue;
+                            printf("  %-5d %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f\n", c,
+                                   u->user_percent, u->system_percent, u->iowait_percent,
+                                   u->irq_percent, u->softirq_percent, u->steal_percent,
+                                   u->idle_percent);
+                        }
+                        system_cpu_csv_write(&ss); // salva em CSV
+                    }
+                    system_cpu_free(&sys);
+                    system_cpu_csv_close(); // fecha o arquivo CSV
+                }
+                break;
+
+            case 7: { // Working set
+                int interval = 1;
+                printf("\nPID: "); scanf("%d", &pid);
+                printf("Duracao (s): "); scanf("%d", &dur);
+                printf("Intervalo de medicao (s): "); scanf("%d", &interval);
+                clear_input_buffer();
+                if (interval < 1) interval = 1;
+
+                WorkingSetState ws;
+                if (target_open(&tg, pid) != 0 || working_set_init(&ws, pid) != 0) break;
+
+                printf("\nEstimando working set via %s (intervalo %d s)...\n",
+                       ws.method == WS_METHOD_PAGE_IDLE ? "page_idle" : "clear_refs", interval);
+                printf("%-19s %10s %10s %6s %9s  %s\n", "HORA", "RSS(MB)", "WS(MB)", "WS%", "CUSTO(ms)", "CURVA");
+
+                for (int i = 0; i + interval <= dur; i += interval) {
+                    WorkingSetSample wss;
+                    if (wait_target(&tg, interval * 1000)) break;
+                    if (working_set_sample(&ws, &wss) != 0 || !target_same_process(&tg)) break;
+
+                    struct tm *tm_info = localtime(&wss.timestamp);
                     char time_str[32];
                     strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
-                    
-                    printf("┌─ [%s] ────────────────\n", time_str);
-                    printf("│ CPU:\n");
-                    printf("│   ├─ Uso: %.2f%%\n", c.cpu_percent);
-                    printf("│   ├─ User time: %llu ticks\n", c.user_time_ticks);
-                    printf("│   ├─ System time: %llu ticks\n", c.system_time_ticks);
-                    printf("│   ├─ Context switches: %llu\n", c.context_switches);
-                    printf("│   └─ Threads: %llu\n", c.threads);
-                    printf("│\n");
-                    printf("│ MEMORIA:\n");
-                    printf("│   ├─ RSS: %.2f MB\n", m.rss_bytes/(1024.0*1024.0));
-                    printf("│   ├─ VSZ: %.2f MB\n", m.vsize_bytes/(1024.0*1024.0));
-                    printf("│   ├─ Page faults: %llu\n", m.page_faults);
-                    printf("│   └─ Swap: %.2f MB\n", m.swap_bytes/(1024.0*1024.0));
-                    
-                    if (io_ok) {
-                        printf("│\n");
-                        printf("│ I/O DISCO:\n");
-                        printf("│   ├─ Leitura: %.2f KB/s\n", io.read_rate_bytes_per_sec/1024.0);
-                        printf("│   ├─ Escrita: %.2f KB/s\n", io.write_rate_bytes_per_sec/1024.0);
-                        printf("│   ├─ Syscalls: %llu\n", io.io_syscalls);
-                        printf("│   └─ Ops/s: %.2f\n", io.disk_ops_per_sec);
-                        printf("│\n");
-                        printf("│ REDE:\n");
-                        printf("│   ├─ RX: %.2f MB (%llu pacotes)\n", 
-                               io.rx_bytes/(1024.0*1024.0), io.rx_packets);
-                        printf("│   ├─ TX: %.2f MB (%llu pacotes)\n", 
-                               io.tx_bytes/(1024.0*1024.0), io.tx_packets);
-                        printf("│   └─ Conexoes: %llu\n", io.connections);
+
+                    // Curva do working set: uma barra de até 40 colunas proporcional ao RSS
+                    char bar[41];
+                    int len = (int)(wss.ws_percent * 40.0 / 100.0 + 0.5);
+                    if (len > 40) len = 40;
+                    memset(bar, '#', (size_t)len);
+                    bar[len] = '\0';
+
+                    printf("%-19s %10.2f %10.2f %6.1f %9.2f  %s\n", time_str,
+                           wss.rss_bytes/(1024.0*1024.0), wss.ws_bytes/(1024.0*1024.0),
+                           wss.ws_percent, wss.cost_ns/1e6, bar);
+                    working_set_csv_write(&wss); // salva em CSV
+                }
+
+                printf("\nPico do working set: %.2f MB (referencia para memory.high)\n",
+                       ws.peak_ws_bytes/(1024.0*1024.0));
+                working_set_free(&ws);
+                working_set_csv_close(); // fecha o arquivo CSV
+                break;
+            }
+
+            case 8: { // NUMA
+                printf("\nPID: "); scanf("%d", &pid);
+                printf("Duracao (s): "); scanf("%d", &dur);
+                clear_input_buffer();
+
+                // Estado grande (topologia + threads): fica fora da pilha
+                NumaMonitorState *ns = malloc(sizeof(*ns));
+                if (!ns || target_open(&tg, pid) != 0) {
+                    free(ns);
+                    break;
+                }
+                if (numa_monitor_init(ns, pid) != 0) {
+                    free(ns);
+                    break;
+                }
+
+                printf("\nMonitorando NUMA (%d no(s))...\n", ns->num_nodes);
+                for (int i = 0; i < dur; i++) {
+                    NumaSample nsmp;
+                    if (wait_target(&tg, 1000)) break;
+                    if (numa_monitor_sample(ns, &nsmp) != 0 || !target_same_process(&tg)) break;
+
+                    struct tm *tm_info = localtime(&nsmp.timestamp);
+                    char time_str[32];
+                    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
+                    printf("\n[%s] Memoria: %.2f MB | Local: %.1f%% | Remota: %.1f%%\n",
+                           time_str, nsmp.total_bytes/(1024.0*1024.0),
+                           nsmp.local_percent, nsmp.remote_percent);
+                    printf("  %-4s %9s %9s %9s %9s %9s %9s %7s %8s %9s %9s\n",
+                           "NO", "HEAP(MB)", "STACK", "ANON", "FILE", "SHMEM", "HUGE",
+                           "THREADS", "CPU%", "MISS/s", "OTHER/s");
+                    for (int n = 0; n < nsmp.num_nodes; n++) {
+                        const NumaNodeUsage *u = &nsmp.nodes[n];
+                        printf("  %-4d %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %7d %8.1f %9.0f %9.0f\n",
+                               u->node,
+                               u->bytes[NUMA_MAP_HEAP]/(1024.0*1024.0),
+                               u->bytes[NUMA_MAP_STACK]/(1024.0*1024.0),
+                               u->bytes[NUMA_MAP_ANON]/(1024.0*1024.0),
+                               u->bytes[NUMA_MAP_FILE]/(1024.0*1024.0),
+                               u->bytes[NUMA_MAP_SHMEM]/(1024.0*1024.0),
+                               u->bytes[NUMA_MAP_HUGE]/(1024.0*1024.0),
+                               u->threads, u->thread_cpu_percent,
+                               u->numa_miss_per_sec, u->other_node_per_sec);
                     }
-                    printf("└────────────────────────────────────────\n\n");
-                    
-                    // Salva em CSVs separados
-                    cpu_sample_csv_write(&c);
-                    memory_sample_csv_write(&m);
-                    if (io_ok) io_sample_csv_write(&io);
+                    numa_sample_csv_write(&nsmp); // salva em CSV
                 }
-                
-                // Fecha todos os arquivos CSV
-                cpu_sample_csv_close();
-                memory_sample_csv_close();
-                if (io_ok) io_sample_csv_close();
+
+                numa_monitor_free(ns);
+                free(ns);
+                numa_sample_csv_close(); // fecha o arquivo CSV
+                break;
+            }
+
+            case 9: { // Mapa de memoria
+                int smaps_every = 0;
+                printf("\nPID: "); scanf("%d", &pid);
+                printf("Duracao (s): "); scanf("%d", &dur);
+                printf("RSS por regiao (smaps) a cada N amostras (0 = desligado): "); scanf("%d", &smaps_every);
+                clear_input_buffer();
+
+                VmaMonitorState vs;
+                if (target_open(&tg, pid) != 0 || vma_monitor_init(&vs, pid, smaps_every) != 0) break;
+
+                printf("\nAnalisando mapa de memoria...\n");
+                for (int i = 0; i < dur; i++) {
+                    VmaSample vsmp;
+                    if (wait_target(&tg, 1000)) break;
+                    if (vma_monitor_sample(&vs, &vsmp) != 0 || !target_same_process(&tg)) break;
+
+                    struct tm *tm_info = localtime(&vsmp.timestamp);
+                    char time_str[32];
+                    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
+                    printf("\n[%s] Regioes: %zu (%zu reaproveitadas) | +%d -%d ^%d v%d | maps: %.2f ms",
+                           time_str, vsmp.num_regions, vsmp.lines_reused,
+                           vsmp.appeared, vsmp.vanished, vsmp.grew, vsmp.shrank,
+                           vsmp.cost_ns/1e6);
+                    if (vsmp.smaps_fresh) printf(" | smaps: %.2f ms", vsmp.smaps_cost_ns/1e6);
+                    printf("\n");
+
+                    printf("  %-13s %12s %12s\n", "TIPO", "VIRT(MB)", "RSS(MB)");
+                    for (int k = 0; k < VMA_KINDS; k++) {
+                        if (vsmp.virt_bytes[k] == 0) continue;
+                        printf("  %-13s %12.2f %12.2f\n", vma_kind_name(k),
+                               vsmp.virt_bytes[k]/(1024.0*1024.0), vsmp.rss_bytes[k]/(1024.0*1024.0));
+                    }
+
+                    // Lista as primeiras mudanças do intervalo
+                    static const char *const change_names[] = { "surgiu", "sumiu", "cresceu", "encolheu" };
+                    for (size_t c = 0; c < vsmp.num_changes && c < 10; c++) {
+                        const VmaChange *ch = &vsmp.changes[c];
+                        printf("  %-8s %-12s %012llx-%012llx %+10.1f KB %.*s\n",
+                               change_names[ch->type], vma_kind_name(ch->kind), ch->start, ch->end,
+                               ch->delta_bytes/1024.0, ch->name_len, ch->name);
+                    }
+                    if (vsmp.num_changes > 10) printf("  ... mais %zu mudancas\n", vsmp.num_changes - 10);
+
+                    vma_sample_csv_write(&vsmp); // salva em CSV
+                }
+
+                vma_monitor_free(&vs);
+                vma_sample_csv_close(); // fecha o arquivo CSV
+                break;
+            }
+
+            case 10: { // perf_event
+                printf("\nPID: "); scanf("%d", &pid);
+                printf("Duracao (s): "); scanf("%d", &dur);
+                clear_input_buffer();
+
+                PerfCounterState ps;
+                if (target_open(&tg, pid) != 0 || perf_counters_init(&ps, pid) != 0) break;
+
+                printf("\nContadores abertos em %d thread(s)%s%s", ps.ngroups,
+                       ps.hw_available ? "" : " | PMU indisponivel: so eventos de software",
+                       ps.exclude_kernel ? " | apenas user space" : "");
+                if (ps.skipped_threads > 0) printf(" | %d thread(s) sem contadores (RLIMIT_NOFILE)", ps.skipped_threads);
+                if (ps.failed_opens > 0) printf(" | %d evento(s) nao abriram (contam 0)", ps.failed_opens);
+                printf("\n");
+                for (int i = 0; i < dur; i++) {
+                    PerfSample pe;
+                    if (wait_target(&tg, 1000)) break;
+                    if (perf_counters_sample(&ps, &pe) != 0 || !target_same_process(&tg)) break;
+
+                    struct tm *tm_info = localtime(&pe.timestamp);
+                    char time_str[32];
+                    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
+                    printf("[%s] CPU: %.2f cores | Faults/s: %.0f | Migr/s: %.0f | Ctx/s: %.0f",
+                           time_str, pe.cpu_utilization,
+                           pe.per_sec[PERF_CNT_PAGE_FAULTS],
+                           pe.per_sec[PERF_CNT_CPU_MIGRATIONS],
+                           pe.per_sec[PERF_CNT_CONTEXT_SWITCHES]);
+                    if (pe.hw_available) {
+                        printf(" | IPC: %.2f | Cache miss: %.2f%% | Branch miss/kinst: %.2f | Ciclos/s: %.2e | PMU: %.0f%%",
+                               pe.ipc, pe.cache_miss_percent, pe.branch_misses_per_kinst,
+                               pe.per_sec[PERF_CNT_CYCLES], pe.multiplex_percent);
+                    }
+                    printf("\n");
+                    perf_sample_csv_write(&pe); // salva em CSV
+                }
+
+                perf_counters_free(&ps);
+                perf_sample_csv_close(); // fecha o arquivo CSV
+                break;
+            }
+            case 11: { // off-CPU
+                int hz, every;
+                printf("\nPID: "); scanf("%d", &pid);
+                printf("Duracao (s): "); scanf("%d", &dur);
+                printf("Frequencia de amostragem (Hz, 0 = %d): ", OFFCPU_DEFAULT_HZ); scanf("%d", &hz);
+                printf("Resumo a cada N segundos: "); scanf("%d", &every);
+                clear_input_buffer();
+                if (hz <= 0) hz = OFFCPU_DEFAULT_HZ;
+                if (every <= 0) every = 1;
+
+                // ~64 KB (histograma e cache de fds): fora da pilha, como o estado NUMA
+                OffCpuState *os = malloc(sizeof(*os));
+                if (!os || target_open(&tg, pid) != 0) {
+                    free(os);
+                    break;
+                }
+                if (offcpu_monitor_init(os, pid) != 0) {
+                    free(os);
+                    break;
+                }
+
+                // Cadência absoluta: o custo da varredura não atrasa as seguintes
+                long period_ns = 1000000000L / hz;
+                struct timespec next;
+                clock_gettime(CLOCK_MONOTONIC, &next);
+                long long total_ticks = (long long)dur * hz;
+                long long summary_ticks = (long long)every * hz;
+                int alive = 1;
+
+                for (long long tick = 1; tick <= total_ticks && alive; tick++) {
+                    next.tv_nsec += period_ns;
+                    while (next.tv_nsec >= 1000000000L) { next.tv_nsec -= 1000000000L; next.tv_sec++; }
+                    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+                    // poll sem espera no pidfd: a saída fecha o período na hora
+                    if (wait_target(&tg, 0) || offcpu_monitor_tick(os) < 0) alive = 0;
+                    if (tick % summary_ticks != 0 && tick != total_ticks && alive) continue;
+
+                    OffCpuSummary sum;
+                    if (offcpu_monitor_summary(os, &sum) != 0) alive = 0;
+                    if (sum.ticks == 0) continue;
+
+                    struct tm *tm_info = localtime(&sum.timestamp);
+                    char time_str[32];
+                    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
+                    double ts = (double)(sum.thread_samples ? sum.thread_samples : 1);
+                    printf("\n[%s] %d thread(s) | %.0f Hz | varredura %.1f us | R: %.1f%% S: %.1f%% D: %.1f%%\n",
+                           time_str, sum.threads, sum.achieved_hz, sum.scan_us,
+                           (double)sum.running / ts * 100.0, (double)sum.sleeping / ts * 100.0,
+                           (double)sum.disk_wait / ts * 100.0);
+                    for (int i = 0; i < sum.ntop && i < 8; i++) {
+                        printf("  %c %6.2f threads  %5.1f%%  %s\n", sum.top[i].state,
+                               (double)sum.top[i].samples / (double)sum.ticks,
+                               (double)sum.top[i].samples / ts * 100.0, sum.top[i].label);
+                    }
+                    if (sum.overflow > 0) {
+                        printf("  %llu amostra(s) (%.1f%%) de motivos alem dos %d que cabem no histograma\n",
+                               sum.overflow, (double)sum.overflow / ts * 100.0, OFFCPU_MAX_BUCKETS);
+                    }
+                    offcpu_summary_csv_write(&sum); // salva em CSV
+                }
+
+                offcpu_monitor_free(os);
+                free(os);
+                offcpu_summary_csv_close(); // fecha o arquivo CSV
+                break;
+            }
+            case 12: { // escalonador
+                printf("\nPID: "); scanf("%d", &pid);
+                printf("Duracao (s): "); scanf("%d", &dur);
+                clear_input_buffer();
+
+                SchedMonitorState ss;
+                if (target_open(&tg, pid) != 0 || sched_monitor_init(&ss, pid) != 0) break;
+
+                for (int i = 0; i < dur; i++) {
+                    SchedSample sc;
+                    if (wait_target(&tg, 1000)) break;
+                    if (sched_monitor_sample(&ss, &sc) != 0 || !target_same_process(&tg)) break;
+
+                    struct tm *tm_info = localtime(&sc.timestamp);
+                    char time_str[32];
+                    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
+                    printf("[%s] CPU: %.0f ms/s | Fila: %.1f ms/s (%.1f%% da demanda, %.0f us/fatia) | Vol/s: %.0f | Invol/s: %.0f | Migr/s: %.1f",
+                           time_str, sc.run_ms_per_sec, sc.delay_ms_per_sec, sc.wait_percent,
+                           sc.delay_per_slice_us, sc.voluntary_per_sec, sc.nonvoluntary_per_sec,
+                           sc.migrations_per_sec);
+                    if (sc.blkio_delay_ms_per_sec >= 0) printf(" | Blk I/O: %.1f ms/s", sc.blkio_delay_ms_per_sec);
+                    printf("\n");
+                    for (int t = 0; t < sc.ntop && t < 5 && sc.top[t].delay_ms_per_sec >= 0.05; t++) {
+                        printf("    %-16s (tid %d) fila %.1f ms/s | CPU %.0f ms/s | invol/s %.0f\n",
+                               sc.top[t].comm, (int)sc.top[t].tid, sc.top[t].delay_ms_per_sec,
+                               sc.top[t].run_ms_per_sec, sc.top[t].nonvoluntary_per_sec);
+                    }
+                    sched_sample_csv_write(&sc); // salva em CSV
+                }
+
+                sched_monitor_free(&ss);
+                sched_sample_csv_close(); // fecha o arquivo CSV
+                break;
+            }
+            case 13: { // árvore de processos
+                printf("\nPID raiz: "); scanf("%d", &pid);
+                printf("Duracao (s): "); scanf("%d", &dur);
+                clear_input_buffer();
+
+                ProcTreeState ts;
+                if (target_open(&tg, pid) != 0 || proc_tree_init(&ts, pid) != 0) break;
+
+                printf("\nArvore de %d: %d processo(s) | %s\n", (int)pid, ts.nmembers,
+                       ts.nl_fd != -1 ? "eventos via proc connector" : "proc connector indisponivel: varrendo /proc");
+                batch_start();
+                for (int i = 0; i < dur; i++) {
+                    ProcTreeSample tr;
+                    if (wait_target(&tg, 1000)) break;
+                    batch_begin_tick();
+                    int rc = proc_tree_sample(&ts, &tr);
+                    batch_end_tick();
+
+                    struct tm *tm_info = localtime(&tr.timestamp);
+                    char time_str[32];
+                    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
+                    printf("[%s] Total: %.1f%% CPU (%.1f%% de filhos encerrados) | RSS: %llu KB | Processos: %d (+%d -%d)\n",
+                           time_str, tr.cpu_percent, tr.exited_cpu_percent, tr.rss_kb,
+                           tr.members, tr.forks, tr.exits);
+                    for (int r = 0; r < tr.nrows; r++) {
+                        printf("    %6d <- %-6d %-16s CPU %5.1f%% (+%.1f%%) | RSS %llu KB | Threads %llu\n",
+                               (int)tr.rows[r].pid, (int)tr.rows[r].ppid, tr.rows[r].comm,
+                               tr.rows[r].cpu_percent, tr.rows[r].exited_children_cpu_percent,
+                               tr.rows[r].rss_kb, tr.rows[r].threads);
+                    }
+                    proc_tree_csv_write(&tr); // salva em CSV
+                    if (rc != 0) {
+                        printf("Processo raiz %d terminou.\n", (int)pid);
+                        break;
+                    }
+                }
+
+                batch_finish();
+                proc_tree_free(&ts);
+                proc_tree_csv_close(); // fecha o arquivo CSV
                 break;
+            }
         }
     }
 }
@@ -335,8 +1017,551 @@ void handle_cgroup_menu(void) {
     }
 }
 
-int main(void) {
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static void print_usage(void) {
+    printf("Uso: resource-monitor [--io-backend uring|pread] [--sinks console,csv,bin,summary] [--self-metrics]\n");
+    printf("                      [--summary-interval S]   (resumo das metricas tambem a cada S segundos)\n");
+    printf("                      [--proc-root DIR] [--sys-root DIR]   (menu interativo)\n");
+    printf("                      [--record ARQ]   (captura as leituras do modo \"Tudo\")\n");
+    printf("                      [--store DIR] [--store-retention raw=10m,1m=6h,10m=2d,1h=31d] [--store-targets N]\n");
+    printf("                      [--metrics-listen PORTA|HOST:PORTA|unix:CAMINHO]   (exportador Prometheus)\n");
+    printf("                      [--live NOME]   (ultima coleta de cada alvo em memoria compartilhada)\n");
+    printf("     resource-monitor profile-stacks --pid N [--duration S] [--freq HZ] [--output ARQ]\n");
+    printf("     resource-monitor [--sinks ...|none] replay ARQ [--loops N]\n");
+    printf("     resource-monitor store DIR [--tier raw|1m|10m|1h] [--pid N] [--from T] [--to T] [--metric NOME]\n");
+    printf("     resource-monitor query ARQ.bin [--pid N] [--from T] [--to T] [--metric A,B] [--agg avg,max,p99,rate]\n");
+    printf("                      [--group-by pid|none]\n");
+    printf("     resource-monitor top [--name NOME] [--interval S] [--count N]\n");
+}
+
+/**
+ * Instante de --from/--to: segundos desde a época, "AAAA-MM-DD HH:MM[:SS]"
+ * ou "HH:MM[:SS]" (hoje, hora local)
+ * @return 0 em sucesso, -1 se o formato não é reconhecido
+ */
+static int parse_time_arg(const char *text, long long *out) {
+
+    static const char *const formats[] = { "%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M", "%H:%M:%S", "%H:%M" };
+
+    char *end;
+    long long epoch = strtoll(text, &end, 10);
+    if (end != text && *end == '\0') {
+        *out = epoch;
+        return 0;
+    }
+
+    time_t now = time(NULL);
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        struct tm tm;
+        localtime_r(&now, &tm);
+        tm.tm_sec = 0;
+        end = strptime(text, formats[f], &tm);
+        if (!end || *end != '\0') continue;
+        tm.tm_isdst = -1;
+        *out = (long long)mktime(&tm);
+        return 0;
+    }
+
+    fprintf(stderr, "Erro: instante invalido: %s (use AAAA-MM-DD HH:MM[:SS], HH:MM[:SS] ou segundos)\n", text);
+    return -1;
+}
+
+typedef struct {
+    RollupTierId tier;
+    int metric;        // índice no catálogo; -1 = todas
+} StoreQuery;
+
+static int print_store_row(const RollupRow *row, void *ctx) {
+    const StoreQuery *q = ctx;
+    for (int i = 0; i < SAMPLE_METRIC_COUNT; i++) {
+        if (!(row->h.present & (1u << i)) || (q->metric >= 0 && q->metric != i)) continue;
+        printf("%s,%lld,%d,%u,%s,%.7g,%.7g,%.7g,%.7g\n", rollup_tier_names[q->tier], row->h.start,
+               row->h.pid, row->h.count, sample_metrics[i].name, row->min[i], row->avg[i], row->max[i], row->last[i]);
+    }
+    return 0;
+}
+
+/**
+ * Modo store: lê o histórico em camadas (--store) em CSV. Sem --tier, usa
+ * a camada mais fina que ainda guarda o início do intervalo, então
+ * consultas longas saem dos agregados e não da camada bruta.
+ */
+static int cmd_store(int argc, char **argv) {
+    const char *dir = NULL;
+    int tier = -1;
+    pid_t pid = 0;
+    long long from = 0, to = 0;
+    StoreQuery query = { ROLLUP_RAW, -1 };
+
+    for (int i = 0; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int ok = 1;
+        if (strcmp(argv[i], "--tier") == 0 && value) {
+            for (int t = 0; t < ROLLUP_TIERS; t++) {
+                if (strcmp(value, rollup_tier_names[t]) == 0) tier = t;
+            }
+            ok = tier >= 0;
+            i++;
+        } else if (strcmp(argv[i], "--pid") == 0 && value) { pid = (pid_t)atoi(value); i++; }
+        else if (strcmp(argv[i], "--from") == 0 && value) { ok = parse_time_arg(value, &from) == 0; i++; }
+        else if (strcmp(argv[i], "--to") == 0 && value) { ok = parse_time_arg(value, &to) == 0; i++; }
+        else if (strcmp(argv[i], "--metric") == 0 && value) {
+            for (int m = 0; m < SAMPLE_METRIC_COUNT; m++) {
+                if (strcmp(value, sample_metrics[m].name) == 0) query.metric = m;
+            }
+            ok = query.metric >= 0;
+            i++;
+        }
+        else if (argv[i][0] != '-' && !dir) dir = argv[i];
+        else ok = 0;
+
+        if (!ok) {
+            fprintf(stderr, "Erro: opcao invalida: %s\n", argv[i]);
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (!dir) {
+        print_usage();
+        return 1;
+    }
+
+    if (tier < 0) {
+        // Sem --from o alvo é o início do histórico: o balde mais antigo de
+        // cada camada vale até o fim dele
+        long long oldest[ROLLUP_TIERS], target = from;
+        static const long long width[ROLLUP_TIERS] = { 1, 60, 600, 3600 };
+        for (int t = 0; t < ROLLUP_TIERS; t++) {
+            if (rollup_store_oldest(dir, t, &oldest[t]) != 0) return 1;
+            if (!from && oldest[t] && (!target || oldest[t] + width[t] - 1 < target)) target = oldest[t] + width[t] - 1;
+        }
+        tier = ROLLUP_1H;
+        for (int t = ROLLUP_RAW; t < ROLLUP_TIERS; t++) {
+            if (oldest[t] && oldest[t] <= target) {
+                tier = t;
+                break;
+            }
+        }
+    }
+    query.tier = tier;
+
+    printf("tier,timestamp,pid,count,metric,min,avg,max,last\n");
+    long rows = rollup_store_scan(dir, tier, pid, from, to, print_store_row, &query);
+    if (rows < 0) return 1;
+    fprintf(stderr, "%ld baldes da camada %s\n", rows, rollup_tier_names[tier]);
+    return 0;
+}
+
+/**
+ * Modo query: agregações sobre uma captura binária (samples-*.bin) pelo
+ * índice de blocos (ARQ.bin.idx, refeito se ausente), em CSV no stdout
+ */
+static int cmd_query(int argc, char **argv) {
+    const char *path = NULL;
+    Query query;
+    memset(&query, 0, sizeof(query));
+    query.group_by_pid = 1;
+    query_parse_aggs(&query, "count,avg,min,max,rate");
+    for (int m = 0; m < SAMPLE_METRIC_COUNT; m++) query.metrics[query.nmetrics++] = m;
+
+    for (int i = 0; i < argc; i++) {
+        const char *opt = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        int ok = 1;
+        if (strcmp(argv[i], "--pid") == 0 && value) { query.pid = (pid_t)atoi(value); i++; }
+        else if (strcmp(argv[i], "--from") == 0 && value) { ok = parse_time_arg(value, &query.from) == 0; i++; }
+        else if (strcmp(argv[i], "--to") == 0 && value) { ok = parse_time_arg(value, &query.to) == 0; i++; }
+        else if (strcmp(argv[i], "--metric") == 0 && value) { ok = query_parse_metrics(&query, value) == 0; i++; }
+        else if (strcmp(argv[i], "--agg") == 0 && value) { ok = query_parse_aggs(&query, value) == 0; i++; }
+        else if (strcmp(argv[i], "--group-by") == 0 && value) {
+            ok = strcmp(value, "pid") == 0 || strcmp(value, "none") == 0;
+            query.group_by_pid = strcmp(value, "pid") == 0;
+            i++;
+        }
+        else if (argv[i][0] != '-' && !path) path = argv[i];
+        else ok = 0;
+
+        if (!ok) {
+            fprintf(stderr, "Erro: opcao invalida: %s%s%s\n", opt, value && opt[0] == '-' ? " " : "", value && opt[0] == '-' ? value : "");
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (!path) {
+        print_usage();
+        return 1;
+    }
+
+    long long start_ns = monotonic_ns();
+    SampleIndex index;
+    if (sample_index_load(&index, path) != 0) return 1;
+    long long loaded_ns = monotonic_ns();
+
+    QueryStats st;
+    int rc = query_run(&index, path, &query, stdout, &st);
+    fflush(stdout);
+    long long end_ns = monotonic_ns();
+
+    fprintf(stderr, "%llu alvos | %llu resumos de bloco do indice | %llu blocos lidos (%llu registros, %.1f MB) | "
+            "indice %.2f ms, consulta %.2f ms\n",
+            st.targets, st.entries_used, st.blocks_read, st.records_read, st.bytes_read / (1024.0 * 1024.0),
+            (loaded_ns - start_ns) / 1e6, (end_ns - loaded_ns) / 1e6);
+    sample_index_free(&index);
+    return rc == 0 ? 0 : 1;
+}
+
+static int compare_cpu_desc(const void *a, const void *b) {
+    const SampleRecord *x = a, *y = b;
+    if (x->cpu.cpu_percent != y->cpu.cpu_percent) return x->cpu.cpu_percent < y->cpu.cpu_percent ? 1 : -1;
+    return (x->pid > y->pid) - (x->pid < y->pid);
+}
+
+/**
+ * Modo top: mostra a última coleta de cada alvo a partir do segmento
+ * compartilhado de um monitor rodando com --live. As leituras são cópias
+ * da memória mapeada (seqlock, live.h): nenhuma syscall por alvo e nenhuma
+ * espera pelo monitor.
+ */
+static int cmd_top(int argc, char **argv) {
+    const char *name = LIVE_DEFAULT_NAME;
+    double interval = 1.0;
+    int count = 0;  // 0 = até Ctrl+C
+
+    for (int i = 0; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--name") == 0 && value) { name = value; i++; }
+        else if (strcmp(argv[i], "--interval") == 0 && value) { interval = atof(value); i++; }
+        else if (strcmp(argv[i], "--count") == 0 && value) { count = atoi(value); i++; }
+        else {
+            fprintf(stderr, "Erro: opcao invalida: %s\n", argv[i]);
+            print_usage();
+            return 1;
+        }
+    }
+    if (interval < 0.1) interval = 0.1;
+
+    LiveReader reader;
+    if (live_reader_open(&reader, name) != 0) {
+        fprintf(stderr, "Erro: segmento %s nao encontrado (o monitor roda com --live %s?)\n", name, name);
+        return 1;
+    }
+    SampleRecord *rows = malloc(reader.header->capacity * sizeof(*rows));
+    if (!rows) {
+        live_reader_close(&reader);
+        return 1;
+    }
+
+    signal(SIGINT, handle_stop_signal);
+    signal(SIGTERM, handle_stop_signal);
+    int tty = isatty(STDOUT_FILENO);
+
+    for (int it = 0; !stop_requested && (count <= 0 || it < count); it++) {
+        if (it > 0) {
+            struct timespec ts = { (time_t)interval, (long)((interval - (time_t)interval) * 1e9) };
+            nanosleep(&ts, NULL);  // Ctrl+C interrompe a espera
+            if (stop_requested) break;
+        }
+
+        size_t n = 0;
+        unsigned slots = live_reader_slots(&reader);
+        for (unsigned s = 0; s < slots; s++)
+            if (live_read_slot(&reader, s, &rows[n]) == 1) n++;
+        qsort(rows, n, sizeof(*rows), compare_cpu_desc);
+
+        long long now = monotonic_ns();
+        long long updated = atomic_load(&reader.header->updated_ns);
+        int writer = atomic_load(&reader.header->writer_pid);
+        int gone = writer == 0 || (kill(writer, 0) != 0 && errno == ESRCH);
+
+        if (tty) printf("\033[H\033[2J");
+        printf("Segmento %s | monitor %d%s | %zu alvos | ultima coleta ha %.1f s\n\n", name, writer,
+               gone ? " (encerrado)" : "", n, updated ? (now - updated) / 1e9 : 0.0);
+        printf("%8s %7s %10s %8s %12s %12s %6s %7s\n",
+               "PID", "CPU%", "RSS MB", "THREADS", "LEIT KB/s", "ESCR KB/s", "CONN", "IDADE");
+        for (size_t r = 0; r < n; r++) {
+            const SampleRecord *rec = &rows[r];
+            printf("%8d %7.1f %10.1f %8llu %12.1f %12.1f %6llu %6.1fs\n", rec->pid, rec->cpu.cpu_percent,
+                   rec->memory.rss_bytes / (1024.0 * 1024.0), rec->cpu.threads,
+                   rec->io.read_rate_bytes_per_sec / 1024.0, rec->io.write_rate_bytes_per_sec / 1024.0,
+                   rec->io.connections, (now - rec->sampled_ns) / 1e9);
+        }
+        fflush(stdout);
+        if (gone) break;  // os valores não mudam mais
+    }
+
+    free(rows);
+    live_reader_close(&reader);
+    return 0;
+}
+
+/**
+ * Modo replay: reproduz uma captura (--record) pelos coletores de CPU,
+ * memória e I/O e pelas leituras de cgroup, o mais rápido possível, e
+ * entrega as amostras aos destinos do pipeline como no modo "Tudo"
+ */
+static int cmd_replay(int argc, char **argv) {
+    const char *path = NULL;
+    long loops = 1;
+
+    for (int i = 0; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--loops") == 0 && value) { loops = atol(value); i++; }
+        else if (argv[i][0] != '-' && !path) path = argv[i];
+        else {
+            fprintf(stderr, "Erro: opcao invalida: %s\n", argv[i]);
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (!path || loops <= 0) {
+        print_usage();
+        return 1;
+    }
+
+    CaptureHeader hdr;
+    if (capture_replay_open(path, &hdr) != 0) return 1;
+
+    printf("Reproduzindo %s: PID %d, %d CPUs", path, hdr.pid, hdr.num_cpus);
+    if (hdr.cgroup_files) printf(", cgroup %s", hdr.cgroup);
+    printf("\n");
+    if (hdr.page_size != (int)sysconf(_SC_PAGESIZE) || hdr.clk_tck != sysconf(_SC_CLK_TCK)) {
+        printf("AVISO: pagina/ticks por segundo diferentes da maquina que gravou (%d B, %ld Hz)\n",
+               hdr.page_size, hdr.clk_tck);
+    }
+
+    SamplePipeline pl;
+    if (pipeline_open(&pl, NULL) != 0) {
+        capture_replay_close();
+        return 1;
+    }
+
+    MemoryMonitorState msa;
+    CpuMonitorState csa;
+    IoMonitorState isa;
+    unsigned long long ticks = 0;
+    CgroupUsageSample cg = {0, 0, 0, 0};
+    long long cg_memory_max = 0;
+    long long start_ns = monotonic_ns();
+
+    for (long loop = 0; loop < loops; loop++) {
+        capture_replay_rewind();
+        if (cpu_monitor_init(&csa, hdr.pid) != 0 || memory_monitor_init(&msa, hdr.pid, 0) != 0) break;
+        csa.num_cpus = hdr.num_cpus;  // normalização da máquina que gravou
+        int io_ok = (io_monitor_init(&isa, hdr.pid) == 0);
+
+        CaptureTick tick;
+        while (capture_replay_next(&tick)) {
+            SampleRecord rec;
+            memset(&rec, 0, sizeof(rec));
+            if (cpu_monitor_sample(&csa, &rec.cpu) == 0) rec.flags |= SAMPLE_HAS_CPU;
+            if (memory_monitor_sample(&msa, &rec.memory) == 0) rec.flags |= SAMPLE_HAS_MEMORY;
+            if (io_ok && io_monitor_sample(&isa, &rec.io, 1.0) == 0) rec.flags |= SAMPLE_HAS_IO;
+            read_cgroup_sample(&hdr, &rec);
+            if (rec.flags & SAMPLE_HAS_CGROUP) cg = rec.cgroup;
+            if (cg.memory_bytes > cg_memory_max) cg_memory_max = cg.memory_bytes;
+
+            rec.pid = hdr.pid;
+            rec.sampled_ns = monotonic_ns();
+            pipeline_push_wait(&pl, &rec);  // nenhuma amostra se perde: espera o escritor
+            ticks++;
+        }
+        memory_monitor_free(&msa);
+    }
+
+    pipeline_close(&pl);
+    double secs = (monotonic_ns() - start_ns) / 1e9;
+    capture_replay_close();
+
+    printf("Reproducao: %llu ciclos em %.3f s (%.0f ciclos/s)\n", ticks, secs, secs > 0 ? ticks / secs : 0.0);
+    if (hdr.cgroup_files) {
+        printf("Cgroup %s no ultimo ciclo: memoria %lld bytes (pico %lld) | CPU %lld us | I/O R %lld W %lld bytes\n",
+               hdr.cgroup, cg.memory_bytes, cg_memory_max, cg.cpu_usage_usec, cg.io_read_bytes, cg.io_write_bytes);
+    }
+    return 0;
+}
+
+/**
+ * Modo profile-stacks: amostra pilhas do processo junto com o monitor de
+ * CPU, imprime a função mais quente de cada segundo ao lado do CPU% e
+ * grava o perfil acumulado em formato folded ao final (ou no Ctrl+C)
+ */
+static int cmd_profile_stacks(int argc, char **argv) {
+    pid_t pid = 0;
+    int duration = 30;
+    int freq = STACK_DEFAULT_FREQ;
+    const char *output = NULL;
+
+    for (int i = 0; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--pid") == 0 && value) { pid = (pid_t)atoi(value); i++; }
+        else if (strcmp(argv[i], "--duration") == 0 && value) { duration = atoi(value); i++; }
+        else if (strcmp(argv[i], "--freq") == 0 && value) { freq = atoi(value); i++; }
+        else if (strcmp(argv[i], "--output") == 0 && value) { output = value; i++; }
+        else {
+            fprintf(stderr, "Erro: opcao invalida: %s\n", argv[i]);
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (pid <= 0 || duration <= 0 || freq <= 0) {
+        print_usage();
+        return 1;
+    }
+
+    MonitorTarget tg;
+    CpuMonitorState cpu_state;
+    StackProfilerState prof;
+    if (target_open(&tg, pid) < 0) return 1;
+    if (cpu_monitor_init(&cpu_state, pid) < 0 || stack_profiler_init(&prof, pid, freq) < 0) {
+        target_close(&tg);
+        return 1;
+    }
+
+    signal(SIGINT, handle_stop_signal);
+    signal(SIGTERM, handle_stop_signal);
+
+    printf("Amostrando pilhas do PID %d a %d Hz por %ds (Ctrl+C encerra)\n", (int)pid, freq, duration);
+    printf("%8s %8s %8s %6s  %s\n", "CPU%", "amostr%", "amostras", "perd", "funcao mais quente");
+
+    int exited = 0;
+    for (int sec = 0; sec < duration && !stop_requested && !exited; sec++) {
+        // Dez drenagens por segundo mantêm os rings longe de encher
+        for (int tick = 0; tick < 10 && !stop_requested && !exited; tick++) {
+            exited = target_wait(&tg, 100) != 0;
+            stack_profiler_poll(&prof);
+        }
+        if (exited) {
+            char msg[256];
+            target_describe_exit(&tg, msg, sizeof(msg));
+            printf("Fim da amostragem: %s\n", msg);
+            break;
+        }
+
+        CpuSample cpu;
+        StackInterval interval;
+        if (cpu_monitor_sample(&cpu_state, &cpu) < 0 || stack_profiler_interval(&prof, &interval) < 0 ||
+            !target_same_process(&tg)) {
+            break;
+        }
+        interval.cpu_percent = cpu.cpu_percent;
+        cpu_sample_csv_write(&cpu);
+        stack_interval_csv_write(&interval);
+
+        printf("%8.1f %8.1f %8llu %6llu  %s (%.0f%%)\n", interval.cpu_percent, interval.sampled_cpu_percent,
+               interval.samples, interval.lost, interval.top_function, interval.top_percent);
+    }
+
+    char filename[256];
+    if (output) {
+        snprintf(filename, sizeof(filename), "%s", output);
+    } else {
+        time_t now = time(NULL);
+        struct tm *tm_info = localtime(&now);
+        strftime(filename, sizeof(filename), "profile-stacks-%Y%m%d_%H%M%S.folded", tm_info);
+    }
+
+    int rc = 0;
+    FILE *fp = fopen(filename, "w");
+    if (!fp) {
+        fprintf(stderr, "Erro: nao foi possivel criar %s\n", filename);
+        rc = 1;
+    } else {
+        if (stack_profiler_write_folded(&prof, fp) < 0) rc = 1;
+        fclose(fp);
+        printf("%llu amostras (%llu perdidas) em %zu pilhas distintas -> %s\n",
+               prof.total_samples, prof.total_lost, prof.stacks.count, filename);
+    }
+
+    stack_profiler_free(&prof);
+    target_close(&tg);
+    cpu_sample_csv_close();
+    stack_interval_csv_close();
+    return rc;
+}
+
+int main(int argc, char **argv) {
     int opt;
+
+    rollup_default_retention(store_retention);
+
+    // Opções globais antes do subcomando
+    while (argc > 1 && strncmp(argv[1], "--", 2) == 0) {
+        if (strcmp(argv[1], "--self-metrics") == 0) {
+            self_metrics = 1;
+            argc--;
+            argv++;
+            continue;
+        }
+        if (argc < 3) break;
+        if (strcmp(argv[1], "--io-backend") == 0) {
+            if (strcmp(argv[2], "uring") == 0) batch_backend = PROC_BATCH_URING;
+            else if (strcmp(argv[2], "pread") == 0) batch_backend = PROC_BATCH_PREAD;
+            else {
+                fprintf(stderr, "Erro: backend invalido: %s\n", argv[2]);
+                print_usage();
+                return 1;
+            }
+            batch_enabled = 1;
+        } else if (strcmp(argv[1], "--summary-interval") == 0) {
+            summary_interval = atoi(argv[2]);
+        } else if (strcmp(argv[1], "--store") == 0) {
+            store_dir = argv[2];
+        } else if (strcmp(argv[1], "--store-retention") == 0) {
+            if (rollup_parse_retention(argv[2], store_retention) != 0) return 1;
+        } else if (strcmp(argv[1], "--store-targets") == 0) {
+            store_targets = atoi(argv[2]);
+        } else if (strcmp(argv[1], "--metrics-listen") == 0) {
+            metrics_listen = argv[2];
+        } else if (strcmp(argv[1], "--live") == 0) {
+            live_name = argv[2];
+        } else if (strcmp(argv[1], "--record") == 0) {
+            record_path = argv[2];
+        } else if (strcmp(argv[1], "--proc-root") == 0) {
+            if (proc_set_roots(argv[2], NULL) != 0) return 1;
+        } else if (strcmp(argv[1], "--sys-root") == 0) {
+            if (proc_set_roots(NULL, argv[2]) != 0) return 1;
+        } else if (strcmp(argv[1], "--sinks") == 0) {
+            char list[128];
+            snprintf(list, sizeof(list), "%s", argv[2]);
+            sink_mask = 0;
+            for (char *save = NULL, *tok = strtok_r(list, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+                if (strcmp(tok, "none") == 0) continue;  // só coleta (ex.: medir a reprodução)
+                if (strcmp(tok, "console") == 0) sink_mask |= SINK_CONSOLE;
+                else if (strcmp(tok, "csv") == 0) sink_mask |= SINK_CSV;
+                else if (strcmp(tok, "bin") == 0) sink_mask |= SINK_BINARY;
+                else if (strcmp(tok, "summary") == 0) sink_mask |= SINK_SUMMARY;
+                else {
+                    fprintf(stderr, "Erro: destino invalido: %s\n", tok);
+                    print_usage();
+                    return 1;
+                }
+            }
+        } else {
+            break;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "profile-stacks") == 0) return cmd_profile_stacks(argc - 2, argv + 2);
+        if (strcmp(argv[1], "replay") == 0) return cmd_replay(argc - 2, argv + 2);
+        if (strcmp(argv[1], "store") == 0) return cmd_store(argc - 2, argv + 2);
+        if (strcmp(argv[1], "query") == 0) return cmd_query(argc - 2, argv + 2);
+        if (strcmp(argv[1], "top") == 0) return cmd_top(argc - 2, argv + 2);
+        print_usage();
+        return 1;
+    }
     
     printf("\n================================================\n");
     printf("  RESOURCE MONITOR - SISTEMA INTEGRADO\n");
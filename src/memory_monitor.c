@@ -1,46 +1,40 @@
+#define _GNU_SOURCE
 #include "monitor.h"
+#include "proc_parse.h"
+#include "capture.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 static int read_rss_vsz(pid_t pid,
                         unsigned long long *rss_bytes_out,
                         unsigned long long *vsize_bytes_out) {
     
-    char path[64];
+    char path[PROC_PATH_MAX];
 
     // Monta o caminho do arquivo /proc/<pid>/statm
-    snprintf(path, sizeof(path), "/proc/%d/statm", (int)pid);
-
-    // Abre o arquivo /proc/<pid>/statm para leitura
-    FILE *fp = fopen(path, "r");
-    
-    if (!fp) {
-        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
-        return -1;
-    }
+    snprintf(path, sizeof(path), "%s/%d/statm", proc_root(), (int)pid);
 
     // Buffer para armazenar a linha lida de statm
     char buf[256];
-    if (!fgets(buf, sizeof(buf), fp)) {
-        fprintf(stderr, "Erro: nao foi possivel ler %s\n", path);
-        fclose(fp);
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
+    
+    if (len <= 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
         return -1;
     }
-    // Já leu o que precisa, fecha o arquivo
-    fclose(fp);
 
     unsigned long long size = 0;     // total de páginas alocadas
     unsigned long long resident = 0; // páginas residentes (RSS)
 
     // Lê size e resident, e descarta o resto
-    int n = sscanf(
-        buf, 
-        "%llu %llu %*u %*u %*u %*u %*u",  // elementos ignorados
-        &size, &resident);
+    const char *p = proc_parse_u64(buf, buf + len, &size);
+    if (p) p = proc_parse_u64(p, buf + len, &resident);
 
-    if (n < 2) {
+    if (!p) {
         fprintf(stderr, "Erro: formato inesperado em %s: %s\n", path, buf);
         return -1;
     }
@@ -58,34 +52,28 @@ static int read_rss_vsz(pid_t pid,
     return 0;
 }
 
-static int read_page_faults(pid_t pid, unsigned long long *faults_out) {
+static int read_page_faults(pid_t pid,
+                            unsigned long long *minflt_out,
+                            unsigned long long *majflt_out) {
     
-    char path[64];
+    char path[PROC_PATH_MAX];
     
     // Monta o caminho do arquivo /proc/<pid>/stat
-    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
-
-    // Abre o arquivo /proc/<pid>/stat para leitura
-    FILE *fp = fopen(path, "r");
-    
-    if (!fp) {
-        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
-        return -1;
-    }
+    snprintf(path, sizeof(path), "%s/%d/stat", proc_root(), (int)pid);
 
     // Buffer para receber a linha inteira de /proc/<pid>/stat
     char buf[4096];
-    if (!fgets(buf, sizeof(buf), fp)) {
-        fprintf(stderr, "Erro: nao foi possivel ler %s\n", path);
-        fclose(fp);
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
+    
+    if (len <= 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
         return -1;
     }
-    // Já leu o que precisa, fecha o arquivo
-    fclose(fp);
 
     // /proc/<pid>/stat tem o nome do processo entre parênteses: pid (nome) ...
     // Procura o último ')' na linha para achar o fim do nome do processo
-    char *p = strrchr(buf, ')');
+    const char *end = buf + len;
+    const char *p = strrchr(buf, ')');
     if (!p) {
         fprintf(stderr, "Erro: formato inesperado em %s: %s\n", path, buf);
         return -1;
@@ -99,54 +87,52 @@ static int read_page_faults(pid_t pid, unsigned long long *faults_out) {
     // Formato de /proc/[pid]/stat após o ')':
     // 1) state (char), 2) ppid, 3) pgrp, 4) session, 5) tty_nr, 6) tpgid
     // 7) flags, 8) minflt, 9) cminflt, 10) majflt
-    int scanned = sscanf(
-        p,
-        " %*c %*d %*d %*d %*d %*d %*u "  // campos 1-7
-        "%llu "                           // campo 8: minflt
-        "%*u "                            // campo 9: cminflt
-        "%llu",                           // campo 10: majflt
-        &minflt, &majflt);
-
-    if (scanned != 2) {
+    p = proc_skip_fields(p, end, 7);              // pula os campos 1-7
+    if (p) p = proc_parse_u64(p, end, &minflt);    // campo 8: minflt
+    if (p) p = proc_skip_fields(p, end, 1);        // pula o campo 9: cminflt
+    if (p) p = proc_parse_u64(p, end, &majflt);    // campo 10: majflt
+
+    if (!p) {
         fprintf(stderr, "Erro: nao foi possivel extrair page faults de %s\n", path);
         return -1;
     }
 
-    // Soma minflt + majflt e escreve na variável original fornecida
-    *faults_out = minflt + majflt;
+    // Mantém minor e major separados: só os major custam I/O
+    *minflt_out = minflt;
+    *majflt_out = majflt;
 
     return 0;
 }
 
 static int read_swap_bytes(pid_t pid, unsigned long long *swap_bytes_out) {
     
-    char path[64];
+    char path[PROC_PATH_MAX];
     
     // Monta o caminho do arquivo /proc/<pid>/status
-    snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+    snprintf(path, sizeof(path), "%s/%d/status", proc_root(), (int)pid);
 
-    // Abre o arquivo /proc/<pid>/status para leitura
-    FILE *fp = fopen(path, "r");
+    // Lê o arquivo /proc/<pid>/status inteiro
+    char buf[4096];
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
     
-    if (!fp) {
+    if (len <= 0) {
         fprintf(stderr, "Aviso: nao foi possivel abrir %s para ler VmSwap\n", path);
         *swap_bytes_out = 0;
         return 0; // trata como zero se não der pra ler
     }
 
-    // Buffer para ler o arquivo linha por linha
-    char line[256];
-    unsigned long long swap_kb = 0;
-
-    // Percorre todas as linhas procurando pela linha que começa com "VmSwap:"
-    while (fgets(line, sizeof(line), fp)) {
-        // Se encontrar "VmSwap: <valor> kB", lê o valor em kilobytes
-        if (sscanf(line, "VmSwap: %llu kB", &swap_kb) == 1) {
-            break; // achou, pode parar de ler
-        }
+    // Tabela de chaves montada uma única vez
+    static const char *const keys[] = { "VmSwap" };
+    static ProcKeyTable table;
+    static int table_ready = 0;
+    if (!table_ready) {
+        proc_key_table_init(&table, keys, 1);
+        table_ready = 1;
     }
-    // Fecha o arquivo depois de ler tudo
-    fclose(fp);
+
+    // Procura a linha "VmSwap: <valor> kB" (valor em kilobytes)
+    unsigned long long swap_kb = 0;
+    proc_parse_kv(buf, (size_t)len, &table, &swap_kb);
 
     // Converte de kB para bytes (1 kB = 1024 bytes)
     // Escreve na variável original fornecida
@@ -155,18 +141,155 @@ static int read_swap_bytes(pid_t pid, unsigned long long *swap_bytes_out) {
     return 0;
 }
 
-int memory_monitor_sample(pid_t pid, MemorySample *sample) {
+static double timespec_diff_sec(struct timespec a, struct timespec b) {
+    return (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+/**
+ * Recalcula as somas da regressão a partir dos pontos do anel, movendo a
+ * origem de x para o ponto mais antigo. Chamado uma vez por volta do anel,
+ * o que mantém o custo amortizado O(1) por amostra.
+ */
+static void leak_rebase(MemoryMonitorState *state) {
+    state->origin_sec = state->points[state->head].t_sec;
+    state->sum_x = state->sum_y = state->sum_xx = state->sum_xy = state->sum_yy = 0.0;
+
+    for (int i = 0; i < state->count; i++) {
+        const MemoryPoint *pt = &state->points[(state->head + i) % state->window];
+        double x = pt->t_sec - state->origin_sec;
+        state->sum_x  += x;
+        state->sum_y  += pt->rss_mb;
+        state->sum_xx += x * x;
+        state->sum_xy += x * pt->rss_mb;
+        state->sum_yy += pt->rss_mb * pt->rss_mb;
+    }
+
+    state->since_rebase = 0;
+}
+
+// Insere um ponto na janela: tira a contribuição do mais antigo (se cheia) e soma a do novo
+static void leak_push(MemoryMonitorState *state, double t_sec, double rss_mb) {
+
+    if (state->count == state->window) {
+        const MemoryPoint *old = &state->points[state->head];
+        double x = old->t_sec - state->origin_sec;
+        state->sum_x  -= x;
+        state->sum_y  -= old->rss_mb;
+        state->sum_xx -= x * x;
+        state->sum_xy -= x * old->rss_mb;
+        state->sum_yy -= old->rss_mb * old->rss_mb;
+        state->head = (state->head + 1) % state->window;
+        state->count--;
+    }
+
+    int tail = (state->head + state->count) % state->window;
+    state->points[tail].t_sec = t_sec;
+    state->points[tail].rss_mb = rss_mb;
+    state->count++;
+
+    double x = t_sec - state->origin_sec;
+    state->sum_x  += x;
+    state->sum_y  += rss_mb;
+    state->sum_xx += x * x;
+    state->sum_xy += x * rss_mb;
+    state->sum_yy += rss_mb * rss_mb;
+
+    if (++state->since_rebase >= state->window) leak_rebase(state);
+}
+
+/**
+ * Mínimos quadrados sobre a janela: inclinação em MB/h e confiança.
+ * A confiança é o R² da reta (quanto da variação do RSS é explicada por
+ * crescimento linear) vezes a fração preenchida da janela, para que poucas
+ * amostras no início não disparem alarme.
+ */
+static void leak_estimate(const MemoryMonitorState *state, MemorySample *sample) {
+
+    sample->leak_slope_mb_per_hour = 0.0;
+    sample->leak_confidence = 0.0;
+    sample->leak_suspected = 0;
+
+    if (state->count < MEMORY_LEAK_MIN_SAMPLES) return;
+
+    double n = (double)state->count;
+    double sxx = n * state->sum_xx - state->sum_x * state->sum_x;
+    double sxy = n * state->sum_xy - state->sum_x * state->sum_y;
+    double syy = n * state->sum_yy - state->sum_y * state->sum_y;
+
+    if (sxx <= 0.0) return;
+
+    double slope_mb_per_sec = sxy / sxx;
+    sample->leak_slope_mb_per_hour = slope_mb_per_sec * 3600.0;
+
+    // RSS constante: não há variação para explicar
+    if (syy <= 0.0) return;
+
+    double r2 = (sxy * sxy) / (sxx * syy);
+    if (r2 > 1.0) r2 = 1.0;
+    sample->leak_confidence = r2 * n / (double)state->window;
+
+    sample->leak_suspected =
+        sample->leak_slope_mb_per_hour >= MEMORY_LEAK_MIN_MB_PER_HOUR &&
+        sample->leak_confidence >= MEMORY_LEAK_MIN_CONFIDENCE;
+}
+
+/**
+ * Inicializa o monitor de memória de um processo
+ * @param state Estado a inicializar
+ * @param pid Processo monitorado
+ * @param window_samples Tamanho da janela de detecção de vazamento (0 = padrão)
+ * @return 0 em sucesso, -1 em erro
+ */
+int memory_monitor_init(MemoryMonitorState *state, pid_t pid, int window_samples) {
+
+    if (!state) {
+        fprintf(stderr, "Erro: ponteiro nulo em memory_monitor_init\n");
+        return -1;
+    }
+
+    if (window_samples == 0) window_samples = MEMORY_LEAK_WINDOW_DEFAULT;
+    if (window_samples < MEMORY_LEAK_MIN_SAMPLES || window_samples > MEMORY_LEAK_WINDOW_MAX) {
+        fprintf(stderr, "Erro: janela invalida em memory_monitor_init: %d (use %d a %d)\n",
+                window_samples, MEMORY_LEAK_MIN_SAMPLES, MEMORY_LEAK_WINDOW_MAX);
+        return -1;
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->pid = pid;
+    state->window = window_samples;
+
+    // Anel do tamanho da janela (escrito antes de ser lido: sem calloc)
+    state->points = malloc((size_t)window_samples * sizeof(*state->points));
+    if (!state->points) {
+        fprintf(stderr, "Erro: sem memoria para a janela de %d amostras\n", window_samples);
+        return -1;
+    }
+    capture_clock(&state->start_ts);
+
+    return 0;
+}
+
+/**
+ * Coleta uma amostra de memória e atualiza taxas e detecção de vazamento
+ * @param state Estado criado por memory_monitor_init
+ * @param sample Recebe a amostra; taxas ficam em 0 na primeira chamada
+ * @return 0 em sucesso, -1 em erro
+ */
+int memory_monitor_sample(MemoryMonitorState *state, MemorySample *sample) {
     
-    // Garante que o ponteiro de saída é válido
-    if (!sample) {
+    // Garante que os ponteiros são válidos
+    if (!state || !sample) {
         fprintf(stderr, "Erro: ponteiro nulo em memory_monitor_sample\n");
         return -1;
     }
 
+    pid_t pid = state->pid;
+
     // Variáveis temporárias para guardar os valores coletados
     unsigned long long rss_bytes = 0;
     unsigned long long vsize_bytes = 0;
-    unsigned long long page_faults = 0;
+    unsigned long long minflt = 0;
+    unsigned long long majflt = 0;
     unsigned long long swap_bytes = 0;
 
     // Lê RSS e VSZ a partir de /proc/<pid>/statm
@@ -177,7 +300,7 @@ int memory_monitor_sample(pid_t pid, MemorySample *sample) {
     }
 
     // Lê page faults a partir de /proc/<pid>/stat
-    if (read_page_faults(pid, &page_faults) < 0) {
+    if (read_page_faults(pid, &minflt, &majflt) < 0) {
         fprintf(stderr, "Erro em memory_monitor_sample: falha ao ler page faults do processo %d\n",
                 (int)pid);
         return -1;
@@ -189,17 +312,60 @@ int memory_monitor_sample(pid_t pid, MemorySample *sample) {
         swap_bytes = 0;
     }
 
+    // Relógio via capture.h: na reprodução as taxas usam os instantes gravados
+    struct timespec now;
+    capture_clock(&now);
+
     // Preenche a struct de amostra com os valores coletados
+    memset(sample, 0, sizeof(*sample));
     sample->pid = pid;
-    sample->timestamp = time(NULL);    // instante da coleta
+    sample->timestamp = capture_time();  // instante da coleta
     sample->rss_bytes = rss_bytes;     // memória ram ocupada em bytes
     sample->vsize_bytes = vsize_bytes; // tamanho virtual do processo em bytes
-    sample->page_faults = page_faults; // número de page faults
+    sample->page_faults = minflt + majflt; // número de page faults
     sample->swap_bytes = swap_bytes;   // uso de swap em bytes
+    sample->minor_faults = minflt;
+    sample->major_faults = majflt;
+
+    // Taxas em relação à amostra anterior
+    double interval_sec = timespec_diff_sec(state->last_ts, now);
+    if (state->has_last && interval_sec > 0.0) {
+        // contadores do kernel só crescem; a guarda cobre reuso de PID
+        if (minflt >= state->last_minor_faults)
+            sample->minor_faults_per_sec = (double)(minflt - state->last_minor_faults) / interval_sec;
+        if (majflt >= state->last_major_faults)
+            sample->major_faults_per_sec = (double)(majflt - state->last_major_faults) / interval_sec;
+
+        sample->rss_growth_bytes_per_sec =
+            ((double)rss_bytes - (double)state->last_rss_bytes) / interval_sec;
+
+        // VmSwap só dá o saldo: crescer é swap-out, encolher é swap-in
+        double swap_delta = (double)swap_bytes - (double)state->last_swap_bytes;
+        if (swap_delta > 0.0) sample->swap_out_bytes_per_sec = swap_delta / interval_sec;
+        else sample->swap_in_bytes_per_sec = -swap_delta / interval_sec;
+    }
+
+    // Regressão do RSS na janela deslizante
+    leak_push(state, timespec_diff_sec(state->start_ts, now), (double)rss_bytes / (1024.0 * 1024.0));
+    leak_estimate(state, sample);
+
+    // Guarda os valores para a próxima amostra
+    state->has_last = 1;
+    state->last_minor_faults = minflt;
+    state->last_major_faults = majflt;
+    state->last_rss_bytes = rss_bytes;
+    state->last_swap_bytes = swap_bytes;
+    state->last_ts = now;
 
     return 0;
 }
 
+void memory_monitor_free(MemoryMonitorState *state) {
+    if (!state) return;
+    free(state->points);
+    state->points = NULL;
+}
+
 static FILE *memory_csv_file = NULL;  // arquivo CSV para memória
 
 int memory_sample_csv_write(const MemorySample *sample) {
@@ -229,18 +395,32 @@ int memory_sample_csv_write(const MemorySample *sample) {
         }
 
         // Escreve o cabeçalho do CSV
-        fprintf(memory_csv_file, "timestamp,pid,rss_bytes,vsize_bytes,page_faults,swap_bytes\n");
+        fprintf(memory_csv_file,
+                "timestamp,pid,rss_bytes,vsize_bytes,page_faults,swap_bytes,"
+                "minor_faults,major_faults,minor_faults_per_sec,major_faults_per_sec,"
+                "rss_growth_bytes_per_sec,swap_in_bytes_per_sec,swap_out_bytes_per_sec,"
+                "leak_slope_mb_per_hour,leak_confidence,leak_suspected\n");
         fflush(memory_csv_file);
     }
 
     if (fprintf(memory_csv_file,
-                "%lld,%d,%llu,%llu,%llu,%llu\n",
+                "%lld,%d,%llu,%llu,%llu,%llu,%llu,%llu,%.2f,%.2f,%.2f,%.2f,%.2f,%.4f,%.3f,%d\n",
                 (long long)sample->timestamp,
                 (int)sample->pid,
                 (unsigned long long)sample->rss_bytes,
                 (unsigned long long)sample->vsize_bytes,
                 (unsigned long long)sample->page_faults,
-                (unsigned long long)sample->swap_bytes) < 0) {
+                (unsigned long long)sample->swap_bytes,
+                sample->minor_faults,
+                sample->major_faults,
+                sample->minor_faults_per_sec,
+                sample->major_faults_per_sec,
+                sample->rss_growth_bytes_per_sec,
+                sample->swap_in_bytes_per_sec,
+                sample->swap_out_bytes_per_sec,
+                sample->leak_slope_mb_per_hour,
+                sample->leak_confidence,
+                sample->leak_suspected) < 0) {
         fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
         return -1;
     }
@@ -254,4 +434,211 @@ void memory_sample_csv_close(void) {
         fclose(memory_csv_file);
         memory_csv_file = NULL;
     }
-}
\ No newline at end of file
+}
+
+/* ============ MEMORY ROLLUP (smaps_rollup) ============ */
+
+// Ordem das chaves lidas de smaps_rollup (valores em kB)
+enum {
+    ROLLUP_RSS, ROLLUP_PSS, ROLLUP_PSS_ANON, ROLLUP_PSS_FILE, ROLLUP_PSS_SHMEM,
+    ROLLUP_SHARED_CLEAN, ROLLUP_SHARED_DIRTY, ROLLUP_PRIVATE_CLEAN, ROLLUP_PRIVATE_DIRTY,
+    ROLLUP_ANONYMOUS, ROLLUP_ANON_HUGE, ROLLUP_SWAP, ROLLUP_SWAP_PSS,
+    ROLLUP_FIELDS
+};
+
+static unsigned long long elapsed_ns(const struct timespec *start, const struct timespec *end) {
+    return (unsigned long long)(end->tv_sec - start->tv_sec) * 1000000000ULL +
+           (unsigned long long)end->tv_nsec - (unsigned long long)start->tv_nsec;
+}
+
+static int read_smaps_rollup(pid_t pid, MemoryRollupSample *sample) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/smaps_rollup", proc_root(), (int)pid);
+
+    // smaps_rollup tem ~25 linhas; 4 KB sobra
+    char buf[4096];
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
+
+    if (len <= 0) {
+        // Kernels anteriores ao 4.14 não têm smaps_rollup
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
+        return -1;
+    }
+
+    static const char *const keys[ROLLUP_FIELDS] = {
+        "Rss", "Pss", "Pss_Anon", "Pss_File", "Pss_Shmem",
+        "Shared_Clean", "Shared_Dirty", "Private_Clean", "Private_Dirty",
+        "Anonymous", "AnonHugePages", "Swap", "SwapPss"
+    };
+    static ProcKeyTable table;
+    static int table_ready = 0;
+    if (!table_ready) {
+        proc_key_table_init(&table, keys, ROLLUP_FIELDS);
+        table_ready = 1;
+    }
+
+    // Pss_Anon/File/Shmem só existem a partir do 5.9: ficam em 0 nos mais antigos
+    unsigned long long kb[ROLLUP_FIELDS] = {0};
+    if (proc_parse_kv(buf, (size_t)len, &table, kb) == 0) {
+        fprintf(stderr, "Erro: formato inesperado em %s\n", path);
+        return -1;
+    }
+
+    sample->rss_bytes       = kb[ROLLUP_RSS] * 1024;
+    sample->pss_bytes       = kb[ROLLUP_PSS] * 1024;
+    sample->uss_bytes       = (kb[ROLLUP_PRIVATE_CLEAN] + kb[ROLLUP_PRIVATE_DIRTY]) * 1024;
+    sample->shared_bytes    = (kb[ROLLUP_SHARED_CLEAN] + kb[ROLLUP_SHARED_DIRTY]) * 1024;
+    sample->pss_anon_bytes  = kb[ROLLUP_PSS_ANON] * 1024;
+    sample->pss_file_bytes  = kb[ROLLUP_PSS_FILE] * 1024;
+    sample->pss_shmem_bytes = kb[ROLLUP_PSS_SHMEM] * 1024;
+    sample->anon_bytes      = kb[ROLLUP_ANONYMOUS] * 1024;
+    sample->anon_huge_bytes = kb[ROLLUP_ANON_HUGE] * 1024;
+    sample->swap_bytes      = kb[ROLLUP_SWAP] * 1024;
+    sample->swap_pss_bytes  = kb[ROLLUP_SWAP_PSS] * 1024;
+
+    return 0;
+}
+
+/**
+ * Inicializa o coletor de smaps_rollup
+ * @param state Estado a inicializar
+ * @param pid Processo monitorado
+ * @param every_n_ticks Lê smaps_rollup a cada N chamadas de memory_rollup_tick (>= 1)
+ * @return 0 em sucesso, -1 em erro
+ */
+int memory_rollup_init(MemoryRollupState *state, pid_t pid, int every_n_ticks) {
+
+    if (!state) {
+        fprintf(stderr, "Erro: ponteiro nulo em memory_rollup_init\n");
+        return -1;
+    }
+
+    if (every_n_ticks < 1) {
+        fprintf(stderr, "Erro: cadencia invalida em memory_rollup_init: %d\n", every_n_ticks);
+        return -1;
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->pid = pid;
+    state->every_n_ticks = every_n_ticks;
+
+    // Força a leitura já na primeira chamada
+    state->tick = every_n_ticks;
+
+    return 0;
+}
+
+/**
+ * Chamado a cada amostra do loop principal; só lê smaps_rollup quando a
+ * cadência vence. Nas demais chamadas devolve a última leitura.
+ * @param state Estado do coletor
+ * @param sample Recebe a leitura (nova ou a anterior)
+ * @return 1 se leu agora, 0 se devolveu a anterior, -1 em erro
+ */
+int memory_rollup_tick(MemoryRollupState *state, MemoryRollupSample *sample) {
+
+    if (!state || !sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em memory_rollup_tick\n");
+        return -1;
+    }
+
+    if (state->tick < state->every_n_ticks) {
+        state->tick++;
+        if (!state->has_sample) return -1;
+        *sample = state->last;
+        return 0;
+    }
+
+    // Relógios pela captura: na reprodução, custo e instante são os da sessão gravada
+    struct timespec start, end;
+    capture_clock(&start);
+
+    MemoryRollupSample fresh;
+    memset(&fresh, 0, sizeof(fresh));
+    int rc = read_smaps_rollup(state->pid, &fresh);
+
+    capture_clock(&end);
+
+    // Mesmo em erro a próxima tentativa espera a cadência inteira
+    state->tick = 1;
+    if (rc < 0) return -1;
+
+    fresh.pid = state->pid;
+    fresh.timestamp = capture_time();
+    fresh.cost_ns = elapsed_ns(&start, &end);
+
+    state->reads++;
+    state->total_cost_ns += fresh.cost_ns;
+    if (fresh.cost_ns > state->max_cost_ns) state->max_cost_ns = fresh.cost_ns;
+
+    state->last = fresh;
+    state->has_sample = 1;
+    *sample = fresh;
+    return 1;
+}
+
+static FILE *rollup_csv_file = NULL;  // arquivo CSV para smaps_rollup
+
+int memory_rollup_csv_write(const MemoryRollupSample *sample) {
+    if (!sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em memory_rollup_csv_write\n");
+        return -1;
+    }
+
+    // cria o arquivo na primeira chamada
+    if (!rollup_csv_file) {
+        struct tm *tm_info = localtime(&sample->timestamp);
+        char filename[64];
+        snprintf(filename, sizeof(filename),
+                 "memory-rollup-%04d%02d%02d_%02d%02d%02d.csv",
+                 tm_info->tm_year + 1900,
+                 tm_info->tm_mon + 1,
+                 tm_info->tm_mday,
+                 tm_info->tm_hour,
+                 tm_info->tm_min,
+                 tm_info->tm_sec);
+
+        rollup_csv_file = fopen(filename, "w");
+        if (!rollup_csv_file) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", filename);
+            return -1;
+        }
+
+        fprintf(rollup_csv_file,
+                "timestamp,pid,rss_bytes,pss_bytes,uss_bytes,shared_bytes,"
+                "pss_anon_bytes,pss_file_bytes,pss_shmem_bytes,anon_bytes,"
+                "anon_huge_bytes,swap_bytes,swap_pss_bytes,cost_ns\n");
+        fflush(rollup_csv_file);
+    }
+
+    if (fprintf(rollup_csv_file,
+                "%lld,%d,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n",
+                (long long)sample->timestamp,
+                (int)sample->pid,
+                sample->rss_bytes,
+                sample->pss_bytes,
+                sample->uss_bytes,
+                sample->shared_bytes,
+                sample->pss_anon_bytes,
+                sample->pss_file_bytes,
+                sample->pss_shmem_bytes,
+                sample->anon_bytes,
+                sample->anon_huge_bytes,
+                sample->swap_bytes,
+                sample->swap_pss_bytes,
+                sample->cost_ns) < 0) {
+        fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+        return -1;
+    }
+
+    fflush(rollup_csv_file);
+    return 0;
+}
+
+void memory_rollup_csv_close(void) {
+    if (rollup_csv_file) {
+        fclose(rollup_csv_file);
+        rollup_csv_file = NULL;
+    }
+}
@@ -1,5 +1,6 @@
 #define _GNU_SOURCE
 #include "namespace.h"
+#include "proc_parse.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <dirent.h>
@@ -11,7 +12,7 @@
 #include <sys/wait.h>
 #include <ctype.h>
 
-#define NS_PATH_FMT "/proc/%d/ns/%s"
+#define NS_PATH_FMT "%s/%d/ns/%s"  // raiz de /proc, pid, tipo
 #define STACK_SIZE 8192
 
 const char *namespace_types[] = {
@@ -52,8 +53,8 @@ void list_process_namespaces(pid_t pid) {
     printf("Namespaces do processo %d\n", pid);
 
     for (int i = 0; i < namespace_count; i++) {
-        char path[256];
-        snprintf(path, sizeof(path), NS_PATH_FMT, pid, namespace_types[i]);
+        char path[PROC_PATH_MAX];
+        snprintf(path, sizeof(path), NS_PATH_FMT, proc_root(), pid, namespace_types[i]);
         long long inode = get_inode(path);
 
         if (inode != -1)
@@ -67,10 +68,10 @@ void compare_namespaces(pid_t p1, pid_t p2) {
     printf("Comparando namespaces entre %d e %d\n", p1, p2);
 
     for (int i = 0; i < namespace_count; i++) {
-        char path1[256], path2[256];
+        char path1[PROC_PATH_MAX], path2[PROC_PATH_MAX];
 
-        snprintf(path1, sizeof(path1), NS_PATH_FMT, p1, namespace_types[i]);
-        snprintf(path2, sizeof(path2), NS_PATH_FMT, p2, namespace_types[i]);
+        snprintf(path1, sizeof(path1), NS_PATH_FMT, proc_root(), p1, namespace_types[i]);
+        snprintf(path2, sizeof(path2), NS_PATH_FMT, proc_root(), p2, namespace_types[i]);
 
         long long i1 = get_inode(path1);
         long long i2 = get_inode(path2);
@@ -86,7 +87,7 @@ void compare_namespaces(pid_t p1, pid_t p2) {
 void list_namespace_members(const char *type, long long inode) {
     printf("Processos no namespace %s inode=%lld:\n", type, inode);
 
-    DIR *d = opendir("/proc");
+    DIR *d = opendir(proc_root());
     if (!d) return;
 
     struct dirent *ent;
@@ -95,8 +96,8 @@ void list_namespace_members(const char *type, long long inode) {
 
         pid_t pid = atoi(ent->d_name);
 
-        char path[256];
-        snprintf(path, sizeof(path), "/proc/%d/ns/%s", pid, type);
+        char path[PROC_PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%d/ns/%s", proc_root(), pid, type);
 
         if (get_inode(path) == inode)
             printf("  PID %d\n", pid);
@@ -166,7 +167,7 @@ void generate_namespace_report(const char *output) {
         const char *type = namespace_types[i];
         NSNode *list = NULL;
 
-        DIR *d = opendir("/proc");
+        DIR *d = opendir(proc_root());
         if (!d) continue;
 
         struct dirent *ent;
@@ -175,8 +176,8 @@ void generate_namespace_report(const char *output) {
 
             pid_t pid = atoi(ent->d_name);
 
-            char path[256];
-            snprintf(path, sizeof(path), "/proc/%d/ns/%s", pid, type);
+            char path[PROC_PATH_MAX];
+            snprintf(path, sizeof(path), "%s/%d/ns/%s", proc_root(), pid, type);
 
             long long inode = get_inode(path);
             if (inode != -1)
@@ -228,7 +229,7 @@ void list_all_system_namespaces(void) {
         const char *type = namespace_types[i];
         NSNode *list = NULL;
 
-        DIR *d = opendir("/proc");
+        DIR *d = opendir(proc_root());
         if (!d) continue;
 
         struct dirent *ent;
@@ -237,8 +238,8 @@ void list_all_system_namespaces(void) {
 
             pid_t pid = atoi(ent->d_name);
 
-            char path[256];
-            snprintf(path, sizeof(path), "/proc/%d/ns/%s", pid, type);
+            char path[PROC_PATH_MAX];
+            snprintf(path, sizeof(path), "%s/%d/ns/%s", proc_root(), pid, type);
 
             long long inode = get_inode(path);
             if (inode != -1)
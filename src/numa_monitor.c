@@ -0,0 +1,397 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "proc_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Colocação NUMA de um processo: em que nó está a memória (numa_maps),
+ * como os nós estão alocando (numastat) e em que nó as threads rodam.
+ * Cruzando os dois dá a fração de acessos que tende a ser remota.
+ */
+
+#define NODE_DIR "%s/devices/system/node"  // prefixo: raiz de /sys (sys_root)
+
+// Ordem das chaves lidas de nodeN/numastat
+enum { NS_HIT, NS_MISS, NS_FOREIGN, NS_LOCAL, NS_OTHER, NS_FIELDS };
+
+static double timespec_diff_sec(struct timespec a, struct timespec b) {
+    return (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+/**
+ * Expande uma lista do kernel no formato "0-3,8,10-11"
+ * @param out Recebe os números expandidos
+ * @param max Capacidade de out
+ * @return quantidade escrita em out
+ */
+static int parse_list(const char *p, const char *end, int *out, int max) {
+    int n = 0;
+    while (p < end && n < max) {
+        unsigned long long first = 0, last = 0;
+        const char *q = proc_parse_u64(p, end, &first);
+        if (!q) break;
+        last = first;
+        if (q < end && *q == '-') {
+            q = proc_parse_u64(q + 1, end, &last);
+            if (!q) break;
+        }
+        for (unsigned long long v = first; v <= last && n < max; v++) out[n++] = (int)v;
+        p = q;
+        if (p < end && *p == ',') p++;
+        else break;
+    }
+    return n;
+}
+
+static int node_index(const NumaMonitorState *state, int node) {
+    for (int i = 0; i < state->num_nodes; i++) {
+        if (state->node_ids[i] == node) return i;
+    }
+    return -1;
+}
+
+static int read_numastat(int node, unsigned long long values[NS_FIELDS]) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), NODE_DIR "/node%d/numastat", sys_root(), node);
+
+    char buf[512];
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
+    if (len <= 0) return -1;
+
+    static const char *const keys[NS_FIELDS] = {
+        "numa_hit", "numa_miss", "numa_foreign", "local_node", "other_node"
+    };
+    static ProcKeyTable table;
+    static int table_ready = 0;
+    if (!table_ready) {
+        proc_key_table_init(&table, keys, NS_FIELDS);
+        table_ready = 1;
+    }
+
+    memset(values, 0, NS_FIELDS * sizeof(values[0]));
+    proc_parse_kv(buf, (size_t)len, &table, values);
+    return 0;
+}
+
+/**
+ * Descobre os nós online e a CPU -> nó. Sem NODE_DIR (kernel sem NUMA),
+ * assume um único nó 0 com todas as CPUs.
+ */
+static int load_topology(NumaMonitorState *state) {
+
+    for (int c = 0; c < NUMA_MAX_CPUS; c++) state->cpu_to_node[c] = -1;
+
+    char buf[256], online[PROC_PATH_MAX];
+    snprintf(online, sizeof(online), NODE_DIR "/online", sys_root());
+    ssize_t len = proc_read_file(online, buf, sizeof(buf));
+    if (len <= 0) {
+        state->num_nodes = 1;
+        state->node_ids[0] = 0;
+        for (int c = 0; c < NUMA_MAX_CPUS; c++) state->cpu_to_node[c] = 0;
+        return 0;
+    }
+
+    state->num_nodes = parse_list(buf, buf + len, state->node_ids, NUMA_MAX_NODES);
+    if (state->num_nodes == 0) {
+        fprintf(stderr, "Erro: formato inesperado em %s\n", online);
+        return -1;
+    }
+
+    for (int i = 0; i < state->num_nodes; i++) {
+        char path[PROC_PATH_MAX];
+        snprintf(path, sizeof(path), NODE_DIR "/node%d/cpulist", sys_root(), state->node_ids[i]);
+
+        len = proc_read_file(path, buf, sizeof(buf));
+        if (len <= 0) continue;  // nó só de memória (sem CPUs)
+
+        int cpus[NUMA_MAX_CPUS];
+        int ncpus = parse_list(buf, buf + len, cpus, NUMA_MAX_CPUS);
+        for (int c = 0; c < ncpus; c++) {
+            if (cpus[c] < NUMA_MAX_CPUS) state->cpu_to_node[cpus[c]] = (short)i;
+        }
+    }
+
+    return 0;
+}
+
+static int starts_with(const char *p, const char *end, const char *prefix, size_t len) {
+    return (size_t)(end - p) >= len && memcmp(p, prefix, len) == 0;
+}
+
+/**
+ * Soma as páginas de cada nó por tipo de mapeamento. Cada linha tem:
+ * endereço política [file=... | heap | stack | huge] anon=.. N<nó>=<páginas> ... kernelpagesize_kB=..
+ */
+static int parse_numa_maps(NumaMonitorState *state, NumaSample *sample) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/numa_maps", proc_root(), (int)state->pid);
+
+    ssize_t len = proc_read_file_dyn(path, &state->buf, &state->buf_capacity);
+    if (len < 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
+        return -1;
+    }
+
+    const char *p = state->buf;
+    const char *end = state->buf + len;
+
+    while (p < end) {
+        const char *line_end = memchr(p, '\n', (size_t)(end - p));
+        if (!line_end) line_end = end;
+
+        unsigned long long pages[NUMA_MAX_NODES] = {0};
+        unsigned long long page_kb = 4;
+        int type = NUMA_MAP_ANON;
+
+        // Pula endereço e política; o resto são tokens independentes
+        const char *tok = proc_skip_fields(p, line_end, 2);
+        while (tok && tok < line_end) {
+            const char *tok_end = tok;
+            while (tok_end < line_end && *tok_end != ' ') tok_end++;
+
+            if (*tok == 'N' && tok + 1 < tok_end && (unsigned char)(tok[1] - '0') < 10) {
+                unsigned long long node = 0, count = 0;
+                const char *q = proc_parse_u64(tok + 1, tok_end, &node);
+                if (q && q < tok_end && *q == '=' && proc_parse_u64(q + 1, tok_end, &count)) {
+                    int idx = node_index(state, (int)node);
+                    if (idx >= 0) pages[idx] += count;
+                }
+            } else if (starts_with(tok, tok_end, "kernelpagesize_kB=", 18)) {
+                proc_parse_u64(tok + 18, tok_end, &page_kb);
+            } else if (starts_with(tok, tok_end, "heap", 4)) {
+                type = NUMA_MAP_HEAP;
+            } else if (starts_with(tok, tok_end, "stack", 5)) {
+                type = NUMA_MAP_STACK;
+            } else if (starts_with(tok, tok_end, "huge", 4)) {
+                type = NUMA_MAP_HUGE;
+            } else if (starts_with(tok, tok_end, "file=", 5) && type != NUMA_MAP_HUGE) {
+                const char *f = tok + 5;
+                type = (starts_with(f, tok_end, "/dev/shm/", 9) ||
+                        starts_with(f, tok_end, "/SYSV", 5) ||
+                        starts_with(f, tok_end, "/memfd:", 7)) ? NUMA_MAP_SHMEM : NUMA_MAP_FILE;
+            }
+
+            tok = tok_end;
+            while (tok < line_end && *tok == ' ') tok++;
+        }
+
+        for (int i = 0; i < state->num_nodes; i++) {
+            unsigned long long bytes = pages[i] * page_kb * 1024;
+            sample->nodes[i].bytes[type] += bytes;
+            sample->nodes[i].total_bytes += bytes;
+            sample->total_bytes += bytes;
+        }
+
+        p = line_end + 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Distribui as threads mais quentes pelos nós do último CPU em que rodaram
+ * e calcula a fração local da memória vista por elas.
+ */
+static void place_threads(NumaMonitorState *state, NumaSample *sample) {
+
+    int n = thread_monitor_sample(&state->threads, state->top, NUMA_THREAD_TOP);
+    if (n <= 0 || sample->total_bytes == 0) return;
+
+    double cpu_sum = 0.0;
+    for (int t = 0; t < n; t++) cpu_sum += state->top[t].cpu_percent;
+
+    double local = 0.0;
+    for (int t = 0; t < n; t++) {
+        int cpu = state->top[t].last_cpu;
+        int idx = (cpu >= 0 && cpu < NUMA_MAX_CPUS) ? state->cpu_to_node[cpu] : -1;
+        if (idx < 0) continue;
+
+        sample->nodes[idx].threads++;
+        sample->nodes[idx].thread_cpu_percent += state->top[t].cpu_percent;
+
+        // Threads paradas pesam igual quando ninguém usou CPU no intervalo
+        double weight = cpu_sum > 0.0 ? state->top[t].cpu_percent / cpu_sum : 1.0 / n;
+        local += weight * (double)sample->nodes[idx].total_bytes / (double)sample->total_bytes;
+    }
+
+    // Arredondamento pode passar de 100% por uma fração mínima
+    sample->local_percent = local >= 1.0 ? 100.0 : 100.0 * local;
+    sample->remote_percent = 100.0 - sample->local_percent;
+}
+
+/**
+ * Inicializa o monitor NUMA de um processo
+ *
+ * @param state Estado a inicializar
+ * @param pid Processo monitorado
+ * @return 0 em sucesso, -1 em erro
+ */
+int numa_monitor_init(NumaMonitorState *state, pid_t pid) {
+
+    if (!state) {
+        fprintf(stderr, "Erro: ponteiro nulo em numa_monitor_init\n");
+        return -1;
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->pid = pid;
+
+    if (load_topology(state) < 0) return -1;
+
+    for (int i = 0; i < state->num_nodes; i++) {
+        read_numastat(state->node_ids[i], state->last_numastat[i]);
+    }
+
+    if (thread_monitor_init(&state->threads, pid) < 0) {
+        fprintf(stderr, "Erro em numa_monitor_init: nao foi possivel ler threads do processo %d\n", (int)pid);
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &state->last_ts);
+    return 0;
+}
+
+// Taxa de um contador de numastat; se ele voltou (hotplug do nó), o intervalo conta 0
+static double numastat_rate(unsigned long long cur, unsigned long long prev, double interval_sec) {
+    return cur >= prev ? (double)(cur - prev) / interval_sec : 0.0;
+}
+
+/**
+ * Coleta memória por nó, taxas de numastat e colocação das threads
+ *
+ * @param state Estado criado por numa_monitor_init
+ * @param sample Recebe a amostra
+ * @return 0 em sucesso, -1 em erro
+ */
+int numa_monitor_sample(NumaMonitorState *state, NumaSample *sample) {
+
+    if (!state || !sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em numa_monitor_sample\n");
+        return -1;
+    }
+
+    memset(sample, 0, sizeof(*sample));
+    sample->pid = state->pid;
+    sample->timestamp = time(NULL);
+    sample->num_nodes = state->num_nodes;
+    for (int i = 0; i < state->num_nodes; i++) sample->nodes[i].node = state->node_ids[i];
+
+    if (parse_numa_maps(state, sample) < 0) {
+        fprintf(stderr, "Erro em numa_monitor_sample: falha ao ler numa_maps do processo %d\n",
+                (int)state->pid);
+        return -1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double interval_sec = timespec_diff_sec(state->last_ts, now);
+
+    for (int i = 0; i < state->num_nodes; i++) {
+        unsigned long long cur[NS_FIELDS];
+        if (read_numastat(state->node_ids[i], cur) < 0) continue;
+
+        if (interval_sec > 0.0) {
+            const unsigned long long *prev = state->last_numastat[i];
+            NumaNodeUsage *u = &sample->nodes[i];
+            u->numa_hit_per_sec     = numastat_rate(cur[NS_HIT], prev[NS_HIT], interval_sec);
+            u->numa_miss_per_sec    = numastat_rate(cur[NS_MISS], prev[NS_MISS], interval_sec);
+            u->numa_foreign_per_sec = numastat_rate(cur[NS_FOREIGN], prev[NS_FOREIGN], interval_sec);
+            u->local_node_per_sec   = numastat_rate(cur[NS_LOCAL], prev[NS_LOCAL], interval_sec);
+            u->other_node_per_sec   = numastat_rate(cur[NS_OTHER], prev[NS_OTHER], interval_sec);
+        }
+        memcpy(state->last_numastat[i], cur, sizeof(cur));
+    }
+    state->last_ts = now;
+
+    place_threads(state, sample);
+    return 0;
+}
+
+void numa_monitor_free(NumaMonitorState *state) {
+    if (!state) return;
+    thread_monitor_free(&state->threads);
+    free(state->buf);
+    state->buf = NULL;
+    state->buf_capacity = 0;
+}
+
+static FILE *numa_csv_file = NULL;  // arquivo CSV para NUMA
+
+int numa_sample_csv_write(const NumaSample *sample) {
+    if (!sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em numa_sample_csv_write\n");
+        return -1;
+    }
+
+    // cria o arquivo na primeira chamada
+    if (!numa_csv_file) {
+        struct tm *tm_info = localtime(&sample->timestamp);
+        char filename[64];
+        snprintf(filename, sizeof(filename),
+                 "numa-monitor-%04d%02d%02d_%02d%02d%02d.csv",
+                 tm_info->tm_year + 1900,
+                 tm_info->tm_mon + 1,
+                 tm_info->tm_mday,
+                 tm_info->tm_hour,
+                 tm_info->tm_min,
+                 tm_info->tm_sec);
+
+        numa_csv_file = fopen(filename, "w");
+        if (!numa_csv_file) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", filename);
+            return -1;
+        }
+
+        fprintf(numa_csv_file,
+                "timestamp,pid,node,heap_bytes,stack_bytes,anon_bytes,file_bytes,shmem_bytes,huge_bytes,"
+                "total_bytes,numa_hit_per_sec,numa_miss_per_sec,numa_foreign_per_sec,"
+                "local_node_per_sec,other_node_per_sec,threads,thread_cpu_percent,"
+                "local_percent,remote_percent\n");
+        fflush(numa_csv_file);
+    }
+
+    // Uma linha por nó; local/remote_percent se repetem (são do processo)
+    for (int i = 0; i < sample->num_nodes; i++) {
+        const NumaNodeUsage *u = &sample->nodes[i];
+        if (fprintf(numa_csv_file,
+                    "%lld,%d,%d,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.2f,%.2f,%.2f,%.2f,%.2f,%d,%.2f,%.2f,%.2f\n",
+                    (long long)sample->timestamp,
+                    (int)sample->pid,
+                    u->node,
+                    u->bytes[NUMA_MAP_HEAP],
+                    u->bytes[NUMA_MAP_STACK],
+                    u->bytes[NUMA_MAP_ANON],
+                    u->bytes[NUMA_MAP_FILE],
+                    u->bytes[NUMA_MAP_SHMEM],
+                    u->bytes[NUMA_MAP_HUGE],
+                    u->total_bytes,
+                    u->numa_hit_per_sec,
+                    u->numa_miss_per_sec,
+                    u->numa_foreign_per_sec,
+                    u->local_node_per_sec,
+                    u->other_node_per_sec,
+                    u->threads,
+                    u->thread_cpu_percent,
+                    sample->local_percent,
+                    sample->remote_percent) < 0) {
+            fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+            return -1;
+        }
+    }
+
+    fflush(numa_csv_file);
+    return 0;
+}
+
+void numa_sample_csv_close(void) {
+    if (numa_csv_file) {
+        fclose(numa_csv_file);
+        numa_csv_file = NULL;
+    }
+}
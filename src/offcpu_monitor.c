@@ -0,0 +1,488 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "proc_parse.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Perfil off-CPU por amostragem do estado das threads.
+ *
+ * A cada varredura, para cada thread: o estado vem de task/<tid>/stat; se
+ * a thread não está em R, task/<tid>/syscall diz em qual syscall ela está
+ * parada (e com quais argumentos) e task/<tid>/wchan em qual função do
+ * kernel dorme. Os três arquivos ficam abertos e são relidos com pread no
+ * offset 0, o que regera o conteúdo sem open/close — a varredura custa
+ * de 1 a 3 syscalls por thread e aguenta 100 Hz ou mais.
+ *
+ * wchan devolve "0" quando o kernel esconde símbolos (kptr_restrict) e
+ * syscall exige permissão de ptrace; nesses casos o rótulo fica só com o
+ * que estiver disponível.
+ */
+
+// Syscalls bloqueantes mais comuns; fd_arg = 1 quando o primeiro argumento é um fd
+static const struct {
+    long nr;
+    const char *name;
+    int fd_arg;
+} syscall_names[] = {
+    { SYS_read, "read", 1 },
+    { SYS_write, "write", 1 },
+    { SYS_pread64, "pread64", 1 },
+    { SYS_pwrite64, "pwrite64", 1 },
+    { SYS_readv, "readv", 1 },
+    { SYS_writev, "writev", 1 },
+    { SYS_recvfrom, "recvfrom", 1 },
+    { SYS_recvmsg, "recvmsg", 1 },
+    { SYS_sendto, "sendto", 1 },
+    { SYS_sendmsg, "sendmsg", 1 },
+    { SYS_accept, "accept", 1 },
+    { SYS_accept4, "accept4", 1 },
+    { SYS_connect, "connect", 1 },
+    { SYS_fsync, "fsync", 1 },
+    { SYS_fdatasync, "fdatasync", 1 },
+    { SYS_flock, "flock", 1 },
+    { SYS_fcntl, "fcntl", 1 },
+    { SYS_ioctl, "ioctl", 1 },
+    { SYS_epoll_pwait, "epoll_pwait", 1 },
+#ifdef SYS_epoll_wait
+    { SYS_epoll_wait, "epoll_wait", 1 },
+#endif
+#ifdef SYS_epoll_pwait2
+    { SYS_epoll_pwait2, "epoll_pwait2", 1 },
+#endif
+    { SYS_io_uring_enter, "io_uring_enter", 1 },
+    { SYS_futex, "futex", 0 },
+    { SYS_ppoll, "ppoll", 0 },
+    { SYS_pselect6, "pselect6", 0 },
+#ifdef SYS_poll
+    { SYS_poll, "poll", 0 },
+#endif
+#ifdef SYS_select
+    { SYS_select, "select", 0 },
+#endif
+#ifdef SYS_pause
+    { SYS_pause, "pause", 0 },
+#endif
+    { SYS_nanosleep, "nanosleep", 0 },
+    { SYS_clock_nanosleep, "clock_nanosleep", 0 },
+    { SYS_wait4, "wait4", 0 },
+    { SYS_waitid, "waitid", 0 },
+    { SYS_io_getevents, "io_getevents", 0 },
+    { SYS_rt_sigtimedwait, "rt_sigtimedwait", 0 },
+    { SYS_rt_sigsuspend, "rt_sigsuspend", 0 },
+    { SYS_msgrcv, "msgrcv", 0 },
+    { SYS_semtimedop, "semtimedop", 0 },
+    { SYS_openat, "openat", 0 },
+    { SYS_sched_yield, "sched_yield", 0 },
+};
+
+static double timespec_diff_sec(struct timespec a, struct timespec b) {
+    return (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+static unsigned long long hash_label(char state, const char *label) {
+    unsigned long long h = 0xcbf29ce484222325ULL ^ (unsigned char)state;  // FNV-1a
+    for (const char *p = label; *p; p++) {
+        h ^= (unsigned char)*p;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static int open_task_file(pid_t pid, pid_t tid, const char *name) {
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/task/%d/%s", proc_root(), (int)pid, (int)tid, name);
+    return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+static void close_thread(OffCpuThread *t) {
+    if (t->stat_fd != -1) close(t->stat_fd);
+    if (t->wchan_fd != -1) close(t->wchan_fd);
+    if (t->syscall_fd != -1) close(t->syscall_fd);
+    t->stat_fd = t->wchan_fd = t->syscall_fd = -1;
+}
+
+/**
+ * Abre os fds de threads novas e fecha os das que terminaram
+ * @return 0 em sucesso, -1 se o processo não existe mais
+ */
+static int scan_threads(OffCpuState *state) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/task", proc_root(), (int)state->pid);
+
+    DIR *dir = opendir(path);
+    if (!dir) return -1;
+
+    for (int i = 0; i < state->nthreads; i++) state->threads[i].seen = 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        pid_t tid = (pid_t)atoi(entry->d_name);
+
+        int found = 0;
+        for (int i = 0; i < state->nthreads; i++) {
+            if (state->threads[i].tid == tid) {
+                state->threads[i].seen = 1;
+                found = 1;
+                break;
+            }
+        }
+        if (found) continue;
+
+        if (state->nthreads == state->threads_capacity) {
+            int cap = state->threads_capacity ? state->threads_capacity * 2 : 16;
+            OffCpuThread *threads = realloc(state->threads, (size_t)cap * sizeof(*threads));
+            if (!threads) break;
+            state->threads = threads;
+            state->threads_capacity = cap;
+        }
+
+        OffCpuThread *t = &state->threads[state->nthreads];
+        t->tid = tid;
+        t->stat_fd = open_task_file(state->pid, tid, "stat");
+        if (t->stat_fd == -1) continue;
+        t->wchan_fd = open_task_file(state->pid, tid, "wchan");
+        t->syscall_fd = open_task_file(state->pid, tid, "syscall");
+        t->seen = 1;
+        state->nthreads++;
+    }
+    closedir(dir);
+
+    int kept = 0;
+    for (int i = 0; i < state->nthreads; i++) {
+        if (!state->threads[i].seen) {
+            close_thread(&state->threads[i]);
+            continue;
+        }
+        state->threads[kept++] = state->threads[i];
+    }
+    state->nthreads = kept;
+    return 0;
+}
+
+/**
+ * Inicializa o amostrador off-CPU de um processo
+ * @param state Estado a inicializar
+ * @param pid Processo a amostrar
+ * @return 0 em sucesso, -1 em erro
+ */
+int offcpu_monitor_init(OffCpuState *state, pid_t pid) {
+
+    if (!state) {
+        fprintf(stderr, "Erro: ponteiro nulo em offcpu_monitor_init\n");
+        return -1;
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->pid = pid;
+    for (int i = 0; i < OFFCPU_FD_CACHE; i++) state->fd_cache[i].fd = -1;
+
+    if (scan_threads(state) < 0 || state->nthreads == 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir as threads do PID %d\n", (int)pid);
+        offcpu_monitor_free(state);
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &state->period_start);
+    return 0;
+}
+
+/**
+ * Alvo de um fd ("socket:[123]", "/var/log/x"), em cache até o próximo resumo
+ */
+static const char *fd_target(OffCpuState *state, long fd) {
+
+    if (fd < 0) return "?";
+
+    OffCpuFdCache *slot = &state->fd_cache[(unsigned long)fd % OFFCPU_FD_CACHE];
+    if (slot->fd == fd) return slot->target;
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/fd/%ld", proc_root(), (int)state->pid, fd);
+    ssize_t n = readlink(path, slot->target, sizeof(slot->target) - 1);
+    if (n < 0) n = 0;
+    slot->target[n] = '\0';
+    slot->fd = (int)fd;
+    return slot->target;
+}
+
+/**
+ * Monta o rótulo de espera a partir de syscall ("nr arg1 ... sp pc") e wchan
+ */
+static void build_label(OffCpuState *state, const char *sys, const char *wchan, char *label, size_t size) {
+
+    size_t len = 0;
+    label[0] = '\0';
+
+    if (sys[0] != '\0' && strncmp(sys, "running", 7) != 0) {
+        const char *end = sys + strlen(sys);
+        long long nr = 0;
+        const char *p = proc_parse_i64(sys, end, &nr);
+
+        if (!p || nr < 0) {
+            // -1: bloqueada fora de syscall (ex.: page fault)
+            len = (size_t)snprintf(label, size, "[fora de syscall]");
+        } else {
+            const char *name = NULL;
+            int fd_arg = 0;
+            for (size_t i = 0; i < sizeof(syscall_names) / sizeof(syscall_names[0]); i++) {
+                if (syscall_names[i].nr == nr) {
+                    name = syscall_names[i].name;
+                    fd_arg = syscall_names[i].fd_arg;
+                    break;
+                }
+            }
+
+            if (name && fd_arg) {
+                unsigned long long fd = 0;
+                while (p < end && *p == ' ') p++;
+                if (p + 2 < end && p[0] == '0' && p[1] == 'x') proc_parse_hex(p + 2, end, &fd);
+                len = (size_t)snprintf(label, size, "%s(fd %llu %s)", name, fd, fd_target(state, (long)fd));
+            } else if (name) {
+                len = (size_t)snprintf(label, size, "%s", name);
+            } else {
+                len = (size_t)snprintf(label, size, "syscall_%lld", nr);
+            }
+        }
+    }
+
+    if (len < size && wchan[0] != '\0' && strcmp(wchan, "0") != 0) {
+        snprintf(label + len, size - len, "%s[%s]", len ? " " : "", wchan);
+    } else if (len == 0) {
+        snprintf(label, size, "[desconhecido]");
+    }
+}
+
+static void add_sample(OffCpuState *state, char task_state, const char *label) {
+
+    unsigned long long h = hash_label(task_state, label);
+
+    for (int i = 0; i < state->nbuckets; i++) {
+        OffCpuBucket *b = &state->buckets[i];
+        if (b->hash == h && b->state == task_state && strcmp(b->label, label) == 0) {
+            b->samples++;
+            return;
+        }
+    }
+
+    if (state->nbuckets == OFFCPU_MAX_BUCKETS) {
+        state->overflow++;
+        return;
+    }
+
+    OffCpuBucket *b = &state->buckets[state->nbuckets++];
+    b->state = task_state;
+    snprintf(b->label, sizeof(b->label), "%s", label);
+    b->hash = h;
+    b->samples = 1;
+}
+
+static ssize_t pread_text(int fd, char *buf, size_t size) {
+    if (fd == -1) return -1;
+    ssize_t n = pread(fd, buf, size - 1, 0);
+    if (n < 0) return -1;
+    while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == ' ')) n--;
+    buf[n] = '\0';
+    return n;
+}
+
+/**
+ * Uma varredura: classifica cada thread pelo estado e, fora de R, pelo
+ * motivo da espera
+ * @return número de threads amostradas, ou -1 se o processo terminou
+ */
+int offcpu_monitor_tick(OffCpuState *state) {
+
+    if (!state) {
+        fprintf(stderr, "Erro: ponteiro nulo em offcpu_monitor_tick\n");
+        return -1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    int sampled = 0;
+    for (int i = 0; i < state->nthreads; i++) {
+        OffCpuThread *t = &state->threads[i];
+        char buf[512];
+        ssize_t n = pread_text(t->stat_fd, buf, sizeof(buf));
+        if (n <= 0) continue;  // thread terminou; sai na próxima varredura de task/
+
+        // O estado vem logo após o ')' do comm
+        const char *paren = memrchr(buf, ')', (size_t)n);
+        if (!paren || paren + 2 >= buf + n) continue;
+        char task_state = paren[2];
+        sampled++;
+
+        if (task_state == 'R') {
+            state->state_counts[0]++;
+            add_sample(state, 'R', "[na CPU / fila de execucao]");
+            continue;
+        }
+
+        char sys[256] = "";
+        char wchan[128] = "";
+        pread_text(t->syscall_fd, sys, sizeof(sys));
+        pread_text(t->wchan_fd, wchan, sizeof(wchan));
+
+        char label[OFFCPU_LABEL_LEN];
+        build_label(state, sys, wchan, label, sizeof(label));
+
+        if (task_state == 'S') state->state_counts[1]++;
+        else if (task_state == 'D') state->state_counts[2]++;
+        else state->state_counts[3]++;
+
+        add_sample(state, task_state, label);
+    }
+
+    state->ticks++;
+    state->thread_samples += (unsigned long long)sampled;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    state->scan_us_total += timespec_diff_sec(t0, t1) * 1e6;
+
+    if (sampled == 0 && scan_threads(state) < 0) return -1;
+    return sampled;
+}
+
+static int compare_buckets_desc(const void *a, const void *b) {
+    const OffCpuBucket *x = a;
+    const OffCpuBucket *y = b;
+    if (x->samples != y->samples) return x->samples < y->samples ? 1 : -1;
+    return 0;
+}
+
+/**
+ * Fecha o período: ordena o histograma, copia os motivos mais frequentes,
+ * zera os contadores e revarre as threads
+ * @return 0 em sucesso, -1 se o processo terminou
+ */
+int offcpu_monitor_summary(OffCpuState *state, OffCpuSummary *summary) {
+
+    if (!state || !summary) {
+        fprintf(stderr, "Erro: ponteiro nulo em offcpu_monitor_summary\n");
+        return -1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = timespec_diff_sec(state->period_start, now);
+
+    memset(summary, 0, sizeof(*summary));
+    summary->pid = state->pid;
+    summary->timestamp = time(NULL);
+    summary->ticks = state->ticks;
+    summary->thread_samples = state->thread_samples;
+    summary->achieved_hz = elapsed > 0 ? (double)state->ticks / elapsed : 0.0;
+    summary->running = state->state_counts[0];
+    summary->sleeping = state->state_counts[1];
+    summary->disk_wait = state->state_counts[2];
+    summary->other = state->state_counts[3];
+    summary->scan_us = state->ticks ? state->scan_us_total / (double)state->ticks : 0.0;
+    summary->overflow = state->overflow;
+
+    qsort(state->buckets, (size_t)state->nbuckets, sizeof(state->buckets[0]), compare_buckets_desc);
+    summary->ntop = state->nbuckets < OFFCPU_TOP ? state->nbuckets : OFFCPU_TOP;
+    memcpy(summary->top, state->buckets, (size_t)summary->ntop * sizeof(summary->top[0]));
+
+    // Novo período
+    state->nbuckets = 0;
+    state->overflow = 0;
+    state->ticks = 0;
+    state->thread_samples = 0;
+    memset(state->state_counts, 0, sizeof(state->state_counts));
+    state->scan_us_total = 0.0;
+    state->period_start = now;
+    for (int i = 0; i < OFFCPU_FD_CACHE; i++) state->fd_cache[i].fd = -1;
+
+    int rc = scan_threads(state);
+    summary->threads = state->nthreads;
+    return rc;
+}
+
+void offcpu_monitor_free(OffCpuState *state) {
+    if (!state) return;
+    for (int i = 0; i < state->nthreads; i++) close_thread(&state->threads[i]);
+    free(state->threads);
+    state->threads = NULL;
+    state->nthreads = 0;
+    state->threads_capacity = 0;
+}
+
+static FILE *offcpu_csv_file = NULL;  // arquivo CSV para o perfil off-CPU
+
+int offcpu_summary_csv_write(const OffCpuSummary *summary) {
+    if (!summary) {
+        fprintf(stderr, "Erro: ponteiro nulo em offcpu_summary_csv_write\n");
+        return -1;
+    }
+
+    // cria o arquivo na primeira chamada
+    if (!offcpu_csv_file) {
+        struct tm *tm_info = localtime(&summary->timestamp);
+        char filename[64];
+        snprintf(filename, sizeof(filename),
+                 "offcpu-monitor-%04d%02d%02d_%02d%02d%02d.csv",
+                 tm_info->tm_year + 1900,
+                 tm_info->tm_mon + 1,
+                 tm_info->tm_mday,
+                 tm_info->tm_hour,
+                 tm_info->tm_min,
+                 tm_info->tm_sec);
+
+        offcpu_csv_file = fopen(filename, "w");
+        if (!offcpu_csv_file) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", filename);
+            return -1;
+        }
+
+        fprintf(offcpu_csv_file,
+                "timestamp,pid,ticks,achieved_hz,threads,state,reason,samples,"
+                "avg_threads,percent_of_thread_time,overflow_samples\n");
+        fflush(offcpu_csv_file);
+    }
+
+    // Uma linha por motivo; avg_threads = quantas threads, em média, estavam ali
+    for (int i = 0; i < summary->ntop; i++) {
+        const OffCpuBucket *b = &summary->top[i];
+        double avg = summary->ticks ? (double)b->samples / (double)summary->ticks : 0.0;
+        double pct = summary->thread_samples ? (double)b->samples / (double)summary->thread_samples * 100.0 : 0.0;
+
+        // O rótulo vem de wchan/syscall e de links de fd, que podem ter vírgulas e aspas
+        if (fprintf(offcpu_csv_file, "%lld,%d,%llu,%.1f,%d,%c,",
+                    (long long)summary->timestamp,
+                    (int)summary->pid,
+                    summary->ticks,
+                    summary->achieved_hz,
+                    summary->threads,
+                    b->state) < 0 ||
+            csv_write_quoted(offcpu_csv_file, b->label) != 0 ||
+            fprintf(offcpu_csv_file, ",%llu,%.3f,%.2f,%llu\n",
+                    b->samples,
+                    avg,
+                    pct,
+                    summary->overflow) < 0) {
+            fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+            return -1;
+        }
+    }
+
+    fflush(offcpu_csv_file);
+    return 0;
+}
+
+void offcpu_summary_csv_close(void) {
+    if (offcpu_csv_file) {
+        fclose(offcpu_csv_file);
+        offcpu_csv_file = NULL;
+    }
+}
@@ -0,0 +1,296 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "proc_parse.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+/*
+ * Custo do próprio monitor, medido por dentro.
+ *
+ * Cada ciclo de coleta é dividido em etapas cronometradas com
+ * CLOCK_MONOTONIC_RAW (imune a ajustes de NTP). O tempo de leitura vem dos
+ * contadores de proc_parse.c, que também somam syscalls e bytes; o resto do
+ * tempo dentro dos coletores é parsing e deltas. CPU e pico de RSS do
+ * processo inteiro (inclusive o thread escritor) vêm de getrusage.
+ *
+ * Os histogramas têm buckets em potências de 2 de nanossegundos: o registro
+ * é O(1) e o percentil sai com erro de no máximo 2x, o que basta para
+ * separar microssegundos de milissegundos.
+ */
+
+long long overhead_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static long long rusage_cpu_us(long *max_rss_kb) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+    if (max_rss_kb) *max_rss_kb = ru.ru_maxrss;
+    return (long long)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000LL +
+           ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+}
+
+void overhead_record(OverheadHistogram *hist, unsigned long long ns) {
+
+    if (!hist) return;
+
+    int b = ns ? 63 - __builtin_clzll(ns) : 0;
+    if (b >= OVERHEAD_BUCKETS) b = OVERHEAD_BUCKETS - 1;
+
+    hist->buckets[b]++;
+    if (hist->count == 0 || ns < hist->min_ns) hist->min_ns = ns;
+    if (ns > hist->max_ns) hist->max_ns = ns;
+    hist->count++;
+    hist->sum_ns += ns;
+}
+
+int overhead_init(OverheadState *state) {
+
+    if (!state) {
+        fprintf(stderr, "Erro: ponteiro nulo em overhead_init\n");
+        return -1;
+    }
+
+    memset(state, 0, sizeof(*state));
+
+    ProcReadStats rs;
+    proc_read_stats(&rs);
+    state->start_syscalls = rs.syscalls;
+    state->start_bytes = rs.bytes;
+    state->start_ns = overhead_now_ns();
+    state->last_wall_ns = state->start_ns;
+    state->start_cpu_us = rusage_cpu_us(NULL);
+    state->last_cpu_us = state->start_cpu_us;
+    return 0;
+}
+
+/**
+ * Marca o início de um ciclo
+ * @param lateness_ns Quanto o ciclo começou depois do horário marcado (0 se adiantado)
+ */
+void overhead_tick_begin(OverheadState *state, long long lateness_ns) {
+
+    if (!state) return;
+
+    ProcReadStats rs;
+    proc_read_stats(&rs);
+    state->mark_syscalls = rs.syscalls;
+    state->mark_bytes = rs.bytes;
+    state->mark_read_ns = rs.ns;
+    state->jitter_ns = lateness_ns > 0 ? (unsigned long long)lateness_ns : 0;
+    state->tick_start_ns = overhead_now_ns();
+    state->collect_end_ns = 0;
+}
+
+// Fim dos coletores: separa leitura de parsing
+void overhead_collect_done(OverheadState *state) {
+
+    if (!state) return;
+
+    state->collect_end_ns = overhead_now_ns();
+
+    ProcReadStats rs;
+    proc_read_stats(&rs);
+    unsigned long long collect_ns = (unsigned long long)(state->collect_end_ns - state->tick_start_ns);
+    unsigned long long read_ns = rs.ns - state->mark_read_ns;
+    if (read_ns > collect_ns) read_ns = collect_ns;
+
+    state->last.read_ns = read_ns;
+    state->last.parse_ns = collect_ns - read_ns;
+}
+
+/**
+ * Fecha o ciclo: registra as etapas nos histogramas e preenche a amostra
+ * da série do próprio monitor
+ */
+void overhead_tick_end(OverheadState *state, OverheadSample *sample) {
+
+    if (!state) return;
+
+    long long now = overhead_now_ns();
+    if (state->collect_end_ns == 0) overhead_collect_done(state);
+
+    ProcReadStats rs;
+    proc_read_stats(&rs);
+
+    OverheadSample *s = &state->last;
+    s->timestamp = time(NULL);
+    s->tick = ++state->ticks;
+    s->compute_ns = (unsigned long long)(now - state->collect_end_ns);
+    s->tick_ns = (unsigned long long)(now - state->tick_start_ns);
+    s->jitter_ns = state->jitter_ns;
+    s->syscalls = rs.syscalls - state->mark_syscalls;
+    s->bytes_read = rs.bytes - state->mark_bytes;
+
+    long long cpu_us = rusage_cpu_us(&s->max_rss_kb);
+    long long wall_ns = now - state->last_wall_ns;
+    s->cpu_percent = wall_ns > 0 ? 100.0 * (double)(cpu_us - state->last_cpu_us) * 1000.0 / (double)wall_ns : 0.0;
+    state->last_cpu_us = cpu_us;
+    state->last_wall_ns = now;
+
+    overhead_record(&state->stages[OVERHEAD_READ], s->read_ns);
+    overhead_record(&state->stages[OVERHEAD_PARSE], s->parse_ns);
+    overhead_record(&state->stages[OVERHEAD_COMPUTE], s->compute_ns);
+    overhead_record(&state->stages[OVERHEAD_TICK], s->tick_ns);
+    overhead_record(&state->stages[OVERHEAD_JITTER], s->jitter_ns);
+
+    if (sample) *sample = *s;
+}
+
+/* ----------------------------- RESUMO ----------------------------- */
+
+static void format_ns(unsigned long long ns, char *buf, size_t size) {
+    if (ns < 1000ULL) snprintf(buf, size, "%llu ns", ns);
+    else if (ns < 1000000ULL) snprintf(buf, size, "%.1f us", ns / 1e3);
+    else if (ns < 1000000000ULL) snprintf(buf, size, "%.1f ms", ns / 1e6);
+    else snprintf(buf, size, "%.2f s", ns / 1e9);
+}
+
+// Limite superior do bucket onde a fração q das amostras é atingida
+static unsigned long long hist_percentile(const OverheadHistogram *hist, double q) {
+
+    if (hist->count == 0) return 0;
+
+    unsigned long long rank = (unsigned long long)(q * (double)hist->count + 0.5);
+    if (rank == 0) rank = 1;
+
+    unsigned long long seen = 0;
+    for (int b = 0; b < OVERHEAD_BUCKETS; b++) {
+        seen += hist->buckets[b];
+        if (seen >= rank) {
+            unsigned long long upper = b >= 63 ? ~0ULL : (1ULL << (b + 1));
+            return upper < hist->max_ns ? upper : hist->max_ns;
+        }
+    }
+    return hist->max_ns;
+}
+
+static void print_histogram(const char *name, const OverheadHistogram *hist, FILE *fp) {
+
+    char mean[24], p50[24], p99[24], max[24];
+    if (hist->count == 0) {
+        fprintf(fp, "  %-8s sem amostras\n", name);
+        return;
+    }
+
+    format_ns(hist->sum_ns / hist->count, mean, sizeof(mean));
+    format_ns(hist_percentile(hist, 0.50), p50, sizeof(p50));
+    format_ns(hist_percentile(hist, 0.99), p99, sizeof(p99));
+    format_ns(hist->max_ns, max, sizeof(max));
+    fprintf(fp, "  %-8s n=%-6llu media %-9s p50 <=%-9s p99 <=%-9s max %s\n",
+            name, hist->count, mean, p50, p99, max);
+
+    int lo = 0, hi = OVERHEAD_BUCKETS - 1;
+    while (lo < hi && hist->buckets[lo] == 0) lo++;
+    while (hi > lo && hist->buckets[hi] == 0) hi--;
+
+    unsigned long long peak = 0;
+    for (int b = lo; b <= hi; b++) {
+        if (hist->buckets[b] > peak) peak = hist->buckets[b];
+    }
+
+    for (int b = lo; b <= hi; b++) {
+        if (hist->buckets[b] == 0) continue;  // só as faixas com amostras
+        char from[24];
+        format_ns(b == 0 ? 0 : 1ULL << b, from, sizeof(from));
+        int width = (int)(hist->buckets[b] * 30 / peak);
+        if (width == 0) width = 1;
+        fprintf(fp, "      >= %-9s %-30.*s %llu\n", from, width,
+                "##############################", hist->buckets[b]);
+    }
+}
+
+void overhead_print_summary(const OverheadState *state, FILE *fp) {
+
+    static const char *const names[OVERHEAD_STAGES] = {
+        "leitura", "parsing", "calculo", "saida", "ciclo", "atraso",
+    };
+
+    if (!state || !fp) return;
+
+    ProcReadStats rs;
+    proc_read_stats(&rs);
+    long max_rss_kb = 0;
+    long long cpu_us = rusage_cpu_us(&max_rss_kb) - state->start_cpu_us;
+    double wall_sec = (overhead_now_ns() - state->start_ns) / 1e9;
+    unsigned long long ticks = state->ticks ? state->ticks : 1;
+
+    fprintf(fp, "\n===== CUSTO DO MONITOR =====\n");
+    fprintf(fp, "Ciclos: %llu em %.1f s | CPU do monitor: %.3f s (%.2f%%) | pico de RSS: %ld KB\n",
+            state->ticks, wall_sec, cpu_us / 1e6, wall_sec > 0 ? 100.0 * cpu_us / 1e6 / wall_sec : 0.0, max_rss_kb);
+    fprintf(fp, "Leituras do kernel: %.1f syscalls e %.1f KB por ciclo\n",
+            (double)(rs.syscalls - state->start_syscalls) / ticks,
+            (double)(rs.bytes - state->start_bytes) / 1024.0 / ticks);
+
+    for (int i = 0; i < OVERHEAD_STAGES; i++) print_histogram(names[i], &state->stages[i], fp);
+}
+
+/* ------------------------------ CSV ------------------------------ */
+
+static FILE *overhead_csv_file = NULL;  // arquivo CSV do próprio monitor
+
+int overhead_csv_write(const OverheadSample *sample) {
+    if (!sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em overhead_csv_write\n");
+        return -1;
+    }
+
+    // cria o arquivo na primeira chamada
+    if (!overhead_csv_file) {
+
+        // Formata o timestamp para o nome do arquivo (YYYYMMDD_HHMMSS)
+        struct tm tm_buf;
+        struct tm *tm_info = localtime_r(&sample->timestamp, &tm_buf);
+        char filename[64];
+        snprintf(filename, sizeof(filename),
+                 "overhead-monitor-%04d%02d%02d_%02d%02d%02d.csv",
+                 tm_info->tm_year + 1900,
+                 tm_info->tm_mon + 1,
+                 tm_info->tm_mday,
+                 tm_info->tm_hour,
+                 tm_info->tm_min,
+                 tm_info->tm_sec);
+
+        overhead_csv_file = fopen(filename, "w");
+        if (!overhead_csv_file) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", filename);
+            return -1;
+        }
+
+        // Escreve o cabeçalho do CSV
+        fprintf(overhead_csv_file, "timestamp,tick,read_ns,parse_ns,compute_ns,tick_ns,jitter_ns,syscalls,bytes_read,cpu_percent,max_rss_kb\n");
+        fflush(overhead_csv_file);
+    }
+
+    if (fprintf(overhead_csv_file,
+                "%lld,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.3f,%ld\n",
+                (long long)sample->timestamp,
+                sample->tick,
+                sample->read_ns,
+                sample->parse_ns,
+                sample->compute_ns,
+                sample->tick_ns,
+                sample->jitter_ns,
+                sample->syscalls,
+                sample->bytes_read,
+                sample->cpu_percent,
+                sample->max_rss_kb) < 0) {
+        fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+        return -1;
+    }
+
+    fflush(overhead_csv_file);
+    return 0;
+}
+
+void overhead_csv_close(void) {
+    if (overhead_csv_file) {
+        fclose(overhead_csv_file);
+        overhead_csv_file = NULL;
+    }
+}
@@ -0,0 +1,469 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "proc_parse.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Contadores de desempenho por processo via perf_event_open.
+ *
+ * Um evento aberto para um pid conta só aquela thread (e as que ela criar,
+ * com inherit). Por isso cada thread existente no init recebe seus grupos;
+ * threads novas entram pela herança. Cada grupo é lido com um único read()
+ * (PERF_FORMAT_GROUP), que já devolve a soma das threads herdadas.
+ *
+ * São até PERF_COUNTERS descritores por thread: o init sobe o limite
+ * flexível de RLIMIT_NOFILE até o rígido e, se ainda não couber, abre só
+ * as primeiras threads e avisa quantas ficaram de fora.
+ */
+
+#define PERF_FD_RESERVE 64  // descritores deixados livres para CSV, /proc, sockets...
+
+static const struct {
+    unsigned int type;
+    unsigned long long config;
+} counter_defs[PERF_COUNTERS] = {
+    [PERF_CNT_CYCLES]           = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    [PERF_CNT_INSTRUCTIONS]     = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    [PERF_CNT_CACHE_REFS]       = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+    [PERF_CNT_CACHE_MISSES]     = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    [PERF_CNT_BRANCH_MISSES]    = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    [PERF_CNT_TASK_CLOCK]       = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+    [PERF_CNT_PAGE_FAULTS]      = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+    [PERF_CNT_CPU_MIGRATIONS]   = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS },
+    [PERF_CNT_CONTEXT_SWITCHES] = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+};
+
+static double timespec_diff_sec(struct timespec a, struct timespec b) {
+    return (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+static int open_counter(int counter, pid_t tid, int group_fd, int exclude_kernel) {
+
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = counter_defs[counter].type;
+    attr.config = counter_defs[counter].config;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.inherit = 1;
+    attr.exclude_kernel = (unsigned)exclude_kernel;
+    attr.exclude_hv = (unsigned)exclude_kernel;
+
+    return (int)syscall(SYS_perf_event_open, &attr, tid, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+/**
+ * Abre um grupo (líder = primeiro contador) para uma thread
+ * @param fds Recebe os fds de cada contador (-1 se aquele não existir)
+ * @param failed Acumula os eventos recusados com a thread ainda viva
+ * @param no_fds Vira 1 se algum open falhou por falta de descritores
+ * @return fd do líder, ou -1 se nem o líder abriu
+ */
+static int open_group(int first, int last, pid_t tid, int exclude_kernel, int *fds,
+                      int *failed, int *no_fds) {
+
+    for (int c = first; c <= last; c++) fds[c - first] = -1;
+
+    for (int c = first; c <= last; c++) {
+        int fd = open_counter(c, tid, c == first ? -1 : fds[0], exclude_kernel);
+        if (fd == -1) {
+            if (errno == EMFILE || errno == ENFILE) *no_fds = 1;
+            // ESRCH: a thread terminou; não há contador a perder
+            if (errno != ESRCH) *failed += c == first ? last - first + 1 : 1;
+            if (c == first) return -1;
+            continue;  // membro não suportado (ex.: branch-misses em algumas PMUs) não derruba o grupo
+        }
+        fds[c - first] = fd;
+    }
+    return fds[0];
+}
+
+static void close_group(int *fds, int n) {
+    for (int i = n - 1; i >= 0; i--) {
+        if (fds[i] != -1) close(fds[i]);
+        fds[i] = -1;
+    }
+}
+
+/**
+ * Lê um grupo com um único read() e soma os valores (escalados pela
+ * multiplexação) em totals[first..last]
+ */
+static int read_group(int leader, const int *fds, int first, int last,
+                      unsigned long long *totals,
+                      unsigned long long *enabled, unsigned long long *running) {
+
+    // nr, time_enabled, time_running, valores...
+    unsigned long long buf[3 + PERF_COUNTERS];
+    ssize_t n = read(leader, buf, sizeof(buf));
+    if (n < (ssize_t)(3 * sizeof(unsigned long long))) return -1;
+
+    unsigned long long nr = buf[0];
+    unsigned long long te = buf[1];
+    unsigned long long tr = buf[2];
+    double scale = (tr > 0 && tr < te) ? (double)te / (double)tr : 1.0;
+
+    // Os valores vêm na ordem em que os membros entraram no grupo
+    unsigned long long v = 0;
+    for (int c = first; c <= last && v < nr; c++) {
+        if (fds[c - first] == -1) continue;
+        totals[c] += (unsigned long long)((double)buf[3 + v] * scale);
+        v++;
+    }
+
+    if (enabled) *enabled += te;
+    if (running) *running += tr;
+    return 0;
+}
+
+static int read_totals(PerfCounterState *state, unsigned long long *totals,
+                       unsigned long long *enabled, unsigned long long *running) {
+
+    memset(totals, 0, PERF_COUNTERS * sizeof(*totals));
+    *enabled = 0;
+    *running = 0;
+    int ok = 0;
+
+    for (int g = 0; g < state->ngroups; g++) {
+        PerfThreadGroup *tg = &state->groups[g];
+        if (tg->hw_fd != -1 &&
+            read_group(tg->hw_fd, tg->hw_fds, 0, PERF_HW_COUNTERS - 1, totals, enabled, running) == 0) {
+            ok = 1;
+        }
+        if (tg->sw_fd != -1 &&
+            read_group(tg->sw_fd, tg->sw_fds, PERF_HW_COUNTERS, PERF_COUNTERS - 1, totals, NULL, NULL) == 0) {
+            ok = 1;
+        }
+    }
+
+    return ok ? 0 : -1;
+}
+
+/**
+ * Abre os grupos de uma thread
+ * @return 0 se algum grupo abriu, -1 se a thread terminou ou se faltaram
+ *         descritores (errno EMFILE/ENFILE, nada fica aberto)
+ */
+static int open_thread(PerfCounterState *state, pid_t tid) {
+
+    PerfThreadGroup *tg = &state->groups[state->ngroups];
+    tg->tid = tid;
+    tg->hw_fd = -1;
+    int failed = 0, no_fds = 0;
+
+    if (state->hw_available) {
+        tg->hw_fd = open_group(0, PERF_HW_COUNTERS - 1, tid, state->exclude_kernel, tg->hw_fds,
+                               &failed, &no_fds);
+    } else {
+        for (int i = 0; i < PERF_HW_COUNTERS; i++) tg->hw_fds[i] = -1;
+    }
+
+    tg->sw_fd = open_group(PERF_HW_COUNTERS, PERF_COUNTERS - 1, tid, state->exclude_kernel, tg->sw_fds,
+                           &failed, &no_fds);
+
+    // Sem descritores a thread ficaria com contadores zerados: desfaz e para
+    if (no_fds) {
+        close_group(tg->hw_fds, PERF_HW_COUNTERS);
+        close_group(tg->sw_fds, PERF_COUNTERS - PERF_HW_COUNTERS);
+        errno = EMFILE;
+        return -1;
+    }
+
+    // Thread que terminou entre o readdir e o open: ignora
+    if (tg->hw_fd == -1 && tg->sw_fd == -1) {
+        errno = ESRCH;
+        return -1;
+    }
+
+    state->failed_opens += failed;
+    state->ngroups++;
+    return 0;
+}
+
+/**
+ * Sobe o limite flexível de descritores até o rígido e devolve quantas
+ * threads cabem nele
+ */
+static int thread_budget(const PerfCounterState *state) {
+
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) return -1;
+    if (rl.rlim_cur != rl.rlim_max) {
+        struct rlimit raised = rl;
+        raised.rlim_cur = rl.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &raised) == 0) rl = raised;
+    }
+    if (rl.rlim_cur == RLIM_INFINITY) return -1;
+
+    int per_thread = (state->hw_available ? PERF_HW_COUNTERS : 0) + PERF_COUNTERS - PERF_HW_COUNTERS;
+    long long budget = ((long long)rl.rlim_cur - PERF_FD_RESERVE) / per_thread;
+    if (budget < 1) budget = 1;
+    return budget > 0x7fffffff ? -1 : (int)budget;
+}
+
+/**
+ * Decide o que dá para abrir nesta máquina usando a primeira thread:
+ * kernel+user ou só user (perf_event_paranoid), hardware ou só software.
+ */
+static int probe(PerfCounterState *state, pid_t tid) {
+
+    for (state->exclude_kernel = 0; state->exclude_kernel <= 1; state->exclude_kernel++) {
+        int fd = open_counter(PERF_CNT_TASK_CLOCK, tid, -1, state->exclude_kernel);
+        if (fd != -1) {
+            close(fd);
+            break;
+        }
+        if (errno != EACCES && errno != EPERM) {
+            fprintf(stderr, "Erro: perf_event_open falhou para %d: %s\n", (int)tid, strerror(errno));
+            return -1;
+        }
+    }
+
+    if (state->exclude_kernel > 1) {
+        fprintf(stderr, "Erro: sem permissao para perf_event_open (veja /proc/sys/kernel/perf_event_paranoid)\n");
+        return -1;
+    }
+
+    // VMs costumam não expor a PMU: ENOENT/EOPNOTSUPP no evento de ciclos
+    int fd = open_counter(PERF_CNT_CYCLES, tid, -1, state->exclude_kernel);
+    state->hw_available = fd != -1;
+    if (fd != -1) close(fd);
+
+    return 0;
+}
+
+/**
+ * Abre os contadores para todas as threads do processo
+ *
+ * @param state Estado a inicializar
+ * @param pid Processo monitorado
+ * @return 0 em sucesso, -1 em erro
+ */
+int perf_counters_init(PerfCounterState *state, pid_t pid) {
+
+    if (!state) {
+        fprintf(stderr, "Erro: ponteiro nulo em perf_counters_init\n");
+        return -1;
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->pid = pid;
+
+    if (!proc_root_is_live()) {
+        fprintf(stderr, "Erro: contadores perf precisam do /proc do kernel (raiz trocada)\n");
+        return -1;
+    }
+
+    if (probe(state, pid) < 0) return -1;
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/task", proc_root(), (int)pid);
+    DIR *dir = opendir(path);
+    if (!dir) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
+        return -1;
+    }
+
+    int budget = thread_budget(state);  // -1 = sem limite
+    int capacity = 0;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (ent->d_name[0] < '0' || ent->d_name[0] > '9') continue;
+
+        if (state->skipped_threads > 0 || (budget >= 0 && state->ngroups >= budget)) {
+            state->skipped_threads++;
+            continue;
+        }
+
+        if (state->ngroups == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            PerfThreadGroup *groups = realloc(state->groups, (size_t)capacity * sizeof(*groups));
+            if (!groups) {
+                closedir(dir);
+                perf_counters_free(state);
+                return -1;
+            }
+            state->groups = groups;
+        }
+
+        if (open_thread(state, (pid_t)atoi(ent->d_name)) != 0 && (errno == EMFILE || errno == ENFILE))
+            state->skipped_threads++;
+    }
+    closedir(dir);
+
+    if (state->skipped_threads > 0) {
+        fprintf(stderr, "Aviso: limite de descritores (RLIMIT_NOFILE) atingido: %d thread(s) de %d "
+                "sem contadores; os totais cobrem so as demais\n",
+                state->skipped_threads, state->ngroups + state->skipped_threads);
+    }
+    if (state->failed_opens > 0) {
+        fprintf(stderr, "Aviso: %d evento(s) perf nao abriram e vao contar 0\n", state->failed_opens);
+    }
+
+    if (state->ngroups == 0) {
+        fprintf(stderr, "Erro em perf_counters_init: nenhum contador aberto para o processo %d\n", (int)pid);
+        perf_counters_free(state);
+        return -1;
+    }
+
+    read_totals(state, state->last, &state->last_enabled, &state->last_running);
+    clock_gettime(CLOCK_MONOTONIC, &state->last_ts);
+    return 0;
+}
+
+/**
+ * Lê todos os grupos e calcula as variações e métricas derivadas
+ *
+ * @param state Estado criado por perf_counters_init
+ * @param sample Recebe a amostra
+ * @return 0 em sucesso, -1 em erro
+ */
+int perf_counters_sample(PerfCounterState *state, PerfSample *sample) {
+
+    if (!state || !sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em perf_counters_sample\n");
+        return -1;
+    }
+
+    unsigned long long totals[PERF_COUNTERS];
+    unsigned long long enabled, running;
+    if (read_totals(state, totals, &enabled, &running) < 0) {
+        fprintf(stderr, "Erro em perf_counters_sample: falha ao ler contadores do processo %d\n",
+                (int)state->pid);
+        return -1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double interval_sec = timespec_diff_sec(state->last_ts, now);
+    if (interval_sec <= 0.0) interval_sec = 1e-9;
+
+    memset(sample, 0, sizeof(*sample));
+    sample->pid = state->pid;
+    sample->timestamp = time(NULL);
+    sample->hw_available = state->hw_available;
+    sample->threads = state->ngroups;
+    sample->skipped_threads = state->skipped_threads;
+    sample->failed_opens = state->failed_opens;
+
+    for (int c = 0; c < PERF_COUNTERS; c++) {
+        // A escala da multiplexação pode oscilar para baixo; não gera delta negativo
+        sample->delta[c] = totals[c] >= state->last[c] ? totals[c] - state->last[c] : 0;
+        sample->per_sec[c] = (double)sample->delta[c] / interval_sec;
+    }
+
+    const unsigned long long *d = sample->delta;
+    if (d[PERF_CNT_CYCLES] > 0)
+        sample->ipc = (double)d[PERF_CNT_INSTRUCTIONS] / (double)d[PERF_CNT_CYCLES];
+    if (d[PERF_CNT_CACHE_REFS] > 0)
+        sample->cache_miss_percent = 100.0 * (double)d[PERF_CNT_CACHE_MISSES] / (double)d[PERF_CNT_CACHE_REFS];
+    if (d[PERF_CNT_INSTRUCTIONS] > 0)
+        sample->branch_misses_per_kinst = 1000.0 * (double)d[PERF_CNT_BRANCH_MISSES] / (double)d[PERF_CNT_INSTRUCTIONS];
+
+    // task-clock é em nanossegundos
+    sample->cpu_utilization = (double)d[PERF_CNT_TASK_CLOCK] / (interval_sec * 1e9);
+
+    unsigned long long de = enabled - state->last_enabled;
+    unsigned long long dr = running - state->last_running;
+    sample->multiplex_percent = (state->hw_available && de > 0) ? 100.0 * (double)dr / (double)de : 100.0;
+
+    memcpy(state->last, totals, sizeof(totals));
+    state->last_enabled = enabled;
+    state->last_running = running;
+    state->last_ts = now;
+    return 0;
+}
+
+void perf_counters_free(PerfCounterState *state) {
+    if (!state) return;
+    for (int g = 0; g < state->ngroups; g++) {
+        close_group(state->groups[g].hw_fds, PERF_HW_COUNTERS);
+        close_group(state->groups[g].sw_fds, PERF_COUNTERS - PERF_HW_COUNTERS);
+    }
+    free(state->groups);
+    state->groups = NULL;
+    state->ngroups = 0;
+}
+
+static FILE *perf_csv_file = NULL;  // arquivo CSV para contadores perf
+
+int perf_sample_csv_write(const PerfSample *sample) {
+    if (!sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em perf_sample_csv_write\n");
+        return -1;
+    }
+
+    // cria o arquivo na primeira chamada
+    if (!perf_csv_file) {
+        struct tm *tm_info = localtime(&sample->timestamp);
+        char filename[64];
+        snprintf(filename, sizeof(filename),
+                 "perf-counters-%04d%02d%02d_%02d%02d%02d.csv",
+                 tm_info->tm_year + 1900,
+                 tm_info->tm_mon + 1,
+                 tm_info->tm_mday,
+                 tm_info->tm_hour,
+                 tm_info->tm_min,
+                 tm_info->tm_sec);
+
+        perf_csv_file = fopen(filename, "w");
+        if (!perf_csv_file) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", filename);
+            return -1;
+        }
+
+        fprintf(perf_csv_file,
+                "timestamp,pid,hw_available,threads,cycles,instructions,cache_references,"
+                "cache_misses,branch_misses,task_clock_ns,page_faults,cpu_migrations,"
+                "context_switches,ipc,cache_miss_percent,branch_misses_per_kinst,"
+                "cpu_utilization,multiplex_percent,skipped_threads,failed_opens\n");
+        fflush(perf_csv_file);
+    }
+
+    const unsigned long long *d = sample->delta;
+    if (fprintf(perf_csv_file,
+                "%lld,%d,%d,%d,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.3f,%.2f,%.3f,%.3f,%.1f,%d,%d\n",
+                (long long)sample->timestamp,
+                (int)sample->pid,
+                sample->hw_available,
+                sample->threads,
+                d[PERF_CNT_CYCLES],
+                d[PERF_CNT_INSTRUCTIONS],
+                d[PERF_CNT_CACHE_REFS],
+                d[PERF_CNT_CACHE_MISSES],
+                d[PERF_CNT_BRANCH_MISSES],
+                d[PERF_CNT_TASK_CLOCK],
+                d[PERF_CNT_PAGE_FAULTS],
+                d[PERF_CNT_CPU_MIGRATIONS],
+                d[PERF_CNT_CONTEXT_SWITCHES],
+                sample->ipc,
+                sample->cache_miss_percent,
+                sample->branch_misses_per_kinst,
+                sample->cpu_utilization,
+                sample->multiplex_percent,
+                sample->skipped_threads,
+                sample->failed_opens) < 0) {
+        fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+        return -1;
+    }
+
+    fflush(perf_csv_file);
+    return 0;
+}
+
+void perf_sample_csv_close(void) {
+    if (perf_csv_file) {
+        fclose(perf_csv_file);
+        perf_csv_file = NULL;
+    }
+}
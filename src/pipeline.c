@@ -0,0 +1,435 @@
+#define _GNU_SOURCE
+#include "pipeline.h"
+#include "query.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ---------------------------- MÉTRICAS ---------------------------- */
+
+#define METRIC(name, unit, flag, field, type) { name, unit, flag, offsetof(SampleRecord, field), type }
+
+const SampleMetric sample_metrics[SAMPLE_METRIC_COUNT] = {
+    METRIC("cpu_percent",              "%",       SAMPLE_HAS_CPU,    cpu.cpu_percent,                   METRIC_DOUBLE),
+    METRIC("cpu_percent_core",         "%",       SAMPLE_HAS_CPU,    cpu.cpu_percent_core,              METRIC_DOUBLE),
+    METRIC("threads",                  "",        SAMPLE_HAS_CPU,    cpu.threads,                       METRIC_U64),
+    METRIC("rss_bytes",                "B",       SAMPLE_HAS_MEMORY, memory.rss_bytes,                  METRIC_U64),
+    METRIC("vsize_bytes",              "B",       SAMPLE_HAS_MEMORY, memory.vsize_bytes,                METRIC_U64),
+    METRIC("swap_bytes",               "B",       SAMPLE_HAS_MEMORY, memory.swap_bytes,                 METRIC_U64),
+    METRIC("minor_faults_per_sec",     "1/s",     SAMPLE_HAS_MEMORY, memory.minor_faults_per_sec,       METRIC_DOUBLE),
+    METRIC("major_faults_per_sec",     "1/s",     SAMPLE_HAS_MEMORY, memory.major_faults_per_sec,       METRIC_DOUBLE),
+    METRIC("rss_growth_bytes_per_sec", "B/s",     SAMPLE_HAS_MEMORY, memory.rss_growth_bytes_per_sec,   METRIC_DOUBLE),
+    METRIC("swap_in_bytes_per_sec",    "B/s",     SAMPLE_HAS_MEMORY, memory.swap_in_bytes_per_sec,      METRIC_DOUBLE),
+    METRIC("swap_out_bytes_per_sec",   "B/s",     SAMPLE_HAS_MEMORY, memory.swap_out_bytes_per_sec,     METRIC_DOUBLE),
+    METRIC("leak_slope_mb_per_hour",   "MB/h",    SAMPLE_HAS_MEMORY, memory.leak_slope_mb_per_hour,     METRIC_DOUBLE),
+    METRIC("read_bytes_per_sec",       "B/s",     SAMPLE_HAS_IO,     io.read_rate_bytes_per_sec,        METRIC_DOUBLE),
+    METRIC("write_bytes_per_sec",      "B/s",     SAMPLE_HAS_IO,     io.write_rate_bytes_per_sec,       METRIC_DOUBLE),
+    METRIC("disk_ops_per_sec",         "1/s",     SAMPLE_HAS_IO,     io.disk_ops_per_sec,               METRIC_DOUBLE),
+    METRIC("connections",              "",        SAMPLE_HAS_IO,     io.connections,                    METRIC_U64),
+};
+
+double sample_metric_value(const SampleRecord *record, int i) {
+    const char *field = (const char *)record + sample_metrics[i].offset;
+    if (sample_metrics[i].type == METRIC_U64) return (double)*(const unsigned long long *)field;
+    return *(const double *)field;
+}
+
+time_t sample_record_time(const SampleRecord *record) {
+    if (record->flags & SAMPLE_HAS_CPU) return record->cpu.timestamp;
+    if (record->flags & SAMPLE_HAS_MEMORY) return record->memory.timestamp;
+    if (record->flags & SAMPLE_HAS_IO) return record->io.timestamp;
+    return 0;
+}
+
+/* ------------------------------ ANEL ------------------------------ */
+
+int pipeline_init(SamplePipeline *pipeline, size_t capacity) {
+
+    if (!pipeline) {
+        fprintf(stderr, "Erro: ponteiro nulo em pipeline_init\n");
+        return -1;
+    }
+
+    memset(pipeline, 0, sizeof(*pipeline));
+
+    size_t cap = 2;
+    if (capacity == 0) capacity = PIPELINE_DEFAULT_CAPACITY;
+    while (cap < capacity) cap *= 2;
+
+    pipeline->slots = calloc(cap, sizeof(SampleRecord));
+    if (!pipeline->slots) {
+        fprintf(stderr, "Erro: sem memoria para o anel de amostras\n");
+        return -1;
+    }
+    pipeline->capacity = cap;
+
+    atomic_init(&pipeline->head, 0);
+    atomic_init(&pipeline->tail, 0);
+    atomic_init(&pipeline->dropped, 0);
+    atomic_init(&pipeline->drained, 0);
+    atomic_init(&pipeline->max_lag_ns, 0);
+    atomic_init(&pipeline->stop, 0);
+
+    if (sem_init(&pipeline->items, 0, 0) != 0) {
+        free(pipeline->slots);
+        pipeline->slots = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// Produtor: copia o registro para o anel. Retorna -1 se o anel está cheio.
+static int ring_push(SamplePipeline *pipeline, const SampleRecord *record) {
+
+    size_t head = atomic_load_explicit(&pipeline->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&pipeline->tail, memory_order_acquire);
+    if (head - tail == pipeline->capacity) return -1;
+
+    pipeline->slots[head & (pipeline->capacity - 1)] = *record;
+    atomic_store_explicit(&pipeline->head, head + 1, memory_order_release);
+
+    pipeline->pushed++;
+    if (head + 1 - tail > pipeline->max_depth) pipeline->max_depth = head + 1 - tail;
+    return 0;
+}
+
+int pipeline_push(SamplePipeline *pipeline, SampleRecord *record) {
+
+    record->seq = pipeline->next_seq++;
+
+    if (ring_push(pipeline, record) != 0) {
+        atomic_fetch_add_explicit(&pipeline->dropped, 1, memory_order_relaxed);
+        return -1;
+    }
+
+    // Só vira syscall (futex wake) se o escritor estiver dormindo
+    sem_post(&pipeline->items);
+    return 0;
+}
+
+void pipeline_push_wait(SamplePipeline *pipeline, SampleRecord *record) {
+
+    record->seq = pipeline->next_seq++;
+
+    // Sem prazo, o escritor é acordado por lote (a cada quarto do anel) e
+    // não a cada registro: um wake por registro custaria mais que a coleta.
+    // pipeline_stop acorda o escritor para o que restar.
+    while (ring_push(pipeline, record) != 0) {
+        sem_post(&pipeline->items);
+        sched_yield();
+    }
+    // Anel de 2 slots: lote de 1 (capacity / 4 daria máscara SIZE_MAX e nenhum wake)
+    size_t batch = pipeline->capacity >= 4 ? pipeline->capacity / 4 : 1;
+    if ((pipeline->pushed & (batch - 1)) == 0) sem_post(&pipeline->items);
+}
+
+// Consumidor: copia o registro mais antigo. Retorna 0 se o anel está vazio.
+static int ring_pop(SamplePipeline *pipeline, SampleRecord *out) {
+
+    size_t tail = atomic_load_explicit(&pipeline->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&pipeline->head, memory_order_acquire);
+    if (tail == head) return 0;
+
+    *out = pipeline->slots[tail & (pipeline->capacity - 1)];
+    atomic_store_explicit(&pipeline->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+/* ---------------------------- ESCRITOR ---------------------------- */
+
+static void deliver(SamplePipeline *pipeline, const SampleRecord *record) {
+
+    long long t0 = overhead_now_ns();
+    for (int i = 0; i < pipeline->nsinks; i++) {
+        SampleSink *sink = &pipeline->sinks[i];
+        if (sink->write(sink, record) == 0) sink->written++;
+        else sink->errors++;
+    }
+    // Histograma com um único escritor: este thread
+    if (pipeline->output_hist) overhead_record(pipeline->output_hist, (unsigned long long)(overhead_now_ns() - t0));
+
+    long long lag = monotonic_ns() - record->sampled_ns;
+    if (lag > atomic_load_explicit(&pipeline->max_lag_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&pipeline->max_lag_ns, lag, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&pipeline->drained, 1, memory_order_relaxed);
+}
+
+// Fim de um lote para os destinos com flush. Retorna 1 se algum adiou trabalho.
+static int flush_sinks(SamplePipeline *pipeline) {
+    int pending = 0;
+    for (int i = 0; i < pipeline->nsinks; i++) {
+        SampleSink *sink = &pipeline->sinks[i];
+        if (sink->flush && sink->flush(sink)) pending = 1;
+    }
+    return pending;
+}
+
+static void *writer_main(void *arg) {
+
+    SamplePipeline *pipeline = arg;
+    SampleRecord record;
+    int pending = 0;
+
+    for (;;) {
+        if (pending) {
+            // Algum destino adiou trabalho: volta mesmo sem registros novos
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += PIPELINE_FLUSH_RETRY_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            while (sem_timedwait(&pipeline->items, &deadline) == -1 && errno == EINTR) {
+            }
+        } else {
+            while (sem_wait(&pipeline->items) == -1 && errno == EINTR) {
+            }
+        }
+        while (ring_pop(pipeline, &record)) deliver(pipeline, &record);
+        pending = flush_sinks(pipeline);
+        if (atomic_load_explicit(&pipeline->stop, memory_order_acquire)) break;
+    }
+
+    // O produtor já parou: o que sobrou entre o último post e o stop
+    while (ring_pop(pipeline, &record)) deliver(pipeline, &record);
+    flush_sinks(pipeline);
+    return NULL;
+}
+
+int pipeline_add_sink(SamplePipeline *pipeline, const SampleSink *sink) {
+
+    if (!pipeline || !sink || !sink->write) return -1;
+    if (pipeline->running || pipeline->nsinks >= PIPELINE_MAX_SINKS) return -1;
+
+    pipeline->sinks[pipeline->nsinks++] = *sink;
+    return 0;
+}
+
+int pipeline_start(SamplePipeline *pipeline) {
+
+    if (!pipeline || !pipeline->slots || pipeline->running) return -1;
+
+    int rc = pthread_create(&pipeline->writer, NULL, writer_main, pipeline);
+    if (rc != 0) {
+        fprintf(stderr, "Erro: nao foi possivel criar o thread escritor: %s\n", strerror(rc));
+        return -1;
+    }
+    pipeline->running = 1;
+    return 0;
+}
+
+void pipeline_stop(SamplePipeline *pipeline) {
+
+    if (!pipeline) return;
+
+    if (pipeline->running) {
+        atomic_store_explicit(&pipeline->stop, 1, memory_order_release);
+        sem_post(&pipeline->items);
+        pthread_join(pipeline->writer, NULL);
+        pipeline->running = 0;
+    }
+
+    for (int i = 0; i < pipeline->nsinks; i++) {
+        if (pipeline->sinks[i].close) pipeline->sinks[i].close(&pipeline->sinks[i]);
+    }
+    pipeline->nsinks = 0;
+}
+
+void pipeline_free(SamplePipeline *pipeline) {
+    if (!pipeline) return;
+    pipeline_stop(pipeline);
+    if (pipeline->slots) sem_destroy(&pipeline->items);
+    free(pipeline->slots);
+    pipeline->slots = NULL;
+}
+
+/* ------------------------------ CSV ------------------------------ */
+
+static int csv_write(SampleSink *sink, const SampleRecord *record) {
+    (void)sink;
+    int rc = 0;
+    if ((record->flags & SAMPLE_HAS_CPU) && cpu_sample_csv_write(&record->cpu) != 0) rc = -1;
+    if ((record->flags & SAMPLE_HAS_MEMORY) && memory_sample_csv_write(&record->memory) != 0) rc = -1;
+    if ((record->flags & SAMPLE_HAS_IO) && io_sample_csv_write(&record->io) != 0) rc = -1;
+    if ((record->flags & SAMPLE_HAS_OVERHEAD) && overhead_csv_write(&record->overhead) != 0) rc = -1;
+    return rc;
+}
+
+static void csv_close(SampleSink *sink) {
+    (void)sink;
+    cpu_sample_csv_close();
+    memory_sample_csv_close();
+    io_sample_csv_close();
+    overhead_csv_close();
+}
+
+int sample_sink_csv(SampleSink *sink) {
+    if (!sink) return -1;
+    memset(sink, 0, sizeof(*sink));
+    sink->name = "csv";
+    sink->write = csv_write;
+    sink->close = csv_close;
+    return 0;
+}
+
+/* ----------------------------- BINÁRIO ----------------------------- */
+
+typedef struct {
+    FILE *fp;
+    char path[256];   // vazio = nome com timestamp da primeira coleta
+    SampleIndexBuilder index;  // vai para path.idx no fechamento (query.h)
+} BinarySink;
+
+static int binary_write(SampleSink *sink, const SampleRecord *record) {
+
+    BinarySink *bin = sink->ctx;
+
+    // cria o arquivo na primeira chamada
+    if (!bin->fp) {
+        if (!bin->path[0]) {
+            // Instante do primeiro bloco presente: a CPU pode ter falhado nesta coleta
+            time_t when = sample_record_time(record);
+            if (when == 0) when = time(NULL);
+            struct tm tm_buf;
+            struct tm *tm_info = localtime_r(&when, &tm_buf);
+            snprintf(bin->path, sizeof(bin->path),
+                     "samples-%04d%02d%02d_%02d%02d%02d.bin",
+                     tm_info->tm_year + 1900,
+                     tm_info->tm_mon + 1,
+                     tm_info->tm_mday,
+                     tm_info->tm_hour,
+                     tm_info->tm_min,
+                     tm_info->tm_sec);
+        }
+
+        bin->fp = fopen(bin->path, "wb");
+        if (!bin->fp) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", bin->path);
+            return -1;
+        }
+
+        SampleFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, SAMPLE_FILE_MAGIC, sizeof(header.magic));
+        header.version = SAMPLE_FILE_VERSION;
+        header.record_size = sizeof(SampleRecord);
+        if (fwrite(&header, sizeof(header), 1, bin->fp) != 1) return -1;
+    }
+
+    // Sem fflush por registro: o buffer do stdio agrupa as escritas
+    if (fwrite(record, sizeof(*record), 1, bin->fp) != 1) return -1;
+    return sample_index_builder_add(&bin->index, record);
+}
+
+static void binary_close(SampleSink *sink) {
+    BinarySink *bin = sink->ctx;
+    if (!bin) return;
+    if (bin->fp) {
+        // Índice depois do fclose: ele guarda o tamanho e o mtime finais do arquivo
+        if (fclose(bin->fp) == 0) sample_index_builder_write(&bin->index, bin->path);
+    }
+    sample_index_builder_free(&bin->index);
+    free(bin);
+    sink->ctx = NULL;
+}
+
+int sample_sink_binary(SampleSink *sink, const char *path) {
+
+    if (!sink) return -1;
+    memset(sink, 0, sizeof(*sink));
+
+    BinarySink *bin = calloc(1, sizeof(*bin));
+    if (!bin) return -1;
+    if (path) snprintf(bin->path, sizeof(bin->path), "%s", path);
+    sample_index_builder_init(&bin->index);
+
+    sink->name = "binario";
+    sink->write = binary_write;
+    sink->close = binary_close;
+    sink->ctx = bin;
+    sink->wants = SAMPLE_HAS_CGROUP;
+    return 0;
+}
+
+/* ----------------------------- CONSOLE ----------------------------- */
+
+static int console_write(SampleSink *sink, const SampleRecord *record) {
+
+    (void)sink;
+    const CpuSample *c = &record->cpu;
+    const MemorySample *m = &record->memory;
+    const IoSample *io = &record->io;
+
+    // Só os blocos lidos nesta coleta; sem nenhum, não há o que mostrar
+    if (!(record->flags & (SAMPLE_HAS_CPU | SAMPLE_HAS_MEMORY | SAMPLE_HAS_IO))) return 0;
+
+    time_t when = sample_record_time(record);
+    struct tm tm_buf;
+    struct tm *tm_info = localtime_r(&when, &tm_buf);
+    char time_str[32];
+    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
+
+    printf("┌─ [%s] ────────────────\n", time_str);
+    int blocks = 0;
+
+    if (record->flags & SAMPLE_HAS_CPU) {
+        blocks++;
+        printf("│ CPU:\n");
+        printf("│   ├─ Uso: %.2f%% (%.2f%% de %d cores)\n", c->cpu_percent_core, c->cpu_percent, c->num_cpus);
+        printf("│   ├─ User time: %llu ticks\n", c->user_time_ticks);
+        printf("│   ├─ System time: %llu ticks\n", c->system_time_ticks);
+        printf("│   ├─ Context switches: %llu (vol: %llu | invol: %llu)\n", c->context_switches,
+               c->voluntary_switches, c->nonvoluntary_switches);
+        printf("│   └─ Threads: %llu\n", c->threads);
+    }
+
+    if (record->flags & SAMPLE_HAS_MEMORY) {
+        if (blocks++) printf("│\n");
+        printf("│ MEMORIA:\n");
+        printf("│   ├─ RSS: %.2f MB\n", m->rss_bytes/(1024.0*1024.0));
+        printf("│   ├─ VSZ: %.2f MB\n", m->vsize_bytes/(1024.0*1024.0));
+        printf("│   ├─ Page faults: %llu (%.0f/s minor, %.0f/s major)\n",
+               m->page_faults, m->minor_faults_per_sec, m->major_faults_per_sec);
+        printf("│   └─ Swap: %.2f MB\n", m->swap_bytes/(1024.0*1024.0));
+    }
+
+    if (record->flags & SAMPLE_HAS_IO) {
+        if (blocks++) printf("│\n");
+        printf("│ I/O DISCO:\n");
+        printf("│   ├─ Leitura: %.2f KB/s\n", io->read_rate_bytes_per_sec/1024.0);
+        printf("│   ├─ Escrita: %.2f KB/s\n", io->write_rate_bytes_per_sec/1024.0);
+        printf("│   ├─ Syscalls: %llu\n", io->io_syscalls);
+        printf("│   └─ Ops/s: %.2f\n", io->disk_ops_per_sec);
+        printf("│\n");
+        printf("│ REDE:\n");
+        printf("│   ├─ RX: %.2f MB (%llu pacotes)\n",
+               io->rx_bytes/(1024.0*1024.0), io->rx_packets);
+        printf("│   ├─ TX: %.2f MB (%llu pacotes)\n",
+               io->tx_bytes/(1024.0*1024.0), io->tx_packets);
+        printf("│   └─ Conexoes: %llu\n", io->connections);
+    }
+    printf("└────────────────────────────────────────\n\n");
+    fflush(stdout);
+    return 0;
+}
+
+int sample_sink_console(SampleSink *sink) {
+    if (!sink) return -1;
+    memset(sink, 0, sizeof(*sink));
+    sink->name = "console";
+    sink->write = console_write;
+    return 0;
+}
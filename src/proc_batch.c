@@ -0,0 +1,549 @@
+#define _GNU_SOURCE
+#include "proc_batch.h"
+#include "proc_parse.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>) && defined(SYS_io_uring_setup)
+#include <linux/io_uring.h>
+#define PROC_BATCH_HAVE_URING 1
+#endif
+#endif
+
+/* ----------------------------- ÍNDICE ----------------------------- */
+
+static unsigned path_hash(const char *s) {
+    unsigned h = 2166136261u;  // FNV-1a
+    for (; *s; s++) h = (h ^ (unsigned char)*s) * 16777619u;
+    return h;
+}
+
+static int index_find(const ProcBatch *batch, const char *path) {
+
+    if (batch->index_slots == 0) return -1;
+
+    size_t mask = batch->index_slots - 1;
+    size_t h = path_hash(path) & mask;
+    while (batch->index[h]) {
+        unsigned i = batch->index[h] - 1;
+        if (strcmp(batch->files[i].path, path) == 0) return (int)i;
+        h = (h + 1) & mask;
+    }
+    return -1;
+}
+
+static void index_insert(ProcBatch *batch, size_t i) {
+    size_t mask = batch->index_slots - 1;
+    size_t h = path_hash(batch->files[i].path) & mask;
+    while (batch->index[h]) h = (h + 1) & mask;
+    batch->index[h] = (unsigned)i + 1;
+}
+
+// Refaz o índice com pelo menos o dobro de slots que arquivos
+static int index_rebuild(ProcBatch *batch, size_t nfiles) {
+
+    size_t slots = 64;
+    while (slots < nfiles * 2) slots *= 2;
+
+    if (slots != batch->index_slots) {
+        unsigned *grown = malloc(slots * sizeof(unsigned));
+        if (!grown) return -1;
+        free(batch->index);
+        batch->index = grown;
+        batch->index_slots = slots;
+    }
+
+    memset(batch->index, 0, batch->index_slots * sizeof(unsigned));
+    for (size_t i = 0; i < batch->count; i++) index_insert(batch, i);
+    return 0;
+}
+
+static inline char *slot_of(const ProcBatch *batch, size_t i) {
+    return batch->slots + i * PROC_BATCH_SLOT_SIZE;
+}
+
+/**
+ * Guarda o resultado de uma leitura: res >= 0 são bytes, res < 0 é -errno
+ */
+static void store_result(ProcBatch *batch, size_t i, long long res) {
+    ProcBatchFile *f = &batch->files[i];
+    if (res >= 0) {
+        slot_of(batch, i)[res] = '\0';
+        f->len = (ssize_t)res;
+        f->error = 0;
+    } else {
+        f->len = -1;
+        f->error = (int)-res;
+    }
+}
+
+/* ----------------------------- IO_URING ----------------------------- */
+
+#ifdef PROC_BATCH_HAVE_URING
+struct ProcBatchUring {
+    int fd;
+    void *sq_ptr;
+    size_t sq_size;
+    void *cq_ptr;              // == sq_ptr com IORING_FEAT_SINGLE_MMAP
+    size_t cq_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned entries;
+    int files_registered;
+    int buffers_registered;
+};
+
+static void uring_teardown(ProcBatchUring *u) {
+    if (!u) return;
+    if (u->sqes) munmap(u->sqes, u->sqes_size);
+    if (u->cq_ptr && u->cq_ptr != u->sq_ptr) munmap(u->cq_ptr, u->cq_size);
+    if (u->sq_ptr) munmap(u->sq_ptr, u->sq_size);
+    if (u->fd != -1) close(u->fd);  // cancela e espera o que estiver em voo
+    free(u);
+}
+
+static ProcBatchUring *uring_setup(unsigned entries) {
+
+    ProcBatchUring *u = calloc(1, sizeof(*u));
+    if (!u) return NULL;
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+#ifdef IORING_SETUP_COOP_TASKRUN
+    // Só este thread submete: dispensa a IPI de conclusão (5.19+)
+    p.flags = IORING_SETUP_COOP_TASKRUN;
+#endif
+    u->fd = (int)syscall(SYS_io_uring_setup, entries, &p);
+    if (u->fd == -1 && errno == EINVAL && p.flags) {
+        memset(&p, 0, sizeof(p));
+        u->fd = (int)syscall(SYS_io_uring_setup, entries, &p);
+    }
+    if (u->fd == -1) {
+        free(u);
+        return NULL;  // ENOSYS, EPERM (io_uring_disabled, seccomp)...
+    }
+
+    u->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (u->cq_size > u->sq_size) u->sq_size = u->cq_size;
+        u->cq_size = u->sq_size;
+    }
+
+    u->sq_ptr = mmap(NULL, u->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+    if (u->sq_ptr == MAP_FAILED) {
+        u->sq_ptr = NULL;
+        uring_teardown(u);
+        return NULL;
+    }
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        u->cq_ptr = u->sq_ptr;
+    } else {
+        u->cq_ptr = mmap(NULL, u->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+        if (u->cq_ptr == MAP_FAILED) {
+            u->cq_ptr = NULL;
+            uring_teardown(u);
+            return NULL;
+        }
+    }
+
+    u->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = mmap(NULL, u->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED) {
+        u->sqes = NULL;
+        uring_teardown(u);
+        return NULL;
+    }
+
+    char *sq = u->sq_ptr;
+    char *cq = u->cq_ptr;
+    u->sq_head = (unsigned *)(void *)(sq + p.sq_off.head);
+    u->sq_tail = (unsigned *)(void *)(sq + p.sq_off.tail);
+    u->sq_mask = (unsigned *)(void *)(sq + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)(void *)(sq + p.sq_off.array);
+    u->cq_head = (unsigned *)(void *)(cq + p.cq_off.head);
+    u->cq_tail = (unsigned *)(void *)(cq + p.cq_off.tail);
+    u->cq_mask = (unsigned *)(void *)(cq + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)(void *)(cq + p.cq_off.cqes);
+    u->entries = p.sq_entries;
+    return u;
+}
+
+/**
+ * Registra de novo arquivos e buffers depois que o conjunto mudou. Falha
+ * no registro não é fatal: sem arquivos fixos o sqe leva o fd, sem buffers
+ * fixos a operação vira IORING_OP_READ
+ */
+static unsigned uring_register(ProcBatch *batch) {
+
+    ProcBatchUring *u = batch->uring;
+    unsigned calls = 0;
+
+    if (u->files_registered) {
+        syscall(SYS_io_uring_register, u->fd, IORING_UNREGISTER_FILES, NULL, 0);
+        calls++;
+        u->files_registered = 0;
+    }
+    if (u->buffers_registered) {
+        syscall(SYS_io_uring_register, u->fd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+        calls++;
+        u->buffers_registered = 0;
+    }
+    if (batch->count == 0) return calls;
+
+    int *fds = malloc(batch->count * sizeof(int));
+    if (fds) {
+        for (size_t i = 0; i < batch->count; i++) fds[i] = batch->files[i].fd;
+        u->files_registered = syscall(SYS_io_uring_register, u->fd, IORING_REGISTER_FILES,
+                                      fds, (unsigned)batch->count) == 0;
+        calls++;
+        free(fds);
+    }
+
+    // Um único iovec cobre todos os slots; buf_index é sempre 0
+    struct iovec iov = { .iov_base = batch->slots, .iov_len = batch->count * PROC_BATCH_SLOT_SIZE };
+    u->buffers_registered = syscall(SYS_io_uring_register, u->fd, IORING_REGISTER_BUFFERS, &iov, 1) == 0;
+    calls++;
+    return calls;
+}
+
+// Colhe as conclusões disponíveis. Retorna quantas.
+static unsigned uring_reap(ProcBatch *batch) {
+
+    ProcBatchUring *u = batch->uring;
+    unsigned head = *u->cq_head;  // só nós consumimos
+    unsigned tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+    unsigned n = 0;
+
+    for (; head != tail; head++, n++) {
+        const struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+        store_result(batch, (size_t)cqe->user_data, cqe->res);
+    }
+    __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+    return n;
+}
+
+/**
+ * Lê o lote em blocos de até entries leituras: cada bloco é submetido e
+ * esperado (min_complete = bloco) na mesma io_uring_enter
+ * @return syscalls feitas, ou -1 se o io_uring falhou
+ */
+static long long uring_read_all(ProcBatch *batch) {
+
+    ProcBatchUring *u = batch->uring;
+    long long calls = 0;
+
+    if (batch->dirty) {
+        calls += uring_register(batch);
+        batch->dirty = 0;
+    }
+
+    for (size_t next = 0; next < batch->count;) {
+        unsigned chunk = batch->count - next < u->entries ? (unsigned)(batch->count - next) : u->entries;
+        unsigned tail = *u->sq_tail;  // só nós produzimos
+
+        for (unsigned k = 0; k < chunk; k++) {
+            size_t i = next + k;
+            unsigned idx = tail & *u->sq_mask;
+            struct io_uring_sqe *sqe = &u->sqes[idx];
+
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = u->buffers_registered ? IORING_OP_READ_FIXED : IORING_OP_READ;
+            if (u->files_registered) {
+                sqe->fd = (int)i;
+                sqe->flags = IOSQE_FIXED_FILE;
+            } else {
+                sqe->fd = batch->files[i].fd;
+            }
+            sqe->addr = (unsigned long long)(uintptr_t)slot_of(batch, i);
+            sqe->len = PROC_BATCH_SLOT_SIZE - 1;
+            sqe->off = 0;
+            sqe->user_data = i;
+            u->sq_array[idx] = idx;
+            tail++;
+        }
+        __atomic_store_n(u->sq_tail, tail, __ATOMIC_RELEASE);
+
+        unsigned done = 0;
+        while (done < chunk) {
+            unsigned pending = tail - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE);
+            int rc = (int)syscall(SYS_io_uring_enter, u->fd, pending, chunk - done, IORING_ENTER_GETEVENTS, NULL, 0);
+            calls++;
+            if (rc < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) return -1;
+            done += uring_reap(batch);
+        }
+        next += chunk;
+    }
+
+    return calls;
+}
+#else
+struct ProcBatchUring {
+    int unused;
+};
+
+static void uring_teardown(ProcBatchUring *u) {
+    free(u);
+}
+
+static long long uring_read_all(ProcBatch *batch) {
+    (void)batch;
+    return -1;
+}
+#endif
+
+/* ----------------------------- PREAD ----------------------------- */
+
+static long long pread_all(ProcBatch *batch) {
+
+    long long calls = 0;
+    for (size_t i = 0; i < batch->count; i++) {
+        ssize_t n;
+        do {
+            n = pread(batch->files[i].fd, slot_of(batch, i), PROC_BATCH_SLOT_SIZE - 1, 0);
+            calls++;
+        } while (n < 0 && errno == EINTR);
+        store_result(batch, i, n >= 0 ? (long long)n : -(long long)errno);
+    }
+    return calls;
+}
+
+/* ----------------------------- LOTE ----------------------------- */
+
+int proc_batch_init(ProcBatch *batch, ProcBatchBackend backend) {
+
+    if (!batch) {
+        fprintf(stderr, "Erro: ponteiro nulo em proc_batch_init\n");
+        return -1;
+    }
+
+    memset(batch, 0, sizeof(*batch));
+    batch->backend = PROC_BATCH_PREAD;
+    batch->learning = 1;
+
+#ifdef PROC_BATCH_HAVE_URING
+    if (backend == PROC_BATCH_URING) {
+        batch->uring = uring_setup(PROC_BATCH_RING_ENTRIES);
+        if (batch->uring) batch->backend = PROC_BATCH_URING;
+    }
+#else
+    (void)backend;
+#endif
+    return 0;
+}
+
+/**
+ * Garante espaço para mais um arquivo. Os slots vivem num mmap anônimo
+ * (alinhado em página, exigência do registro de buffers) e são copiados
+ * ao crescer, porque o crescimento pode acontecer no meio de um ciclo
+ */
+static int ensure_capacity(ProcBatch *batch) {
+
+    if (batch->count < batch->capacity) return 0;
+    if (batch->capacity >= PROC_BATCH_MAX_FILES) return -1;
+
+    size_t cap = batch->capacity ? batch->capacity * 2 : 64;
+    if (cap > PROC_BATCH_MAX_FILES) cap = PROC_BATCH_MAX_FILES;
+
+    ProcBatchFile *files = realloc(batch->files, cap * sizeof(ProcBatchFile));
+    if (!files) return -1;
+    batch->files = files;
+
+    size_t bytes = cap * PROC_BATCH_SLOT_SIZE;
+    char *slots = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (slots == MAP_FAILED) return -1;
+    if (batch->slots) {
+        memcpy(slots, batch->slots, batch->count * PROC_BATCH_SLOT_SIZE);
+        munmap(batch->slots, batch->slots_bytes);
+    }
+    batch->slots = slots;
+    batch->slots_bytes = bytes;
+    batch->capacity = cap;
+    batch->dirty = 1;  // buffers registrados apontavam para o mapeamento antigo
+    return 0;
+}
+
+int proc_batch_add(ProcBatch *batch, const char *path) {
+
+    if (!batch || !path) return -1;
+
+    int found = index_find(batch, path);
+    if (found >= 0) return found;
+
+    if (ensure_capacity(batch) < 0) return -1;
+    if ((batch->count + 1) * 2 > batch->index_slots && index_rebuild(batch, batch->count + 1) < 0) return -1;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    proc_account_read(1, 0, 0);
+    if (fd == -1) return -1;
+
+    char *copy = strdup(path);
+    if (!copy) {
+        close(fd);
+        return -1;
+    }
+
+    size_t i = batch->count++;
+    batch->files[i].path = copy;
+    batch->files[i].fd = fd;
+    batch->files[i].len = -1;
+    batch->files[i].error = 0;  // ainda não lido: o gancho deixa passar
+    index_insert(batch, i);
+    batch->dirty = 1;
+    return (int)i;
+}
+
+// Tira do lote os arquivos que falharam no ciclo anterior (processo encerrado)
+static void drop_failed(ProcBatch *batch) {
+
+    size_t kept = 0;
+    for (size_t i = 0; i < batch->count; i++) {
+        ProcBatchFile *f = &batch->files[i];
+        if (f->error != 0) {
+            close(f->fd);
+            free(f->path);
+            continue;
+        }
+        batch->files[kept++] = *f;
+    }
+
+    if (kept != batch->count) {
+        batch->count = kept;
+        index_rebuild(batch, kept);
+        batch->dirty = 1;
+    }
+}
+
+int proc_batch_read_all(ProcBatch *batch) {
+
+    if (!batch) return -1;
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &t0);
+
+    drop_failed(batch);
+
+    long long calls = -1;
+    if (batch->backend == PROC_BATCH_URING) {
+        calls = uring_read_all(batch);
+        if (calls < 0) {
+            fprintf(stderr, "Aviso: io_uring falhou (%s), usando pread\n", strerror(errno));
+            uring_teardown(batch->uring);
+            batch->uring = NULL;
+            batch->backend = PROC_BATCH_PREAD;
+        }
+    }
+    if (calls < 0) calls = pread_all(batch);
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+    long long ns = (t1.tv_sec - t0.tv_sec) * 1000000000LL + (t1.tv_nsec - t0.tv_nsec);
+    batch->last_tick_ms = ns / 1e6;
+    batch->syscalls_last_tick = (unsigned long long)calls;
+    batch->ticks++;
+
+    int ok = 0;
+    unsigned long long bytes = 0;
+    for (size_t i = 0; i < batch->count; i++) {
+        if (batch->files[i].len >= 0) {
+            ok++;
+            bytes += (unsigned long long)batch->files[i].len;
+        }
+    }
+    proc_account_read((unsigned long long)calls, bytes, (unsigned long long)ns);
+    return ok;
+}
+
+const char *proc_batch_data(const ProcBatch *batch, int idx, ssize_t *len) {
+    if (!batch || idx < 0 || (size_t)idx >= batch->count || batch->files[idx].len < 0) return NULL;
+    if (len) *len = batch->files[idx].len;
+    return slot_of(batch, (size_t)idx);
+}
+
+/**
+ * Atende proc_read_file a partir do lote. Um slot cheio pode ter sido
+ * truncado: nesse caso a leitura vai direto ao kernel, que devolve tudo
+ */
+static ssize_t batch_read_hook(void *ctx, const char *path, char *buf, size_t size) {
+
+    ProcBatch *batch = ctx;
+    int idx = batch->fresh ? index_find(batch, path) : -1;
+
+    if (idx < 0) {
+        batch->passed++;
+        if (batch->fresh && batch->learning) proc_batch_add(batch, path);
+        return PROC_READ_PASS;
+    }
+
+    const ProcBatchFile *f = &batch->files[idx];
+    if (f->len < 0 && f->error == 0) {  // entrou no lote durante este ciclo
+        batch->passed++;
+        return PROC_READ_PASS;
+    }
+    if (f->len >= PROC_BATCH_SLOT_SIZE - 1) {
+        batch->passed++;
+        return PROC_READ_PASS;
+    }
+
+    batch->served++;
+    if (f->len < 0) {
+        errno = f->error;
+        return -1;
+    }
+
+    size_t n = (size_t)f->len < size - 1 ? (size_t)f->len : size - 1;
+    memcpy(buf, slot_of(batch, (size_t)idx), n);
+    buf[n] = '\0';
+    return (ssize_t)n;
+}
+
+int proc_batch_begin_tick(ProcBatch *batch) {
+
+    if (!batch) return -1;
+
+    int rc = proc_batch_read_all(batch);
+    batch->fresh = 1;
+    proc_set_read_hook(batch_read_hook, batch);
+    return rc;
+}
+
+void proc_batch_end_tick(ProcBatch *batch) {
+    if (!batch) return;
+    batch->fresh = 0;
+    proc_set_read_hook(NULL, NULL);
+}
+
+const char *proc_batch_backend_name(const ProcBatch *batch) {
+    if (!batch) return "?";
+    return batch->backend == PROC_BATCH_URING ? "io_uring" : "pread";
+}
+
+void proc_batch_free(ProcBatch *batch) {
+
+    if (!batch) return;
+    if (batch->fresh) proc_batch_end_tick(batch);
+
+    for (size_t i = 0; i < batch->count; i++) {
+        close(batch->files[i].fd);
+        free(batch->files[i].path);
+    }
+    uring_teardown(batch->uring);
+    if (batch->slots) munmap(batch->slots, batch->slots_bytes);
+    free(batch->files);
+    free(batch->index);
+    memset(batch, 0, sizeof(*batch));
+}
@@ -0,0 +1,556 @@
+#define _GNU_SOURCE
+#include "proc_parse.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// SWAR depende de carregar 8 bytes em little-endian (x86, ARM comum)
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PROC_PARSE_SWAR 1
+#endif
+
+static const unsigned long long pow10_table[9] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL,
+    100000ULL, 1000000ULL, 10000000ULL, 100000000ULL
+};
+
+static inline int is_digit(char c) {
+    return (unsigned char)(c - '0') < 10;
+}
+
+static inline int is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+/* ----------------------------- RAÍZES ----------------------------- */
+
+static char proc_root_buf[PROC_ROOT_MAX] = "/proc";
+static char sys_root_buf[PROC_ROOT_MAX] = "/sys";
+
+static int set_root(char *dst, const char *root) {
+
+    size_t len = strlen(root);
+    while (len > 1 && root[len - 1] == '/') len--;  // "dir/" e "dir" montam o mesmo caminho
+
+    if (len == 0 || len >= PROC_ROOT_MAX) {
+        fprintf(stderr, "Erro: raiz invalida: %s\n", root);
+        return -1;
+    }
+    memcpy(dst, root, len);
+    dst[len] = '\0';
+    return 0;
+}
+
+int proc_set_roots(const char *proc_root, const char *sys_root) {
+    if (proc_root && set_root(proc_root_buf, proc_root) != 0) return -1;
+    if (sys_root && set_root(sys_root_buf, sys_root) != 0) return -1;
+    return 0;
+}
+
+const char *proc_root(void) {
+    return proc_root_buf;
+}
+
+const char *sys_root(void) {
+    return sys_root_buf;
+}
+
+int proc_root_is_live(void) {
+    return strcmp(proc_root_buf, "/proc") == 0;
+}
+
+const char *proc_path(char *buf, size_t size, const char *rel) {
+    snprintf(buf, size, "%s/%s", proc_root_buf, rel);
+    return buf;
+}
+
+const char *sys_path(char *buf, size_t size, const char *rel) {
+    snprintf(buf, size, "%s/%s", sys_root_buf, rel);
+    return buf;
+}
+
+/* ----------------------------- LEITURA ----------------------------- */
+
+static ProcReadHook read_hook = NULL;
+static void *read_hook_ctx = NULL;
+static ProcReadTap read_tap = NULL;
+static void *read_tap_ctx = NULL;
+static ProcReadSource read_source = NULL;
+static void *read_source_ctx = NULL;
+static ProcReadStats read_stats;
+
+void proc_set_read_hook(ProcReadHook hook, void *ctx) {
+    read_hook = hook;
+    read_hook_ctx = ctx;
+}
+
+void proc_set_read_tap(ProcReadTap tap, void *ctx) {
+    read_tap = tap;
+    read_tap_ctx = ctx;
+}
+
+void proc_set_read_source(ProcReadSource source, void *ctx) {
+    read_source = source;
+    read_source_ctx = ctx;
+}
+
+void proc_read_stats(ProcReadStats *out) {
+    if (out) *out = read_stats;
+}
+
+unsigned long long proc_read_syscalls(void) {
+    return read_stats.syscalls;
+}
+
+void proc_account_read(unsigned long long syscalls, unsigned long long bytes, unsigned long long ns) {
+    read_stats.syscalls += syscalls;
+    read_stats.bytes += bytes;
+    read_stats.ns += ns;
+}
+
+static inline unsigned long long raw_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+// Leitura servida pela fonte: copia o que couber, como uma leitura truncada do kernel
+static ssize_t read_from_source(const char *path, char *buf, size_t size) {
+    const char *data = NULL;
+    ssize_t len = read_source(read_source_ctx, path, &data);
+    if (len < 0) return -1;
+    if ((size_t)len > size - 1) len = (ssize_t)(size - 1);
+    memcpy(buf, data, (size_t)len);
+    buf[len] = '\0';
+    return len;
+}
+
+ssize_t proc_read_file(const char *path, char *buf, size_t size) {
+
+    if (!buf || size == 0) return -1;
+    if (read_source) return read_from_source(path, buf, size);
+
+    if (read_hook) {
+        ssize_t served = read_hook(read_hook_ctx, path, buf, size);
+        if (served != PROC_READ_PASS) {
+            if (read_tap) read_tap(read_tap_ctx, path, buf, served);
+            return served;
+        }
+    }
+
+    unsigned long long t0 = raw_ns();
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    read_stats.syscalls++;
+    if (fd == -1) {
+        read_stats.ns += raw_ns() - t0;
+        if (read_tap) read_tap(read_tap_ctx, path, NULL, -1);
+        return -1;
+    }
+
+    size_t total = 0;
+    ssize_t rc = 0;
+    while (total < size - 1) {
+        ssize_t n = read(fd, buf + total, size - 1 - total);
+        read_stats.syscalls++;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            rc = -1;
+            break;
+        }
+        if (n == 0) break;  // EOF
+        total += (size_t)n;
+    }
+    close(fd);
+    read_stats.syscalls++;
+    read_stats.bytes += total;
+    read_stats.ns += raw_ns() - t0;
+    if (rc < 0) {
+        if (read_tap) read_tap(read_tap_ctx, path, NULL, -1);
+        return -1;
+    }
+
+    buf[total] = '\0';
+    if (read_tap) read_tap(read_tap_ctx, path, buf, (ssize_t)total);
+    return (ssize_t)total;
+}
+
+ssize_t proc_read_file_dyn(const char *path, char **buf, size_t *capacity) {
+
+    if (!buf || !capacity) return -1;
+
+    if (read_source) {
+        const char *data = NULL;
+        ssize_t len = read_source(read_source_ctx, path, &data);
+        if (len < 0) return -1;
+        if (*capacity < (size_t)len + 1) {
+            char *grown = realloc(*buf, (size_t)len + 1);
+            if (!grown) return -1;
+            *buf = grown;
+            *capacity = (size_t)len + 1;
+        }
+        memcpy(*buf, data, (size_t)len);
+        (*buf)[len] = '\0';
+        return len;
+    }
+
+    unsigned long long t0 = raw_ns();
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    read_stats.syscalls++;
+    if (fd == -1) {
+        read_stats.ns += raw_ns() - t0;
+        if (read_tap) read_tap(read_tap_ctx, path, NULL, -1);
+        return -1;
+    }
+
+    size_t total = 0;
+    ssize_t rc = 0;
+    for (;;) {
+        // Garante pelo menos 4 KB livres (uma página do seq_file) + '\0'
+        if (*capacity - total < 4096 + 1) {
+            size_t cap = *capacity ? *capacity * 2 : 65536;
+            char *grown = realloc(*buf, cap);
+            if (!grown) {
+                rc = -1;
+                break;
+            }
+            *buf = grown;
+            *capacity = cap;
+        }
+
+        ssize_t n = read(fd, *buf + total, *capacity - total - 1);
+        read_stats.syscalls++;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            rc = -1;
+            break;
+        }
+        if (n == 0) break;  // EOF
+        total += (size_t)n;
+    }
+    close(fd);
+    read_stats.syscalls++;
+    read_stats.bytes += total;
+    read_stats.ns += raw_ns() - t0;
+    if (rc < 0) {
+        if (read_tap) read_tap(read_tap_ctx, path, NULL, -1);
+        return -1;
+    }
+
+    (*buf)[total] = '\0';
+    if (read_tap) read_tap(read_tap_ctx, path, *buf, (ssize_t)total);
+    return (ssize_t)total;
+}
+
+ssize_t proc_read_file_chunked(const char *path, char *buf, size_t size, ProcChunkFn chunk, void *ctx) {
+
+    if (!buf || size < 2 || !chunk) return -1;
+
+    if (read_source) {
+        const char *data = NULL;
+        ssize_t len = read_source(read_source_ctx, path, &data);
+        if (len < 0) return -1;
+        chunk(ctx, data, (size_t)len);
+        return len;
+    }
+
+    if (read_hook) {
+        ssize_t served = read_hook(read_hook_ctx, path, buf, size);
+        if (served != PROC_READ_PASS) {
+            if (read_tap) read_tap(read_tap_ctx, path, buf, served);
+            if (served > 0) chunk(ctx, buf, (size_t)served);
+            return served;
+        }
+    }
+
+    if (read_tap) {
+        static char *whole = NULL;   // reaproveitado entre gravações
+        static size_t whole_capacity = 0;
+        ssize_t len = proc_read_file_dyn(path, &whole, &whole_capacity);
+        if (len > 0) chunk(ctx, whole, (size_t)len);
+        return len;
+    }
+
+    unsigned long long t0 = raw_ns();
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    read_stats.syscalls++;
+    read_stats.ns += raw_ns() - t0;
+    if (fd == -1) return -1;
+
+    size_t used = 0;
+    size_t total = 0;
+    ssize_t rc = 0;
+    for (;;) {
+        // O tempo do parser em chunk fica fora da contabilidade
+        t0 = raw_ns();
+        ssize_t n = read(fd, buf + used, size - 1 - used);
+        read_stats.syscalls++;
+        read_stats.ns += raw_ns() - t0;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            rc = -1;
+            break;
+        }
+        if (n == 0) break;  // EOF
+        read_stats.bytes += (size_t)n;
+        total += (size_t)n;
+        used += (size_t)n;
+
+        // Guarda a linha incompleta para a próxima leitura
+        size_t done = chunk(ctx, buf, used);
+        used -= done;
+        memmove(buf, buf + done, used);
+        if (used == size - 1) break;  // linha maior que o buffer: formato inesperado
+    }
+    t0 = raw_ns();
+    close(fd);
+    read_stats.syscalls++;
+    read_stats.ns += raw_ns() - t0;
+
+    return rc < 0 ? -1 : (ssize_t)total;
+}
+
+/* ------------------------------ SWAR ------------------------------ */
+
+#ifdef PROC_PARSE_SWAR
+/**
+ * Quantos dos 8 bytes iniciais (em ordem de memória) são dígitos ASCII
+ *
+ * Um byte é dígito se o nibble alto é 3 e o nibble baixo é <= 9.
+ * Nenhuma das somas abaixo gera carry entre bytes.
+ */
+static inline int swar_leading_digits(uint64_t v) {
+    uint64_t hi = (v & 0xF0F0F0F0F0F0F0F0ULL) ^ 0x3030303030303030ULL;
+    uint64_t lo = ((v & 0x0F0F0F0F0F0F0F0FULL) + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL;
+    uint64_t bad = hi | lo;  // byte != 0 => não é dígito
+    uint64_t mask = (((bad & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | bad) & 0x8080808080808080ULL;
+    return mask ? __builtin_ctzll(mask) >> 3 : 8;
+}
+
+/**
+ * Converte os n (1..8) primeiros dígitos de v de uma vez
+ *
+ * Os dígitos válidos são alinhados no topo da palavra (os bytes zerados
+ * embaixo viram zeros à esquerda) e combinados em pares, quartetos e
+ * depois o número de 8 dígitos com três multiplicações.
+ */
+static inline uint64_t swar_convert(uint64_t v, int n) {
+    v &= 0x0F0F0F0F0F0F0F0FULL;
+    v <<= 8 * (8 - n);
+    v = (v * 10) + (v >> 8);
+    v = (((v & 0x000000FF000000FFULL) * 0x000F424000000064ULL) +
+         (((v >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >> 32;
+    return v;
+}
+#endif
+
+/* ----------------------------- CAMPOS ----------------------------- */
+
+const char *proc_parse_u64(const char *p, const char *end, unsigned long long *out) {
+
+    while (p < end && is_blank(*p)) p++;
+
+    const char *start = p;
+    unsigned long long acc = 0;
+
+#ifdef PROC_PARSE_SWAR
+    while (end - p >= 8) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        int n = swar_leading_digits(v);
+        if (n == 0) break;
+        acc = acc * pow10_table[n] + swar_convert(v, n);
+        p += n;
+        if (n < 8) goto done;
+    }
+#endif
+
+    while (p < end && is_digit(*p)) {
+        acc = acc * 10 + (unsigned long long)(*p - '0');
+        p++;
+    }
+
+#ifdef PROC_PARSE_SWAR
+done:
+#endif
+    if (p == start) return NULL;
+    *out = acc;
+    return p;
+}
+
+const char *proc_parse_i64(const char *p, const char *end, long long *out) {
+
+    while (p < end && is_blank(*p)) p++;
+
+    int negative = 0;
+    if (p < end && *p == '-') {
+        negative = 1;
+        p++;
+    }
+
+    unsigned long long value = 0;
+    p = proc_parse_u64(p, end, &value);
+    if (!p) return NULL;
+
+    *out = negative ? -(long long)value : (long long)value;
+    return p;
+}
+
+const char *proc_parse_hex(const char *p, const char *end, unsigned long long *out) {
+
+    while (p < end && is_blank(*p)) p++;
+
+    const char *start = p;
+    unsigned long long acc = 0;
+
+    while (p < end) {
+        unsigned c = (unsigned char)*p;
+        unsigned d;
+        if (c - '0' < 10u) d = c - '0';
+        else if ((c | 0x20u) - 'a' < 6u) d = (c | 0x20u) - 'a' + 10;
+        else break;
+        acc = (acc << 4) | d;
+        p++;
+    }
+
+    if (p == start) return NULL;
+    *out = acc;
+    return p;
+}
+
+/**
+ * Um campo começa em todo byte que não é separador e vem depois de um
+ * separador (ou do início). Com SSE2, 16 bytes são classificados por vez:
+ * a máscara de inícios é contada com popcount e, quando o campo procurado
+ * está no bloco, os bits anteriores são descartados até sobrar o certo.
+ */
+const char *proc_skip_fields(const char *p, const char *end, int n) {
+
+    if (!p || n < 0) return NULL;
+
+    int remaining = n + 1;
+    unsigned prev_sep = 1;
+
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(const void *)p);
+        unsigned seps = (unsigned)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newline)));
+        unsigned starts = ~seps & ((seps << 1) | prev_sep) & 0xFFFFu;
+        int count = __builtin_popcount(starts);
+
+        if (count >= remaining) {
+            while (--remaining > 0) starts &= starts - 1;  // descarta os anteriores
+            return p + __builtin_ctz(starts);
+        }
+
+        remaining -= count;
+        prev_sep = (seps >> 15) & 1u;
+        p += 16;
+    }
+#endif
+
+    for (; p < end; p++) {
+        unsigned sep = (*p == ' ' || *p == '\n');
+        if (!sep && prev_sep && --remaining == 0) return p;
+        prev_sep = sep;
+    }
+
+    return NULL;
+}
+
+const char *proc_next_line(const char *p, const char *end) {
+    const char *nl = memchr(p, '\n', (size_t)(end - p));
+    return nl ? nl + 1 : end;
+}
+
+/* ------------------------ CHAVE: VALOR ------------------------ */
+
+static inline unsigned key_hash(const char *key, size_t len) {
+    return ((unsigned)len * 31u + (unsigned char)key[0] * 7u +
+            (unsigned char)key[len - 1]) & (PROC_KEY_TABLE_SLOTS - 1);
+}
+
+int proc_key_table_init(ProcKeyTable *table, const char *const *keys, int nkeys) {
+
+    if (!table || !keys || nkeys <= 0 || nkeys > PROC_KEY_TABLE_SLOTS / 2) return -1;
+
+    memset(table, 0, sizeof(*table));
+
+    for (int i = 0; i < nkeys; i++) {
+        size_t len = strlen(keys[i]);
+        if (len == 0 || len > 255) return -1;
+
+        // endereçamento aberto com sondagem linear
+        unsigned h = key_hash(keys[i], len);
+        while (table->slots[h].key) {
+            h = (h + 1) & (PROC_KEY_TABLE_SLOTS - 1);
+        }
+        table->slots[h].key = keys[i];
+        table->slots[h].len = (unsigned char)len;
+        table->slots[h].index = i;
+    }
+
+    table->nkeys = nkeys;
+    return 0;
+}
+
+static inline int key_lookup(const ProcKeyTable *table, const char *key, size_t len) {
+    unsigned h = key_hash(key, len);
+    while (table->slots[h].key) {
+        const ProcKeySlot *s = &table->slots[h];
+        if (s->len == len && memcmp(s->key, key, len) == 0) return s->index;
+        h = (h + 1) & (PROC_KEY_TABLE_SLOTS - 1);
+    }
+    return -1;
+}
+
+int proc_parse_kv(const char *buf, size_t len, const ProcKeyTable *table, unsigned long long *values) {
+
+    if (!buf || !table || !values) return 0;
+
+    const char *p = buf;
+    const char *end = buf + len;
+    int found = 0;
+
+    while (p < end && found < table->nkeys) {
+        const char *line_end = memchr(p, '\n', (size_t)(end - p));
+        if (!line_end) line_end = end;
+
+        // a chave termina no ':' ou no primeiro espaço
+        const char *k = p;
+        while (k < line_end && *k != ':' && !is_blank(*k)) k++;
+
+        if (k > p && k < line_end) {
+            int idx = key_lookup(table, p, (size_t)(k - p));
+            if (idx >= 0) {
+                // separador: ':' colado, espaços, ou espaços + ':' (/proc/<pid>/sched)
+                const char *sep = k;
+                while (sep < line_end && is_blank(*sep)) sep++;
+                if (sep < line_end && *sep == ':') sep++;
+
+                unsigned long long v;
+                if (proc_parse_u64(sep, line_end, &v)) {
+                    values[idx] = v;
+                    found++;
+                }
+            }
+        }
+
+        p = line_end + 1;
+    }
+
+    return found;
+}
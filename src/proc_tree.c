@@ -0,0 +1,559 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "proc_parse.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Árvore de processos monitorada como uma unidade.
+ *
+ * A raiz e os descendentes existentes são achados com uma varredura de
+ * /proc no init; daí em diante os eventos fork/exit do proc connector
+ * (netlink) mantêm a lista, sem varrer /proc a cada amostra. Sem
+ * CAP_NET_ADMIN o connector não abre e a varredura é refeita a cada
+ * amostra.
+ *
+ * A CPU de filhos que terminam entre duas amostras aparece no cutime/cstime
+ * de quem os recolheu (wait). Desse aumento desconta-se o que já tinha sido
+ * contado enquanto o filho era membro; o resto é o trecho final do filho,
+ * ou um filho inteiro que nasceu e morreu sem ser lido.
+ *
+ * Um membro é o par pid + starttime: se o pid volta com outro starttime
+ * (reaproveitado entre duas amostras), a encarnação antiga sai da árvore
+ * e os ticks acumulados do processo novo não viram delta.
+ */
+
+typedef struct {
+    int ok;
+    char comm[THREAD_COMM_LEN];
+    pid_t ppid;
+    unsigned long long own;
+    unsigned long long child;
+    unsigned long long threads;
+    unsigned long long starttime;
+    unsigned long long rss_pages;
+} StatRead;
+
+static double timespec_diff_sec(struct timespec a, struct timespec b) {
+    return (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+static int read_stat(pid_t pid, StatRead *out) {
+
+    char path[PROC_PATH_MAX];
+    char buf[1024];
+    snprintf(path, sizeof(path), "%s/%d/stat", proc_root(), (int)pid);
+
+    memset(out, 0, sizeof(*out));
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
+    if (len <= 0) return -1;
+
+    const char *open_paren = strchr(buf, '(');
+    const char *close_paren = strrchr(buf, ')');
+    if (!open_paren || !close_paren || close_paren < open_paren) return -1;
+
+    size_t comm_len = (size_t)(close_paren - open_paren - 1);
+    if (comm_len >= THREAD_COMM_LEN) comm_len = THREAD_COMM_LEN - 1;
+    memcpy(out->comm, open_paren + 1, comm_len);
+    out->comm[comm_len] = '\0';
+
+    // Após o ')': state ppid ... utime(12) stime(13) cutime(14) cstime(15) ... num_threads(18) ... starttime(20) ... rss(22)
+    const char *end = buf + len;
+    unsigned long long ppid = 0, utime = 0, stime = 0, cutime = 0, cstime = 0;
+    const char *p = proc_skip_fields(close_paren + 1, end, 1);
+    if (p) p = proc_parse_u64(p, end, &ppid);
+    if (p) p = proc_skip_fields(p, end, 9);
+    if (p) p = proc_parse_u64(p, end, &utime);
+    if (p) p = proc_parse_u64(p, end, &stime);
+    if (p) p = proc_parse_u64(p, end, &cutime);
+    if (p) p = proc_parse_u64(p, end, &cstime);
+    if (p) p = proc_skip_fields(p, end, 2);
+    if (p) p = proc_parse_u64(p, end, &out->threads);
+    if (p) p = proc_skip_fields(p, end, 1);
+    if (p) p = proc_parse_u64(p, end, &out->starttime);
+    if (p) p = proc_skip_fields(p, end, 1);
+    if (p) p = proc_parse_u64(p, end, &out->rss_pages);
+    if (!p) return -1;
+
+    out->ppid = (pid_t)ppid;
+    out->own = utime + stime;
+    out->child = cutime + cstime;
+    out->ok = 1;
+    return 0;
+}
+
+static ProcTreeMember *find_member(ProcTreeState *state, pid_t pid) {
+    for (int i = 0; i < state->nmembers; i++) {
+        if (state->members[i].pid == pid) return &state->members[i];
+    }
+    return NULL;
+}
+
+// Acrescenta sem procurar antes: o chamador garante que pid ainda não é membro
+static ProcTreeMember *append_member(ProcTreeState *state, pid_t pid, pid_t ppid, int fresh) {
+
+    ProcTreeMember *m;
+    if (state->nmembers == state->capacity) {
+        int cap = state->capacity ? state->capacity * 2 : 32;
+        ProcTreeMember *members = realloc(state->members, (size_t)cap * sizeof(*members));
+        if (!members) return NULL;
+        state->members = members;
+        state->capacity = cap;
+    }
+
+    m = &state->members[state->nmembers++];
+    memset(m, 0, sizeof(*m));
+    m->pid = pid;
+    m->ppid = ppid;
+    m->fresh = fresh;
+    if (fresh) state->forks++;
+    return m;
+}
+
+static ProcTreeMember *add_member(ProcTreeState *state, pid_t pid, pid_t ppid, int fresh) {
+    ProcTreeMember *m = find_member(state, pid);
+    return m ? m : append_member(state, pid, ppid, fresh);
+}
+
+// A encarnação do membro terminou: o pai desconta o que já foi contado dela quando a recolher
+static void retire_member(ProcTreeState *state, const ProcTreeMember *gone) {
+    ProcTreeMember *parent = find_member(state, gone->ppid);
+    if (parent && parent != gone) parent->reaped_seen += gone->own_ticks + gone->child_ticks;
+    state->exits++;
+}
+
+static int cmp_pid(const void *a, const void *b) {
+    pid_t x = *(const pid_t *)a, y = *(const pid_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Ordena os pares {pid, ppid} pelo pai
+static int cmp_pair_ppid(const void *a, const void *b) {
+    pid_t x = ((const pid_t *)a)[1], y = ((const pid_t *)b)[1];
+    return (x > y) - (x < y);
+}
+
+// Primeiro par cujo pai é ppid (pares ordenados por pai), ou count se não há
+static size_t first_child(pid_t (*pairs)[2], size_t count, pid_t ppid) {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (pairs[mid][1] < ppid) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * Varre /proc e adiciona todo descendente da raiz que ainda não é membro
+ */
+static int scan_descendants(ProcTreeState *state, int fresh) {
+
+    DIR *dir = opendir(proc_root());
+    if (!dir) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", proc_root());
+        return -1;
+    }
+
+    size_t count = 0, capacity = 1024;
+    pid_t (*pairs)[2] = malloc(capacity * sizeof(*pairs));  // {pid, ppid}
+    if (!pairs) {
+        closedir(dir);
+        return -1;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        pid_t pid = (pid_t)atoi(entry->d_name);
+
+        StatRead st;
+        if (read_stat(pid, &st) < 0) continue;
+
+        if (count == capacity) {
+            capacity *= 2;
+            pid_t (*grown)[2] = realloc(pairs, capacity * sizeof(*pairs));
+            if (!grown) break;
+            pairs = grown;
+        }
+        pairs[count][0] = pid;
+        pairs[count][1] = st.ppid;
+        count++;
+    }
+    closedir(dir);
+
+    // Fecho transitivo em largura a partir dos membros atuais: com os pares
+    // ordenados por pai, os filhos de cada membro são uma faixa contígua.
+    // O(n log n); com 100 mil processos a versão que repassava a lista
+    // inteira até estabilizar era quadrática.
+    qsort(pairs, count, sizeof(*pairs), cmp_pair_ppid);
+
+    int known = state->nmembers;
+    pid_t *members = malloc((size_t)(known ? known : 1) * sizeof(*members));
+    if (!members) {
+        free(pairs);
+        return -1;
+    }
+    for (int i = 0; i < known; i++) members[i] = state->members[i].pid;
+    qsort(members, (size_t)known, sizeof(*members), cmp_pid);
+
+    // Cada pid tem um só pai: entra na fila no máximo uma vez
+    for (int head = 0; head < state->nmembers; head++) {
+        pid_t parent = state->members[head].pid;
+        for (size_t i = first_child(pairs, count, parent); i < count && pairs[i][1] == parent; i++) {
+            pid_t pid = pairs[i][0];
+            if (pid == parent || bsearch(&pid, members, (size_t)known, sizeof(*members), cmp_pid)) continue;
+            if (!append_member(state, pid, parent, fresh)) break;
+        }
+    }
+
+    free(members);
+    free(pairs);
+    return 0;
+}
+
+/**
+ * Assina os eventos de processo do proc connector
+ * @return fd do socket, ou -1 se indisponível (sem permissão, kernel sem CONFIG_PROC_EVENTS)
+ */
+static int open_proc_connector(void) {
+
+    int fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (fd == -1) return -1;
+
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = CN_IDX_PROC;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    // nlmsghdr + cn_msg + operação
+    char msg[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))];
+    memset(msg, 0, sizeof(msg));
+    struct nlmsghdr *nlh = (struct nlmsghdr *)(void *)msg;
+    nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+    nlh->nlmsg_type = NLMSG_DONE;
+    nlh->nlmsg_pid = (unsigned)getpid();
+
+    struct cn_msg *cn = NLMSG_DATA(nlh);
+    cn->id.idx = CN_IDX_PROC;
+    cn->id.val = CN_VAL_PROC;
+    cn->len = sizeof(enum proc_cn_mcast_op);
+    enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+    memcpy(cn->data, &op, sizeof(op));
+
+    if (send(fd, msg, nlh->nlmsg_len, 0) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Consome os eventos pendentes do connector
+ * @return 0 em sucesso, -1 se eventos foram perdidos (fila cheia)
+ */
+static int drain_events(ProcTreeState *state) {
+
+    char buf[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+
+    for (;;) {
+        ssize_t len = recv(state->nl_fd, buf, sizeof(buf), 0);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            return -1;  // ENOBUFS: o kernel descartou eventos
+        }
+
+        for (struct nlmsghdr *nlh = (struct nlmsghdr *)(void *)buf; NLMSG_OK(nlh, (unsigned)len);
+             nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type == NLMSG_ERROR || nlh->nlmsg_type == NLMSG_NOOP) continue;
+
+            const struct cn_msg *cn = NLMSG_DATA(nlh);
+            if (cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC) continue;
+            const struct proc_event *ev = (const struct proc_event *)(const void *)cn->data;
+
+            if (ev->what == PROC_EVENT_FORK) {
+                // Threads também geram fork; só interessa processo novo (pid == tgid)
+                const struct fork_proc_event *f = &ev->event_data.fork;
+                if (f->child_pid != f->child_tgid) continue;
+                if (!find_member(state, f->parent_tgid)) continue;
+                // pid ainda na lista: é de um membro que terminou e foi recolhido, e o pid voltou
+                ProcTreeMember *old = find_member(state, f->child_tgid);
+                if (old) {
+                    retire_member(state, old);
+                    memset(old, 0, sizeof(*old));
+                    old->pid = f->child_tgid;
+                    old->ppid = f->parent_tgid;
+                    old->fresh = 1;
+                    state->forks++;
+                } else {
+                    append_member(state, f->child_tgid, f->parent_tgid, 1);
+                }
+            } else if (ev->what == PROC_EVENT_EXIT) {
+                const struct exit_proc_event *e = &ev->event_data.exit;
+                if (e->process_pid != e->process_tgid) continue;
+                ProcTreeMember *m = find_member(state, e->process_tgid);
+                if (m) m->exited = 1;
+            } else if (ev->what == PROC_EVENT_EXEC) {
+                // exec vindo de um thread que não é o líder: o kernel pode ter
+                // avisado a saída do líder antigo, mas o processo (pid e
+                // starttime) continua. O comm novo vem na próxima leitura.
+                ProcTreeMember *m = find_member(state, ev->event_data.exec.process_tgid);
+                if (m) m->exited = 0;
+            }
+        }
+    }
+}
+
+/**
+ * Inicializa o monitor de árvore: assina o proc connector e acha os
+ * descendentes atuais da raiz
+ * @param state Estado a inicializar
+ * @param root PID raiz da árvore
+ * @return 0 em sucesso, -1 em erro
+ */
+int proc_tree_init(ProcTreeState *state, pid_t root) {
+
+    if (!state) {
+        fprintf(stderr, "Erro: ponteiro nulo em proc_tree_init\n");
+        return -1;
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->nl_fd = -1;
+    state->root = root;
+    state->ticks_per_sec = sysconf(_SC_CLK_TCK);
+    if (state->ticks_per_sec <= 0) state->ticks_per_sec = 100;
+    state->page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    if (state->page_kb <= 0) state->page_kb = 4;
+
+    StatRead st;
+    if (read_stat(root, &st) < 0) {
+        fprintf(stderr, "Erro: processo %d nao encontrado\n", (int)root);
+        return -1;
+    }
+
+    // Assina antes de varrer: um fork durante a varredura chega como evento.
+    // Numa árvore sintética os eventos do kernel não valem: só varredura.
+    if (proc_root_is_live()) state->nl_fd = open_proc_connector();
+
+    add_member(state, root, st.ppid, 0);
+    if (scan_descendants(state, 0) < 0) {
+        proc_tree_free(state);
+        return -1;
+    }
+
+    // Linha de base: o acumulado anterior ao init não entra nas taxas
+    for (int i = 0; i < state->nmembers; i++) {
+        ProcTreeMember *m = &state->members[i];
+        if (read_stat(m->pid, &st) == 0) {
+            m->own_ticks = st.own;
+            m->child_ticks = st.child;
+            m->starttime = st.starttime;
+            memcpy(m->comm, st.comm, sizeof(m->comm));
+        }
+        m->fresh = 0;
+    }
+    state->forks = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &state->last_ts);
+    return 0;
+}
+
+/**
+ * Atualiza a árvore e calcula CPU por membro e o total
+ * @return 0 em sucesso, -1 se a raiz terminou ou em erro
+ */
+int proc_tree_sample(ProcTreeState *state, ProcTreeSample *sample) {
+
+    if (!state || !sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em proc_tree_sample\n");
+        return -1;
+    }
+
+    // 1. Entradas: eventos do connector ou, sem ele, nova varredura
+    if (state->nl_fd == -1 || drain_events(state) < 0) scan_descendants(state, 1);
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = timespec_diff_sec(state->last_ts, now);
+    if (elapsed <= 0) elapsed = 1e-9;
+    state->last_ts = now;
+    double ticks_to_percent = 100.0 / ((double)state->ticks_per_sec * elapsed);
+
+    // 2. Lê todos; quem não tem mais /proc/<pid> foi recolhido pelo pai
+    StatRead *reads = calloc((size_t)(state->nmembers ? state->nmembers : 1), sizeof(*reads));
+    if (!reads) return -1;
+    for (int i = 0; i < state->nmembers; i++) read_stat(state->members[i].pid, &reads[i]);
+
+    for (int i = 0; i < state->nmembers; i++) {
+        const ProcTreeMember *m = &state->members[i];
+        StatRead *st = &reads[i];
+        /*
+         * O pid ainda existe, mas não é mais o membro: starttime diferente
+         * (reaproveitado) ou saída avisada antes da primeira leitura (sem
+         * starttime para comparar). Saída avisada com o mesmo starttime é
+         * um zumbi à espera do wait: continua até ser recolhido.
+         */
+        if (st->ok && (m->starttime ? st->starttime != m->starttime : m->exited)) st->ok = 0;
+        // O pai recebe em cutime/cstime o total do filho: o que já contamos sai do delta dele
+        if (!st->ok) retire_member(state, m);
+    }
+
+    // 3. Deltas dos vivos e compactação
+    ProcTreeMemberSample *rows = realloc(state->rows, (size_t)(state->nmembers ? state->nmembers : 1) * sizeof(*rows));
+    if (!rows) {
+        free(reads);
+        return -1;
+    }
+    state->rows = rows;
+
+    memset(sample, 0, sizeof(*sample));
+    sample->root = state->root;
+    sample->timestamp = time(NULL);
+    sample->using_netlink = state->nl_fd != -1;
+
+    int root_alive = 0;
+    int kept = 0;
+    for (int i = 0; i < state->nmembers; i++) {
+        ProcTreeMember m = state->members[i];
+        const StatRead *st = &reads[i];
+
+        if (!st->ok) continue;  // contado em retire_member
+
+        unsigned long long own_prev = m.fresh ? 0 : m.own_ticks;
+        unsigned long long own_delta = st->own >= own_prev ? st->own - own_prev : 0;
+
+        // Filho recém-nascido começa com cutime zerado
+        unsigned long long child_prev = m.fresh ? 0 : m.child_ticks;
+        unsigned long long child_delta = st->child >= child_prev ? st->child - child_prev : 0;
+        child_delta = child_delta > m.reaped_seen ? child_delta - m.reaped_seen : 0;
+
+        ProcTreeMemberSample *row = &rows[kept];
+        row->pid = m.pid;
+        row->ppid = st->ppid;
+        memcpy(row->comm, st->comm, sizeof(row->comm));
+        row->cpu_percent = (double)own_delta * ticks_to_percent;
+        row->exited_children_cpu_percent = (double)child_delta * ticks_to_percent;
+        row->rss_kb = st->rss_pages * (unsigned long long)state->page_kb;
+        row->threads = st->threads;
+
+        sample->cpu_percent += row->cpu_percent + row->exited_children_cpu_percent;
+        sample->exited_cpu_percent += row->exited_children_cpu_percent;
+        sample->rss_kb += row->rss_kb;
+        sample->threads += row->threads;
+        if (m.pid == state->root) root_alive = 1;
+
+        m.ppid = st->ppid;  // órfãos são adotados por outro processo
+        m.own_ticks = st->own;
+        m.child_ticks = st->child;
+        m.reaped_seen = 0;
+        m.starttime = st->starttime;
+        m.fresh = 0;
+        memcpy(m.comm, st->comm, sizeof(m.comm));
+        state->members[kept++] = m;
+    }
+    state->nmembers = kept;
+    free(reads);
+
+    sample->members = kept;
+    sample->forks = state->forks;
+    sample->exits = state->exits;
+    sample->rows = rows;
+    sample->nrows = kept;
+    state->forks = 0;
+    state->exits = 0;
+
+    return root_alive ? 0 : -1;
+}
+
+void proc_tree_free(ProcTreeState *state) {
+    if (!state) return;
+    if (state->nl_fd != -1) close(state->nl_fd);
+    state->nl_fd = -1;
+    free(state->members);
+    free(state->rows);
+    state->members = NULL;
+    state->rows = NULL;
+    state->nmembers = 0;
+    state->capacity = 0;
+}
+
+static FILE *tree_csv_file = NULL;  // arquivo CSV para a árvore de processos
+
+int proc_tree_csv_write(const ProcTreeSample *sample) {
+    if (!sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em proc_tree_csv_write\n");
+        return -1;
+    }
+
+    // cria o arquivo na primeira chamada
+    if (!tree_csv_file) {
+        struct tm *tm_info = localtime(&sample->timestamp);
+        char filename[64];
+        snprintf(filename, sizeof(filename),
+                 "proc-tree-%04d%02d%02d_%02d%02d%02d.csv",
+                 tm_info->tm_year + 1900,
+                 tm_info->tm_mon + 1,
+                 tm_info->tm_mday,
+                 tm_info->tm_hour,
+                 tm_info->tm_min,
+                 tm_info->tm_sec);
+
+        tree_csv_file = fopen(filename, "w");
+        if (!tree_csv_file) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", filename);
+            return -1;
+        }
+
+        fprintf(tree_csv_file,
+                "timestamp,root,kind,pid,ppid,comm,cpu_percent,exited_children_cpu_percent,"
+                "rss_kb,threads,members,forks,exits\n");
+        fflush(tree_csv_file);
+    }
+
+    // Linhas "member" por processo e uma linha "total" com a árvore inteira
+    for (int i = 0; i < sample->nrows; i++) {
+        const ProcTreeMemberSample *r = &sample->rows[i];
+        if (fprintf(tree_csv_file, "%lld,%d,member,%d,%d,",
+                    (long long)sample->timestamp, (int)sample->root, (int)r->pid, (int)r->ppid) < 0 ||
+            csv_write_quoted(tree_csv_file, r->comm) != 0 ||
+            fprintf(tree_csv_file, ",%.2f,%.2f,%llu,%llu,,,\n",
+                    r->cpu_percent, r->exited_children_cpu_percent, r->rss_kb, r->threads) < 0) {
+            fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+            return -1;
+        }
+    }
+
+    if (fprintf(tree_csv_file, "%lld,%d,total,,,,%.2f,%.2f,%llu,%llu,%d,%d,%d\n",
+                (long long)sample->timestamp, (int)sample->root,
+                sample->cpu_percent, sample->exited_cpu_percent, sample->rss_kb,
+                sample->threads, sample->members, sample->forks, sample->exits) < 0) {
+        fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+        return -1;
+    }
+
+    fflush(tree_csv_file);
+    return 0;
+}
+
+void proc_tree_csv_close(void) {
+    if (tree_csv_file) {
+        fclose(tree_csv_file);
+        tree_csv_file = NULL;
+    }
+}
@@ -0,0 +1,791 @@
+#define _GNU_SOURCE
+#include "query.h"
+#include "stats.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct IndexPidEntries {
+    int pid;
+    SampleIndexEntry *entries;
+    size_t count, cap;
+};
+
+/* ----------------------------- CONSTRUÇÃO ----------------------------- */
+
+void sample_index_builder_init(SampleIndexBuilder *builder) {
+    memset(builder, 0, sizeof(*builder));
+}
+
+// Lista de blocos do alvo, criada na primeira vez (vetor ordenado por pid)
+static struct IndexPidEntries *builder_pid(SampleIndexBuilder *builder, int pid) {
+
+    size_t lo = 0, hi = builder->npids;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (builder->pids[mid].pid < pid) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < builder->npids && builder->pids[lo].pid == pid) return &builder->pids[lo];
+
+    if (builder->npids == builder->pids_cap) {
+        size_t cap = builder->pids_cap ? builder->pids_cap * 2 : 16;
+        struct IndexPidEntries *grown = realloc(builder->pids, cap * sizeof(*grown));
+        if (!grown) return NULL;
+        builder->pids = grown;
+        builder->pids_cap = cap;
+    }
+    memmove(&builder->pids[lo + 1], &builder->pids[lo], (builder->npids - lo) * sizeof(*builder->pids));
+    memset(&builder->pids[lo], 0, sizeof(builder->pids[lo]));
+    builder->pids[lo].pid = pid;
+    builder->npids++;
+    return &builder->pids[lo];
+}
+
+int sample_index_builder_add(SampleIndexBuilder *builder, const SampleRecord *record) {
+
+    unsigned long long block = builder->records / SAMPLE_INDEX_BLOCK;
+    long long t = (long long)sample_record_time(record);
+
+    if (block == builder->nblocks) {
+        if (builder->nblocks == builder->blocks_cap) {
+            size_t cap = builder->blocks_cap ? builder->blocks_cap * 2 : 64;
+            SampleIndexBlock *grown = realloc(builder->blocks, cap * sizeof(*grown));
+            if (!grown) return -1;
+            builder->blocks = grown;
+            builder->blocks_cap = cap;
+        }
+        SampleIndexBlock *b = &builder->blocks[builder->nblocks++];
+        b->first_ts = b->last_ts = t;
+        b->first_record = builder->records;
+        b->count = 0;
+    }
+
+    SampleIndexBlock *b = &builder->blocks[block];
+    if (t < b->first_ts) b->first_ts = t;
+    if (t > b->last_ts) b->last_ts = t;
+    b->count++;
+
+    struct IndexPidEntries *p = builder_pid(builder, (int)record->pid);
+    if (!p) return -1;
+
+    if (p->count == 0 || p->entries[p->count - 1].block != block) {
+        if (p->count == p->cap) {
+            size_t cap = p->cap ? p->cap * 2 : 8;
+            SampleIndexEntry *grown = realloc(p->entries, cap * sizeof(*grown));
+            if (!grown) return -1;
+            p->entries = grown;
+            p->cap = cap;
+        }
+        SampleIndexEntry *e = &p->entries[p->count++];
+        memset(e, 0, sizeof(*e));
+        e->block = block;
+        e->first_ts = e->last_ts = t;
+    }
+
+    SampleIndexEntry *e = &p->entries[p->count - 1];
+    if (t < e->first_ts) e->first_ts = t;
+    if (t > e->last_ts) e->last_ts = t;
+    e->records++;
+
+    for (int i = 0; i < SAMPLE_METRIC_COUNT; i++) {
+        if (!(record->flags & sample_metrics[i].flag)) continue;
+        double v = sample_metric_value(record, i);
+        if (!isfinite(v)) continue;
+        if (e->n[i] == 0 || v < e->min[i]) e->min[i] = v;
+        if (e->n[i] == 0 || v > e->max[i]) e->max[i] = v;
+        if (e->n[i] == 0 || t < e->first_at[i]) {
+            e->first[i] = v;
+            e->first_at[i] = t;
+        }
+        if (e->n[i] == 0 || t >= e->last_at[i]) {
+            e->last[i] = v;
+            e->last_at[i] = t;
+        }
+        e->sum[i] += v;
+        e->n[i]++;
+        e->present |= 1u << i;
+    }
+
+    builder->records++;
+    return 0;
+}
+
+void sample_index_builder_free(SampleIndexBuilder *builder) {
+    if (!builder) return;
+    for (size_t i = 0; i < builder->npids; i++) free(builder->pids[i].entries);
+    free(builder->pids);
+    free(builder->blocks);
+    sample_index_builder_init(builder);
+}
+
+// Copia o índice em construção para o formato de consulta (arrays contíguos)
+static int builder_finish(const SampleIndexBuilder *builder, SampleIndex *index) {
+
+    memset(index, 0, sizeof(*index));
+    SampleIndexHeader *h = &index->header;
+    memcpy(h->magic, SAMPLE_INDEX_MAGIC, sizeof(h->magic));
+    h->version = SAMPLE_INDEX_VERSION;
+    h->record_size = sizeof(SampleRecord);
+    h->block_records = SAMPLE_INDEX_BLOCK;
+    h->metric_count = SAMPLE_METRIC_COUNT;
+    h->records = builder->records;
+    h->nblocks = builder->nblocks;
+    h->npids = builder->npids;
+
+    h->sorted = 1;
+    for (size_t b = 1; b < builder->nblocks; b++) {
+        if (builder->blocks[b].first_ts < builder->blocks[b - 1].last_ts) h->sorted = 0;
+    }
+    for (size_t i = 0; i < builder->npids; i++) h->nentries += builder->pids[i].count;
+
+    index->blocks = malloc((h->nblocks ? h->nblocks : 1) * sizeof(SampleIndexBlock));
+    index->pids = malloc((h->npids ? h->npids : 1) * sizeof(SampleIndexPid));
+    index->entries = malloc((h->nentries ? h->nentries : 1) * sizeof(SampleIndexEntry));
+    if (!index->blocks || !index->pids || !index->entries) {
+        sample_index_free(index);
+        return -1;
+    }
+
+    memcpy(index->blocks, builder->blocks, h->nblocks * sizeof(SampleIndexBlock));
+    unsigned long long next = 0;
+    for (size_t i = 0; i < builder->npids; i++) {
+        const struct IndexPidEntries *p = &builder->pids[i];
+        index->pids[i].pid = p->pid;
+        index->pids[i].reserved = 0;
+        index->pids[i].first_entry = next;
+        index->pids[i].nentries = p->count;
+        memcpy(&index->entries[next], p->entries, p->count * sizeof(SampleIndexEntry));
+        next += p->count;
+    }
+    return 0;
+}
+
+static int capture_stat(const char *capture_path, unsigned long long *size, long long *mtime_ns) {
+    struct stat st;
+    if (stat(capture_path, &st) != 0) return -1;
+    *size = (unsigned long long)st.st_size;
+    *mtime_ns = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    return 0;
+}
+
+static int index_write(SampleIndex *index, const char *capture_path) {
+
+    if (capture_stat(capture_path, &index->header.capture_size, &index->header.capture_mtime_ns) != 0) return -1;
+
+    char path[PATH_MAX], tmp[PATH_MAX];
+    snprintf(path, sizeof(path), "%s.idx", capture_path);
+    snprintf(tmp, sizeof(tmp), "%s.idx.tmp", capture_path);
+
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp) {
+        fprintf(stderr, "Erro: nao foi possivel criar %s\n", tmp);
+        return -1;
+    }
+
+    const SampleIndexHeader *h = &index->header;
+    int ok = fwrite(h, sizeof(*h), 1, fp) == 1 &&
+             fwrite(index->blocks, sizeof(SampleIndexBlock), h->nblocks, fp) == h->nblocks &&
+             fwrite(index->pids, sizeof(SampleIndexPid), h->npids, fp) == h->npids &&
+             fwrite(index->entries, sizeof(SampleIndexEntry), h->nentries, fp) == h->nentries;
+    if (fclose(fp) != 0) ok = 0;
+
+    if (!ok || rename(tmp, path) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel gravar %s\n", path);
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int sample_index_builder_write(const SampleIndexBuilder *builder, const char *capture_path) {
+
+    SampleIndex index;
+    if (builder_finish(builder, &index) != 0) return -1;
+    int rc = index_write(&index, capture_path);
+    sample_index_free(&index);
+    return rc;
+}
+
+/* ------------------------------ CARGA ------------------------------ */
+
+void sample_index_free(SampleIndex *index) {
+    if (!index) return;
+    if (index->map) {
+        munmap(index->map, index->map_len);
+    } else {
+        free(index->blocks);
+        free(index->pids);
+        free(index->entries);
+    }
+    memset(index, 0, sizeof(*index));
+}
+
+// Índice gravado, se ainda corresponde ao .bin: mmap, sem copiar nada
+static int index_map(SampleIndex *index, const char *capture_path) {
+
+    unsigned long long size;
+    long long mtime_ns;
+    if (capture_stat(capture_path, &size, &mtime_ns) != 0) return -1;
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s.idx", capture_path);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    SampleIndexHeader h;
+    if (fstat(fd, &st) != 0 || pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) {
+        close(fd);
+        return -1;
+    }
+
+    size_t expected = sizeof(h) + h.nblocks * sizeof(SampleIndexBlock) +
+                      h.npids * sizeof(SampleIndexPid) + h.nentries * sizeof(SampleIndexEntry);
+    if (memcmp(h.magic, SAMPLE_INDEX_MAGIC, sizeof(h.magic)) != 0 || h.version != SAMPLE_INDEX_VERSION ||
+        h.record_size != sizeof(SampleRecord) || h.block_records != SAMPLE_INDEX_BLOCK ||
+        h.metric_count != SAMPLE_METRIC_COUNT || h.capture_size != size || h.capture_mtime_ns != mtime_ns ||
+        (size_t)st.st_size != expected) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, expected, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    memset(index, 0, sizeof(*index));
+    index->header = h;
+    index->map = map;
+    index->map_len = expected;
+    index->blocks = (SampleIndexBlock *)((char *)map + sizeof(h));
+    index->pids = (SampleIndexPid *)(index->blocks + h.nblocks);
+    index->entries = (SampleIndexEntry *)(index->pids + h.npids);
+    return 0;
+}
+
+// Abre o .bin e confere o cabeçalho. Retorna o fd ou -1.
+static int capture_open(const char *capture_path) {
+
+    int fd = open(capture_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", capture_path);
+        return -1;
+    }
+
+    SampleFileHeader header;
+    if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        memcmp(header.magic, SAMPLE_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "Erro: %s nao e uma captura de amostras\n", capture_path);
+        close(fd);
+        return -1;
+    }
+    if (header.version != SAMPLE_FILE_VERSION || header.record_size != sizeof(SampleRecord)) {
+        fprintf(stderr, "Erro: %s foi gravado por outra versao (registro de %u bytes)\n",
+                capture_path, header.record_size);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int sample_index_load(SampleIndex *index, const char *capture_path) {
+
+    if (!index || !capture_path) return -1;
+    if (index_map(index, capture_path) == 0) return 0;
+
+    int fd = capture_open(capture_path);
+    if (fd < 0) return -1;
+
+    // Refaz o índice numa leitura sequencial do .bin
+    fprintf(stderr, "Indexando %s...\n", capture_path);
+    SampleIndexBuilder builder;
+    sample_index_builder_init(&builder);
+
+    size_t chunk = SAMPLE_INDEX_BLOCK * sizeof(SampleRecord);
+    SampleRecord *buf = malloc(chunk);
+    off_t off = sizeof(SampleFileHeader);
+    int rc = buf ? 0 : -1;
+    while (rc == 0) {
+        ssize_t got = pread(fd, buf, chunk, off);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        size_t n = (size_t)got / sizeof(SampleRecord);
+        if (n == 0) break;   // registro final incompleto (gravação interrompida)
+        for (size_t i = 0; i < n && rc == 0; i++) rc = sample_index_builder_add(&builder, &buf[i]);
+        off += (off_t)(n * sizeof(SampleRecord));
+    }
+    free(buf);
+    close(fd);
+
+    if (rc == 0) rc = builder_finish(&builder, index);
+    sample_index_builder_free(&builder);
+    if (rc != 0) {
+        fprintf(stderr, "Erro: sem memoria para indexar %s\n", capture_path);
+        return -1;
+    }
+
+    index_write(index, capture_path);  // sem o cache a consulta ainda funciona
+    return 0;
+}
+
+/* ------------------------------ CONSULTA ------------------------------ */
+
+int query_parse_aggs(Query *query, const char *list) {
+
+    char copy[256];
+    snprintf(copy, sizeof(copy), "%s", list);
+    query->naggs = 0;
+
+    for (char *save = NULL, *tok = strtok_r(copy, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        if (query->naggs == QUERY_MAX_AGGS) return -1;
+        QueryAgg *agg = &query->aggs[query->naggs];
+        memset(agg, 0, sizeof(*agg));
+
+        if (strcmp(tok, "count") == 0) agg->kind = QUERY_COUNT;
+        else if (strcmp(tok, "avg") == 0) agg->kind = QUERY_AVG;
+        else if (strcmp(tok, "min") == 0) agg->kind = QUERY_MIN;
+        else if (strcmp(tok, "max") == 0) agg->kind = QUERY_MAX;
+        else if (strcmp(tok, "rate") == 0) agg->kind = QUERY_RATE;
+        else if (tok[0] == 'p') {
+            char *end;
+            double pct = strtod(tok + 1, &end);
+            // p999 = p99.9, p9999 = p99.99 (3 ou mais dígitos sem ponto)
+            if (!strchr(tok, '.') && strlen(tok + 1) > 2) pct /= pow(10.0, (double)strlen(tok + 1) - 2.0);
+            if (end == tok + 1 || *end != '\0' || pct <= 0.0 || pct > 100.0) return -1;
+            agg->kind = QUERY_PERCENTILE;
+            agg->q = pct / 100.0;
+        } else {
+            return -1;
+        }
+        snprintf(agg->name, sizeof(agg->name), "%s", tok);
+        query->naggs++;
+    }
+    return query->naggs > 0 ? 0 : -1;
+}
+
+int query_parse_metrics(Query *query, const char *list) {
+
+    char copy[512];
+    snprintf(copy, sizeof(copy), "%s", list);
+    query->nmetrics = 0;
+
+    for (char *save = NULL, *tok = strtok_r(copy, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        int found = -1;
+        for (int i = 0; i < SAMPLE_METRIC_COUNT; i++) {
+            if (strcmp(tok, sample_metrics[i].name) == 0) found = i;
+        }
+        if (found < 0 || query->nmetrics == QUERY_MAX_METRICS) return -1;
+        query->metrics[query->nmetrics++] = found;
+    }
+    return query->nmetrics > 0 ? 0 : -1;
+}
+
+// Agregado de uma métrica num grupo
+typedef struct {
+    unsigned long long n;
+    double sum, min, max;
+    double first, last;
+    long long first_at, last_at;
+    StreamStats *hist;                    // só com percentis
+} QueryAcc;
+
+static void acc_merge(QueryAcc *acc, unsigned long long n, double sum, double min, double max,
+                      double first, long long first_at, double last, long long last_at) {
+    if (n == 0) return;
+    if (acc->n == 0 || min < acc->min) acc->min = min;
+    if (acc->n == 0 || max > acc->max) acc->max = max;
+    if (acc->n == 0 || first_at < acc->first_at) {
+        acc->first = first;
+        acc->first_at = first_at;
+    }
+    if (acc->n == 0 || last_at >= acc->last_at) {
+        acc->last = last;
+        acc->last_at = last_at;
+    }
+    acc->sum += sum;
+    acc->n += n;
+}
+
+// Taxa de um alvo: (último - primeiro) / segundos entre eles
+static double acc_rate(const QueryAcc *acc) {
+    return acc->last_at > acc->first_at ? (acc->last - acc->first) / (double)(acc->last_at - acc->first_at) : 0.0;
+}
+
+/*
+ * Kernels de coluna: laços simples sobre arrays contíguos, sem desvios no
+ * corpo (o filtro vira aritmética), para o preditor de desvios não errar
+ * a cada registro de outro alvo. O binário principal sai sem -O, então não
+ * contam com vetorização.
+ */
+
+// Posições do bloco com o alvo e o instante no intervalo: grava sempre e só avança k se passou
+static size_t kernel_select(const int *pids, const long long *ts, size_t n, int pid,
+                            long long from, long long to, unsigned *sel) {
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        sel[k] = (unsigned)i;
+        k += (size_t)((pids[i] == pid) & (ts[i] >= from) & (ts[i] <= to));
+    }
+    return k;
+}
+
+static double kernel_sum(const double *v, size_t n) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += v[i];
+        s1 += v[i + 1];
+        s2 += v[i + 2];
+        s3 += v[i + 3];
+    }
+    for (; i < n; i++) s0 += v[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+static double kernel_min(const double *v, size_t n) {
+    double m = v[0];
+    for (size_t i = 1; i < n; i++) m = v[i] < m ? v[i] : m;
+    return m;
+}
+
+static double kernel_max(const double *v, size_t n) {
+    double m = v[0];
+    for (size_t i = 1; i < n; i++) m = v[i] > m ? v[i] : m;
+    return m;
+}
+
+// Bloco lido do .bin, com as colunas de pid e tempo já extraídas
+typedef struct {
+    unsigned long long block;             // ULLONG_MAX = nenhum
+    SampleRecord *records;
+    size_t count;
+    int *pids;
+    long long *ts;
+    unsigned *sel;
+    double *values;
+    long long *at;
+} BlockCache;
+
+static int block_load(BlockCache *cache, int fd, const SampleIndex *index, unsigned long long block, QueryStats *stats) {
+
+    if (cache->block == block) return 0;
+
+    const SampleIndexBlock *b = &index->blocks[block];
+    size_t bytes = b->count * sizeof(SampleRecord);
+    off_t off = (off_t)sizeof(SampleFileHeader) + (off_t)(b->first_record * sizeof(SampleRecord));
+    if (pread(fd, cache->records, bytes, off) != (ssize_t)bytes) {
+        fprintf(stderr, "Erro: leitura incompleta do bloco %llu\n", block);
+        cache->block = ULLONG_MAX;
+        return -1;
+    }
+
+    cache->count = b->count;
+    for (size_t i = 0; i < cache->count; i++) {
+        cache->pids[i] = (int)cache->records[i].pid;
+        cache->ts[i] = (long long)sample_record_time(&cache->records[i]);
+    }
+    cache->block = block;
+
+    stats->blocks_read++;
+    stats->records_read += cache->count;
+    stats->bytes_read += bytes;
+    return 0;
+}
+
+// Registros de um alvo num bloco: seleção, coluna de cada métrica e kernels
+static void block_aggregate(BlockCache *cache, int pid, long long from, long long to,
+                            const Query *query, QueryAcc *accs, QueryAcc *target_accs, int need_hist) {
+
+    size_t k = kernel_select(cache->pids, cache->ts, cache->count, pid, from, to, cache->sel);
+    if (k == 0) return;
+
+    for (int m = 0; m < query->nmetrics; m++) {
+        int metric = query->metrics[m];
+        size_t n = 0;
+        for (size_t j = 0; j < k; j++) {
+            const SampleRecord *r = &cache->records[cache->sel[j]];
+            if (!(r->flags & sample_metrics[metric].flag)) continue;
+            double v = sample_metric_value(r, metric);
+            if (!isfinite(v)) continue;
+            cache->values[n] = v;
+            cache->at[n] = cache->ts[cache->sel[j]];
+            n++;
+        }
+        if (n == 0) continue;
+
+        // primeiro/último pelo tempo (os registros do bloco estão na ordem de gravação)
+        size_t lo = 0, hi = 0;
+        for (size_t j = 1; j < n; j++) {
+            if (cache->at[j] < cache->at[lo]) lo = j;
+            if (cache->at[j] >= cache->at[hi]) hi = j;
+        }
+        QueryAcc *acc = &accs[m];
+        acc_merge(acc, n, kernel_sum(cache->values, n), kernel_min(cache->values, n), kernel_max(cache->values, n),
+                  cache->values[lo], cache->at[lo], cache->values[hi], cache->at[hi]);
+        if (target_accs) {
+            acc_merge(&target_accs[m], n, 0.0, 0.0, 0.0,
+                      cache->values[lo], cache->at[lo], cache->values[hi], cache->at[hi]);
+        }
+        if (need_hist && !acc->hist) {
+            acc->hist = malloc(sizeof(*acc->hist));
+            if (acc->hist) stream_stats_init(acc->hist);
+        }
+        if (need_hist && acc->hist) {
+            for (size_t j = 0; j < n; j++) stream_stats_add(acc->hist, cache->values[j]);
+        }
+    }
+}
+
+// Primeira entrada do alvo com bloco >= block
+static unsigned long long entries_lower_bound(const SampleIndexEntry *entries, unsigned long long n,
+                                              unsigned long long block) {
+    unsigned long long lo = 0, hi = n;
+    while (lo < hi) {
+        unsigned long long mid = lo + (hi - lo) / 2;
+        if (entries[mid].block < block) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * Escreve as linhas de um grupo
+ * @param rates Taxa de cada métrica já somada por alvo (grupo "*"), ou NULL
+ */
+static void print_group(FILE *out, const char *label, const Query *query, QueryAcc *accs, const double *rates) {
+
+    for (int m = 0; m < query->nmetrics; m++) {
+        QueryAcc *acc = &accs[m];
+        if (acc->n == 0) continue;
+        fprintf(out, "%s,%s", label, sample_metrics[query->metrics[m]].name);
+        for (int a = 0; a < query->naggs; a++) {
+            double v = 0.0;
+            switch (query->aggs[a].kind) {
+                case QUERY_COUNT: v = (double)acc->n; break;
+                case QUERY_AVG: v = acc->sum / (double)acc->n; break;
+                case QUERY_MIN: v = acc->min; break;
+                case QUERY_MAX: v = acc->max; break;
+                case QUERY_RATE: v = rates ? rates[m] : acc_rate(acc); break;
+                case QUERY_PERCENTILE: v = acc->hist ? stream_stats_percentile(acc->hist, query->aggs[a].q) : 0.0; break;
+            }
+            fprintf(out, ",%.10g", v);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+// Um bloco a ler para um alvo (resumo do índice não basta)
+typedef struct {
+    unsigned long long block;
+    size_t target;                        // posição em targets[]
+} BlockWork;
+
+static int cmp_work(const void *a, const void *b) {
+    const BlockWork *x = a, *y = b;
+    if (x->block != y->block) return x->block < y->block ? -1 : 1;
+    return (x->target > y->target) - (x->target < y->target);
+}
+
+static void block_cache_free(BlockCache *cache) {
+    free(cache->records);
+    free(cache->pids);
+    free(cache->ts);
+    free(cache->sel);
+    free(cache->values);
+    free(cache->at);
+}
+
+static int block_cache_init(BlockCache *cache) {
+    size_t n = SAMPLE_INDEX_BLOCK;
+    memset(cache, 0, sizeof(*cache));
+    cache->block = ULLONG_MAX;
+    cache->records = malloc(n * sizeof(SampleRecord));
+    cache->pids = malloc(n * sizeof(int));
+    cache->ts = malloc(n * sizeof(long long));
+    cache->sel = malloc(n * sizeof(unsigned));
+    cache->values = malloc(n * sizeof(double));
+    cache->at = malloc(n * sizeof(long long));
+    if (!cache->records || !cache->pids || !cache->ts || !cache->sel || !cache->values || !cache->at) {
+        block_cache_free(cache);
+        return -1;
+    }
+    return 0;
+}
+
+int query_run(const SampleIndex *index, const char *capture_path, const Query *query, FILE *out, QueryStats *stats) {
+
+    if (!index || !capture_path || !query || !out || !stats) {
+        fprintf(stderr, "Erro: ponteiro nulo em query_run\n");
+        return -1;
+    }
+    memset(stats, 0, sizeof(*stats));
+
+    int need_hist = 0, need_rate = 0;
+    for (int a = 0; a < query->naggs; a++) {
+        if (query->aggs[a].kind == QUERY_PERCENTILE) need_hist = 1;
+        if (query->aggs[a].kind == QUERY_RATE) need_rate = 1;
+    }
+
+    const SampleIndexHeader *h = &index->header;
+    long long from = query->from ? query->from : LLONG_MIN;
+    long long to = query->to ? query->to : LLONG_MAX;
+
+    // Índice esparso de tempo: blocos [b0, b1) que podem ter registros no intervalo
+    unsigned long long b0 = 0, b1 = h->nblocks;
+    if (h->sorted) {
+        unsigned long long lo = 0, hi = h->nblocks;
+        while (lo < hi) {
+            unsigned long long mid = lo + (hi - lo) / 2;
+            if (index->blocks[mid].last_ts < from) lo = mid + 1;
+            else hi = mid;
+        }
+        b0 = lo;
+        hi = h->nblocks;
+        while (lo < hi) {
+            unsigned long long mid = lo + (hi - lo) / 2;
+            if (index->blocks[mid].first_ts <= to) lo = mid + 1;
+            else hi = mid;
+        }
+        b1 = lo;
+    }
+
+    // Alvos da consulta: o pedido ou todos
+    size_t ntargets = 0, first_target = 0;
+    if (query->pid) {
+        size_t lo = 0, hi = h->npids;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (index->pids[mid].pid < (int)query->pid) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo < h->npids && index->pids[lo].pid == (int)query->pid) {
+            first_target = lo;
+            ntargets = 1;
+        }
+    } else {
+        ntargets = h->npids;
+    }
+
+    // Um grupo por alvo, ou um só para todos
+    size_t ngroups = query->group_by_pid ? ntargets : 1;
+    QueryAcc *accs = calloc((ngroups ? ngroups : 1) * (size_t)query->nmetrics, sizeof(QueryAcc));
+    unsigned char *touched = calloc(ntargets ? ntargets : 1, 1);
+    // Sem agrupar, o primeiro e o último valor do grupo são de alvos diferentes:
+    // a taxa sai por alvo e depois é somada
+    QueryAcc *target_accs = NULL;
+    if (!query->group_by_pid && need_rate) target_accs = calloc((ntargets ? ntargets : 1) * (size_t)query->nmetrics, sizeof(QueryAcc));
+    BlockWork *work = NULL;
+    size_t nwork = 0, work_cap = 0;
+    int rc = (accs && touched && (target_accs || query->group_by_pid || !need_rate)) ? 0 : -1;
+
+    // Blocos inteiros no intervalo saem do índice; os demais viram leituras
+    for (size_t t = 0; t < ntargets && rc == 0; t++) {
+        const SampleIndexPid *target = &index->pids[first_target + t];
+        const SampleIndexEntry *entries = &index->entries[target->first_entry];
+        QueryAcc *group = &accs[(query->group_by_pid ? t : 0) * (size_t)query->nmetrics];
+        QueryAcc *per_target = target_accs ? &target_accs[t * (size_t)query->nmetrics] : NULL;
+
+        for (unsigned long long e = entries_lower_bound(entries, target->nentries, b0);
+             e < target->nentries && entries[e].block < b1; e++) {
+            const SampleIndexEntry *entry = &entries[e];
+            if (entry->last_ts < from || entry->first_ts > to) continue;
+            touched[t] = 1;
+
+            if (!need_hist && entry->first_ts >= from && entry->last_ts <= to) {
+                for (int m = 0; m < query->nmetrics; m++) {
+                    int i = query->metrics[m];
+                    acc_merge(&group[m], entry->n[i], entry->sum[i], entry->min[i], entry->max[i],
+                              entry->first[i], entry->first_at[i], entry->last[i], entry->last_at[i]);
+                    if (per_target) {
+                        acc_merge(&per_target[m], entry->n[i], 0.0, 0.0, 0.0,
+                                  entry->first[i], entry->first_at[i], entry->last[i], entry->last_at[i]);
+                    }
+                }
+                stats->entries_used++;
+                continue;
+            }
+
+            if (nwork == work_cap) {
+                size_t cap = work_cap ? work_cap * 2 : 64;
+                BlockWork *grown = realloc(work, cap * sizeof(*grown));
+                if (!grown) {
+                    rc = -1;
+                    break;
+                }
+                work = grown;
+                work_cap = cap;
+            }
+            work[nwork].block = entry->block;
+            work[nwork].target = t;
+            nwork++;
+        }
+    }
+
+    // Cada bloco é lido uma vez e agregado para todos os alvos que precisam dele
+    if (rc == 0 && nwork > 0) {
+        qsort(work, nwork, sizeof(*work), cmp_work);
+
+        BlockCache cache;
+        int fd = capture_open(capture_path);
+        if (fd < 0 || block_cache_init(&cache) != 0) {
+            rc = -1;
+        } else {
+            for (size_t w = 0; w < nwork && rc == 0; w++) {
+                if (block_load(&cache, fd, index, work[w].block, stats) != 0) {
+                    rc = -1;
+                    break;
+                }
+                size_t t = work[w].target;
+                QueryAcc *group = &accs[(query->group_by_pid ? t : 0) * (size_t)query->nmetrics];
+                QueryAcc *per_target = target_accs ? &target_accs[t * (size_t)query->nmetrics] : NULL;
+                block_aggregate(&cache, index->pids[first_target + t].pid, from, to, query, group, per_target,
+                                need_hist);
+            }
+            block_cache_free(&cache);
+        }
+        if (fd >= 0) close(fd);
+    }
+
+    if (rc == 0) {
+        fprintf(out, "pid,metric");
+        for (int a = 0; a < query->naggs; a++) fprintf(out, ",%s", query->aggs[a].name);
+        fprintf(out, "\n");
+
+        for (size_t t = 0; t < ntargets; t++) stats->targets += touched[t];
+        if (query->group_by_pid) {
+            for (size_t t = 0; t < ntargets; t++) {
+                if (!touched[t]) continue;
+                char label[16];
+                snprintf(label, sizeof(label), "%d", index->pids[first_target + t].pid);
+                print_group(out, label, query, &accs[t * (size_t)query->nmetrics], NULL);
+            }
+        } else {
+            double rates[QUERY_MAX_METRICS] = { 0.0 };
+            for (size_t t = 0; target_accs && t < ntargets; t++) {
+                for (int m = 0; m < query->nmetrics; m++) rates[m] += acc_rate(&target_accs[t * (size_t)query->nmetrics + m]);
+            }
+            print_group(out, "*", query, accs, rates);
+        }
+    }
+
+    if (accs) {
+        for (size_t g = 0; g < ngroups * (size_t)query->nmetrics; g++) {
+            if (accs[g].hist) stream_stats_free(accs[g].hist);
+            free(accs[g].hist);
+        }
+    }
+    free(accs);
+    free(target_accs);
+    free(touched);
+    free(work);
+    return rc;
+}
@@ -0,0 +1,456 @@
+#define _GNU_SOURCE
+#include "rollup.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char *const rollup_tier_names[ROLLUP_TIERS] = { "raw", "1m", "10m", "1h" };
+
+static const unsigned tier_seconds[ROLLUP_TIERS] = { 1, 60, 600, 3600 };
+
+static size_t tier_slot_size(int tier) {
+    return tier == ROLLUP_RAW ? sizeof(RollupRawSlot) : sizeof(RollupRow);
+}
+
+/* ---------------------------- RETENÇÃO ---------------------------- */
+
+void rollup_default_retention(long retention_sec[ROLLUP_TIERS]) {
+    retention_sec[ROLLUP_RAW] = 10 * 60;
+    retention_sec[ROLLUP_1M] = 6 * 3600;
+    retention_sec[ROLLUP_10M] = 2 * 86400;
+    retention_sec[ROLLUP_1H] = 31 * 86400;
+}
+
+// "90", "10m", "6h", "31d" -> segundos; -1 se inválido
+static long parse_duration(const char *text) {
+
+    char *end;
+    errno = 0;
+    long value = strtol(text, &end, 10);
+    if (errno != 0 || end == text || value <= 0) return -1;
+
+    long unit = 1;
+    if (*end == 'm') unit = 60;
+    else if (*end == 'h') unit = 3600;
+    else if (*end == 'd') unit = 86400;
+    else if (*end != 's' && *end != '\0') return -1;
+    if (*end != '\0' && end[1] != '\0') return -1;
+    return value * unit;
+}
+
+int rollup_parse_retention(const char *spec, long retention_sec[ROLLUP_TIERS]) {
+
+    char list[256];
+    snprintf(list, sizeof(list), "%s", spec);
+
+    for (char *save = NULL, *tok = strtok_r(list, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(tok, '=');
+        if (!eq) goto invalid;
+        *eq = '\0';
+
+        int tier = -1;
+        for (int t = 0; t < ROLLUP_TIERS; t++) {
+            if (strcmp(tok, rollup_tier_names[t]) == 0) tier = t;
+        }
+        long seconds = parse_duration(eq + 1);
+        if (tier < 0 || seconds < 0) goto invalid;
+        retention_sec[tier] = seconds;
+    }
+    return 0;
+
+invalid:
+    fprintf(stderr, "Erro: retencao invalida: %s (ex.: raw=10m,1m=6h,10m=2d,1h=31d)\n", spec);
+    return -1;
+}
+
+/* ----------------------------- ARQUIVOS ----------------------------- */
+
+static off_t slot_offset(const RollupTier *tier, unsigned long long index) {
+    return (off_t)sizeof(RollupFileHeader) + (off_t)(index * tier->slot_size);
+}
+
+// Maior seq gravado: a escrita continua no slot seguinte
+static int find_head(RollupTier *tier) {
+
+    enum { CHUNK = 4096 };
+    char *buf = malloc(CHUNK * tier->slot_size);
+    if (!buf) return -1;
+
+    unsigned long long max_seq = 0, max_index = 0;
+    for (unsigned long long first = 0; first < tier->capacity; first += CHUNK) {
+        unsigned long long n = tier->capacity - first < CHUNK ? tier->capacity - first : CHUNK;
+        ssize_t got = pread(tier->fd, buf, n * tier->slot_size, slot_offset(tier, first));
+        if (got < 0) {
+            free(buf);
+            return -1;
+        }
+        for (unsigned long long i = 0; i < (unsigned long long)got / tier->slot_size; i++) {
+            const RollupSlotHeader *h = (const RollupSlotHeader *)(buf + i * tier->slot_size);
+            if (h->seq > max_seq) {
+                max_seq = h->seq;
+                max_index = first + i;
+            }
+        }
+    }
+    free(buf);
+
+    tier->next_seq = max_seq + 1;
+    tier->head = max_seq ? (max_index + 1) % tier->capacity : 0;
+    return 0;
+}
+
+static int open_tier(RollupTier *tier, const char *dir, int id, long retention_sec, size_t max_targets) {
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.ring", dir, rollup_tier_names[id]);
+
+    tier->seconds = tier_seconds[id];
+    tier->slot_size = tier_slot_size(id);
+    unsigned long long buckets = (unsigned long long)retention_sec / tier->seconds;
+    tier->capacity = (buckets ? buckets : 1) * max_targets;
+
+    tier->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (tier->fd < 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    RollupFileHeader expected;
+    memset(&expected, 0, sizeof(expected));
+    memcpy(expected.magic, ROLLUP_MAGIC, sizeof(expected.magic));
+    expected.version = ROLLUP_VERSION;
+    expected.tier_seconds = tier->seconds;
+    expected.slot_size = (unsigned)tier->slot_size;
+    expected.metric_count = SAMPLE_METRIC_COUNT;
+    expected.capacity = tier->capacity;
+
+    struct stat st;
+    if (fstat(tier->fd, &st) != 0) return -1;
+
+    if (st.st_size == 0) {
+        // Arquivo novo: o tamanho final é reservado já (esparso até ser escrito)
+        if (pwrite(tier->fd, &expected, sizeof(expected), 0) != (ssize_t)sizeof(expected) ||
+            ftruncate(tier->fd, slot_offset(tier, tier->capacity)) != 0) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s: %s\n", path, strerror(errno));
+            return -1;
+        }
+        tier->next_seq = 1;
+        tier->head = 0;
+        return 0;
+    }
+
+    RollupFileHeader header;
+    if (pread(tier->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        memcmp(&header, &expected, sizeof(header)) != 0) {
+        fprintf(stderr, "Erro: %s foi criado com outro formato, retencao ou numero de alvos\n", path);
+        return -1;
+    }
+    return find_head(tier);
+}
+
+int rollup_store_open(RollupStore *store, const char *dir, const long retention_sec[ROLLUP_TIERS], int max_targets) {
+
+    if (!store || !dir || !retention_sec) {
+        fprintf(stderr, "Erro: ponteiro nulo em rollup_store_open\n");
+        return -1;
+    }
+
+    memset(store, 0, sizeof(*store));
+    for (int t = 0; t < ROLLUP_TIERS; t++) store->tiers[t].fd = -1;
+    snprintf(store->dir, sizeof(store->dir), "%s", dir);
+    store->max_targets = max_targets > 0 ? (size_t)max_targets : ROLLUP_DEFAULT_TARGETS;
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Erro: nao foi possivel criar %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+
+    for (int t = 0; t < ROLLUP_TIERS; t++) {
+        if (open_tier(&store->tiers[t], dir, t, retention_sec[t], store->max_targets) != 0) {
+            rollup_store_close(store);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+unsigned long long rollup_store_bytes(const RollupStore *store) {
+    unsigned long long total = 0;
+    for (int t = 0; t < ROLLUP_TIERS; t++) {
+        total += (unsigned long long)slot_offset(&store->tiers[t], store->tiers[t].capacity);
+    }
+    return total;
+}
+
+static int write_slot(RollupTier *tier, void *slot) {
+
+    RollupSlotHeader *h = slot;
+    h->seq = tier->next_seq;
+
+    if (pwrite(tier->fd, slot, tier->slot_size, slot_offset(tier, tier->head)) != (ssize_t)tier->slot_size) {
+        tier->write_errors++;
+        return -1;
+    }
+    tier->next_seq++;
+    tier->head = (tier->head + 1) % tier->capacity;
+    return 0;
+}
+
+/* ------------------------------ ESCRITA ------------------------------ */
+
+// Alvo da coleta, criado na primeira vez (vetor ordenado por pid)
+static RollupTarget *find_target(RollupStore *store, pid_t pid) {
+
+    size_t lo = 0, hi = store->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (store->targets[mid]->pid < pid) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < store->count && store->targets[lo]->pid == pid) return store->targets[lo];
+    if (store->count >= store->max_targets) return NULL;
+
+    if (store->count == store->capacity) {
+        size_t cap = store->capacity ? store->capacity * 2 : 8;
+        RollupTarget **grown = realloc(store->targets, cap * sizeof(*grown));
+        if (!grown) return NULL;
+        store->targets = grown;
+        store->capacity = cap;
+    }
+
+    RollupTarget *target = calloc(1, sizeof(*target));
+    if (!target) return NULL;
+    target->pid = pid;
+
+    memmove(&store->targets[lo + 1], &store->targets[lo], (store->count - lo) * sizeof(*store->targets));
+    store->targets[lo] = target;
+    store->count++;
+    return target;
+}
+
+static int flush_bucket(RollupStore *store, int tier, pid_t pid, RollupBucket *bucket) {
+
+    if (bucket->count == 0) return 0;
+
+    RollupRow row;
+    memset(&row, 0, sizeof(row));
+    row.h.start = bucket->start;
+    row.h.pid = (int)pid;
+    row.h.count = bucket->count;
+    row.h.present = bucket->present;
+    for (int i = 0; i < SAMPLE_METRIC_COUNT; i++) {
+        if (!(bucket->present & (1u << i))) continue;
+        row.min[i] = bucket->min[i];
+        row.max[i] = bucket->max[i];
+        row.avg[i] = (float)(bucket->sum[i] / bucket->n[i]);
+        row.last[i] = bucket->last[i];
+    }
+
+    memset(bucket, 0, sizeof(*bucket));
+    return write_slot(&store->tiers[tier], &row);
+}
+
+int rollup_store_add(RollupStore *store, const SampleRecord *record) {
+
+    if (!store || !record) return -1;
+
+    RollupTarget *target = find_target(store, record->pid);
+    if (!target) {
+        store->ignored++;
+        return -1;
+    }
+
+    long long t = (long long)sample_record_time(record);
+    int rc = 0;
+    store->added++;
+
+    RollupRawSlot raw;
+    memset(&raw, 0, sizeof(raw));
+    raw.h.start = t;
+    raw.h.pid = (int)record->pid;
+    raw.h.count = 1;
+    for (int i = 0; i < SAMPLE_METRIC_COUNT; i++) {
+        if (!(record->flags & sample_metrics[i].flag)) continue;
+        double v = sample_metric_value(record, i);
+        if (!isfinite(v)) continue;
+        raw.value[i] = (float)v;
+        raw.h.present |= 1u << i;
+    }
+    if (write_slot(&store->tiers[ROLLUP_RAW], &raw) != 0) rc = -1;
+
+    for (int tier = ROLLUP_1M; tier < ROLLUP_TIERS; tier++) {
+        RollupBucket *bucket = &target->open[tier];
+        long long start = t - t % store->tiers[tier].seconds;
+
+        // O balde anterior terminou: vai para o disco e outro começa
+        if (bucket->count && bucket->start != start && flush_bucket(store, tier, record->pid, bucket) != 0) rc = -1;
+        if (bucket->count == 0) bucket->start = start;
+
+        bucket->count++;
+        for (int i = 0; i < SAMPLE_METRIC_COUNT; i++) {
+            if (!(raw.h.present & (1u << i))) continue;
+            float v = raw.value[i];
+            if (bucket->n[i] == 0 || v < bucket->min[i]) bucket->min[i] = v;
+            if (bucket->n[i] == 0 || v > bucket->max[i]) bucket->max[i] = v;
+            bucket->sum[i] += v;
+            bucket->n[i]++;
+            bucket->last[i] = v;
+        }
+        bucket->present |= raw.h.present;
+    }
+    return rc;
+}
+
+void rollup_store_close(RollupStore *store) {
+
+    if (!store) return;
+
+    // Baldes em andamento entram como estão (count diz quantas coletas têm)
+    for (size_t k = 0; k < store->count; k++) {
+        RollupTarget *target = store->targets[k];
+        for (int tier = ROLLUP_1M; tier < ROLLUP_TIERS; tier++) {
+            if (store->tiers[tier].fd >= 0) flush_bucket(store, tier, target->pid, &target->open[tier]);
+        }
+        free(target);
+    }
+    free(store->targets);
+    store->targets = NULL;
+    store->count = store->capacity = 0;
+
+    for (int t = 0; t < ROLLUP_TIERS; t++) {
+        if (store->tiers[t].fd >= 0) close(store->tiers[t].fd);
+        store->tiers[t].fd = -1;
+    }
+}
+
+/* ------------------------------ LEITURA ------------------------------ */
+
+long rollup_store_scan(const char *dir, RollupTierId tier, pid_t pid, long long from, long long to,
+                       int (*fn)(const RollupRow *row, void *ctx), void *ctx) {
+
+    if (!dir || tier < 0 || tier >= ROLLUP_TIERS || !fn) return -1;
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.ring", dir, rollup_tier_names[tier]);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
+        return -1;
+    }
+
+    RollupFileHeader header;
+    if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        memcmp(header.magic, ROLLUP_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != ROLLUP_VERSION || header.metric_count != SAMPLE_METRIC_COUNT ||
+        header.slot_size != tier_slot_size(tier) || header.capacity == 0) {
+        fprintf(stderr, "Erro: %s nao e uma camada de historico valida\n", path);
+        close(fd);
+        return -1;
+    }
+
+    size_t bytes = (size_t)(header.capacity * header.slot_size);
+    char *slots = malloc(bytes);
+    if (!slots || pread(fd, slots, bytes, sizeof(header)) != (ssize_t)bytes) {
+        fprintf(stderr, "Erro: nao foi possivel ler %s\n", path);
+        free(slots);
+        close(fd);
+        return -1;
+    }
+    close(fd);
+
+    // O slot depois do maior seq é o mais antigo: a partir dele a ordem é a de escrita
+    unsigned long long newest = 0, max_seq = 0;
+    for (unsigned long long i = 0; i < header.capacity; i++) {
+        const RollupSlotHeader *h = (const RollupSlotHeader *)(slots + i * header.slot_size);
+        if (h->seq > max_seq) {
+            max_seq = h->seq;
+            newest = i;
+        }
+    }
+
+    long delivered = 0;
+    for (unsigned long long k = 1; max_seq && k <= header.capacity; k++) {
+        const char *slot = slots + ((newest + k) % header.capacity) * header.slot_size;
+        const RollupSlotHeader *h = (const RollupSlotHeader *)slot;
+        if (h->seq == 0) continue;
+        if (pid && h->pid != (int)pid) continue;
+        if ((from && h->start < from) || (to && h->start > to)) continue;
+
+        RollupRow row;
+        if (tier == ROLLUP_RAW) {
+            const RollupRawSlot *raw = (const RollupRawSlot *)slot;
+            row.h = raw->h;
+            memcpy(row.min, raw->value, sizeof(raw->value));
+            memcpy(row.max, raw->value, sizeof(raw->value));
+            memcpy(row.avg, raw->value, sizeof(raw->value));
+            memcpy(row.last, raw->value, sizeof(raw->value));
+        } else {
+            memcpy(&row, slot, sizeof(row));
+        }
+
+        delivered++;
+        if (fn(&row, ctx) != 0) break;
+    }
+
+    free(slots);
+    return delivered;
+}
+
+static int take_first(const RollupRow *row, void *ctx) {
+    *(long long *)ctx = row->h.start;
+    return 1;
+}
+
+int rollup_store_oldest(const char *dir, RollupTierId tier, long long *oldest) {
+    *oldest = 0;
+    return rollup_store_scan(dir, tier, 0, 0, 0, take_first, oldest) < 0 ? -1 : 0;
+}
+
+/* ------------------------------ DESTINO ------------------------------ */
+
+static int rollup_write(SampleSink *sink, const SampleRecord *record) {
+    return rollup_store_add(sink->ctx, record);
+}
+
+static void rollup_close(SampleSink *sink) {
+
+    RollupStore *store = sink->ctx;
+    if (!store) return;
+
+    unsigned long long errors = 0;
+    for (int t = 0; t < ROLLUP_TIERS; t++) errors += store->tiers[t].write_errors;
+    printf("Historico: %llu coletas em %s (%.1f KB reservados", store->added,
+           store->dir, rollup_store_bytes(store) / 1024.0);
+    if (errors) printf(", %llu escritas falharam", errors);
+    if (store->ignored) printf(", %llu coletas de alvos alem do limite", store->ignored);
+    printf(")\n");
+
+    rollup_store_close(store);
+    free(store);
+    sink->ctx = NULL;
+}
+
+int sample_sink_rollup(SampleSink *sink, const char *dir, const long retention_sec[ROLLUP_TIERS], int max_targets) {
+
+    if (!sink) return -1;
+    memset(sink, 0, sizeof(*sink));
+
+    RollupStore *store = malloc(sizeof(*store));
+    if (!store) return -1;
+    if (rollup_store_open(store, dir, retention_sec, max_targets) != 0) {
+        free(store);
+        return -1;
+    }
+
+    sink->name = "historico";
+    sink->write = rollup_write;
+    sink->close = rollup_close;
+    sink->ctx = store;
+    return 0;
+}
@@ -0,0 +1,358 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "proc_parse.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Métricas do escalonador por thread e somadas no processo.
+ *
+ * schedstat dá o tempo na CPU, o tempo esperando na fila de execução e
+ * quantas vezes a thread ganhou a CPU; sched dá as trocas voluntárias e
+ * involuntárias separadas e as migrações entre CPUs. Espera na fila alta
+ * com CPU baixa indica um serviço sem CPU por causa dos vizinhos, não um
+ * serviço ocupado. /proc/<pid>/schedstat sozinho cobre só a thread
+ * principal, por isso tudo é lido em task/<tid>.
+ */
+
+static double timespec_diff_sec(struct timespec a, struct timespec b) {
+    return (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+static int compare_tid(const void *a, const void *b) {
+    pid_t ta = ((const SchedThreadState *)a)->tid;
+    pid_t tb = ((const SchedThreadState *)b)->tid;
+    return (ta > tb) - (ta < tb);
+}
+
+static int compare_delay_desc(const void *a, const void *b) {
+    double da = ((const SchedThreadSample *)a)->delay_ms_per_sec;
+    double db = ((const SchedThreadSample *)b)->delay_ms_per_sec;
+    return (da < db) - (da > db);
+}
+
+/**
+ * Lê os contadores cumulativos de uma thread
+ * @return 0 em sucesso, -1 se a thread não existe mais
+ */
+static int read_thread(pid_t pid, int delayacct, SchedThreadState *t) {
+
+    char path[PROC_PATH_MAX];
+    char buf[4096];
+
+    // schedstat: <tempo em CPU ns> <tempo na fila ns> <timeslices>
+    snprintf(path, sizeof(path), "%s/%d/task/%d/schedstat", proc_root(), (int)pid, (int)t->tid);
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
+    if (len <= 0) return -1;
+
+    const char *end = buf + len;
+    const char *p = proc_parse_u64(buf, end, &t->run_ns);
+    if (p) p = proc_parse_u64(p, end, &t->delay_ns);
+    if (p) p = proc_parse_u64(p, end, &t->timeslices);
+    if (!p) return -1;
+
+    // sched: "chave   :   valor", uma por linha
+    static const char *const keys[] = {
+        "nr_voluntary_switches",    // values[0]
+        "nr_involuntary_switches",  // values[1]
+        "se.nr_migrations",         // values[2]
+    };
+    static ProcKeyTable table;
+    static int table_ready = 0;
+    if (!table_ready) {
+        proc_key_table_init(&table, keys, 3);
+        table_ready = 1;
+    }
+
+    snprintf(path, sizeof(path), "%s/%d/task/%d/sched", proc_root(), (int)pid, (int)t->tid);
+    len = proc_read_file(path, buf, sizeof(buf));
+    if (len > 0) {
+        unsigned long long values[3] = {0, 0, 0};
+        proc_parse_kv(buf, (size_t)len, &table, values);
+        t->voluntary = values[0];
+        t->nonvoluntary = values[1];
+        t->migrations = values[2];
+    }
+
+    // stat campo 42: delayacct_blkio_ticks (só tem valor com delay accounting ligado)
+    if (delayacct) {
+        snprintf(path, sizeof(path), "%s/%d/task/%d/stat", proc_root(), (int)pid, (int)t->tid);
+        len = proc_read_file(path, buf, sizeof(buf));
+        const char *paren = len > 0 ? strrchr(buf, ')') : NULL;
+        if (paren) {
+            p = proc_skip_fields(paren + 1, buf + len, 39);
+            if (!p || !proc_parse_u64(p, buf + len, &t->blkio_ticks)) t->blkio_ticks = 0;
+        }
+    }
+
+    return 0;
+}
+
+static void read_comm(pid_t pid, pid_t tid, char *comm) {
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/task/%d/comm", proc_root(), (int)pid, (int)tid);
+    ssize_t n = proc_read_file(path, comm, THREAD_COMM_LEN);
+    if (n <= 0) {
+        snprintf(comm, THREAD_COMM_LEN, "%d", (int)tid);
+        return;
+    }
+    if (comm[n - 1] == '\n') comm[n - 1] = '\0';
+}
+
+/**
+ * Garante uma entrada para cada thread de task/ (novas entram zeradas e
+ * ordenadas por tid) e remove as que terminaram
+ * @return 0 em sucesso, -1 se o processo não existe mais
+ */
+static int scan_threads(SchedMonitorState *state) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/task", proc_root(), (int)state->pid);
+
+    DIR *dir = opendir(path);
+    if (!dir) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
+        return -1;
+    }
+
+    for (int i = 0; i < state->nthreads; i++) state->threads[i].seen = 0;
+    int existing = state->nthreads;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+
+        SchedThreadState key;
+        key.tid = (pid_t)atoi(entry->d_name);
+        SchedThreadState *t = bsearch(&key, state->threads, (size_t)existing, sizeof(*t), compare_tid);
+        if (t) {
+            t->seen = 1;
+            continue;
+        }
+
+        if (state->nthreads == state->threads_capacity) {
+            int cap = state->threads_capacity ? state->threads_capacity * 2 : 32;
+            SchedThreadState *threads = realloc(state->threads, (size_t)cap * sizeof(*threads));
+            if (!threads) break;
+            state->threads = threads;
+            state->threads_capacity = cap;
+        }
+
+        t = &state->threads[state->nthreads++];
+        memset(t, 0, sizeof(*t));
+        t->tid = key.tid;
+        t->seen = 1;
+        read_comm(state->pid, t->tid, t->comm);
+    }
+    closedir(dir);
+
+    int kept = 0;
+    for (int i = 0; i < state->nthreads; i++) {
+        if (state->threads[i].seen) state->threads[kept++] = state->threads[i];
+    }
+    state->nthreads = kept;
+    qsort(state->threads, (size_t)state->nthreads, sizeof(*state->threads), compare_tid);
+    return 0;
+}
+
+/**
+ * Inicializa o monitor de escalonamento e lê a referência inicial
+ * @param state Estado a inicializar
+ * @param pid Processo a monitorar
+ * @return 0 em sucesso, -1 em erro
+ */
+int sched_monitor_init(SchedMonitorState *state, pid_t pid) {
+
+    if (!state) {
+        fprintf(stderr, "Erro: ponteiro nulo em sched_monitor_init\n");
+        return -1;
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->pid = pid;
+    state->ticks_per_sec = sysconf(_SC_CLK_TCK);
+    if (state->ticks_per_sec <= 0) state->ticks_per_sec = 100;
+
+    char buf[16], path[PROC_PATH_MAX];
+    proc_path(path, sizeof(path), "sys/kernel/task_delayacct");
+    state->delayacct = proc_read_file(path, buf, sizeof(buf)) > 0 && buf[0] == '1';
+
+    if (scan_threads(state) < 0) return -1;
+
+    for (int i = 0; i < state->nthreads; i++) {
+        read_thread(pid, state->delayacct, &state->threads[i]);
+    }
+
+    snprintf(path, sizeof(path), "%s/%d/schedstat", proc_root(), (int)pid);
+    if (state->nthreads == 0 || proc_read_file(path, buf, sizeof(buf)) <= 0) {
+        fprintf(stderr, "Erro: %s indisponivel (kernel sem CONFIG_SCHED_INFO?)\n", path);
+        sched_monitor_free(state);
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &state->last_ts);
+    return 0;
+}
+
+static unsigned long long delta_u64(unsigned long long now, unsigned long long before) {
+    return now >= before ? now - before : 0;
+}
+
+/**
+ * Lê todas as threads e calcula as taxas do intervalo desde a última amostra
+ * @return 0 em sucesso, -1 em erro
+ */
+int sched_monitor_sample(SchedMonitorState *state, SchedSample *sample) {
+
+    if (!state || !sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em sched_monitor_sample\n");
+        return -1;
+    }
+
+    if (scan_threads(state) < 0) return -1;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = timespec_diff_sec(state->last_ts, now);
+    if (elapsed <= 0) elapsed = 1e-9;
+    state->last_ts = now;
+
+    memset(sample, 0, sizeof(*sample));
+    sample->pid = state->pid;
+    sample->timestamp = time(NULL);
+
+    // Buffer temporário para ordenar as threads por espera
+    SchedThreadSample *all = malloc((size_t)(state->nthreads ? state->nthreads : 1) * sizeof(*all));
+    if (!all) return -1;
+
+    unsigned long long run = 0, delay = 0, slices = 0, vol = 0, invol = 0, migr = 0, blkio = 0;
+    int n = 0;
+
+    for (int i = 0; i < state->nthreads; i++) {
+        SchedThreadState *t = &state->threads[i];
+        SchedThreadState prev = *t;
+        if (read_thread(state->pid, state->delayacct, t) < 0) continue;
+
+        // Thread nova: prev zerado, o acumulado todo cai neste intervalo
+        unsigned long long d_run = delta_u64(t->run_ns, prev.run_ns);
+        unsigned long long d_delay = delta_u64(t->delay_ns, prev.delay_ns);
+        unsigned long long d_slices = delta_u64(t->timeslices, prev.timeslices);
+        unsigned long long d_vol = delta_u64(t->voluntary, prev.voluntary);
+        unsigned long long d_invol = delta_u64(t->nonvoluntary, prev.nonvoluntary);
+        unsigned long long d_migr = delta_u64(t->migrations, prev.migrations);
+
+        run += d_run;
+        delay += d_delay;
+        slices += d_slices;
+        vol += d_vol;
+        invol += d_invol;
+        migr += d_migr;
+        blkio += delta_u64(t->blkio_ticks, prev.blkio_ticks);
+
+        SchedThreadSample *ts = &all[n++];
+        ts->tid = t->tid;
+        memcpy(ts->comm, t->comm, sizeof(ts->comm));
+        ts->run_ms_per_sec = (double)d_run / 1e6 / elapsed;
+        ts->delay_ms_per_sec = (double)d_delay / 1e6 / elapsed;
+        ts->delay_per_slice_us = d_slices ? (double)d_delay / 1e3 / (double)d_slices : 0.0;
+        ts->timeslices_per_sec = (double)d_slices / elapsed;
+        ts->voluntary_per_sec = (double)d_vol / elapsed;
+        ts->nonvoluntary_per_sec = (double)d_invol / elapsed;
+        ts->migrations_per_sec = (double)d_migr / elapsed;
+    }
+
+    sample->threads = n;
+    sample->run_ms_per_sec = (double)run / 1e6 / elapsed;
+    sample->delay_ms_per_sec = (double)delay / 1e6 / elapsed;
+    sample->wait_percent = (run + delay) ? (double)delay / (double)(run + delay) * 100.0 : 0.0;
+    sample->delay_per_slice_us = slices ? (double)delay / 1e3 / (double)slices : 0.0;
+    sample->timeslices_per_sec = (double)slices / elapsed;
+    sample->voluntary_per_sec = (double)vol / elapsed;
+    sample->nonvoluntary_per_sec = (double)invol / elapsed;
+    sample->migrations_per_sec = (double)migr / elapsed;
+    sample->blkio_delay_ms_per_sec = state->delayacct
+        ? (double)blkio * 1000.0 / (double)state->ticks_per_sec / elapsed
+        : -1.0;
+
+    qsort(all, (size_t)n, sizeof(*all), compare_delay_desc);
+    sample->ntop = n < SCHED_THREAD_TOP ? n : SCHED_THREAD_TOP;
+    memcpy(sample->top, all, (size_t)sample->ntop * sizeof(*all));
+    free(all);
+
+    return n > 0 ? 0 : -1;
+}
+
+void sched_monitor_free(SchedMonitorState *state) {
+    if (!state) return;
+    free(state->threads);
+    state->threads = NULL;
+    state->nthreads = 0;
+    state->threads_capacity = 0;
+}
+
+static FILE *sched_csv_file = NULL;  // arquivo CSV para métricas do escalonador
+
+int sched_sample_csv_write(const SchedSample *sample) {
+    if (!sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em sched_sample_csv_write\n");
+        return -1;
+    }
+
+    // cria o arquivo na primeira chamada
+    if (!sched_csv_file) {
+        struct tm *tm_info = localtime(&sample->timestamp);
+        char filename[64];
+        snprintf(filename, sizeof(filename),
+                 "sched-monitor-%04d%02d%02d_%02d%02d%02d.csv",
+                 tm_info->tm_year + 1900,
+                 tm_info->tm_mon + 1,
+                 tm_info->tm_mday,
+                 tm_info->tm_hour,
+                 tm_info->tm_min,
+                 tm_info->tm_sec);
+
+        sched_csv_file = fopen(filename, "w");
+        if (!sched_csv_file) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", filename);
+            return -1;
+        }
+
+        fprintf(sched_csv_file,
+                "timestamp,pid,threads,run_ms_per_sec,delay_ms_per_sec,wait_percent,"
+                "delay_per_slice_us,timeslices_per_sec,voluntary_per_sec,"
+                "nonvoluntary_per_sec,migrations_per_sec,blkio_delay_ms_per_sec\n");
+        fflush(sched_csv_file);
+    }
+
+    if (fprintf(sched_csv_file, "%lld,%d,%d,%.3f,%.3f,%.2f,%.2f,%.1f,%.1f,%.1f,%.2f,%.3f\n",
+                (long long)sample->timestamp,
+                (int)sample->pid,
+                sample->threads,
+                sample->run_ms_per_sec,
+                sample->delay_ms_per_sec,
+                sample->wait_percent,
+                sample->delay_per_slice_us,
+                sample->timeslices_per_sec,
+                sample->voluntary_per_sec,
+                sample->nonvoluntary_per_sec,
+                sample->migrations_per_sec,
+                sample->blkio_delay_ms_per_sec) < 0) {
+        fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+        return -1;
+    }
+
+    fflush(sched_csv_file);
+    return 0;
+}
+
+void sched_sample_csv_close(void) {
+    if (sched_csv_file) {
+        fclose(sched_csv_file);
+        sched_csv_file = NULL;
+    }
+}
@@ -0,0 +1,592 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "proc_parse.h"
+#include "symbolizer.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Profiler de pilhas por amostragem.
+ *
+ * Cada thread recebe um evento cpu-clock (software, funciona sem PMU) com
+ * PERF_SAMPLE_CALLCHAIN e um ring mmap próprio; o kernel escreve as
+ * amostras no ring e o poll só consome o que há entre data_tail e
+ * data_head, sem syscalls. inherit não é aceito com ring por thread, então
+ * threads novas são descobertas relendo /proc/<pid>/task a cada intervalo.
+ *
+ * As pilhas de usuário vêm do frame pointer: binários compilados com
+ * -fomit-frame-pointer mostram pilhas truncadas, como no perf record
+ * sem --call-graph dwarf.
+ */
+
+#define KERNEL_ADDR_MIN 0xffff800000000000ULL
+
+static double timespec_diff_sec(struct timespec a, struct timespec b) {
+    return (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+/* ---------------------- tabela de pilhas ---------------------- */
+
+static unsigned long long hash_string(const char *s, size_t len) {
+    unsigned long long h = 0xcbf29ce484222325ULL;  // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static int folded_grow(FoldedTable *table) {
+
+    size_t capacity = table->capacity ? table->capacity * 2 : 1024;
+    FoldedEntry *entries = calloc(capacity, sizeof(*entries));
+    if (!entries) return -1;
+
+    for (size_t i = 0; i < table->capacity; i++) {
+        FoldedEntry *e = &table->entries[i];
+        if (!e->stack) continue;
+        size_t slot = (size_t)e->hash & (capacity - 1);
+        while (entries[slot].stack) slot = (slot + 1) & (capacity - 1);
+        entries[slot] = *e;
+    }
+
+    free(table->entries);
+    table->entries = entries;
+    table->capacity = capacity;
+    return 0;
+}
+
+/**
+ * Soma count à pilha key (len bytes), criando a entrada se preciso
+ * @return 0 em sucesso, -1 sem memória
+ */
+static int folded_add(FoldedTable *table, const char *key, size_t len, unsigned long long count) {
+
+    // Mantém ocupação abaixo de 70%
+    if ((table->count + 1) * 10 > table->capacity * 7 && folded_grow(table) < 0) return -1;
+
+    unsigned long long h = hash_string(key, len);
+    size_t slot = (size_t)h & (table->capacity - 1);
+
+    while (table->entries[slot].stack) {
+        FoldedEntry *e = &table->entries[slot];
+        if (e->hash == h && strncmp(e->stack, key, len) == 0 && e->stack[len] == '\0') {
+            e->count += count;
+            return 0;
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+
+    char *copy = strndup(key, len);
+    if (!copy) return -1;
+
+    table->entries[slot].stack = copy;
+    table->entries[slot].hash = h;
+    table->entries[slot].count = count;
+    table->count++;
+    return 0;
+}
+
+static void folded_clear(FoldedTable *table) {
+    for (size_t i = 0; i < table->capacity; i++) {
+        free(table->entries[i].stack);
+        table->entries[i].stack = NULL;
+    }
+    table->count = 0;
+}
+
+static void folded_free(FoldedTable *table) {
+    folded_clear(table);
+    free(table->entries);
+    memset(table, 0, sizeof(*table));
+}
+
+/* ---------------------- eventos por thread ---------------------- */
+
+static int open_sampler(pid_t tid, int freq, int exclude_kernel) {
+
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_SOFTWARE;
+    attr.config = PERF_COUNT_SW_CPU_CLOCK;
+    attr.freq = 1;
+    attr.sample_freq = (unsigned long long)freq;
+    attr.sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_TID | PERF_SAMPLE_CALLCHAIN;
+    attr.exclude_callchain_kernel = 1;  // só a pilha de usuário vira frames
+    attr.exclude_kernel = (unsigned)exclude_kernel;
+    attr.exclude_hv = 1;
+
+    return (int)syscall(SYS_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+static void read_comm(pid_t pid, pid_t tid, char *comm) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/task/%d/comm", proc_root(), (int)pid, (int)tid);
+
+    char buf[THREAD_COMM_LEN + 1];
+    ssize_t n = proc_read_file(path, buf, sizeof(buf));
+    if (n <= 0) {
+        snprintf(comm, THREAD_COMM_LEN, "%d", (int)tid);
+        return;
+    }
+    if (buf[n - 1] == '\n') n--;
+
+    // Espaços e ';' quebrariam o formato folded
+    int len = 0;
+    for (ssize_t i = 0; i < n && len < THREAD_COMM_LEN - 1; i++) {
+        comm[len++] = (buf[i] == ' ' || buf[i] == ';') ? '_' : buf[i];
+    }
+    comm[len] = '\0';
+}
+
+static StackThread *find_thread(StackProfilerState *state, pid_t tid) {
+    for (int i = 0; i < state->nthreads; i++) {
+        if (state->threads[i].tid == tid) return &state->threads[i];
+    }
+    return NULL;
+}
+
+/**
+ * Abre o sampler e o ring de uma thread
+ * @return 0 em sucesso, -1 se a thread não pôde ser amostrada
+ */
+static int attach_thread(StackProfilerState *state, pid_t tid) {
+
+    if (state->nthreads == state->threads_capacity) {
+        int cap = state->threads_capacity ? state->threads_capacity * 2 : 16;
+        StackThread *threads = realloc(state->threads, (size_t)cap * sizeof(*threads));
+        if (!threads) return -1;
+        state->threads = threads;
+        state->threads_capacity = cap;
+    }
+
+    int fd = open_sampler(tid, state->freq, state->exclude_kernel);
+    if (fd == -1) return -1;
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = page * (1 + STACK_RING_PAGES);
+    void *ring = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ring == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+
+    StackThread *t = &state->threads[state->nthreads++];
+    t->tid = tid;
+    t->fd = fd;
+    t->ring = ring;
+    t->ring_size = size;
+    read_comm(state->pid, tid, t->comm);
+    return 0;
+}
+
+static void detach_thread(StackThread *t) {
+    if (t->ring) munmap(t->ring, t->ring_size);
+    if (t->fd != -1) close(t->fd);
+    t->ring = NULL;
+    t->fd = -1;
+}
+
+/**
+ * Abre samplers para threads que apareceram desde a última varredura
+ * @return número de threads novas, ou -1 se o processo não existe mais
+ */
+static int scan_threads(StackProfilerState *state) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/task", proc_root(), (int)state->pid);
+
+    DIR *dir = opendir(path);
+    if (!dir) return -1;
+
+    for (int i = 0; i < state->nthreads; i++) state->threads[i].seen = 0;
+
+    int added = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        pid_t tid = (pid_t)atoi(entry->d_name);
+        StackThread *t = find_thread(state, tid);
+        if (!t && attach_thread(state, tid) == 0) {
+            t = &state->threads[state->nthreads - 1];
+            added++;
+        }
+        if (t) t->seen = 1;
+    }
+    closedir(dir);
+
+    // Threads que terminaram: o que restou no ring já foi consumido pelo poll
+    int kept = 0;
+    for (int i = 0; i < state->nthreads; i++) {
+        if (!state->threads[i].seen) {
+            detach_thread(&state->threads[i]);
+            continue;
+        }
+        state->threads[kept++] = state->threads[i];
+    }
+    state->nthreads = kept;
+
+    return added;
+}
+
+/* ---------------------- consumo do ring ---------------------- */
+
+/**
+ * Converte uma amostra em "comm;raiz;...;folha" e soma nas tabelas
+ */
+static void record_sample(StackProfilerState *state, const StackThread *t,
+                          const unsigned long long *ips, unsigned long long nr,
+                          unsigned long long sample_ip) {
+
+    Symbolizer *sym = state->symbolizer;
+    const char *frames[STACK_MAX_DEPTH + 1];
+    int depth = 0;
+
+    // O callchain vem da folha para a raiz, intercalado com marcadores de contexto
+    for (unsigned long long i = 0; i < nr && depth < STACK_MAX_DEPTH; i++) {
+        if (ips[i] >= (unsigned long long)PERF_CONTEXT_MAX) continue;
+        if (ips[i] >= KERNEL_ADDR_MIN) continue;
+        frames[depth++] = symbolizer_lookup(sym, ips[i]);
+    }
+
+    char stack[8192];
+    size_t len = (size_t)snprintf(stack, sizeof(stack), "%s", t->comm);
+
+    for (int i = depth - 1; i >= 0 && len < sizeof(stack) - 1; i--) {
+        len += (size_t)snprintf(stack + len, sizeof(stack) - len, ";%s", frames[i]);
+    }
+
+    // Amostra caída dentro de uma syscall: o tempo é do kernel, não da função folha
+    const char *leaf = depth > 0 ? frames[0] : "[unknown]";
+    if (sample_ip >= KERNEL_ADDR_MIN) {
+        leaf = "[kernel]";
+        if (len < sizeof(stack) - 1) {
+            len += (size_t)snprintf(stack + len, sizeof(stack) - len, ";[kernel]");
+        }
+    }
+    if (len >= sizeof(stack)) len = sizeof(stack) - 1;
+
+    folded_add(&state->stacks, stack, len, 1);
+    folded_add(&state->leaves, leaf, strlen(leaf), 1);
+    state->interval_samples++;
+}
+
+/**
+ * Consome os registros pendentes de um ring
+ * @return amostras lidas
+ */
+static int drain_ring(StackProfilerState *state, StackThread *t) {
+
+    struct perf_event_mmap_page *meta = t->ring;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    unsigned char *data = (unsigned char *)t->ring + (meta->data_offset ? meta->data_offset : page);
+    unsigned long long data_size = meta->data_size ? meta->data_size : (unsigned long long)page * STACK_RING_PAGES;
+
+    // data_head é escrito pelo kernel: leitura com acquire antes de tocar nos dados
+    unsigned long long head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+    unsigned long long tail = meta->data_tail;
+    int samples = 0;
+
+    unsigned long long record[STACK_MAX_DEPTH + 16];
+
+    while (tail < head) {
+        unsigned long long off = tail % data_size;
+        struct perf_event_header hdr;
+        memcpy(&hdr, data + off, sizeof(hdr));  // cabeçalho alinhado em 8 nunca cruza o fim
+
+        if (hdr.size < sizeof(hdr)) break;
+
+        // Registro que dá a volta no ring é remontado numa cópia contígua
+        const unsigned char *rec = data + off;
+        if (off + hdr.size > data_size) {
+            size_t first = (size_t)(data_size - off);
+            size_t copy = hdr.size <= sizeof(record) ? hdr.size : sizeof(record);
+            if (first > copy) first = copy;
+            memcpy(record, data + off, first);
+            memcpy((unsigned char *)record + first, data, copy - first);
+            rec = (const unsigned char *)record;
+        }
+
+        if (hdr.type == PERF_RECORD_SAMPLE) {
+            // ip, pid/tid, nr, ips[nr]
+            const unsigned long long *body = (const unsigned long long *)(const void *)(rec + sizeof(hdr));
+            unsigned long long sample_ip = body[0];
+            unsigned long long nr = body[2];
+            unsigned long long max_nr = (hdr.size - sizeof(hdr)) / sizeof(unsigned long long) - 3;
+            if (nr > max_nr) nr = max_nr;
+            record_sample(state, t, body + 3, nr, sample_ip);
+            samples++;
+        } else if (hdr.type == PERF_RECORD_LOST) {
+            // id, lost
+            const unsigned long long *body = (const unsigned long long *)(const void *)(rec + sizeof(hdr));
+            state->interval_lost += body[1];
+        }
+
+        tail += hdr.size;
+    }
+
+    // Libera o espaço para o kernel só depois de consumir os registros
+    __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+    return samples;
+}
+
+/* ---------------------- API ---------------------- */
+
+/**
+ * Inicializa o profiler de pilhas para um processo
+ * @param state Estado a inicializar
+ * @param pid Processo a amostrar
+ * @param freq_hz Amostras por segundo por thread (0 = STACK_DEFAULT_FREQ)
+ * @return 0 em sucesso, -1 em erro
+ */
+int stack_profiler_init(StackProfilerState *state, pid_t pid, int freq_hz) {
+
+    if (!state) {
+        fprintf(stderr, "Erro: ponteiro nulo em stack_profiler_init\n");
+        return -1;
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->pid = pid;
+    state->freq = freq_hz > 0 ? freq_hz : STACK_DEFAULT_FREQ;
+
+    if (!proc_root_is_live()) {
+        fprintf(stderr, "Erro: amostragem de pilhas precisa do /proc do kernel (raiz trocada)\n");
+        return -1;
+    }
+
+    // Com perf_event_paranoid >= 2 só user space é permitido sem privilégio
+    int probe = open_sampler(pid, state->freq, 0);
+    if (probe == -1 && (errno == EACCES || errno == EPERM)) {
+        state->exclude_kernel = 1;
+        probe = open_sampler(pid, state->freq, 1);
+    }
+    if (probe == -1) {
+        fprintf(stderr, "Erro: perf_event_open falhou para PID %d: %s\n", (int)pid, strerror(errno));
+        return -1;
+    }
+    close(probe);
+
+    Symbolizer *sym = malloc(sizeof(*sym));
+    if (!sym || symbolizer_init(sym, pid) < 0) {
+        free(sym);
+        return -1;
+    }
+    state->symbolizer = sym;
+
+    if (folded_grow(&state->stacks) < 0 || folded_grow(&state->leaves) < 0 ||
+        scan_threads(state) <= 0) {
+        fprintf(stderr, "Erro: nao foi possivel amostrar as threads do PID %d\n", (int)pid);
+        stack_profiler_free(state);
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &state->last_ts);
+    return 0;
+}
+
+/**
+ * Consome as amostras pendentes de todos os rings. Deve ser chamado com
+ * frequência suficiente para o ring não encher (64 páginas comportam
+ * alguns segundos a 99 Hz).
+ * @return amostras lidas, ou -1 em erro
+ */
+int stack_profiler_poll(StackProfilerState *state) {
+
+    if (!state || !state->symbolizer) {
+        fprintf(stderr, "Erro: estado invalido em stack_profiler_poll\n");
+        return -1;
+    }
+
+    int samples = 0;
+    for (int i = 0; i < state->nthreads; i++) {
+        samples += drain_ring(state, &state->threads[i]);
+    }
+    return samples;
+}
+
+/**
+ * Fecha o intervalo corrente: resume as amostras desde a chamada anterior,
+ * abre samplers para threads novas e relê maps se surgiram endereços fora
+ * das regiões conhecidas (dlopen, JIT).
+ * @param interval Recebe o resumo; cpu_percent fica para quem chama
+ * @return 0 em sucesso, -1 se o processo terminou
+ */
+int stack_profiler_interval(StackProfilerState *state, StackInterval *interval) {
+
+    if (!state || !interval) {
+        fprintf(stderr, "Erro: ponteiro nulo em stack_profiler_interval\n");
+        return -1;
+    }
+
+    stack_profiler_poll(state);
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = timespec_diff_sec(state->last_ts, now);
+    state->last_ts = now;
+
+    memset(interval, 0, sizeof(*interval));
+    interval->pid = state->pid;
+    interval->timestamp = time(NULL);
+    interval->samples = state->interval_samples;
+    interval->lost = state->interval_lost;
+    if (elapsed > 0) {
+        interval->sampled_cpu_percent = (double)state->interval_samples / ((double)state->freq * elapsed) * 100.0;
+    }
+
+    const FoldedEntry *top = NULL;
+    for (size_t i = 0; i < state->leaves.capacity; i++) {
+        const FoldedEntry *e = &state->leaves.entries[i];
+        if (e->stack && (!top || e->count > top->count)) top = e;
+    }
+    if (top) {
+        snprintf(interval->top_function, sizeof(interval->top_function), "%s", top->stack);
+        interval->top_percent = (double)top->count / (double)state->interval_samples * 100.0;
+    } else {
+        snprintf(interval->top_function, sizeof(interval->top_function), "-");
+    }
+
+    state->total_samples += state->interval_samples;
+    state->total_lost += state->interval_lost;
+    state->interval_samples = 0;
+    state->interval_lost = 0;
+    folded_clear(&state->leaves);
+
+    Symbolizer *sym = state->symbolizer;
+    if (sym->unmapped != state->unknown_seen) {
+        symbolizer_reload_maps(sym);
+        state->unknown_seen = sym->unmapped;
+    }
+
+    if (scan_threads(state) < 0) return -1;
+
+    interval->threads = state->nthreads;
+    return 0;
+}
+
+static int compare_entries_desc(const void *a, const void *b) {
+    const FoldedEntry *x = *(const FoldedEntry *const *)a;
+    const FoldedEntry *y = *(const FoldedEntry *const *)b;
+    if (x->count != y->count) return x->count < y->count ? 1 : -1;
+    return strcmp(x->stack, y->stack);
+}
+
+/**
+ * Escreve o perfil acumulado no formato folded ("frame;frame;... N"),
+ * mais amostradas primeiro, pronto para flamegraph.pl / speedscope
+ * @return 0 em sucesso, -1 em erro
+ */
+int stack_profiler_write_folded(const StackProfilerState *state, FILE *fp) {
+
+    if (!state || !fp) {
+        fprintf(stderr, "Erro: ponteiro nulo em stack_profiler_write_folded\n");
+        return -1;
+    }
+
+    const FoldedEntry **sorted = malloc((state->stacks.count + 1) * sizeof(*sorted));
+    if (!sorted) return -1;
+
+    size_t n = 0;
+    for (size_t i = 0; i < state->stacks.capacity; i++) {
+        if (state->stacks.entries[i].stack) sorted[n++] = &state->stacks.entries[i];
+    }
+    qsort(sorted, n, sizeof(*sorted), compare_entries_desc);
+
+    int rc = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (fprintf(fp, "%s %llu\n", sorted[i]->stack, sorted[i]->count) < 0) {
+            fprintf(stderr, "Erro: nao foi possivel escrever pilhas\n");
+            rc = -1;
+            break;
+        }
+    }
+
+    free(sorted);
+    return rc;
+}
+
+void stack_profiler_free(StackProfilerState *state) {
+    if (!state) return;
+
+    for (int i = 0; i < state->nthreads; i++) detach_thread(&state->threads[i]);
+    free(state->threads);
+
+    if (state->symbolizer) {
+        symbolizer_free(state->symbolizer);
+        free(state->symbolizer);
+    }
+
+    folded_free(&state->stacks);
+    folded_free(&state->leaves);
+    memset(state, 0, sizeof(*state));
+}
+
+static FILE *stack_csv_file = NULL;  // arquivo CSV da linha do tempo do profiler
+
+int stack_interval_csv_write(const StackInterval *interval) {
+    if (!interval) {
+        fprintf(stderr, "Erro: ponteiro nulo em stack_interval_csv_write\n");
+        return -1;
+    }
+
+    // cria o arquivo na primeira chamada
+    if (!stack_csv_file) {
+        struct tm *tm_info = localtime(&interval->timestamp);
+        char filename[64];
+        snprintf(filename, sizeof(filename),
+                 "profile-timeline-%04d%02d%02d_%02d%02d%02d.csv",
+                 tm_info->tm_year + 1900,
+                 tm_info->tm_mon + 1,
+                 tm_info->tm_mday,
+                 tm_info->tm_hour,
+                 tm_info->tm_min,
+                 tm_info->tm_sec);
+
+        stack_csv_file = fopen(filename, "w");
+        if (!stack_csv_file) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", filename);
+            return -1;
+        }
+
+        fprintf(stack_csv_file,
+                "timestamp,pid,cpu_percent,sampled_cpu_percent,samples,lost,threads,"
+                "top_function,top_percent\n");
+        fflush(stack_csv_file);
+    }
+
+    if (fprintf(stack_csv_file, "%lld,%d,%.2f,%.2f,%llu,%llu,%d,\"%s\",%.1f\n",
+                (long long)interval->timestamp,
+                (int)interval->pid,
+                interval->cpu_percent,
+                interval->sampled_cpu_percent,
+                interval->samples,
+                interval->lost,
+                interval->threads,
+                interval->top_function,
+                interval->top_percent) < 0) {
+        fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+        return -1;
+    }
+
+    fflush(stack_csv_file);
+    return 0;
+}
+
+void stack_interval_csv_close(void) {
+    if (stack_csv_file) {
+        fclose(stack_csv_file);
+        stack_csv_file = NULL;
+    }
+}
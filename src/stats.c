@@ -0,0 +1,350 @@
+#define _GNU_SOURCE
+#include "stats.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ------------------------- RESUMO DE UMA MÉTRICA ------------------------- */
+
+void stream_stats_init(StreamStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+/**
+ * Faixa do histograma de um valor positivo
+ * @return 0 com octave/sub preenchidos, -1 se o valor conta como zero
+ */
+static int bucket_of(double value, int *octave, int *sub) {
+
+    int exp;
+    double frac = frexp(value, &exp);   // value = frac * 2^exp, frac em [0.5, 1)
+    int o = exp - 1 - STATS_MIN_EXP;    // value em [2^(exp-1), 2^exp)
+    if (frac == 0.0 || o < 0) return -1; // frexp(0) dá exp = 0, não um expoente pequeno
+
+    if (o >= STATS_OCTAVES) {           // acima de 2^48: última faixa (max continua exato)
+        *octave = STATS_OCTAVES - 1;
+        *sub = STATS_SUB_BUCKETS - 1;
+        return 0;
+    }
+    *octave = o;
+    *sub = (int)((frac * 2.0 - 1.0) * STATS_SUB_BUCKETS);
+    return 0;
+}
+
+// Ponto médio da faixa: o erro relativo fica em no máximo meia faixa
+static double bucket_value(int octave, int sub) {
+    return ldexp(1.0 + (sub + 0.5) / STATS_SUB_BUCKETS, octave + STATS_MIN_EXP);
+}
+
+int stream_stats_add(StreamStats *stats, double value) {
+
+    if (!isfinite(value)) return 0;
+
+    stats->count++;
+    if (stats->count == 1 || value < stats->min) stats->min = value;
+    if (stats->count == 1 || value > stats->max) stats->max = value;
+    stats->last = value;
+
+    double delta = value - stats->mean;
+    stats->mean += delta / (double)stats->count;
+    stats->m2 += delta * (value - stats->mean);
+
+    int octave, sub;
+    if (bucket_of(fabs(value), &octave, &sub) != 0) {
+        stats->zeros++;
+        return 0;
+    }
+
+    unsigned **slot = value > 0 ? &stats->pos[octave] : &stats->neg[octave];
+    if (!*slot) {
+        *slot = calloc(STATS_SUB_BUCKETS, sizeof(unsigned));
+        if (!*slot) return -1;
+    }
+    (*slot)[sub]++;
+    return 0;
+}
+
+double stream_stats_stddev(const StreamStats *stats) {
+    return stats->count > 1 ? sqrt(stats->m2 / (double)(stats->count - 1)) : 0.0;
+}
+
+static double clamp_range(const StreamStats *stats, double value) {
+    if (value < stats->min) return stats->min;
+    if (value > stats->max) return stats->max;
+    return value;
+}
+
+double stream_stats_percentile(const StreamStats *stats, double q) {
+
+    if (stats->count == 0) return 0.0;
+
+    unsigned long long rank = (unsigned long long)ceil(q * (double)stats->count);
+    if (rank == 0) rank = 1;
+    if (rank > stats->count) rank = stats->count;
+
+    // Do mais negativo ao mais positivo: negativos com |v| decrescente, zeros, positivos
+    unsigned long long seen = 0;
+    for (int o = STATS_OCTAVES - 1; o >= 0; o--) {
+        if (!stats->neg[o]) continue;
+        for (int s = STATS_SUB_BUCKETS - 1; s >= 0; s--) {
+            seen += stats->neg[o][s];
+            if (seen >= rank) return clamp_range(stats, -bucket_value(o, s));
+        }
+    }
+
+    seen += stats->zeros;
+    if (seen >= rank) return clamp_range(stats, 0.0);
+
+    for (int o = 0; o < STATS_OCTAVES; o++) {
+        if (!stats->pos[o]) continue;
+        for (int s = 0; s < STATS_SUB_BUCKETS; s++) {
+            seen += stats->pos[o][s];
+            if (seen >= rank) return clamp_range(stats, bucket_value(o, s));
+        }
+    }
+    return stats->max;  // oitavas que não puderam ser alocadas
+}
+
+void stream_stats_free(StreamStats *stats) {
+    for (int o = 0; o < STATS_OCTAVES; o++) {
+        free(stats->pos[o]);
+        free(stats->neg[o]);
+    }
+    stream_stats_init(stats);
+}
+
+/* --------------------------- RESUMO POR ALVO --------------------------- */
+
+void stats_table_init(StatsTable *table) {
+    memset(table, 0, sizeof(*table));
+}
+
+// Posição do alvo no vetor ordenado por pid (ou onde ele entraria)
+static size_t find_target(const StatsTable *table, pid_t pid, int *found) {
+
+    if (table->hint < table->count && table->targets[table->hint]->pid == pid) {
+        *found = 1;
+        return table->hint;
+    }
+
+    size_t lo = 0, hi = table->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (table->targets[mid]->pid < pid) lo = mid + 1;
+        else hi = mid;
+    }
+    *found = lo < table->count && table->targets[lo]->pid == pid;
+    return lo;
+}
+
+static TargetStats *insert_target(StatsTable *table, size_t at, pid_t pid) {
+
+    if (table->count >= STATS_MAX_TARGETS) return NULL;
+
+    if (table->count == table->capacity) {
+        size_t cap = table->capacity ? table->capacity * 2 : 16;
+        TargetStats **grown = realloc(table->targets, cap * sizeof(*grown));
+        if (!grown) return NULL;
+        table->targets = grown;
+        table->capacity = cap;
+    }
+
+    TargetStats *target = calloc(1, sizeof(*target));
+    if (!target) return NULL;
+    target->pid = pid;
+
+    memmove(&table->targets[at + 1], &table->targets[at], (table->count - at) * sizeof(*table->targets));
+    table->targets[at] = target;
+    table->count++;
+    return target;
+}
+
+int stats_table_add(StatsTable *table, const SampleRecord *record) {
+
+    if (!table || !record) return -1;
+
+    int found;
+    size_t at = find_target(table, record->pid, &found);
+    TargetStats *target = found ? table->targets[at] : insert_target(table, at, record->pid);
+    if (!target) {
+        table->ignored++;
+        return -1;
+    }
+    table->hint = at;
+
+    time_t t = sample_record_time(record);
+    if (target->samples == 0) target->first = t;
+    target->last = t;
+    target->samples++;
+
+    int rc = 0;
+    for (int i = 0; i < SAMPLE_METRIC_COUNT; i++) {
+        if (!(record->flags & sample_metrics[i].flag)) continue;
+        if (stream_stats_add(&target->metrics[i], sample_metric_value(record, i)) != 0) rc = -1;
+    }
+    return rc;
+}
+
+static void format_time(time_t t, char *buf, size_t size) {
+    struct tm tm_buf;
+    struct tm *tm_info = localtime_r(&t, &tm_buf);
+    strftime(buf, size, "%Y-%m-%d %H:%M:%S", tm_info);
+}
+
+void stats_table_print(const StatsTable *table, FILE *fp) {
+
+    if (!table || !fp) return;
+
+    fprintf(fp, "\n===== RESUMO DAS METRICAS =====\n");
+    if (table->count == 0) fprintf(fp, "Sem amostras\n");
+
+    for (size_t t = 0; t < table->count; t++) {
+        const TargetStats *target = table->targets[t];
+        char from[32], to[32];
+        format_time(target->first, from, sizeof(from));
+        format_time(target->last, to, sizeof(to));
+        fprintf(fp, "PID %d: %llu amostras de %s a %s\n", (int)target->pid, target->samples, from, to);
+        fprintf(fp, "  %-26s %8s %10s %10s %10s %10s %10s %10s %10s %10s\n",
+                "METRICA", "N", "MIN", "MEDIA", "DESVIO", "P50", "P90", "P99", "P99.9", "MAX");
+
+        for (int i = 0; i < SAMPLE_METRIC_COUNT; i++) {
+            const StreamStats *s = &target->metrics[i];
+            if (s->count == 0) continue;
+            fprintf(fp, "  %-26s %8llu %10.4g %10.4g %10.4g %10.4g %10.4g %10.4g %10.4g %10.4g\n",
+                    sample_metrics[i].name, s->count, s->min, s->mean, stream_stats_stddev(s),
+                    stream_stats_percentile(s, 0.50), stream_stats_percentile(s, 0.90),
+                    stream_stats_percentile(s, 0.99), stream_stats_percentile(s, 0.999), s->max);
+        }
+    }
+    if (table->ignored) fprintf(fp, "%llu amostras ignoradas (mais de %d alvos)\n", table->ignored, STATS_MAX_TARGETS);
+}
+
+int stats_table_write_csv(const StatsTable *table, const char *path) {
+
+    if (!table || !path) {
+        fprintf(stderr, "Erro: ponteiro nulo em stats_table_write_csv\n");
+        return -1;
+    }
+
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "w");
+    if (!fp) {
+        fprintf(stderr, "Erro: nao foi possivel criar %s\n", tmp);
+        return -1;
+    }
+
+    // Escreve o cabeçalho do CSV
+    fprintf(fp, "pid,metric,unit,count,min,max,mean,stddev,p50,p90,p99,p999,last,first_timestamp,last_timestamp\n");
+
+    for (size_t t = 0; t < table->count; t++) {
+        const TargetStats *target = table->targets[t];
+        for (int i = 0; i < SAMPLE_METRIC_COUNT; i++) {
+            const StreamStats *s = &target->metrics[i];
+            if (s->count == 0) continue;
+            fprintf(fp, "%d,%s,%s,%llu,%.10g,%.10g,%.10g,%.10g,%.10g,%.10g,%.10g,%.10g,%.10g,%lld,%lld\n",
+                    (int)target->pid, sample_metrics[i].name, sample_metrics[i].unit, s->count,
+                    s->min, s->max, s->mean, stream_stats_stddev(s),
+                    stream_stats_percentile(s, 0.50), stream_stats_percentile(s, 0.90),
+                    stream_stats_percentile(s, 0.99), stream_stats_percentile(s, 0.999), s->last,
+                    (long long)target->first, (long long)target->last);
+        }
+    }
+
+    if (fclose(fp) != 0 || rename(tmp, path) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel gravar %s\n", path);
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+void stats_table_free(StatsTable *table) {
+    if (!table) return;
+    for (size_t t = 0; t < table->count; t++) {
+        for (int i = 0; i < SAMPLE_METRIC_COUNT; i++) stream_stats_free(&table->targets[t]->metrics[i]);
+        free(table->targets[t]);
+    }
+    free(table->targets);
+    stats_table_init(table);
+}
+
+/* ------------------------------ DESTINO ------------------------------ */
+
+typedef struct {
+    StatsTable table;
+    int interval_sec;
+    time_t next_report;
+    unsigned long long added;      // registros recebidos
+    unsigned long long reported;   // registros no último resumo impresso
+    char path[256];   // vazio até a primeira coleta
+} SummarySink;
+
+static void summary_report(SummarySink *sum) {
+    sum->reported = sum->added;
+    stats_table_print(&sum->table, stdout);
+    fflush(stdout);
+    if (sum->path[0]) stats_table_write_csv(&sum->table, sum->path);
+}
+
+static int summary_write(SampleSink *sink, const SampleRecord *record) {
+
+    SummarySink *sum = sink->ctx;
+    time_t t = sample_record_time(record);
+
+    // nome do arquivo pela primeira coleta, como os CSVs das amostras
+    if (!sum->path[0]) {
+        struct tm tm_buf;
+        struct tm *tm_info = localtime_r(&t, &tm_buf);
+        snprintf(sum->path, sizeof(sum->path),
+                 "summary-%04d%02d%02d_%02d%02d%02d.csv",
+                 tm_info->tm_year + 1900,
+                 tm_info->tm_mon + 1,
+                 tm_info->tm_mday,
+                 tm_info->tm_hour,
+                 tm_info->tm_min,
+                 tm_info->tm_sec);
+        sum->next_report = t + sum->interval_sec;
+    }
+
+    int rc = stats_table_add(&sum->table, record);
+    sum->added++;
+
+    // O relógio é o das amostras: na reprodução de uma captura os
+    // intervalos seguem o tempo gravado, não o da máquina
+    if (sum->interval_sec > 0 && t >= sum->next_report) {
+        summary_report(sum);
+        while (sum->next_report <= t) sum->next_report += sum->interval_sec;
+    }
+    return rc;
+}
+
+static void summary_close(SampleSink *sink) {
+    SummarySink *sum = sink->ctx;
+    if (!sum) return;
+    if (sum->reported != sum->added || sum->added == 0) summary_report(sum);  // sem repetir o último resumo
+    if (sum->path[0]) printf("Resumo salvo em %s\n", sum->path);
+    stats_table_free(&sum->table);
+    free(sum);
+    sink->ctx = NULL;
+}
+
+int sample_sink_summary(SampleSink *sink, int interval_sec) {
+
+    if (!sink) return -1;
+    memset(sink, 0, sizeof(*sink));
+
+    SummarySink *sum = calloc(1, sizeof(*sum));
+    if (!sum) return -1;
+    stats_table_init(&sum->table);
+    sum->interval_sec = interval_sec > 0 ? interval_sec : 0;
+
+    sink->name = "resumo";
+    sink->write = summary_write;
+    sink->close = summary_close;
+    sink->ctx = sum;
+    return 0;
+}
@@ -0,0 +1,330 @@
+#define _GNU_SOURCE
+#include "symbolizer.h"
+#include "proc_parse.h"
+
+#include <elf.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int compare_syms(const void *a, const void *b) {
+    const SymbolEntry *x = a;
+    const SymbolEntry *y = b;
+    return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+static int compare_maps(const void *a, const void *b) {
+    const SymbolMap *x = a;
+    const SymbolMap *y = b;
+    return (x->start > y->start) - (x->start < y->start);
+}
+
+static const char *keep_name(Symbolizer *sym, const char *text) {
+    if (sym->nowned == sym->owned_capacity) {
+        size_t cap = sym->owned_capacity ? sym->owned_capacity * 2 : 256;
+        char **owned = realloc(sym->owned, cap * sizeof(*owned));
+        if (!owned) return "[unknown]";
+        sym->owned = owned;
+        sym->owned_capacity = cap;
+    }
+    char *copy = strdup(text);
+    if (!copy) return "[unknown]";
+    sym->owned[sym->nowned++] = copy;
+    return copy;
+}
+
+/**
+ * Coleta os símbolos de função de uma seção SHT_SYMTAB/SHT_DYNSYM
+ */
+static int load_symtab(ElfSymbols *elf, const Elf64_Shdr *shdrs, int nsections, int type) {
+
+    const unsigned char *base = elf->image;
+
+    for (int i = 0; i < nsections; i++) {
+        const Elf64_Shdr *sh = &shdrs[i];
+        if ((int)sh->sh_type != type || sh->sh_entsize != sizeof(Elf64_Sym)) continue;
+        if (sh->sh_link >= (unsigned)nsections) continue;
+
+        const Elf64_Shdr *strsh = &shdrs[sh->sh_link];
+        if (sh->sh_offset + sh->sh_size > elf->image_size ||
+            strsh->sh_offset + strsh->sh_size > elf->image_size) continue;
+
+        const Elf64_Sym *syms = (const Elf64_Sym *)(const void *)(base + sh->sh_offset);
+        const char *strtab = (const char *)base + strsh->sh_offset;
+        size_t count = sh->sh_size / sizeof(Elf64_Sym);
+
+        SymbolEntry *out = realloc(elf->syms, (elf->nsyms + count) * sizeof(*out));
+        if (!out) return -1;
+        elf->syms = out;
+
+        for (size_t s = 0; s < count; s++) {
+            if (ELF64_ST_TYPE(syms[s].st_info) != STT_FUNC || syms[s].st_value == 0) continue;
+            if (syms[s].st_name >= strsh->sh_size) continue;
+            SymbolEntry *e = &elf->syms[elf->nsyms++];
+            e->addr = syms[s].st_value;
+            e->size = syms[s].st_size;
+            e->name = strtab + syms[s].st_name;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Mapeia o arquivo ELF (visto pela raiz do processo, para funcionar dentro
+ * de containers) e monta a tabela ordenada de funções.
+ */
+static int load_elf(pid_t pid, ElfSymbols *elf) {
+
+    char path[4096 + 64];
+    snprintf(path, sizeof(path), "%s/%d/root%s", proc_root(), (int)pid, elf->path);
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(Elf64_Ehdr)) {
+        close(fd);
+        return -1;
+    }
+
+    void *image = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) return -1;
+
+    elf->image = image;
+    elf->image_size = (size_t)st.st_size;
+
+    const Elf64_Ehdr *eh = image;
+    if (memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 || eh->e_ident[EI_CLASS] != ELFCLASS64 ||
+        eh->e_shoff + (unsigned long long)eh->e_shnum * sizeof(Elf64_Shdr) > elf->image_size ||
+        eh->e_phoff + (unsigned long long)eh->e_phnum * sizeof(Elf64_Phdr) > elf->image_size) {
+        return -1;
+    }
+
+    const Elf64_Phdr *ph = (const Elf64_Phdr *)(const void *)((const char *)image + eh->e_phoff);
+    for (int i = 0; i < eh->e_phnum && elf->nsegments < 16; i++) {
+        if (ph[i].p_type != PT_LOAD) continue;
+        ElfSegment *seg = &elf->segments[elf->nsegments++];
+        seg->offset = ph[i].p_offset;
+        seg->vaddr = ph[i].p_vaddr;
+        seg->filesz = ph[i].p_filesz;
+    }
+
+    const Elf64_Shdr *sh = (const Elf64_Shdr *)(const void *)((const char *)image + eh->e_shoff);
+    if (load_symtab(elf, sh, eh->e_shnum, SHT_SYMTAB) < 0) return -1;
+
+    // Binário sem .symtab (strip): usa os símbolos exportados
+    if (elf->nsyms == 0 && load_symtab(elf, sh, eh->e_shnum, SHT_DYNSYM) < 0) return -1;
+
+    qsort(elf->syms, elf->nsyms, sizeof(*elf->syms), compare_syms);
+    return 0;
+}
+
+static int find_or_add_file(Symbolizer *sym, const char *path, size_t len) {
+
+    for (size_t i = 0; i < sym->nfiles; i++) {
+        if (strlen(sym->files[i].path) == len && memcmp(sym->files[i].path, path, len) == 0) return (int)i;
+    }
+
+    ElfSymbols *files = realloc(sym->files, (sym->nfiles + 1) * sizeof(*files));
+    if (!files) return -1;
+    sym->files = files;
+
+    ElfSymbols *elf = &sym->files[sym->nfiles];
+    memset(elf, 0, sizeof(*elf));
+    elf->path = strndup(path, len);
+    if (!elf->path) return -1;
+    const char *slash = strrchr(elf->path, '/');
+    elf->base_name = slash ? slash + 1 : elf->path;
+
+    // Falha ao carregar não é erro: os endereços saem como arquivo+offset
+    load_elf(sym->pid, elf);
+
+    return (int)sym->nfiles++;
+}
+
+int symbolizer_reload_maps(Symbolizer *sym) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/maps", proc_root(), (int)sym->pid);
+
+    char *buf = NULL;
+    size_t capacity = 0;
+    ssize_t len = proc_read_file_dyn(path, &buf, &capacity);
+    if (len < 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
+        free(buf);
+        return -1;
+    }
+
+    sym->nmaps = 0;
+    size_t maps_capacity = 0;
+    const char *p = buf;
+    const char *end = buf + len;
+
+    while (p < end) {
+        const char *next = proc_next_line(p, end);
+        const char *line_end = (next > p && next[-1] == '\n') ? next - 1 : next;
+        unsigned long long start = 0, stop = 0, offset = 0;
+
+        const char *q = proc_parse_hex(p, line_end, &start);
+        if (q && q < line_end && *q == '-') q = proc_parse_hex(q + 1, line_end, &stop);
+
+        // Só interessam regiões executáveis ("r-xp")
+        if (!q || line_end - q < 5 || q[3] != 'x') {
+            p = next;
+            continue;
+        }
+        q = proc_parse_hex(q + 5, line_end, &offset);
+        const char *name = q ? proc_skip_fields(q, line_end, 2) : NULL;  // pula dev e inode
+
+        if (sym->nmaps == maps_capacity) {
+            maps_capacity = maps_capacity ? maps_capacity * 2 : 64;
+            SymbolMap *maps = realloc(sym->maps, maps_capacity * sizeof(*maps));
+            if (!maps) {
+                free(buf);
+                return -1;
+            }
+            sym->maps = maps;
+        }
+
+        SymbolMap *m = &sym->maps[sym->nmaps++];
+        m->start = start;
+        m->end = stop;
+        m->offset = offset;
+        m->file = (name && *name == '/') ? find_or_add_file(sym, name, (size_t)(line_end - name)) : -1;
+
+        p = next;
+    }
+
+    free(buf);
+    qsort(sym->maps, sym->nmaps, sizeof(*sym->maps), compare_maps);
+    memset(sym->cache, 0, sizeof(sym->cache));
+    return 0;
+}
+
+/**
+ * Inicializa o simbolizador lendo as regiões executáveis do processo
+ * @param sym Estado a inicializar
+ * @param pid Processo cujos endereços serão traduzidos
+ * @return 0 em sucesso, -1 em erro
+ */
+int symbolizer_init(Symbolizer *sym, pid_t pid) {
+
+    if (!sym) {
+        fprintf(stderr, "Erro: ponteiro nulo em symbolizer_init\n");
+        return -1;
+    }
+
+    memset(sym, 0, sizeof(*sym));
+    sym->pid = pid;
+
+    if (symbolizer_reload_maps(sym) < 0) {
+        symbolizer_free(sym);
+        return -1;
+    }
+    return 0;
+}
+
+static const SymbolMap *find_map(const Symbolizer *sym, unsigned long long ip) {
+    size_t lo = 0, hi = sym->nmaps;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (sym->maps[mid].end <= ip) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < sym->nmaps && sym->maps[lo].start <= ip) return &sym->maps[lo];
+    return NULL;
+}
+
+static const char *resolve(Symbolizer *sym, unsigned long long ip) {
+
+    const SymbolMap *m = find_map(sym, ip);
+    if (!m) {
+        sym->unmapped++;
+        return "[unknown]";
+    }
+    if (m->file < 0) return "[anon]";
+
+    const ElfSymbols *elf = &sym->files[m->file];
+    unsigned long long file_off = ip - m->start + m->offset;
+
+    // Offset no arquivo -> endereço virtual do ELF pelo segmento PT_LOAD
+    unsigned long long vaddr = 0;
+    int found = 0;
+    for (int s = 0; s < elf->nsegments; s++) {
+        const ElfSegment *seg = &elf->segments[s];
+        if (file_off >= seg->offset && file_off < seg->offset + seg->filesz) {
+            vaddr = file_off - seg->offset + seg->vaddr;
+            found = 1;
+            break;
+        }
+    }
+
+    if (found && elf->nsyms > 0) {
+        // Último símbolo com addr <= vaddr
+        size_t lo = 0, hi = elf->nsyms;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (elf->syms[mid].addr <= vaddr) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo > 0) {
+            const SymbolEntry *e = &elf->syms[lo - 1];
+            if (e->size == 0 || vaddr < e->addr + e->size) return e->name;
+        }
+    }
+
+    char text[512];
+    snprintf(text, sizeof(text), "%s+0x%llx", elf->base_name, file_off);
+    return keep_name(sym, text);
+}
+
+const char *symbolizer_lookup(Symbolizer *sym, unsigned long long ip) {
+
+    if (!sym || ip == 0) return "[unknown]";
+    sym->lookups++;
+
+    // Cache de mapeamento direto com sondagem linear curta
+    unsigned h = (unsigned)((ip * 0x9E3779B97F4A7C15ULL) >> 51) & (SYMBOLIZER_CACHE_SLOTS - 1);
+    for (int probe = 0; probe < 8; probe++) {
+        SymbolCacheSlot *slot = &sym->cache[(h + (unsigned)probe) & (SYMBOLIZER_CACHE_SLOTS - 1)];
+        if (slot->ip == ip) {
+            sym->cache_hits++;
+            return slot->name;
+        }
+        if (slot->ip == 0) {
+            slot->ip = ip;
+            slot->name = resolve(sym, ip);
+            return slot->name;
+        }
+    }
+
+    // Vizinhança cheia: sobrescreve o primeiro slot
+    SymbolCacheSlot *slot = &sym->cache[h];
+    slot->ip = ip;
+    slot->name = resolve(sym, ip);
+    return slot->name;
+}
+
+void symbolizer_free(Symbolizer *sym) {
+    if (!sym) return;
+
+    for (size_t i = 0; i < sym->nfiles; i++) {
+        if (sym->files[i].image) munmap(sym->files[i].image, sym->files[i].image_size);
+        free(sym->files[i].syms);
+        free(sym->files[i].path);
+    }
+    free(sym->files);
+    free(sym->maps);
+
+    for (size_t i = 0; i < sym->nowned; i++) free(sym->owned[i]);
+    free(sym->owned);
+
+    memset(sym, 0, sizeof(*sym));
+}
@@ -0,0 +1,337 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "proc_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Converte a diferença entre duas leituras de uma linha "cpu" em percentuais
+ *
+ * guest e guest_nice já estão contabilizados em user e nice pelo kernel,
+ * por isso ficam fora do total (senão seriam contados duas vezes)
+ */
+static void compute_usage(const unsigned long long *prev,
+                          const unsigned long long *curr,
+                          CoreCpuUsage *usage) {
+
+    unsigned long long delta[CPU_STAT_FIELDS];
+    unsigned long long total = 0;
+
+    for (int i = 0; i < CPU_STAT_FIELDS; i++) {
+        // contadores podem "voltar" quando um core fica offline e volta
+        delta[i] = curr[i] >= prev[i] ? curr[i] - prev[i] : 0;
+        if (i < CPU_STAT_GUEST) total += delta[i];
+    }
+
+    usage->online = 1;
+    if (total == 0) {
+        usage->user_percent = usage->system_percent = usage->iowait_percent = 0.0;
+        usage->irq_percent = usage->softirq_percent = usage->steal_percent = 0.0;
+        usage->idle_percent = 100.0;
+        return;
+    }
+
+    double t = (double)total;
+    usage->user_percent    = 100.0 * (double)(delta[CPU_STAT_USER] + delta[CPU_STAT_NICE]) / t;
+    usage->system_percent  = 100.0 * (double)delta[CPU_STAT_SYSTEM] / t;
+    usage->idle_percent    = 100.0 * (double)delta[CPU_STAT_IDLE] / t;
+    usage->iowait_percent  = 100.0 * (double)delta[CPU_STAT_IOWAIT] / t;
+    usage->irq_percent     = 100.0 * (double)delta[CPU_STAT_IRQ] / t;
+    usage->softirq_percent = 100.0 * (double)delta[CPU_STAT_SOFTIRQ] / t;
+    usage->steal_percent   = 100.0 * (double)delta[CPU_STAT_STEAL] / t;
+}
+
+/**
+ * Lê os campos numéricos de uma linha "cpu"/"cpuN" (kernels antigos têm menos campos)
+ */
+static int parse_cpu_fields(const char *p, const char *end, unsigned long long *fields) {
+    int n = 0;
+    memset(fields, 0, CPU_STAT_FIELDS * sizeof(unsigned long long));
+    while (n < CPU_STAT_FIELDS && (p = proc_parse_u64(p, end, &fields[n])) != NULL) {
+        n++;
+    }
+    return n;
+}
+
+/**
+ * Compara o início da linha com um prefixo literal
+ */
+static int line_starts_with(const char *line, const char *end, const char *prefix, size_t len) {
+    return (size_t)(end - line) >= len && memcmp(line, prefix, len) == 0;
+}
+
+/**
+ * Lê /proc/stat inteiro em uma passada
+ *
+ * @param state Estado com os valores anteriores (atualizado com os atuais)
+ * @param sample Se não for NULL, recebe os percentuais calculados pelos deltas
+ * @return 0 em sucesso, -1 em erro
+ */
+static int read_proc_stat(SystemCpuState *state, SystemCpuSample *sample) {
+
+    // A linha "intr" tem uma coluna por IRQ e pode deixar o arquivo grande;
+    // se o buffer encher, dobra de tamanho e lê de novo
+    ssize_t len;
+    char path[PROC_PATH_MAX];
+    proc_path(path, sizeof(path), "stat");
+    while ((len = proc_read_file(path, state->buf, state->buf_size)) >= 0 &&
+           (size_t)len == state->buf_size - 1) {
+        char *tmp = realloc(state->buf, state->buf_size * 2);
+        if (!tmp) break;
+        state->buf = tmp;
+        state->buf_size *= 2;
+    }
+
+    if (len < 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir /proc/stat\n");
+        return -1;
+    }
+
+    for (int i = 0; i < state->max_cores; i++) {
+        state->cores[i].online = 0;
+    }
+
+    int got_total = 0;
+    unsigned long long ctxt = 0, intr = 0, running = 0, blocked = 0;
+    const char *end = state->buf + len;
+    const char *line = state->buf;
+
+    while (line < end) {
+        const char *next = proc_next_line(line, end);
+
+        if (line_starts_with(line, next, "cpu", 3)) {
+            unsigned long long fields[CPU_STAT_FIELDS];
+
+            if (line[3] == ' ') {
+                // linha agregada "cpu  user nice system ..."
+                if (parse_cpu_fields(line + 3, next, fields) >= 4) {
+                    if (sample) compute_usage(state->last_total, fields, &sample->total);
+                    memcpy(state->last_total, fields, sizeof(fields));
+                    got_total = 1;
+                }
+            } else {
+                unsigned long long core = 0;
+                const char *p = proc_parse_u64(line + 3, next, &core);
+                // cores além do tamanho definido na inicialização são ignorados
+                if (p && core < (unsigned long long)state->max_cores &&
+                    parse_cpu_fields(p, next, fields) >= 4) {
+                    compute_usage(state->last_cores[core], fields, &state->cores[core]);
+                    memcpy(state->last_cores[core], fields, sizeof(fields));
+                }
+            }
+        } else if (line_starts_with(line, next, "intr ", 5)) {
+            // só o primeiro número (o total) interessa
+            proc_parse_u64(line + 5, next, &intr);
+        } else if (line_starts_with(line, next, "ctxt ", 5)) {
+            proc_parse_u64(line + 5, next, &ctxt);
+        } else if (line_starts_with(line, next, "procs_running ", 14)) {
+            proc_parse_u64(line + 14, next, &running);
+        } else if (line_starts_with(line, next, "procs_blocked ", 14)) {
+            proc_parse_u64(line + 14, next, &blocked);
+        }
+
+        line = next;
+    }
+
+    if (!got_total) {
+        fprintf(stderr, "Erro: formato inesperado em /proc/stat\n");
+        return -1;
+    }
+
+    if (sample) {
+        sample->ctxt = ctxt;
+        sample->intr = intr;
+        sample->procs_running = running;
+        sample->procs_blocked = blocked;
+    }
+
+    state->last_ctxt = ctxt;
+    state->last_intr = intr;
+    return 0;
+}
+
+/**
+ * Inicializa o coletor de CPU do sistema
+ *
+ * @param state Ponteiro para estrutura de estado a ser inicializada
+ * @return 0 em sucesso, -1 em erro
+ *
+ * Os vetores por core são alocados uma única vez, com o número de CPUs
+ * configuradas no sistema; nenhuma alocação acontece nas amostras seguintes
+ */
+int system_cpu_init(SystemCpuState *state) {
+
+    if (!state) {
+        fprintf(stderr, "Erro: state nulo em system_cpu_init\n");
+        return -1;
+    }
+
+    memset(state, 0, sizeof(*state));
+
+    long ncpu = sysconf(_SC_NPROCESSORS_CONF);
+    if (ncpu <= 0) ncpu = 1;
+    state->max_cores = (int)ncpu;
+
+    state->last_cores = calloc((size_t)ncpu, sizeof(*state->last_cores));
+    state->cores = calloc((size_t)ncpu, sizeof(CoreCpuUsage));
+    state->buf_size = 8192;
+    state->buf = malloc(state->buf_size);
+    if (!state->last_cores || !state->cores || !state->buf) {
+        fprintf(stderr, "Erro: sem memoria em system_cpu_init\n");
+        system_cpu_free(state);
+        return -1;
+    }
+
+    if (read_proc_stat(state, NULL) < 0) {
+        fprintf(stderr, "Erro em system_cpu_init: nao foi possivel ler /proc/stat\n");
+        system_cpu_free(state);
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &state->last_ts);
+    return 0;
+}
+
+/**
+ * Coleta uma amostra de uso de CPU por core e contadores globais do sistema
+ *
+ * @param state Ponteiro para estrutura de estado (mantém valores anteriores)
+ * @param sample Ponteiro para estrutura que receberá os dados coletados
+ * @return 0 em sucesso, -1 em erro
+ */
+int system_cpu_sample(SystemCpuState *state, SystemCpuSample *sample) {
+
+    if (!state || !sample || !state->cores) {
+        fprintf(stderr, "Erro: ponteiro nulo em system_cpu_sample\n");
+        return -1;
+    }
+
+    unsigned long long prev_ctxt = state->last_ctxt;
+    unsigned long long prev_intr = state->last_intr;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double interval_sec = (double)(now.tv_sec - state->last_ts.tv_sec) +
+                          (double)(now.tv_nsec - state->last_ts.tv_nsec) / 1e9;
+
+    if (read_proc_stat(state, sample) < 0) {
+        fprintf(stderr, "Erro em system_cpu_sample: nao foi possivel ler /proc/stat\n");
+        return -1;
+    }
+
+    sample->timestamp = time(NULL);
+    sample->num_cores = state->max_cores;
+    sample->cores = state->cores;
+    sample->ctxt_per_sec = 0.0;
+    sample->intr_per_sec = 0.0;
+
+    if (interval_sec > 0.0) {
+        if (sample->ctxt >= prev_ctxt)
+            sample->ctxt_per_sec = (double)(sample->ctxt - prev_ctxt) / interval_sec;
+        if (sample->intr >= prev_intr)
+            sample->intr_per_sec = (double)(sample->intr - prev_intr) / interval_sec;
+    }
+
+    state->last_ts = now;
+    return 0;
+}
+
+/**
+ * Libera os vetores alocados por system_cpu_init
+ */
+void system_cpu_free(SystemCpuState *state) {
+    if (!state) return;
+    free(state->last_cores);
+    free(state->cores);
+    free(state->buf);
+    state->last_cores = NULL;
+    state->cores = NULL;
+    state->buf = NULL;
+    state->buf_size = 0;
+    state->max_cores = 0;
+}
+
+static FILE *system_cpu_csv_file = NULL;  // arquivo CSV para CPU do sistema
+
+static int write_core_row(const SystemCpuSample *sample, const char *core, const CoreCpuUsage *u) {
+    return fprintf(system_cpu_csv_file,
+                   "%lld,%s,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%llu,%llu\n",
+                   (long long)sample->timestamp,
+                   core,
+                   u->user_percent,
+                   u->system_percent,
+                   u->idle_percent,
+                   u->iowait_percent,
+                   u->irq_percent,
+                   u->softirq_percent,
+                   u->steal_percent,
+                   sample->ctxt_per_sec,
+                   sample->intr_per_sec,
+                   sample->procs_running,
+                   sample->procs_blocked);
+}
+
+/**
+ * Escreve uma linha por core (mais a linha "all") para a amostra
+ */
+int system_cpu_csv_write(const SystemCpuSample *sample) {
+    if (!sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em system_cpu_csv_write\n");
+        return -1;
+    }
+
+    // cria o arquivo na primeira chamada
+    if (!system_cpu_csv_file) {
+        // Formata o timestamp para o nome do arquivo (YYYYMMDD_HHMMSS)
+        struct tm *tm_info = localtime(&sample->timestamp);
+        char filename[64];
+        snprintf(filename, sizeof(filename),
+                 "system-cpu-%04d%02d%02d_%02d%02d%02d.csv",
+                 tm_info->tm_year + 1900,
+                 tm_info->tm_mon + 1,
+                 tm_info->tm_mday,
+                 tm_info->tm_hour,
+                 tm_info->tm_min,
+                 tm_info->tm_sec);
+
+        system_cpu_csv_file = fopen(filename, "w");
+        if (!system_cpu_csv_file) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", filename);
+            return -1;
+        }
+
+        // Escreve o cabeçalho do CSV
+        fprintf(system_cpu_csv_file, "timestamp,core,user_percent,system_percent,idle_percent,iowait_percent,irq_percent,softirq_percent,steal_percent,ctxt_per_sec,intr_per_sec,procs_running,procs_blocked\n");
+        fflush(system_cpu_csv_file);
+    }
+
+    if (write_core_row(sample, "all", &sample->total) < 0) {
+        fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+        return -1;
+    }
+
+    for (int i = 0; i < sample->num_cores; i++) {
+        if (!sample->cores[i].online) continue;
+
+        char core[16];
+        snprintf(core, sizeof(core), "%d", i);
+        if (write_core_row(sample, core, &sample->cores[i]) < 0) {
+            fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+            return -1;
+        }
+    }
+
+    fflush(system_cpu_csv_file);
+    return 0;
+}
+
+void system_cpu_csv_close(void) {
+    if (system_cpu_csv_file) {
+        fclose(system_cpu_csv_file);
+        system_cpu_csv_file = NULL;
+    }
+}
@@ -0,0 +1,215 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "proc_parse.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * Alvo monitorado preso por pidfd.
+ *
+ * Enquanto o processo original existir (mesmo zumbi), o pid não pode ser
+ * reaproveitado. Por isso, uma leitura de /proc/<pid> seguida de um
+ * pidfd_send_signal(0) que não deu ESRCH pertence ao processo certo. O pidfd
+ * também fica legível (POLLIN) no instante em que o processo termina, o
+ * que substitui o sleep dos laços de amostragem.
+ *
+ * Sem pidfd (kernel < 5.3) a identidade é o par pid + starttime
+ * (stat campo 22), conferido a cada verificação.
+ */
+
+typedef struct {
+    char state;
+    unsigned long long utime;
+    unsigned long long stime;
+    unsigned long long start_time;
+    long long exit_code;
+} StatFields;
+
+static int read_stat_fields(pid_t pid, StatFields *out) {
+
+    char path[PROC_PATH_MAX];
+    char buf[1024];
+    snprintf(path, sizeof(path), "%s/%d/stat", proc_root(), (int)pid);
+
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
+    if (len <= 0) return -1;
+
+    const char *end = buf + len;
+    const char *p = strrchr(buf, ')');
+    if (!p || p + 2 >= end) return -1;
+
+    // Após o ')': state(3) ... utime(14) stime(15) ... starttime(22) ... exit_code(52)
+    out->state = p[2];
+    out->exit_code = -1;
+    p = proc_skip_fields(p + 1, end, 11);
+    if (p) p = proc_parse_u64(p, end, &out->utime);
+    if (p) p = proc_parse_u64(p, end, &out->stime);
+    if (p) p = proc_skip_fields(p, end, 6);
+    if (p) p = proc_parse_u64(p, end, &out->start_time);
+    if (!p) return -1;
+
+    // exit_code só existe a partir do 3.5; ausente fica -1
+    const char *q = proc_skip_fields(p, end, 29);
+    if (q) proc_parse_i64(q, end, &out->exit_code);
+    return 0;
+}
+
+/**
+ * Prende o processo por um pidfd e guarda sua identidade
+ * @param target Estado a inicializar
+ * @param pid Processo alvo
+ * @return 0 em sucesso, -1 se o processo não existe
+ */
+int target_open(MonitorTarget *target, pid_t pid) {
+
+    if (!target) {
+        fprintf(stderr, "Erro: ponteiro nulo em target_open\n");
+        return -1;
+    }
+
+    memset(target, 0, sizeof(*target));
+    target->pid = pid;
+    target->exit_code = -1;
+    target->pidfd = -1;
+
+#ifdef SYS_pidfd_open
+    // Numa árvore sintética o pid não é um processo: fica só o starttime
+    if (proc_root_is_live()) {
+        target->pidfd = (int)syscall(SYS_pidfd_open, pid, 0);
+        if (target->pidfd == -1 && errno == ESRCH) {
+            fprintf(stderr, "Erro: processo %d nao encontrado\n", (int)pid);
+            return -1;
+        }
+    }
+#endif
+
+    // starttime lido depois do pidfd: se o pidfd abriu, o pid ainda é o mesmo processo
+    StatFields st;
+    if (read_stat_fields(pid, &st) < 0) {
+        fprintf(stderr, "Erro: processo %d nao encontrado\n", (int)pid);
+        target_close(target);
+        return -1;
+    }
+    target->start_time = st.start_time;
+    return 0;
+}
+
+/**
+ * Registra a saída: status de wait quando somos o pai, senão o exit_code
+ * do zumbi em stat (se o pai ainda não o recolheu), e os tempos finais
+ */
+static void capture_exit(MonitorTarget *target) {
+
+    target->exited = 1;
+    target->exit_time = time(NULL);
+
+#ifdef P_PIDFD
+    if (target->pidfd != -1) {
+        siginfo_t info;
+        memset(&info, 0, sizeof(info));
+        // WNOWAIT: não recolhe o filho de quem chamou; ECHILD se não é nosso filho
+        if (waitid(P_PIDFD, (id_t)target->pidfd, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid != 0) {
+            target->exit_code = info.si_code == CLD_EXITED ? (info.si_status & 0xff) << 8 : info.si_status & 0x7f;
+        }
+    }
+#endif
+
+    StatFields st;
+    if (read_stat_fields(target->pid, &st) == 0 && st.start_time == target->start_time) {
+        target->final_user_ticks = st.utime;
+        target->final_system_ticks = st.stime;
+        if (target->exit_code == -1 && (st.state == 'Z' || st.state == 'X')) target->exit_code = (int)st.exit_code;
+    }
+}
+
+/**
+ * Espera até timeout_ms ou até o processo terminar, o que vier antes
+ * @return 1 se o processo terminou, 0 se o tempo passou, -1 em erro
+ */
+int target_wait(MonitorTarget *target, int timeout_ms) {
+
+    if (!target) {
+        fprintf(stderr, "Erro: ponteiro nulo em target_wait\n");
+        return -1;
+    }
+    if (target->exited) return 1;
+
+    if (target->pidfd != -1) {
+        struct pollfd pfd = { .fd = target->pidfd, .events = POLLIN, .revents = 0 };
+        int rc;
+        do {
+            rc = poll(&pfd, 1, timeout_ms);
+        } while (rc == -1 && errno == EINTR);
+
+        if (rc < 0) return -1;
+        if (rc == 0) return 0;
+        capture_exit(target);
+        return 1;
+    }
+
+    // Sem pidfd: dorme e confere a identidade
+    if (timeout_ms > 0) usleep((useconds_t)timeout_ms * 1000);
+    if (!target_same_process(target)) {
+        target->exited = 1;
+        target->exit_time = time(NULL);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Confirma, depois de uma leitura de /proc/<pid>, que o pid ainda é o
+ * processo aberto em target_open
+ * @return 1 se é o mesmo processo, 0 se terminou ou o pid foi reaproveitado
+ */
+int target_same_process(MonitorTarget *target) {
+
+    if (!target || target->exited) return 0;
+
+#ifdef SYS_pidfd_send_signal
+    if (target->pidfd != -1) {
+        // Sinal 0 só testa existência; zumbi ainda conta como o mesmo processo.
+        // EPERM: o processo existe, só é de outro usuário (o kernel confere a
+        // permissão de kill mesmo para o sinal 0)
+        return syscall(SYS_pidfd_send_signal, target->pidfd, 0, NULL, 0) == 0 || errno == EPERM;
+    }
+#endif
+
+    StatFields st;
+    return read_stat_fields(target->pid, &st) == 0 && st.start_time == target->start_time;
+}
+
+void target_describe_exit(const MonitorTarget *target, char *buf, size_t size) {
+
+    if (!target || !buf || size == 0) return;
+
+    if (target->exit_code == -1) {
+        snprintf(buf, size, "processo %d terminou (status desconhecido)", (int)target->pid);
+    } else if (WIFEXITED(target->exit_code)) {
+        snprintf(buf, size, "processo %d terminou com codigo %d", (int)target->pid, WEXITSTATUS(target->exit_code));
+    } else if (WIFSIGNALED(target->exit_code)) {
+        snprintf(buf, size, "processo %d terminou pelo sinal %d (%s)", (int)target->pid,
+                 WTERMSIG(target->exit_code), strsignal(WTERMSIG(target->exit_code)));
+    } else {
+        snprintf(buf, size, "processo %d terminou (status 0x%x)", (int)target->pid, (unsigned)target->exit_code);
+    }
+
+    if (target->final_user_ticks || target->final_system_ticks) {
+        size_t len = strlen(buf);
+        snprintf(buf + len, size - len, " | CPU final: user %llu ticks, system %llu ticks",
+                 target->final_user_ticks, target->final_system_ticks);
+    }
+}
+
+void target_close(MonitorTarget *target) {
+    if (!target) return;
+    if (target->pidfd != -1) close(target->pidfd);
+    target->pidfd = -1;
+}
@@ -0,0 +1,418 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "proc_parse.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Dados brutos de uma thread lidos em uma única passada por /proc
+ */
+typedef struct {
+    pid_t tid;
+    char state;
+    int last_cpu;
+    unsigned long long utime;
+    unsigned long long stime;
+    unsigned long long run_time_ns;
+    unsigned long long run_delay_ns;
+    int has_schedstat;
+} ThreadRaw;
+
+static int compare_tid(const void *a, const void *b) {
+    pid_t ta = *(const pid_t *)a;
+    pid_t tb = *(const pid_t *)b;
+    return (ta > tb) - (ta < tb);
+}
+
+static int compare_cpu_desc(const void *a, const void *b) {
+    double ca = ((const ThreadSample *)a)->cpu_percent;
+    double cb = ((const ThreadSample *)b)->cpu_percent;
+    return (ca < cb) - (ca > cb);
+}
+
+static double timespec_diff_sec(struct timespec a, struct timespec b) {
+    return (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+/**
+ * Lista os tids de /proc/<pid>/task em ordem crescente
+ *
+ * @param pid PID do processo
+ * @param tids_out Recebe um vetor alocado com os tids (liberar com free)
+ * @return número de threads encontradas, ou -1 em erro
+ */
+static int list_thread_ids(pid_t pid, pid_t **tids_out) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/task", proc_root(), (int)pid);
+
+    DIR *d = opendir(path);
+    if (!d) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
+        return -1;
+    }
+
+    size_t count = 0, capacity = 64;
+    pid_t *tids = malloc(capacity * sizeof(pid_t));
+    if (!tids) {
+        closedir(d);
+        return -1;
+    }
+
+    struct dirent *ent;
+    while ((ent = readdir(d))) {
+        if (!isdigit((unsigned char)ent->d_name[0])) continue;
+
+        if (count == capacity) {
+            capacity *= 2;
+            pid_t *tmp = realloc(tids, capacity * sizeof(pid_t));
+            if (!tmp) {
+                free(tids);
+                closedir(d);
+                return -1;
+            }
+            tids = tmp;
+        }
+        tids[count++] = (pid_t)atoi(ent->d_name);
+    }
+    closedir(d);
+
+    // readdir costuma devolver em ordem, mas não é garantido
+    qsort(tids, count, sizeof(pid_t), compare_tid);
+
+    *tids_out = tids;
+    return (int)count;
+}
+
+/**
+ * Lê /proc/<pid>/task/<tid>/stat e /proc/<pid>/task/<tid>/schedstat
+ *
+ * @return 0 em sucesso, -1 se a thread terminou durante a leitura
+ */
+static int read_thread_raw(pid_t pid, pid_t tid, ThreadRaw *raw) {
+
+    char path[PROC_PATH_MAX];
+    char buf[1024];
+
+    snprintf(path, sizeof(path), "%s/%d/task/%d/stat", proc_root(), (int)pid, (int)tid);
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
+    if (len <= 0) return -1;  // thread terminou entre o readdir e a leitura
+
+    const char *end = buf + len;
+    const char *p = strrchr(buf, ')');
+    if (!p) return -1;
+    p = proc_skip_fields(p + 1, end, 0);  // campo 1: state
+    if (!p) return -1;
+
+    char state = *p;
+    unsigned long long utime = 0, stime = 0, processor = 0;
+
+    // Mesmo layout de /proc/<pid>/stat (ver cpu_monitor.c):
+    // 1) state ... 12) utime, 13) stime ... 37) processor
+    p = proc_skip_fields(p, end, 11);                 // campo 12
+    if (p) p = proc_parse_u64(p, end, &utime);
+    if (p) p = proc_parse_u64(p, end, &stime);        // campo 13
+    if (!p) return -1;
+
+    const char *q = proc_skip_fields(p, end, 23);     // campo 37: processor
+    if (q) q = proc_parse_u64(q, end, &processor);
+
+    raw->tid = tid;
+    raw->state = state;
+    raw->utime = utime;
+    raw->stime = stime;
+    raw->last_cpu = q ? (int)processor : -1;
+    raw->run_time_ns = 0;
+    raw->run_delay_ns = 0;
+    raw->has_schedstat = 0;
+
+    // schedstat: <tempo em CPU ns> <tempo na run queue ns> <timeslices>
+    snprintf(path, sizeof(path), "%s/%d/task/%d/schedstat", proc_root(), (int)pid, (int)tid);
+    len = proc_read_file(path, buf, sizeof(buf));
+    if (len > 0) {
+        p = proc_parse_u64(buf, buf + len, &raw->run_time_ns);
+        if (p) p = proc_parse_u64(p, buf + len, &raw->run_delay_ns);
+        raw->has_schedstat = p != NULL;
+    }
+
+    return 0;
+}
+
+/**
+ * Lê o nome da thread a partir de /proc/<pid>/task/<tid>/comm
+ * Só é chamado quando a thread aparece pela primeira vez
+ */
+static void read_thread_comm(pid_t pid, pid_t tid, char *comm_out) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/task/%d/comm", proc_root(), (int)pid, (int)tid);
+
+    comm_out[0] = '\0';
+    if (proc_read_file(path, comm_out, THREAD_COMM_LEN) > 0) {
+        comm_out[strcspn(comm_out, "\n")] = '\0';
+    }
+}
+
+/**
+ * Busca binária pelo tid no estado anterior (ordenado por tid)
+ */
+static ThreadEntry *find_entry(ThreadMonitorState *state, pid_t tid) {
+    size_t lo = 0, hi = state->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (state->threads[mid].tid == tid) return &state->threads[mid];
+        if (state->threads[mid].tid < tid) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+/**
+ * Lê todas as threads do processo e reconstrói o estado por tid
+ *
+ * @param interval_sec Intervalo desde a amostra anterior; se for 0 (inicialização)
+ *                     só o estado é atualizado, sem gerar amostras em state->scratch
+ * @return número de threads lidas, ou -1 em erro
+ */
+static int scan_threads(ThreadMonitorState *state, double interval_sec) {
+
+    pid_t *tids = NULL;
+    int n = list_thread_ids(state->pid, &tids);
+    if (n < 0) return -1;
+
+    size_t slots = n > 0 ? (size_t)n : 1;
+    ThreadEntry *next = malloc(slots * sizeof(ThreadEntry));
+    if (!next) {
+        free(tids);
+        return -1;
+    }
+
+    ThreadSample *samples_out = NULL;
+    if (interval_sec > 0.0) {
+        // Buffer de amostras é reaproveitado entre chamadas, só cresce
+        if (state->scratch_capacity < slots) {
+            ThreadSample *tmp = realloc(state->scratch, slots * sizeof(ThreadSample));
+            if (!tmp) {
+                free(next);
+                free(tids);
+                return -1;
+            }
+            state->scratch = tmp;
+            state->scratch_capacity = slots;
+        }
+        samples_out = state->scratch;
+    }
+
+    long ticks_per_sec = sysconf(_SC_CLK_TCK);
+    if (ticks_per_sec <= 0) ticks_per_sec = 100;
+
+    time_t now = time(NULL);
+    size_t count = 0;
+
+    for (int i = 0; i < n; i++) {
+        ThreadRaw raw;
+        if (read_thread_raw(state->pid, tids[i], &raw) < 0) continue;
+
+        ThreadEntry *prev = find_entry(state, raw.tid);
+        ThreadEntry *e = &next[count];
+
+        e->tid = raw.tid;
+        if (prev) {
+            memcpy(e->comm, prev->comm, THREAD_COMM_LEN);
+        } else {
+            read_thread_comm(state->pid, raw.tid, e->comm);
+        }
+
+        if (samples_out) {
+            // Thread nova (criada após a última amostra): todo o tempo dela
+            // aconteceu dentro do intervalo, então a referência é zero
+            unsigned long long prev_ticks = prev ? prev->last_user_time_ticks + prev->last_system_time_ticks : 0;
+            unsigned long long prev_ns = prev ? prev->last_run_time_ns : 0;
+            unsigned long long curr_ticks = raw.utime + raw.stime;
+
+            // schedstat tem resolução de ns; ticks são o fallback
+            double cpu_percent = 0.0;
+            if (raw.has_schedstat && raw.run_time_ns >= prev_ns) {
+                cpu_percent = 100.0 * (double)(raw.run_time_ns - prev_ns) / (interval_sec * 1e9);
+            } else if (curr_ticks >= prev_ticks) {
+                cpu_percent = 100.0 * (double)(curr_ticks - prev_ticks) /
+                              (interval_sec * (double)ticks_per_sec);
+            }
+
+            ThreadSample *s = &samples_out[count];
+            s->pid = state->pid;
+            s->tid = raw.tid;
+            s->timestamp = now;
+            memcpy(s->comm, e->comm, THREAD_COMM_LEN);
+            s->state = raw.state;
+            s->last_cpu = raw.last_cpu;
+            s->cpu_percent = cpu_percent;
+            s->user_time_ticks = raw.utime;
+            s->system_time_ticks = raw.stime;
+            s->run_time_ns = raw.run_time_ns;
+            s->run_delay_ns = raw.run_delay_ns;
+        }
+
+        e->last_user_time_ticks = raw.utime;
+        e->last_system_time_ticks = raw.stime;
+        e->last_run_time_ns = raw.run_time_ns;
+        count++;
+    }
+    free(tids);
+
+    // Threads que terminaram simplesmente não entram no novo estado
+    free(state->threads);
+    state->threads = next;
+    state->count = count;
+    state->capacity = slots;
+
+    return (int)count;
+}
+
+/**
+ * Inicializa o monitor de threads
+ *
+ * @param state Ponteiro para estrutura de estado a ser inicializada
+ * @param pid PID do processo a ser monitorado
+ * @return 0 em sucesso, -1 em erro
+ *
+ * Lê o estado inicial de todas as threads, que servirá de referência
+ * para calcular o uso de CPU de cada uma na próxima amostra
+ */
+int thread_monitor_init(ThreadMonitorState *state, pid_t pid) {
+
+    if (!state) {
+        fprintf(stderr, "Erro: state nulo em thread_monitor_init\n");
+        return -1;
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->pid = pid;
+
+    if (scan_threads(state, 0.0) < 0) {
+        fprintf(stderr, "Erro em thread_monitor_init: nao foi possivel ler threads do processo %d\n", (int)pid);
+        thread_monitor_free(state);
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &state->last_ts);
+    return 0;
+}
+
+/**
+ * Coleta uma amostra de todas as threads e devolve as N mais quentes
+ *
+ * @param state Ponteiro para estrutura de estado (mantém valores anteriores por tid)
+ * @param top Vetor com espaço para top_n amostras, ordenadas por CPU decrescente
+ * @param top_n Quantidade máxima de threads a devolver
+ * @return número de amostras escritas em top, ou -1 em erro
+ */
+int thread_monitor_sample(ThreadMonitorState *state, ThreadSample *top, int top_n) {
+
+    if (!state || !top || top_n <= 0) {
+        fprintf(stderr, "Erro: parametro invalido em thread_monitor_sample\n");
+        return -1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double interval_sec = timespec_diff_sec(state->last_ts, now);
+
+    // Evita intervalo nulo se duas amostras forem pedidas em sequência
+    if (interval_sec <= 0.0) interval_sec = 1e-9;
+
+    int n = scan_threads(state, interval_sec);
+    if (n < 0) {
+        fprintf(stderr, "Erro em thread_monitor_sample: nao foi possivel ler threads do processo %d\n",
+                (int)state->pid);
+        return -1;
+    }
+    state->last_ts = now;
+
+    qsort(state->scratch, (size_t)n, sizeof(ThreadSample), compare_cpu_desc);
+
+    int out = n < top_n ? n : top_n;
+    memcpy(top, state->scratch, (size_t)out * sizeof(ThreadSample));
+    return out;
+}
+
+/**
+ * Libera a memória alocada pelo monitor de threads
+ */
+void thread_monitor_free(ThreadMonitorState *state) {
+    if (!state) return;
+    free(state->threads);
+    free(state->scratch);
+    state->threads = NULL;
+    state->scratch = NULL;
+    state->count = state->capacity = state->scratch_capacity = 0;
+}
+
+static FILE *thread_csv_file = NULL;  // arquivo CSV para threads
+
+int thread_sample_csv_write(const ThreadSample *sample) {
+    if (!sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em thread_sample_csv_write\n");
+        return -1;
+    }
+
+    // cria o arquivo na primeira chamada
+    if (!thread_csv_file) {
+        // Formata o timestamp para o nome do arquivo (YYYYMMDD_HHMMSS)
+        struct tm *tm_info = localtime(&sample->timestamp);
+        char filename[64];
+        snprintf(filename, sizeof(filename),
+                 "thread-monitor-%04d%02d%02d_%02d%02d%02d.csv",
+                 tm_info->tm_year + 1900,
+                 tm_info->tm_mon + 1,
+                 tm_info->tm_mday,
+                 tm_info->tm_hour,
+                 tm_info->tm_min,
+                 tm_info->tm_sec);
+
+        thread_csv_file = fopen(filename, "w");
+        if (!thread_csv_file) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", filename);
+            return -1;
+        }
+
+        // Escreve o cabeçalho do CSV
+        fprintf(thread_csv_file, "timestamp,pid,tid,comm,state,last_cpu,cpu_percent,user_time_ticks,system_time_ticks,run_time_ns,run_delay_ns\n");
+        fflush(thread_csv_file);
+    }
+
+    // comm é escolhido pela própria thread e pode ter vírgulas e aspas
+    if (fprintf(thread_csv_file, "%lld,%d,%d,",
+                (long long)sample->timestamp,
+                (int)sample->pid,
+                (int)sample->tid) < 0 ||
+        csv_write_quoted(thread_csv_file, sample->comm) != 0 ||
+        fprintf(thread_csv_file,
+                ",%c,%d,%.2f,%llu,%llu,%llu,%llu\n",
+                sample->state,
+                sample->last_cpu,
+                sample->cpu_percent,
+                sample->user_time_ticks,
+                sample->system_time_ticks,
+                sample->run_time_ns,
+                sample->run_delay_ns) < 0) {
+        fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+        return -1;
+    }
+
+    fflush(thread_csv_file);
+    return 0;
+}
+
+void thread_sample_csv_close(void) {
+    if (thread_csv_file) {
+        fclose(thread_csv_file);
+        thread_csv_file = NULL;
+    }
+}
@@ -0,0 +1,459 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "proc_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Mapa de memória de um processo: /proc/<pid>/maps vira um vetor de regiões
+ * ordenado por endereço (busca binária por endereço) e cada snapshot é
+ * comparado com o anterior para dizer o que surgiu, sumiu, cresceu ou
+ * encolheu. smaps, que custa muito mais, só é lido a cada N amostras para
+ * atribuir RSS às regiões.
+ *
+ * O parse é incremental: uma linha idêntica à do snapshot anterior (o caso
+ * comum, mesmo em mapas com dezenas de milhares de regiões) é copiada sem
+ * ser interpretada de novo.
+ */
+
+#define ARENA_ALIGN (64ULL * 1024 * 1024)  // HEAP_MAX_SIZE do glibc em 64 bits
+
+static unsigned long long elapsed_ns(const struct timespec *start, const struct timespec *end) {
+    return (unsigned long long)(end->tv_sec - start->tv_sec) * 1000000000ULL +
+           (unsigned long long)end->tv_nsec - (unsigned long long)start->tv_nsec;
+}
+
+const char *vma_kind_name(int kind) {
+    static const char *const names[VMA_KINDS] = {
+        "heap", "stack", "thread_stack", "arena", "anon", "file", "shmem", "special", "guard"
+    };
+    return (kind >= 0 && kind < VMA_KINDS) ? names[kind] : "?";
+}
+
+static const char *region_name(const VmaSnapshot *snap, const VmaRegion *r) {
+    return snap->buf + r->line_off + r->name_rel;
+}
+
+static int push_region(VmaSnapshot *snap, const VmaRegion *r) {
+    if (snap->count == snap->capacity) {
+        size_t cap = snap->capacity ? snap->capacity * 2 : 1024;
+        VmaRegion *regions = realloc(snap->regions, cap * sizeof(*regions));
+        if (!regions) return -1;
+        snap->regions = regions;
+        snap->capacity = cap;
+    }
+    snap->regions[snap->count++] = *r;
+    return 0;
+}
+
+static int push_change(VmaMonitorState *state, const VmaChange *c) {
+    if (state->num_changes == state->changes_capacity) {
+        size_t cap = state->changes_capacity ? state->changes_capacity * 2 : 64;
+        VmaChange *changes = realloc(state->changes, cap * sizeof(*changes));
+        if (!changes) return -1;
+        state->changes = changes;
+        state->changes_capacity = cap;
+    }
+    state->changes[state->num_changes++] = *c;
+    return 0;
+}
+
+/**
+ * Interpreta uma linha "inicio-fim perms offset dev inode   nome"
+ * @return 0 em sucesso, -1 se a linha não tiver o formato esperado
+ */
+static int parse_line(const char *line, const char *end, VmaRegion *r) {
+
+    memset(r, 0, sizeof(*r));
+
+    const char *p = proc_parse_hex(line, end, &r->start);
+    if (!p || p >= end || *p != '-') return -1;
+    p = proc_parse_hex(p + 1, end, &r->end);
+    if (!p || end - p < 5) return -1;
+
+    memcpy(r->perms, p + 1, 4);
+    p = proc_parse_hex(p + 5, end, &r->offset);
+    if (p) p = proc_skip_fields(p, end, 1);          // dev (maj:min)
+    if (p) p = proc_parse_u64(p, end, &r->inode);
+    if (!p) return -1;
+
+    while (p < end && *p == ' ') p++;
+    r->name_rel = (unsigned short)(p - line);
+    r->name_len = (unsigned short)(end - p);
+    return 0;
+}
+
+// Reclassifica todas as regiões (barato; depende da vizinha anterior)
+static void classify(VmaSnapshot *snap) {
+
+    for (size_t i = 0; i < snap->count; i++) {
+        VmaRegion *r = &snap->regions[i];
+        const char *name = region_name(snap, r);
+        int n = r->name_len;
+
+        if (n == 0) {
+            if (memcmp(r->perms, "---", 3) == 0) {
+                r->kind = VMA_GUARD;
+            } else if (r->start % ARENA_ALIGN == 0) {
+                r->kind = VMA_ARENA;
+            } else if (i > 0 && snap->regions[i - 1].kind == VMA_GUARD &&
+                       snap->regions[i - 1].end == r->start) {
+                r->kind = VMA_THREAD_STACK;
+            } else {
+                r->kind = VMA_ANON;
+            }
+        } else if (n == 6 && memcmp(name, "[heap]", 6) == 0) {
+            r->kind = VMA_HEAP;
+        } else if (n == 7 && memcmp(name, "[stack]", 7) == 0) {
+            r->kind = VMA_STACK;
+        } else if (name[0] == '[') {
+            r->kind = VMA_SPECIAL;
+        } else if ((n >= 9 && memcmp(name, "/dev/shm/", 9) == 0) ||
+                   (n >= 5 && memcmp(name, "/SYSV", 5) == 0) ||
+                   (n >= 7 && memcmp(name, "/memfd:", 7) == 0)) {
+            r->kind = VMA_SHMEM;
+        } else {
+            r->kind = VMA_FILE;
+        }
+    }
+}
+
+/**
+ * Lê maps para snap reaproveitando as regiões de old cujas linhas não mudaram
+ */
+static int build_snapshot(VmaMonitorState *state, VmaSnapshot *snap, const VmaSnapshot *old,
+                          VmaSample *sample) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/maps", proc_root(), (int)state->pid);
+
+    ssize_t len = proc_read_file_dyn(path, &snap->buf, &snap->buf_capacity);
+    if (len < 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
+        return -1;
+    }
+    snap->len = (size_t)len;
+    snap->count = 0;
+
+    const char *p = snap->buf;
+    const char *end = snap->buf + len;
+    size_t k = 0;  // cursor no snapshot anterior
+
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        const char *line_end = nl ? nl : end;
+        unsigned int line_len = (unsigned int)(line_end - p);
+        VmaRegion r;
+
+        const VmaRegion *o = (old && k < old->count) ? &old->regions[k] : NULL;
+        if (o && o->line_len == line_len && memcmp(old->buf + o->line_off, p, line_len) == 0) {
+            // Linha idêntica: mesma região, só muda a posição no buffer
+            r = *o;
+            k++;
+            sample->lines_reused++;
+        } else {
+            if (parse_line(p, line_end, &r) < 0) {
+                p = nl ? nl + 1 : end;
+                continue;
+            }
+            sample->lines_parsed++;
+
+            // Realinha o cursor: regiões antigas antes desta não têm linha igual
+            while (old && k < old->count && old->regions[k].start <= r.start) {
+                if (old->regions[k].start == r.start) r.rss_bytes = old->regions[k].rss_bytes;
+                k++;
+            }
+        }
+
+        r.line_off = (unsigned int)(p - snap->buf);
+        r.line_len = line_len;
+        if (push_region(snap, &r) < 0) return -1;
+
+        p = nl ? nl + 1 : end;
+    }
+
+    classify(snap);
+    return 0;
+}
+
+static void add_change(VmaMonitorState *state, VmaSample *sample, int type,
+                       const VmaSnapshot *snap, const VmaRegion *r, long long delta) {
+    VmaChange c;
+    c.type = type;
+    c.kind = r->kind;
+    c.start = r->start;
+    c.end = r->end;
+    c.delta_bytes = delta;
+    c.name = region_name(snap, r);
+    c.name_len = r->name_len;
+    push_change(state, &c);
+
+    switch (type) {
+        case VMA_APPEARED: sample->appeared++; break;
+        case VMA_VANISHED: sample->vanished++; break;
+        case VMA_GREW:     sample->grew++;     break;
+        case VMA_SHRANK:   sample->shrank++;   break;
+    }
+    if (delta > 0) sample->grown_bytes += delta;
+    else sample->shrunk_bytes += -delta;
+}
+
+/**
+ * Compara dois snapshots ordenados. Regiões com o mesmo início são a mesma
+ * região; com o mesmo fim e o mesmo nome também (pilhas crescem para baixo).
+ */
+static void diff_snapshots(VmaMonitorState *state, const VmaSnapshot *old, const VmaSnapshot *cur,
+                           VmaSample *sample) {
+
+    size_t i = 0, j = 0;
+    state->num_changes = 0;
+
+    while (i < old->count || j < cur->count) {
+        const VmaRegion *a = i < old->count ? &old->regions[i] : NULL;
+        const VmaRegion *b = j < cur->count ? &cur->regions[j] : NULL;
+
+        int same = a && b && (a->start == b->start ||
+                   (a->end == b->end && a->name_len == b->name_len &&
+                    memcmp(region_name(old, a), region_name(cur, b), a->name_len) == 0));
+
+        if (same) {
+            long long delta = (long long)(b->end - b->start) - (long long)(a->end - a->start);
+            if (delta > 0) add_change(state, sample, VMA_GREW, cur, b, delta);
+            else if (delta < 0) add_change(state, sample, VMA_SHRANK, cur, b, delta);
+            i++;
+            j++;
+        } else if (a && (!b || a->start < b->start)) {
+            add_change(state, sample, VMA_VANISHED, old, a, -(long long)(a->end - a->start));
+            i++;
+        } else {
+            add_change(state, sample, VMA_APPEARED, cur, b, (long long)(b->end - b->start));
+            j++;
+        }
+    }
+
+    sample->changes = state->changes;
+    sample->num_changes = state->num_changes;
+}
+
+/**
+ * Atribui o Rss de smaps a cada região do snapshot atual. Cabeçalhos de
+ * região começam com o endereço em hexadecimal; a região é achada pelo índice.
+ */
+static int read_smaps(VmaMonitorState *state) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/smaps", proc_root(), (int)state->pid);
+
+    ssize_t len = proc_read_file_dyn(path, &state->smaps_buf, &state->smaps_capacity);
+    if (len < 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
+        return -1;
+    }
+
+    VmaSnapshot *snap = &state->snaps[state->cur];
+    for (size_t i = 0; i < snap->count; i++) snap->regions[i].rss_bytes = 0;
+
+    VmaRegion *current = NULL;
+    const char *p = state->smaps_buf;
+    const char *end = state->smaps_buf + len;
+
+    while (p < end) {
+        const char *next = proc_next_line(p, end);
+
+        if (next - p > 4 && memcmp(p, "Rss:", 4) == 0) {
+            unsigned long long kb = 0;
+            if (current && proc_parse_u64(p + 4, next, &kb)) current->rss_bytes = kb * 1024;
+        } else if ((unsigned char)(*p - 'A') >= 26) {
+            // Não é "Chave:", então é o cabeçalho de uma nova região
+            unsigned long long start = 0;
+            if (proc_parse_hex(p, next, &start)) {
+                current = (VmaRegion *)vma_monitor_find(state, start);
+            }
+        }
+
+        p = next;
+    }
+
+    return 0;
+}
+
+/**
+ * Localiza a região que contém addr no snapshot atual (busca binária)
+ * @return a região, ou NULL se addr não estiver mapeado
+ */
+const VmaRegion *vma_monitor_find(const VmaMonitorState *state, unsigned long long addr) {
+
+    if (!state) return NULL;
+    const VmaSnapshot *snap = &state->snaps[state->cur];
+
+    size_t lo = 0, hi = snap->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (snap->regions[mid].end <= addr) lo = mid + 1;
+        else hi = mid;
+    }
+
+    if (lo < snap->count && snap->regions[lo].start <= addr) return &snap->regions[lo];
+    return NULL;
+}
+
+/**
+ * Inicializa o analisador com o primeiro snapshot de maps
+ *
+ * @param state Estado a inicializar
+ * @param pid Processo monitorado
+ * @param smaps_every Lê smaps a cada N amostras para o RSS por região (0 = nunca)
+ * @return 0 em sucesso, -1 em erro
+ */
+int vma_monitor_init(VmaMonitorState *state, pid_t pid, int smaps_every) {
+
+    if (!state || smaps_every < 0) {
+        fprintf(stderr, "Erro: parametro invalido em vma_monitor_init\n");
+        return -1;
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->pid = pid;
+    state->smaps_every = smaps_every;
+
+    VmaSample scratch;
+    memset(&scratch, 0, sizeof(scratch));
+    if (build_snapshot(state, &state->snaps[0], NULL, &scratch) < 0) {
+        vma_monitor_free(state);
+        return -1;
+    }
+
+    // Primeira amostra já lê smaps, para o RSS por tipo não começar zerado
+    state->tick = smaps_every;
+    return 0;
+}
+
+/**
+ * Lê um novo snapshot, compara com o anterior e soma os totais por tipo
+ *
+ * @param state Estado criado por vma_monitor_init
+ * @param sample Recebe totais, mudanças (válidas até a próxima amostra) e custos
+ * @return 0 em sucesso, -1 em erro
+ */
+int vma_monitor_sample(VmaMonitorState *state, VmaSample *sample) {
+
+    if (!state || !sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em vma_monitor_sample\n");
+        return -1;
+    }
+
+    memset(sample, 0, sizeof(*sample));
+    sample->pid = state->pid;
+    sample->timestamp = time(NULL);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    const VmaSnapshot *old = &state->snaps[state->cur];
+    VmaSnapshot *cur = &state->snaps[!state->cur];
+
+    if (build_snapshot(state, cur, old, sample) < 0) {
+        fprintf(stderr, "Erro em vma_monitor_sample: falha ao ler maps do processo %d\n",
+                (int)state->pid);
+        return -1;
+    }
+    diff_snapshots(state, old, cur, sample);
+
+    // O snapshot antigo continua intacto até a próxima amostra (nomes das mudanças)
+    state->cur = !state->cur;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    sample->cost_ns = elapsed_ns(&t0, &t1);
+
+    if (state->smaps_every > 0 && ++state->tick >= state->smaps_every) {
+        state->tick = 0;
+        if (read_smaps(state) == 0) sample->smaps_fresh = 1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        sample->smaps_cost_ns = elapsed_ns(&t1, &t0);
+    }
+
+    const VmaSnapshot *snap = &state->snaps[state->cur];
+    sample->num_regions = snap->count;
+    for (size_t i = 0; i < snap->count; i++) {
+        const VmaRegion *r = &snap->regions[i];
+        sample->virt_bytes[r->kind] += r->end - r->start;
+        sample->rss_bytes[r->kind] += r->rss_bytes;
+    }
+
+    return 0;
+}
+
+void vma_monitor_free(VmaMonitorState *state) {
+    if (!state) return;
+    for (int i = 0; i < 2; i++) {
+        free(state->snaps[i].regions);
+        free(state->snaps[i].buf);
+    }
+    free(state->changes);
+    free(state->smaps_buf);
+    memset(state, 0, sizeof(*state));
+}
+
+static FILE *vma_csv_file = NULL;  // arquivo CSV para o mapa de memória
+
+int vma_sample_csv_write(const VmaSample *sample) {
+    if (!sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em vma_sample_csv_write\n");
+        return -1;
+    }
+
+    // cria o arquivo na primeira chamada
+    if (!vma_csv_file) {
+        struct tm *tm_info = localtime(&sample->timestamp);
+        char filename[64];
+        snprintf(filename, sizeof(filename),
+                 "vma-monitor-%04d%02d%02d_%02d%02d%02d.csv",
+                 tm_info->tm_year + 1900,
+                 tm_info->tm_mon + 1,
+                 tm_info->tm_mday,
+                 tm_info->tm_hour,
+                 tm_info->tm_min,
+                 tm_info->tm_sec);
+
+        vma_csv_file = fopen(filename, "w");
+        if (!vma_csv_file) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", filename);
+            return -1;
+        }
+
+        fprintf(vma_csv_file, "timestamp,pid,regions");
+        for (int k = 0; k < VMA_KINDS; k++) fprintf(vma_csv_file, ",%s_virt_bytes", vma_kind_name(k));
+        for (int k = 0; k < VMA_KINDS; k++) fprintf(vma_csv_file, ",%s_rss_bytes", vma_kind_name(k));
+        fprintf(vma_csv_file,
+                ",appeared,vanished,grew,shrank,grown_bytes,shrunk_bytes,"
+                "lines_reused,lines_parsed,cost_ns,smaps_cost_ns\n");
+        fflush(vma_csv_file);
+    }
+
+    fprintf(vma_csv_file, "%lld,%d,%zu",
+            (long long)sample->timestamp, (int)sample->pid, sample->num_regions);
+    for (int k = 0; k < VMA_KINDS; k++) fprintf(vma_csv_file, ",%llu", sample->virt_bytes[k]);
+    for (int k = 0; k < VMA_KINDS; k++) fprintf(vma_csv_file, ",%llu", sample->rss_bytes[k]);
+
+    if (fprintf(vma_csv_file, ",%d,%d,%d,%d,%lld,%lld,%zu,%zu,%llu,%llu\n",
+                sample->appeared, sample->vanished, sample->grew, sample->shrank,
+                sample->grown_bytes, sample->shrunk_bytes,
+                sample->lines_reused, sample->lines_parsed,
+                sample->cost_ns, sample->smaps_cost_ns) < 0) {
+        fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+        return -1;
+    }
+
+    fflush(vma_csv_file);
+    return 0;
+}
+
+void vma_sample_csv_close(void) {
+    if (vma_csv_file) {
+        fclose(vma_csv_file);
+        vma_csv_file = NULL;
+    }
+}
@@ -0,0 +1,419 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "proc_parse.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Estimativa do working set: quantas páginas o processo realmente tocou
+ * em cada intervalo, e não só quantas estão residentes.
+ *
+ * Com page_idle (root), as páginas presentes são marcadas como ociosas no
+ * bitmap do kernel; no fim do intervalo as que perderam a marca foram
+ * acessadas. Sem page_idle, clear_refs zera os bits de acesso e o campo
+ * Referenced de smaps_rollup diz quanto foi tocado desde então.
+ */
+
+#define PAGE_IDLE_BITMAP "kernel/mm/page_idle/bitmap"  // relativo à raiz de /sys
+
+#define WS_PAGEMAP_BATCH 8192  // entradas por pread do pagemap (64 KB)
+
+#define PM_PRESENT (1ULL << 63)
+#define PM_PFN_MASK ((1ULL << 55) - 1)
+
+static double timespec_diff_sec(struct timespec a, struct timespec b) {
+    return (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+static unsigned long long elapsed_ns(const struct timespec *start, const struct timespec *end) {
+    return (unsigned long long)(end->tv_sec - start->tv_sec) * 1000000000ULL +
+           (unsigned long long)end->tv_nsec - (unsigned long long)start->tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long *)a;
+    unsigned long long y = *(const unsigned long long *)b;
+    return (x > y) - (x < y);
+}
+
+/* ---------------------------- page_idle ---------------------------- */
+
+static ssize_t read_maps(WorkingSetState *state) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/maps", proc_root(), (int)state->pid);
+
+    ssize_t len = proc_read_file_dyn(path, &state->maps_buf, &state->maps_capacity);
+    if (len < 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
+    }
+    return len;
+}
+
+static int push_pfn(WorkingSetState *state, unsigned long long pfn) {
+    if (state->npfns == state->pfns_capacity) {
+        size_t cap = state->pfns_capacity ? state->pfns_capacity * 2 : 65536;
+        unsigned long long *pfns = realloc(state->pfns, cap * sizeof(*pfns));
+        if (!pfns) return -1;
+        state->pfns = pfns;
+        state->pfns_capacity = cap;
+    }
+    state->pfns[state->npfns++] = pfn;
+    return 0;
+}
+
+/**
+ * Percorre o pagemap de cada região de maps em leituras de WS_PAGEMAP_BATCH
+ * entradas e guarda os PFNs das páginas presentes, ordenados.
+ * @return 0 em sucesso, -1 em erro
+ */
+static int collect_pfns(WorkingSetState *state) {
+
+    ssize_t len = read_maps(state);
+    if (len < 0) return -1;
+
+    state->npfns = 0;
+    const char *p = state->maps_buf;
+    const char *end = state->maps_buf + len;
+
+    while (p < end) {
+        const char *next = proc_next_line(p, end);
+        unsigned long long start = 0, stop = 0;
+
+        // "inicio-fim perms ..." em hexadecimal
+        const char *q = proc_parse_hex(p, next, &start);
+        if (q && q < next && *q == '-') q = proc_parse_hex(q + 1, next, &stop);
+        p = next;
+        if (!q || stop <= start) continue;
+
+        unsigned long long first = start / (unsigned long long)state->page_size;
+        unsigned long long npages = (stop - start) / (unsigned long long)state->page_size;
+
+        while (npages > 0) {
+            size_t want = npages < WS_PAGEMAP_BATCH ? (size_t)npages : WS_PAGEMAP_BATCH;
+            ssize_t got = pread(state->pagemap_fd, state->batch, want * sizeof(uint64_t),
+                                (off_t)(first * sizeof(uint64_t)));
+            // [vsyscall] e regiões que somem durante a leitura: segue para a próxima
+            if (got <= 0) break;
+
+            size_t entries = (size_t)got / sizeof(uint64_t);
+            for (size_t i = 0; i < entries; i++) {
+                unsigned long long e = state->batch[i];
+                if ((e & PM_PRESENT) && (e & PM_PFN_MASK)) {
+                    if (push_pfn(state, e & PM_PFN_MASK) < 0) return -1;
+                }
+            }
+
+            first += entries;
+            npages -= entries;
+        }
+    }
+
+    // Páginas compartilhadas entre regiões aparecem mais de uma vez
+    qsort(state->pfns, state->npfns, sizeof(*state->pfns), compare_u64);
+    size_t out = 0;
+    for (size_t i = 0; i < state->npfns; i++) {
+        if (out == 0 || state->pfns[i] != state->pfns[out - 1]) state->pfns[out++] = state->pfns[i];
+    }
+    state->npfns = out;
+
+    return 0;
+}
+
+/**
+ * Para cada faixa contígua de palavras de 64 bits do bitmap que contém PFNs
+ * do processo: lê as palavras de uma vez, conta as páginas que não estão
+ * mais ociosas (tocadas) e escreve a máscara de volta para marcá-las de novo.
+ * @param touched_out Páginas acessadas desde a última marcação (pode ser NULL)
+ * @return 0 em sucesso, -1 em erro
+ */
+static int mark_idle_and_count(WorkingSetState *state, unsigned long long *touched_out) {
+
+    unsigned long long *masks = state->batch;
+    unsigned long long *idle = state->batch + WS_PAGEMAP_BATCH / 2;
+    const size_t max_words = WS_PAGEMAP_BATCH / 2;
+    unsigned long long touched = 0;
+    size_t i = 0;
+
+    while (i < state->npfns) {
+        unsigned long long first_word = state->pfns[i] / 64;
+        size_t nwords = 0;
+
+        // Junta PFNs enquanto as palavras forem contíguas e couberem no lote
+        while (i < state->npfns) {
+            unsigned long long word = state->pfns[i] / 64;
+            size_t idx = (size_t)(word - first_word);
+            if (idx >= max_words || idx > nwords) break;
+            if (idx == nwords) masks[nwords++] = 0;
+            masks[idx] |= 1ULL << (state->pfns[i] % 64);
+            i++;
+        }
+
+        off_t offset = (off_t)(first_word * sizeof(uint64_t));
+        size_t bytes = nwords * sizeof(uint64_t);
+
+        if (touched_out) {
+            if (pread(state->bitmap_fd, idle, bytes, offset) != (ssize_t)bytes) return -1;
+            for (size_t w = 0; w < nwords; w++) {
+                touched += (unsigned long long)__builtin_popcountll(masks[w] & ~idle[w]);
+            }
+        }
+
+        // Bits 1 marcam a página como ociosa; bits 0 não alteram nada
+        if (pwrite(state->bitmap_fd, masks, bytes, offset) != (ssize_t)bytes) return -1;
+    }
+
+    if (touched_out) *touched_out = touched;
+    return 0;
+}
+
+static int page_idle_open(WorkingSetState *state) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/pagemap", proc_root(), (int)state->pid);
+
+    char bitmap[PROC_PATH_MAX];
+    state->bitmap_fd = open(sys_path(bitmap, sizeof(bitmap), PAGE_IDLE_BITMAP), O_RDWR | O_CLOEXEC);
+    if (state->bitmap_fd == -1) return -1;
+
+    state->pagemap_fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (state->pagemap_fd == -1) return -1;
+
+    state->batch = malloc(WS_PAGEMAP_BATCH * sizeof(uint64_t));
+    if (!state->batch) return -1;
+
+    // Sem CAP_SYS_ADMIN o pagemap devolve PFN zero e nada é coletado
+    if (collect_pfns(state) < 0 || state->npfns == 0) return -1;
+
+    return mark_idle_and_count(state, NULL);
+}
+
+/* ---------------------------- clear_refs ---------------------------- */
+
+static int clear_refs(pid_t pid) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/clear_refs", proc_root(), (int)pid);
+
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd == -1) return -1;
+
+    // "1" limpa os bits de acesso de todas as páginas do processo
+    ssize_t n = write(fd, "1", 1);
+    close(fd);
+    return n == 1 ? 0 : -1;
+}
+
+static int read_referenced(pid_t pid, unsigned long long *rss_kb, unsigned long long *referenced_kb) {
+
+    char path[PROC_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%d/smaps_rollup", proc_root(), (int)pid);
+
+    char buf[4096];
+    ssize_t len = proc_read_file(path, buf, sizeof(buf));
+    if (len <= 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir %s\n", path);
+        return -1;
+    }
+
+    static const char *const keys[] = { "Rss", "Referenced" };
+    static ProcKeyTable table;
+    static int table_ready = 0;
+    if (!table_ready) {
+        proc_key_table_init(&table, keys, 2);
+        table_ready = 1;
+    }
+
+    unsigned long long values[2] = {0, 0};
+    if (proc_parse_kv(buf, (size_t)len, &table, values) < 2) {
+        fprintf(stderr, "Erro: formato inesperado em %s\n", path);
+        return -1;
+    }
+
+    *rss_kb = values[0];
+    *referenced_kb = values[1];
+    return 0;
+}
+
+/* ------------------------------ API ------------------------------ */
+
+/**
+ * Inicializa o estimador e inicia o primeiro intervalo
+ *
+ * @param state Estado a inicializar
+ * @param pid Processo monitorado
+ * @return 0 em sucesso, -1 se nenhum dos métodos estiver disponível
+ *
+ * Usa page_idle quando o kernel tem CONFIG_IDLE_PAGE_TRACKING e o processo
+ * roda como root; caso contrário cai para clear_refs.
+ */
+int working_set_init(WorkingSetState *state, pid_t pid) {
+
+    if (!state) {
+        fprintf(stderr, "Erro: ponteiro nulo em working_set_init\n");
+        return -1;
+    }
+
+    memset(state, 0, sizeof(*state));
+    state->pid = pid;
+    state->pagemap_fd = -1;
+    state->bitmap_fd = -1;
+    state->page_size = sysconf(_SC_PAGESIZE);
+    if (state->page_size <= 0) state->page_size = 4096;
+
+    if (page_idle_open(state) == 0) {
+        state->method = WS_METHOD_PAGE_IDLE;
+    } else {
+        // Libera o que page_idle chegou a alocar antes de tentar o fallback
+        long page_size = state->page_size;
+        working_set_free(state);
+        state->pid = pid;
+        state->page_size = page_size;
+
+        if (clear_refs(pid) < 0) {
+            fprintf(stderr, "Erro em working_set_init: nem page_idle nem clear_refs disponiveis para o processo %d\n",
+                    (int)pid);
+            return -1;
+        }
+        state->method = WS_METHOD_CLEAR_REFS;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &state->last_ts);
+    return 0;
+}
+
+/**
+ * Fecha o intervalo atual, mede o working set e inicia o próximo
+ *
+ * @param state Estado criado por working_set_init
+ * @param sample Recebe a medição do intervalo
+ * @return 0 em sucesso, -1 em erro
+ */
+int working_set_sample(WorkingSetState *state, WorkingSetSample *sample) {
+
+    if (!state || !sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em working_set_sample\n");
+        return -1;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    memset(sample, 0, sizeof(*sample));
+    sample->pid = state->pid;
+    sample->method = state->method;
+    sample->interval_sec = timespec_diff_sec(state->last_ts, start);
+
+    if (state->method == WS_METHOD_PAGE_IDLE) {
+        // Mapeamento pode ter mudado: páginas novas contam como tocadas
+        unsigned long long touched = 0;
+        if (collect_pfns(state) < 0 || mark_idle_and_count(state, &touched) < 0) {
+            fprintf(stderr, "Erro em working_set_sample: falha no page_idle do processo %d\n",
+                    (int)state->pid);
+            return -1;
+        }
+        sample->scanned_pages = state->npfns;
+        sample->rss_bytes = (unsigned long long)state->npfns * (unsigned long long)state->page_size;
+        sample->ws_bytes = touched * (unsigned long long)state->page_size;
+    } else {
+        unsigned long long rss_kb = 0, referenced_kb = 0;
+        if (read_referenced(state->pid, &rss_kb, &referenced_kb) < 0 || clear_refs(state->pid) < 0) {
+            fprintf(stderr, "Erro em working_set_sample: falha no clear_refs do processo %d\n",
+                    (int)state->pid);
+            return -1;
+        }
+        sample->rss_bytes = rss_kb * 1024;
+        sample->ws_bytes = referenced_kb * 1024;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    sample->timestamp = time(NULL);
+    sample->ws_percent = sample->rss_bytes > 0 ?
+        100.0 * (double)sample->ws_bytes / (double)sample->rss_bytes : 0.0;
+    sample->cost_ns = elapsed_ns(&start, &end);
+
+    if (sample->ws_bytes > state->peak_ws_bytes) state->peak_ws_bytes = sample->ws_bytes;
+
+    // O próximo intervalo começa quando as marcas foram rearmadas
+    state->last_ts = end;
+    return 0;
+}
+
+void working_set_free(WorkingSetState *state) {
+    if (!state) return;
+
+    if (state->pagemap_fd != -1) close(state->pagemap_fd);
+    if (state->bitmap_fd != -1) close(state->bitmap_fd);
+    free(state->pfns);
+    free(state->batch);
+    free(state->maps_buf);
+
+    memset(state, 0, sizeof(*state));
+    state->pagemap_fd = -1;
+    state->bitmap_fd = -1;
+}
+
+static FILE *ws_csv_file = NULL;  // arquivo CSV para working set
+
+int working_set_csv_write(const WorkingSetSample *sample) {
+    if (!sample) {
+        fprintf(stderr, "Erro: ponteiro nulo em working_set_csv_write\n");
+        return -1;
+    }
+
+    // cria o arquivo na primeira chamada
+    if (!ws_csv_file) {
+        struct tm *tm_info = localtime(&sample->timestamp);
+        char filename[64];
+        snprintf(filename, sizeof(filename),
+                 "working-set-%04d%02d%02d_%02d%02d%02d.csv",
+                 tm_info->tm_year + 1900,
+                 tm_info->tm_mon + 1,
+                 tm_info->tm_mday,
+                 tm_info->tm_hour,
+                 tm_info->tm_min,
+                 tm_info->tm_sec);
+
+        ws_csv_file = fopen(filename, "w");
+        if (!ws_csv_file) {
+            fprintf(stderr, "Erro: nao foi possivel criar %s\n", filename);
+            return -1;
+        }
+
+        fprintf(ws_csv_file,
+                "timestamp,pid,method,interval_sec,rss_bytes,ws_bytes,ws_percent,scanned_pages,cost_ns\n");
+        fflush(ws_csv_file);
+    }
+
+    if (fprintf(ws_csv_file,
+                "%lld,%d,%s,%.3f,%llu,%llu,%.2f,%llu,%llu\n",
+                (long long)sample->timestamp,
+                (int)sample->pid,
+                sample->method == WS_METHOD_PAGE_IDLE ? "page_idle" : "clear_refs",
+                sample->interval_sec,
+                sample->rss_bytes,
+                sample->ws_bytes,
+                sample->ws_percent,
+                sample->scanned_pages,
+                sample->cost_ns) < 0) {
+        fprintf(stderr, "Erro: nao foi possivel escrever linha CSV\n");
+        return -1;
+    }
+
+    fflush(ws_csv_file);
+    return 0;
+}
+
+void working_set_csv_close(void) {
+    if (ws_csv_file) {
+        fclose(ws_csv_file);
+        ws_csv_file = NULL;
+    }
+}
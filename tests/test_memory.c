@@ -1,7 +1,9 @@
 #include <stdio.h>    // printf, scanf, fprintf
 #include <time.h>     // time_t, struct tm, localtime, strftime
 #include <unistd.h>   // sleep
-#include "monitor.h"  // MemorySample, memory_monitor_sample
+#include "monitor.h"  // MemoryMonitorState, MemorySample, memory_monitor_sample
+
+#define ROLLUP_EVERY 5  // lê smaps_rollup (PSS/USS) a cada 5 amostras
 
 int main(void) {
     pid_t pid;          // PID do processo a ser monitorado
@@ -25,13 +27,24 @@ int main(void) {
 
     printf("\nMonitorando MEMORIA do PID %d por %d segundo(s)...\n", (int)pid, duration_sec);
 
+    // Estado do monitor: guarda a amostra anterior para as taxas e a janela do vazamento
+    MemoryMonitorState state;
+    if (memory_monitor_init(&state, pid, 0) != 0) {
+        return 1;
+    }
+
+    // Coletor de smaps_rollup com cadência mais lenta que o loop principal
+    MemoryRollupState rollup;
+    memory_rollup_init(&rollup, pid, ROLLUP_EVERY);
+
     // Loop principal de monitoramento: uma amostra por segundo
     for (int i = 0; i < duration_sec; i++) {
         MemorySample sample;  // struct que vai receber os dados desta amostra
 
         // Coleta os dados de memoria para o processo monitorado
-        if (memory_monitor_sample(pid, &sample) != 0) {
+        if (memory_monitor_sample(&state, &sample) != 0) {
             fprintf(stderr, "Erro ao coletar memoria do processo %d.\n", (int)pid);
+            memory_monitor_free(&state);
             return 1;
         }
 
@@ -50,10 +63,31 @@ int main(void) {
                (unsigned long long)sample.rss_bytes);
         printf(" VSZ           : %10llu bytes\n",
                (unsigned long long)sample.vsize_bytes);
-        printf(" Page faults   : %10llu\n",
-               (unsigned long long)sample.page_faults);
+        printf(" Page faults   : %10llu (minor %llu, major %llu)\n",
+               (unsigned long long)sample.page_faults,
+               sample.minor_faults, sample.major_faults);
+        printf(" Faults/s      : %10.1f minor, %.1f major\n",
+               sample.minor_faults_per_sec, sample.major_faults_per_sec);
+        printf(" Crescim. RSS  : %10.1f bytes/s\n", sample.rss_growth_bytes_per_sec);
         printf(" Swap          : %10llu bytes\n",
                (unsigned long long)sample.swap_bytes);
+        printf(" Swap in/out   : %10.1f / %.1f bytes/s\n",
+               sample.swap_in_bytes_per_sec, sample.swap_out_bytes_per_sec);
+        printf(" Vazamento     : %10.2f MB/h (confianca %.2f)%s\n",
+               sample.leak_slope_mb_per_hour, sample.leak_confidence,
+               sample.leak_suspected ? " SUSPEITO" : "");
+
+        // PSS/USS só aparecem nas amostras em que smaps_rollup foi lido
+        MemoryRollupSample rb;
+        if (memory_rollup_tick(&rollup, &rb) == 1) {
+            printf(" PSS           : %10llu bytes\n", rb.pss_bytes);
+            printf(" USS           : %10llu bytes\n", rb.uss_bytes);
+            printf(" Compartilhada : %10llu bytes\n", rb.shared_bytes);
+            printf(" AnonHugePages : %10llu bytes\n", rb.anon_huge_bytes);
+            printf(" SwapPss       : %10llu bytes\n", rb.swap_pss_bytes);
+            printf(" Custo rollup  : %10.1f us\n", rb.cost_ns / 1000.0);
+            memory_rollup_csv_write(&rb);
+        }
         printf("---------------------------------------------\n");
 
         // Salva amostra em CSV
@@ -63,8 +97,17 @@ int main(void) {
         sleep(1);
     }
 
+    memory_monitor_free(&state);
+
     // Fecha o arquivo CSV
     memory_sample_csv_close();
+    memory_rollup_csv_close();
+
+    if (rollup.reads > 0) {
+        printf("\nsmaps_rollup: %llu leitura(s), custo medio %.1f us, maximo %.1f us\n",
+               rollup.reads, rollup.total_cost_ns / 1000.0 / rollup.reads,
+               rollup.max_cost_ns / 1000.0);
+    }
 
     return 0;
 }
\ No newline at end of file
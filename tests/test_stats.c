@@ -0,0 +1,50 @@
+#include <math.h>
+#include <stdio.h>
+#include "stats.h"    // StreamStats, stream_stats_add, stream_stats_percentile
+
+/*
+ * Regressão do histograma de stats.c com zeros exatos: frexp(0) devolve
+ * expoente 0, e um zero que não caísse no contador de zeros ia para a
+ * faixa -32 de uma oitava, escrevendo antes da alocação. CPU% de um
+ * processo parado é exatamente 0 a cada amostra.
+ */
+
+static int failures = 0;
+
+static void check(int ok, const char *what) {
+    printf("  %-48s %s\n", what, ok ? "OK" : "FALHOU");
+    if (!ok) failures++;
+}
+
+int main(void) {
+    printf("===== TESTE STREAM STATS (ZEROS) =====\n\n");
+
+    // Só zeros, positivos e negativos
+    StreamStats zeros;
+    stream_stats_init(&zeros);
+    for (int i = 0; i < 100; i++) {
+        stream_stats_add(&zeros, 0.0);
+        stream_stats_add(&zeros, -0.0);
+    }
+    printf("Somente 0.0 e -0.0 (200 amostras):\n");
+    check(zeros.count == 200, "count == 200");
+    check(zeros.zeros == 200, "todas no contador de zeros");
+    check(zeros.min == 0.0 && zeros.max == 0.0, "min == max == 0");
+    check(stream_stats_percentile(&zeros, 0.5) == 0.0, "p50 == 0");
+    stream_stats_free(&zeros);
+
+    // Processo ocioso na maior parte do tempo: 60 zeros e 40 amostras de 5%
+    StreamStats mixed;
+    stream_stats_init(&mixed);
+    for (int i = 0; i < 100; i++) stream_stats_add(&mixed, i % 5 < 3 ? (i % 2 ? -0.0 : 0.0) : 5.0);
+    printf("60 zeros e 40 amostras de 5.0:\n");
+    check(mixed.count == 100, "count == 100");
+    check(mixed.zeros == 60, "60 no contador de zeros");
+    check(mixed.min == 0.0 && mixed.max == 5.0, "min == 0, max == 5");
+    check(stream_stats_percentile(&mixed, 0.5) == 0.0, "p50 == 0");
+    check(fabs(stream_stats_percentile(&mixed, 0.9) - 5.0) <= 5.0 / 64, "p90 ~= 5 (erro <= 1/64)");
+    stream_stats_free(&mixed);
+
+    printf("\n%s\n", failures ? "FALHOU" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+#include <signal.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "monitor.h"  // MonitorTarget, target_open, target_same_process, cpu_monitor_*
+
+/*
+ * Regressão de target.c com um alvo de outro usuário: o pidfd abre sem
+ * permissão especial, mas pidfd_send_signal(0) devolve EPERM para um
+ * processo alheio, e isso não pode ser lido como "terminou".
+ *
+ * Roda como root: cria o alvo (fica root) e então troca o próprio uid para
+ * nobody antes de monitorar. Sem root, o teste é pulado.
+ */
+
+#define OTHER_UID 65534  // nobody
+
+static int failures = 0;
+
+static void check(int ok, const char *what) {
+    printf("  %-48s %s\n", what, ok ? "OK" : "FALHOU");
+    if (!ok) failures++;
+}
+
+int main(void) {
+    printf("===== TESTE ALVO DE OUTRO USUARIO =====\n\n");
+
+    if (geteuid() != 0) {
+        printf("PULADO: precisa de root para trocar de uid\n");
+        return 0;
+    }
+
+    // O alvo termina quando o lado de escrita do pipe fecha
+    int fds[2];
+    if (pipe(fds) != 0) return 1;
+    pid_t child = fork();
+    if (child < 0) return 1;
+    if (child == 0) {
+        close(fds[1]);
+        char c;
+        while (read(fds[0], &c, 1) > 0) {}
+        _exit(0);
+    }
+    close(fds[0]);
+
+    if (setgid(OTHER_UID) != 0 || setuid(OTHER_UID) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel trocar para o uid %d\n", OTHER_UID);
+        kill(child, SIGKILL);
+        return 1;
+    }
+    check(kill(child, 0) != 0, "sem permissao de sinal para o alvo");
+
+    MonitorTarget tg;
+    check(target_open(&tg, child) == 0, "target_open no alvo de outro usuario");
+    check(target_same_process(&tg), "target_same_process == 1 com o alvo vivo");
+
+    CpuMonitorState cs;
+    CpuSample sample;
+    check(cpu_monitor_init(&cs, child) == 0 && target_wait(&tg, 200) == 0 &&
+          cpu_monitor_sample(&cs, &sample) == 0 && target_same_process(&tg),
+          "amostra de CPU aceita");
+
+    // Fechar o pipe encerra o alvo (fica zumbi até o waitpid abaixo)
+    close(fds[1]);
+    check(target_wait(&tg, 2000) == 1, "target_wait ve o fim do alvo");
+    check(!target_same_process(&tg), "target_same_process == 0 depois do fim");
+    target_close(&tg);
+    waitpid(child, NULL, 0);
+
+    printf("\n%s\n", failures ? "FALHOU" : "OK");
+    return failures ? 1 : 0;
+}
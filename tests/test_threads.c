@@ -0,0 +1,84 @@
+#include <stdio.h>    // printf, scanf, fprintf
+#include <time.h>     // time_t, struct tm, localtime, strftime
+#include <unistd.h>   // sleep
+#include "monitor.h"  // ThreadMonitorState, ThreadSample, thread_monitor_init, thread_monitor_sample
+
+#define TOP_N 10  // quantidade de threads exibidas por amostra
+
+int main(void) {
+    pid_t pid;          // PID do processo a ser monitorado
+    int duration_sec;   // tempo total de monitoramento, em segundos
+
+    printf("===== TESTE THREAD MONITOR =====\n\n");
+
+    // Lê o PID que o usuário deseja monitorar
+    printf("Digite o PID do processo: ");
+    if (scanf("%d", &pid) != 1) {
+        fprintf(stderr, "Erro ao ler PID.\n");
+        return 1;
+    }
+
+    // Lê por quanto tempo o monitoramento deve ser feito
+    printf("Digite o tempo de monitoramento (segundos): ");
+    if (scanf("%d", &duration_sec) != 1 || duration_sec <= 0) {
+        fprintf(stderr, "Tempo invalido.\n");
+        return 1;
+    }
+
+    // Estrutura de estado usada pelo monitor de threads
+    ThreadMonitorState state;
+
+    // Inicializa o monitor de threads para o PID informado
+    if (thread_monitor_init(&state, pid) != 0) {
+        fprintf(stderr, "Erro ao inicializar monitor de threads.\n");
+        return 1;
+    }
+
+    printf("\nMonitorando THREADS do PID %d por %d segundo(s)...\n", (int)pid, duration_sec);
+
+    // Loop principal de monitoramento: uma amostra por segundo
+    for (int i = 0; i < duration_sec; i++) {
+        ThreadSample top[TOP_N];  // threads mais quentes desta amostra
+
+        // Espera 1 segundo antes da próxima leitura
+        sleep(1);
+
+        // Coleta as threads e devolve as TOP_N com maior uso de CPU
+        int n = thread_monitor_sample(&state, top, TOP_N);
+        if (n < 0) {
+            fprintf(stderr, "Erro ao coletar threads do processo %d.\n", (int)pid);
+            thread_monitor_free(&state);
+            return 1;
+        }
+
+        char buf[32];    // buffer para string de data/hora formatada
+        time_t now = time(NULL);
+        struct tm *tm_info = localtime(&now);
+
+        // Formata como "YYYY-MM-DD HH:MM:SS"
+        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", tm_info);
+
+        // Impressão formatada das threads mais quentes
+        printf("\n---------------------------------------------\n");
+        printf(" PID           : %d\n", (int)pid);
+        printf(" Timestamp     : %s\n", buf);
+        printf(" Threads       : %10zu\n", state.count);
+        printf("---------------------------------------------\n");
+        printf(" %-8s %-16s %-2s %-4s %8s\n", "TID", "NOME", "ST", "CPU", "CPU%");
+        for (int k = 0; k < n; k++) {
+            printf(" %-8d %-16s %-2c %-4d %7.2f%%\n",
+                   (int)top[k].tid, top[k].comm, top[k].state,
+                   top[k].last_cpu, top[k].cpu_percent);
+
+            // Salva amostra em CSV
+            thread_sample_csv_write(&top[k]);
+        }
+        printf("---------------------------------------------\n");
+    }
+
+    // Libera o estado e fecha o arquivo CSV
+    thread_monitor_free(&state);
+    thread_sample_csv_close();
+
+    return 0;
+}